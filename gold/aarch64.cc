@@ -1475,6 +1475,11 @@ class Stub_table : public Output_data
   void
   relocate_erratum_stub(The_erratum_stub*, unsigned char*);
 
+  // Return the data size of the previous relaxation pass.
+  off_t
+  prev_data_size() const
+  { return this->prev_data_size_; }
+
   // Update data size at the end of a relaxation pass.  Return true if data size
   // is different from that of the previous relaxation pass.
   bool
@@ -1762,6 +1767,8 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
   typedef Stub_table<size, big_endian> The_stub_table;
   typedef Erratum_stub<size, big_endian> The_erratum_stub;
   typedef typename The_stub_table::Erratum_stub_set_iter Erratum_stub_set_iter;
+  typedef Reloc_stub<size, big_endian> The_reloc_stub;
+  typedef typename The_reloc_stub::Key The_reloc_stub_key;
   typedef std::vector<The_stub_table*> Stub_table_list;
   static const AArch64_address invalid_address =
       static_cast<AArch64_address>(-1);
@@ -1769,7 +1776,7 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
   AArch64_relobj(const std::string& name, Input_file* input_file, off_t offset,
 		 const typename elfcpp::Ehdr<size, big_endian>& ehdr)
     : Sized_relobj_file<size, big_endian>(name, input_file, offset, ehdr),
-      stub_tables_()
+      stub_tables_(), stub_scan_info_(), pending_reloc_stubs_()
   { }
 
   ~AArch64_relobj()
@@ -1803,6 +1810,35 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
   scan_sections_for_stubs(The_target_aarch64*, const Symbol_table*,
 			  const Layout*);
 
+  // Record that a branch in section SHNDX needs the stub with KEY in
+  // STUB_TABLE, to reach DESTINATION.  The stub is not added to the
+  // stub table until add_pending_reloc_stubs is called.
+  void
+  add_pending_reloc_stub(unsigned int shndx, The_stub_table* stub_table,
+			 const The_reloc_stub_key& key,
+			 AArch64_address destination)
+  {
+    this->stub_scan_info_[shndx].headroom = 0;
+    this->pending_reloc_stubs_.push_back(Pending_reloc_stub(stub_table, key,
+							    destination));
+  }
+
+  // Record that a branch in section SHNDX would still be in range if
+  // it moved HEADROOM bytes further from its destination.
+  void
+  update_stub_scan_headroom(unsigned int shndx, AArch64_address headroom)
+  {
+    Stub_scan_info& info(this->stub_scan_info_[shndx]);
+    info.headroom = std::min(info.headroom, headroom);
+  }
+
+  // Add the stubs found by scan_sections_for_stubs to their stub
+  // tables.  The objects are scanned in parallel, but this is called
+  // for each object in order, so the stubs are always added in the
+  // same order.
+  void
+  add_pending_reloc_stubs();
+
   // Whether a section is a scannable text section.
   bool
   text_section_is_scannable(const elfcpp::Shdr<size, big_endian>&, unsigned int,
@@ -1852,6 +1888,7 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
 
     // Initialize look-up tables.
     this->stub_tables_.resize(this->shnum());
+    this->stub_scan_info_.resize(this->shnum());
   }
 
   virtual void
@@ -1885,9 +1922,47 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
 				    const Relobj::Output_sections&,
 				    const Symbol_table*, const unsigned char*);
 
+  // What the last scan for relocation stubs found about a section.
+  struct Stub_scan_info
+  {
+    Stub_scan_info()
+      : scanned(false), headroom(0), drift(0)
+    { }
+
+    // Whether the section has been scanned.
+    bool scanned;
+    // How much further any branch in the section could move from its
+    // destination and still be in range.  This is 0 if a branch
+    // needed a stub.
+    AArch64_address headroom;
+    // The value of Target_aarch64::relax_drift when the section was
+    // scanned.
+    uint64_t drift;
+  };
+
+  // A stub found by scan_sections_for_stubs.
+  struct Pending_reloc_stub
+  {
+    Pending_reloc_stub(The_stub_table* a_stub_table,
+		       const The_reloc_stub_key& a_key,
+		       AArch64_address a_destination)
+      : stub_table(a_stub_table), key(a_key), destination(a_destination)
+    { }
+
+    The_stub_table* stub_table;
+    The_reloc_stub_key key;
+    AArch64_address destination;
+  };
+
   // List of stub tables.
   Stub_table_list stub_tables_;
 
+  // Information about the last scan of each section for stubs.
+  std::vector<Stub_scan_info> stub_scan_info_;
+
+  // The stubs found by the last scan, in the order they were found.
+  std::vector<Pending_reloc_stub> pending_reloc_stubs_;
+
   // Mapping symbol information sorted by (section index, section_offset).
   Mapping_symbol_info mapping_symbol_info_;
 };  // End of AArch64_relobj
@@ -2411,6 +2486,21 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
 						  pshdrs))
 	{
 	  unsigned int index = this->adjust_shndx(shdr.get_sh_info());
+
+	  // Skip the section if none of its branches can have moved
+	  // out of range since it was last scanned.  Branches which
+	  // needed stubs are always scanned again, to update the
+	  // stubs' destinations.
+	  Stub_scan_info& info(this->stub_scan_info_[index]);
+	  uint64_t drift = target->relax_drift();
+	  if (info.scanned
+	      && target->may_skip_stub_rescan()
+	      && drift - info.drift < info.headroom)
+	    continue;
+	  info.scanned = true;
+	  info.headroom = invalid_address;
+	  info.drift = drift;
+
 	  AArch64_address output_offset =
 	      this->get_output_section_offset(index);
 	  AArch64_address output_address;
@@ -2456,6 +2546,29 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
 }
 
 
+// Add the stubs found by scan_sections_for_stubs to their stub tables.
+
+template<int size, bool big_endian>
+void
+AArch64_relobj<size, big_endian>::add_pending_reloc_stubs()
+{
+  for (typename std::vector<Pending_reloc_stub>::iterator p =
+	 this->pending_reloc_stubs_.begin();
+       p != this->pending_reloc_stubs_.end();
+       ++p)
+    {
+      The_reloc_stub* stub = p->stub_table->find_reloc_stub(p->key);
+      if (stub == NULL)
+	{
+	  stub = new The_reloc_stub(p->key.type());
+	  p->stub_table->add_reloc_stub(stub, p->key);
+	}
+      stub->set_destination_address(p->destination);
+    }
+  this->pending_reloc_stubs_.clear();
+}
+
+
 // A class to wrap an ordinary input section containing executable code.
 
 template<int size, bool big_endian>
@@ -2923,7 +3036,8 @@ class Target_aarch64 : public Sized_target<size, big_endian>
       rela_irelative_(NULL), copy_relocs_(elfcpp::R_AARCH64_COPY),
       got_mod_index_offset_(-1U),
       tlsdesc_reloc_info_(), tls_base_symbol_defined_(false),
-      stub_tables_(), stub_group_size_(0), aarch64_input_section_map_()
+      stub_tables_(), stub_group_size_(0), aarch64_input_section_map_(),
+      relax_drift_(0), may_skip_stub_rescan_(false)
   { }
 
   // Scan the relocations to determine unreferenced sections for
@@ -3119,6 +3233,18 @@ class Target_aarch64 : public Sized_target<size, big_endian>
     return static_cast<This*>(parameters->sized_target<size, big_endian>());
   }
 
+  // The sum of the amounts by which the distance between any two
+  // addresses may have changed in the relaxation passes so far.
+  uint64_t
+  relax_drift() const
+  { return this->relax_drift_; }
+
+  // Whether a section need not be scanned for stubs again if its
+  // branches cannot have moved out of range.
+  bool
+  may_skip_stub_rescan() const
+  { return this->may_skip_stub_rescan_; }
+
 
   // Scan erratum 843419 for a part of a section.
   void
@@ -3190,7 +3316,8 @@ class Target_aarch64 : public Sized_target<size, big_endian>
 
   // Relaxation hook.  This is where we do stub generation.
   virtual bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*);
 
   void
   group_sections(Layout* layout,
@@ -3536,6 +3663,9 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   // Actual stub group size
   section_size_type stub_group_size_;
   AArch64_input_section_map aarch64_input_section_map_;
+  // See relax_drift and may_skip_stub_rescan.
+  uint64_t relax_drift_;
+  bool may_skip_stub_rescan_;
 };  // End of Target_aarch64
 
 
@@ -3760,6 +3890,16 @@ Target_aarch64<size, big_endian>::rela_dyn_section(Layout* layout)
       layout->add_output_section_data(".rela.dyn", elfcpp::SHT_RELA,
 				      elfcpp::SHF_ALLOC, this->rela_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<size, big_endian>* relr =
+	    new Output_data_relr<size, big_endian>(elfcpp::R_AARCH64_RELATIVE);
+	  layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+					  elfcpp::SHF_ALLOC, relr,
+					  ORDER_DYNAMIC_RELOCS, false);
+	  this->rela_dyn_->set_relr_section(relr);
+	}
     }
   return this->rela_dyn_;
 }
@@ -3844,7 +3984,7 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
     typename elfcpp::Elf_types<size>::Elf_Swxword addend,
     Address address)
 {
-  const AArch64_relobj<size, big_endian>* aarch64_relobj =
+  AArch64_relobj<size, big_endian>* aarch64_relobj =
       static_cast<AArch64_relobj<size, big_endian>*>(relinfo->object);
 
   Symbol_value<size> symval;
@@ -3888,19 +4028,21 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
   int stub_type = The_reloc_stub::
       stub_type_for_reloc(r_type, address, destination);
   if (stub_type == ST_NONE)
-    return;
+    {
+      int64_t branch_offset = destination - address;
+      aarch64_relobj->update_stub_scan_headroom(
+	  relinfo->data_shndx,
+	  std::min(The_reloc_stub::MAX_BRANCH_OFFSET - branch_offset,
+		   branch_offset - The_reloc_stub::MIN_BRANCH_OFFSET));
+      return;
+    }
 
   The_stub_table* stub_table = aarch64_relobj->stub_table(relinfo->data_shndx);
   gold_assert(stub_table != NULL);
 
   The_reloc_stub_key key(stub_type, gsym, aarch64_relobj, r_sym, addend);
-  The_reloc_stub* stub = stub_table->find_reloc_stub(key);
-  if (stub == NULL)
-    {
-      stub = new The_reloc_stub(stub_type);
-      stub_table->add_reloc_stub(stub, key);
-    }
-  stub->set_destination_address(destination);
+  aarch64_relobj->add_pending_reloc_stub(relinfo->data_shndx, stub_table, key,
+					 destination);
 }  // End of Target_aarch64::scan_reloc_for_stub
 
 
@@ -5629,6 +5771,31 @@ Target_aarch64<size, big_endian>::new_aarch64_input_section(
 }
 
 
+// A class which scans an object for stubs, for Target_aarch64::do_relax.
+
+template<int size, bool big_endian>
+class AArch64_relax_scan_runner : public Relax_scan_runner
+{
+ public:
+  AArch64_relax_scan_runner(Target_aarch64<size, big_endian>* target,
+			    const Symbol_table* symtab, const Layout* layout)
+    : target_(target), symtab_(symtab), layout_(layout)
+  { }
+
+  void
+  scan(Relobj* object, const Task*)
+  {
+    static_cast<AArch64_relobj<size, big_endian>*>(object)->
+      scan_sections_for_stubs(this->target_, this->symtab_, this->layout_);
+  }
+
+ private:
+  Target_aarch64<size, big_endian>* target_;
+  const Symbol_table* symtab_;
+  const Layout* layout_;
+};
+
+
 // Relaxation hook.  This is where we do stub generation.
 
 template<int size, bool big_endian>
@@ -5637,7 +5804,8 @@ Target_aarch64<size, big_endian>::do_relax(
     int pass,
     const Input_objects* input_objects,
     Symbol_table* symtab,
-    Layout* layout ,
+    Layout* layout,
+    Workqueue* workqueue,
     const Task* task)
 {
   gold_assert(!parameters->options().relocatable());
@@ -5654,6 +5822,11 @@ Target_aarch64<size, big_endian>::do_relax(
 				   4096 * 4;
 	}
       group_sections(layout, this->stub_group_size_, true, task);
+
+      // A linker script may align sections by more than we account
+      // for below.
+      this->may_skip_stub_rescan_ =
+	!layout->script_options()->saw_sections_clause();
     }
   else
     {
@@ -5671,18 +5844,25 @@ Target_aarch64<size, big_endian>::do_relax(
 	}
     }
 
-  // Scan relocs for relocation stubs
+  // Scan relocs for relocation stubs.  The erratum stubs are added
+  // to the stub tables while scanning, so we only scan in parallel if
+  // we are not fixing errata.
+  if (parameters->options().fix_cortex_a53_843419()
+      || parameters->options().fix_cortex_a53_835769())
+    workqueue = NULL;
+  AArch64_relax_scan_runner<size, big_endian> runner(this, symtab, layout);
+  this->scan_relobjs_for_relax(input_objects, layout, &runner, workqueue,
+			       task);
   for (Input_objects::Relobj_iterator op = input_objects->relobj_begin();
        op != input_objects->relobj_end();
        ++op)
-    {
-      The_aarch64_relobj* aarch64_relobj =
-	  static_cast<The_aarch64_relobj*>(*op);
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from Layout::finalize, so it is OK to lock.
-      Task_lock_obj<Object> tl(task, aarch64_relobj);
-      aarch64_relobj->scan_sections_for_stubs(this, symtab, layout);
-    }
+    static_cast<The_aarch64_relobj*>(*op)->add_pending_reloc_stubs();
+
+  std::vector<off_t> prev_sizes;
+  prev_sizes.reserve(this->stub_tables_.size());
+  for (Stub_table_iterator siter = this->stub_tables_.begin();
+       siter != this->stub_tables_.end(); ++siter)
+    prev_sizes.push_back((*siter)->prev_data_size());
 
   bool any_stub_table_changed = false;
   for (Stub_table_iterator siter = this->stub_tables_.begin();
@@ -5701,6 +5881,28 @@ Target_aarch64<size, big_endian>::do_relax(
 	}
     }
 
+  // Work out how far apart any two addresses may move in the next
+  // pass.  Each stub table which changed size moves everything after
+  // it by the change in size, plus any change in the padding before
+  // the next aligned section.  A segment boundary may also add up to
+  // a page of padding.
+  uint64_t max_align = 0;
+  for (Layout::Section_list::const_iterator p = layout->section_list().begin();
+       p != layout->section_list().end();
+       ++p)
+    if (((*p)->flags() & elfcpp::SHF_ALLOC) != 0)
+      max_align = std::max(max_align, (*p)->addralign());
+  uint64_t drift = 0;
+  for (size_t i = 0; i < prev_sizes.size(); ++i)
+    {
+      off_t size_now = this->stub_tables_[i]->prev_data_size();
+      if (size_now != prev_sizes[i])
+	drift += (std::abs(size_now - prev_sizes[i]) + max_align);
+    }
+  if (drift > 0)
+    drift += this->abi_pagesize();
+  this->relax_drift_ += drift;
+
   // Do not continue relaxation.
   bool continue_relaxation = any_stub_table_changed;
   if (!continue_relaxation)
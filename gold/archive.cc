@@ -199,7 +199,7 @@ Archive::Archive(const std::string& name, Input_file* input_file,
                  bool is_thin_archive, Dirsearch* dirpath, Task* task)
   : Library_base(task), name_(name), input_file_(input_file), armap_(),
     armap_names_(), extended_names_(), armap_checked_(), seen_offsets_(),
-    members_(), is_thin_archive_(is_thin_archive), included_member_(false),
+    armap_buckets_(), armap_index_(), members_(), is_thin_archive_(is_thin_archive), included_member_(false),
     nested_archives_(), dirpath_(dirpath), num_members_(0),
     included_all_members_(false)
 {
@@ -758,12 +758,136 @@ Archive::read_symbols(off_t off)
   this->members_[off] = member;
 }
 
+// Build the hash index of the archive map.  This is done at most
+// once for each archive, the first time we include a member.
+
+void
+Archive::build_armap_index()
+{
+  gold_assert(this->armap_buckets_.empty());
+
+  const size_t armap_size = this->armap_.size();
+  size_t nbuckets = 1;
+  while (nbuckets < armap_size)
+    nbuckets <<= 1;
+
+  // Count the entries in each bucket, then turn the counts into
+  // starting positions, then fill in the entries.  Filling them in
+  // in order keeps each bucket in archive map order.
+  std::vector<unsigned int> hashes(armap_size);
+  this->armap_buckets_.assign(nbuckets + 1, 0);
+  for (size_t i = 0; i < armap_size; ++i)
+    {
+      const char* name = (this->armap_names_.data()
+			  + this->armap_[i].name_offset);
+      size_t len = strcspn(name, "@");
+      hashes[i] = gold::string_hash<char>(name, len) & (nbuckets - 1);
+      ++this->armap_buckets_[hashes[i] + 1];
+    }
+  for (size_t b = 0; b < nbuckets; ++b)
+    this->armap_buckets_[b + 1] += this->armap_buckets_[b];
+
+  std::vector<unsigned int> next(this->armap_buckets_.begin(),
+				 this->armap_buckets_.end() - 1);
+  this->armap_index_.resize(armap_size);
+  for (size_t i = 0; i < armap_size; ++i)
+    this->armap_index_[next[hashes[i]]++] = i;
+}
+
+// Call F for each entry in the archive map whose symbol name, without
+// any version, is the LEN bytes at NAME.
+
+template<typename Function>
+void
+Archive::find_armap_entries(const char* name, size_t len, Function f) const
+{
+  size_t nbuckets = this->armap_buckets_.size() - 1;
+  size_t b = gold::string_hash<char>(name, len) & (nbuckets - 1);
+  for (unsigned int j = this->armap_buckets_[b];
+       j < this->armap_buckets_[b + 1];
+       ++j)
+    {
+      unsigned int i = this->armap_index_[j];
+      const char* armap_name = (this->armap_names_.data()
+				+ this->armap_[i].name_offset);
+      if (strncmp(armap_name, name, len) == 0
+	  && (armap_name[len] == '\0' || armap_name[len] == '@'))
+	f(i);
+    }
+}
+
+// A function object used to add entries to a set of archive map
+// entries to check.
+
+class Add_pending_armap_entry
+{
+ public:
+  Add_pending_armap_entry(const std::vector<bool>* checked,
+			  std::set<size_t>* pending)
+    : checked_(checked), pending_(pending)
+  { }
+
+  void
+  operator()(size_t i) const
+  {
+    if (!(*this->checked_)[i])
+      this->pending_->insert(i);
+  }
+
+ private:
+  const std::vector<bool>* checked_;
+  std::set<size_t>* pending_;
+};
+
+// Add to PENDING the entries in the archive map which have not been
+// checked and which name a global symbol of OBJ, which we just
+// included.  These are the only entries for which
+// should_include_member can now give a different answer.
+
+void
+Archive::add_pending_armap_entries(Object* obj, std::set<size_t>* pending)
+{
+  // We can not get the symbols of an object claimed by a plugin, so
+  // check all the entries again.
+  if (obj->pluginobj() != NULL)
+    {
+      const size_t armap_size = this->armap_.size();
+      for (size_t i = 0; i < armap_size; ++i)
+	if (!this->armap_checked_[i])
+	  pending->insert(pending->end(), i);
+      return;
+    }
+
+  const Object::Symbols* syms = obj->get_global_symbols();
+  if (syms == NULL)
+    return;
+
+  if (this->armap_buckets_.empty())
+    this->build_armap_index();
+
+  Add_pending_armap_entry add(&this->armap_checked_, pending);
+  for (Object::Symbols::const_iterator p = syms->begin();
+       p != syms->end();
+       ++p)
+    {
+      if (*p == NULL)
+	continue;
+      const char* name = (*p)->name();
+      this->find_armap_entries(name, strlen(name), add);
+    }
+}
+
 // Select members from the archive and add them to the link.  We walk
 // through the elements in the archive map, and look each one up in
 // the symbol table.  If it exists as a strong undefined symbol, we
-// pull in the corresponding element.  We have to do this in a loop,
-// since pulling in one element may create new undefined symbols which
-// may be satisfied by other objects in the archive.  Return true in
+// pull in the corresponding element.  Pulling in one element may
+// create new undefined symbols which may be satisfied by other
+// objects in the archive.  Rather than walking the whole archive map
+// again until nothing changes, we only look again at the entries
+// which name a symbol of an element we pulled in.  We check those in
+// archive map order, treating the entries after the one we just
+// checked as part of the current walk, so we pull in the same
+// elements in the same order as repeated walks would.  Return true in
 // the normal case, false if the first member we tried to add from
 // this archive had an incompatible target.
 
@@ -788,65 +912,79 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   // offset we saw that was present in the seen_offsets_ set.
   off_t last_seen_offset = -1;
 
-  // Track which symbols in the symbol table we've already found to be
-  // defined.
+  // The entries to check after the first walk.
+  std::set<size_t> pending;
+  bool first_walk = true;
+  size_t next = 0;
 
   char* tmpbuf = NULL;
   size_t tmpbuflen = 0;
-  bool added_new_object;
-  do
+  while (true)
     {
-      added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+      size_t i;
+      if (first_walk && next < armap_size)
+	i = next;
+      else
 	{
-          if (this->armap_checked_[i])
-            continue;
-	  if (this->armap_[i].file_offset == last_seen_offset)
-            {
-              this->armap_checked_[i] = true;
-              continue;
-            }
-	  if (this->seen_offsets_.find(this->armap_[i].file_offset)
-              != this->seen_offsets_.end())
-	    {
-              this->armap_checked_[i] = true;
-	      last_seen_offset = this->armap_[i].file_offset;
-	      continue;
-	    }
+	  first_walk = false;
+	  if (pending.empty())
+	    break;
+	  std::set<size_t>::iterator p = pending.lower_bound(next);
+	  if (p == pending.end())
+	    p = pending.begin();
+	  i = *p;
+	  pending.erase(p);
+	}
+      next = i + 1;
 
-	  const char* sym_name = (this->armap_names_.data()
-				  + this->armap_[i].name_offset);
+      if (this->armap_checked_[i])
+	continue;
+      if (this->armap_[i].file_offset == last_seen_offset)
+	{
+	  this->armap_checked_[i] = true;
+	  continue;
+	}
+      if (this->seen_offsets_.find(this->armap_[i].file_offset)
+	  != this->seen_offsets_.end())
+	{
+	  this->armap_checked_[i] = true;
+	  last_seen_offset = this->armap_[i].file_offset;
+	  continue;
+	}
 
-          Symbol* sym;
-          std::string why;
-          Archive::Should_include t =
-	    Archive::should_include_member(symtab, layout, sym_name, &sym,
-					   &why, &tmpbuf, &tmpbuflen);
+      const char* sym_name = (this->armap_names_.data()
+			      + this->armap_[i].name_offset);
 
-	  if (t == Archive::SHOULD_INCLUDE_NO
-              || t == Archive::SHOULD_INCLUDE_YES)
-	    this->armap_checked_[i] = true;
+      Symbol* sym;
+      std::string why;
+      Archive::Should_include t =
+	Archive::should_include_member(symtab, layout, sym_name, &sym,
+				       &why, &tmpbuf, &tmpbuflen);
 
-	  if (t != Archive::SHOULD_INCLUDE_YES)
-	    continue;
+      if (t == Archive::SHOULD_INCLUDE_NO
+	  || t == Archive::SHOULD_INCLUDE_YES)
+	this->armap_checked_[i] = true;
 
-	  // We want to include this object in the link.
-	  last_seen_offset = this->armap_[i].file_offset;
-	  this->seen_offsets_.insert(last_seen_offset);
+      if (t != Archive::SHOULD_INCLUDE_YES)
+	continue;
 
-	  if (!this->include_member(symtab, layout, input_objects,
-				    last_seen_offset, mapfile, sym,
-				    why.c_str()))
-	    {
-	      if (tmpbuf != NULL)
-		free(tmpbuf);
-	      return false;
-	    }
+      // We want to include this object in the link.
+      last_seen_offset = this->armap_[i].file_offset;
+      this->seen_offsets_.insert(last_seen_offset);
 
-	  added_new_object = true;
+      Object* obj = NULL;
+      if (!this->include_member(symtab, layout, input_objects,
+				last_seen_offset, mapfile, sym,
+				why.c_str(), &obj))
+	{
+	  if (tmpbuf != NULL)
+	    free(tmpbuf);
+	  return false;
 	}
+
+      if (obj != NULL)
+	this->add_pending_armap_entries(obj, &pending);
     }
-  while (added_new_object);
 
   if (tmpbuf != NULL)
     free(tmpbuf);
@@ -915,7 +1053,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->first,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -927,7 +1065,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->off,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -980,14 +1118,16 @@ class Thin_archive_object_unlocker
 
 // Include an archive member in the link.  OFF is the file offset of
 // the member header.  WHY is the reason we are including this member.
-// Return true if we added the member or if we had an error, return
-// false if this was the first member we tried to add from this
-// archive and it had an incompatible format.
+// If PINCLUDED is not NULL, set *PINCLUDED to the object if we added
+// it to the link.  Return true if we added the member or if we had an
+// error, return false if this was the first member we tried to add
+// from this archive and it had an incompatible format.
 
 bool
 Archive::include_member(Symbol_table* symtab, Layout* layout,
 			Input_objects* input_objects, off_t off,
-			Mapfile* mapfile, Symbol* sym, const char* why)
+			Mapfile* mapfile, Symbol* sym, const char* why,
+			Object** pincluded)
 {
   ++Archive::total_members_loaded;
 
@@ -1004,6 +1144,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
           obj->layout(symtab, layout, sd);
           obj->add_symbols(symtab, sd, layout);
 	  this->included_member_ = true;
+	  if (pincluded != NULL)
+	    *pincluded = obj;
         }
       delete sd;
       return true;
@@ -1038,6 +1180,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
     {
       pluginobj->add_symbols(symtab, NULL, layout);
       this->included_member_ = true;
+      if (pincluded != NULL)
+	*pincluded = pluginobj;
       return true;
     }
 
@@ -1058,6 +1202,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
   }
 
   this->included_member_ = true;
+  if (pincluded != NULL)
+    *pincluded = obj;
   return true;
 }
 
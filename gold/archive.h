@@ -23,6 +23,7 @@
 #ifndef GOLD_ARCHIVE_H
 #define GOLD_ARCHIVE_H
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -335,10 +336,26 @@ class Archive : public Library_base
   bool
   include_all_members(Symbol_table*, Layout*, Input_objects*, Mapfile*);
 
-  // Include an archive member in the link.
+  // Include an archive member in the link.  If PINCLUDED is not
+  // NULL, set *PINCLUDED to the object if it was added to the link.
   bool
   include_member(Symbol_table*, Layout*, Input_objects*, off_t off,
-		 Mapfile*, Symbol*, const char* why);
+		 Mapfile*, Symbol*, const char* why, Object** pincluded);
+
+  // Build the hash index of the archive map.
+  void
+  build_armap_index();
+
+  // Call F for the index in armap_ of each entry whose symbol name,
+  // without any version, is the LEN bytes at NAME.
+  template<typename Function>
+  void
+  find_armap_entries(const char* name, size_t len, Function f) const;
+
+  // Add to PENDING the entries in the archive map which have not been
+  // checked and which name a global symbol of OBJ.
+  void
+  add_pending_armap_entries(Object* obj, std::set<size_t>* pending);
 
   // Return whether we found this archive by searching a directory.
   bool
@@ -395,6 +412,13 @@ class Archive : public Library_base
   std::vector<bool> armap_checked_;
   // Track which elements have been included by offset.
   Unordered_set<off_t, Seen_hash> seen_offsets_;
+  // The hash index of the archive map, built by build_armap_index
+  // when first needed.  The entries whose symbol names hash to bucket
+  // B are armap_index_[armap_buckets_[B]] up to, but not including,
+  // armap_index_[armap_buckets_[B + 1]], in archive map order.  The
+  // hash ignores any version in the name.
+  std::vector<unsigned int> armap_buckets_;
+  std::vector<unsigned int> armap_index_;
   // Table of objects whose symbols have been pre-read.
   std::map<off_t, Archive_member> members_;
   // True if this is a thin archive.
@@ -2526,7 +2526,8 @@ class Target_arm : public Sized_target<32, big_endian>
   { return !parameters->options().relocatable(); }
 
   bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*);
 
   // Determine whether an object attribute tag takes an integer, a
   // string or both.
@@ -4386,6 +4387,16 @@ Target_arm<big_endian>::rel_dyn_section(Layout* layout)
       layout->add_output_section_data(".rel.dyn", elfcpp::SHT_REL,
 				      elfcpp::SHF_ALLOC, this->rel_irelative_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<32, big_endian>* relr =
+	    new Output_data_relr<32, big_endian>(elfcpp::R_ARM_RELATIVE);
+	  layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+					  elfcpp::SHF_ALLOC, relr,
+					  ORDER_DYNAMIC_RELOCS, false);
+	  this->rel_dyn_->set_relr_section(relr);
+	}
     }
   return this->rel_dyn_;
 }
@@ -12356,6 +12367,7 @@ Target_arm<big_endian>::do_relax(
     const Input_objects* input_objects,
     Symbol_table* symtab,
     Layout* layout,
+    Workqueue*,
     const Task* task)
 {
   // No need to generate stubs if this is a relocatable link.
@@ -0,0 +1,366 @@
+// call-graph.cc -- order sections using a call graph profile
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "object.h"
+#include "symtab.h"
+#include "call-graph.h"
+
+namespace gold
+{
+
+// We don't grow a cluster beyond this many bytes, since there is
+// little to gain from keeping callers and callees closer than this.
+
+static const uint64_t max_cluster_size = 1024 * 1024;
+
+// We don't merge two clusters if that would make the density of the
+// first one, in calls per byte, drop by more than this factor.
+
+static const uint64_t max_density_degradation = 8;
+
+// Read the call graph profile from FILENAME.  Blank lines and
+// anything after a '#' are ignored.  If a caller and callee appear
+// together on more than one line, the counts are added when the
+// sections are ordered.
+
+void
+Call_graph::read(const char* filename)
+{
+  std::ifstream in;
+  std::string line;
+
+  in.open(filename);
+  if (!in)
+    gold_fatal(_("unable to open --call-graph-ordering-file file %s: %s"),
+	       filename, strerror(errno));
+
+  unsigned int lineno = 0;
+  while (std::getline(in, line))
+    {
+      ++lineno;
+      std::string::size_type hash = line.find('#');
+      if (hash != std::string::npos)
+	line.resize(hash);
+
+      std::istringstream fields(line);
+      std::string caller;
+      std::string callee;
+      std::string count;
+      std::string extra;
+      if (!(fields >> caller))
+	continue;
+      if (!(fields >> callee >> count)
+	  || (fields >> extra)
+	  || count.find_first_not_of("0123456789") != std::string::npos)
+	{
+	  gold_error(_("%s:%u: expected caller, callee and count"),
+		     filename, lineno);
+	  continue;
+	}
+      uint64_t value = strtoull(count.c_str(), NULL, 10);
+      if (value == 0)
+	continue;
+
+      this->edges_.push_back(Edge(this->name_index(caller),
+				  this->name_index(callee),
+				  value));
+    }
+}
+
+// Return the index in names_ of NAME, adding it if it is new.
+
+unsigned int
+Call_graph::name_index(const std::string& name)
+{
+  std::pair<Unordered_map<std::string, unsigned int>::iterator, bool> ins =
+    this->name_indexes_.insert(std::make_pair(name, this->names_.size()));
+  if (ins.second)
+    this->names_.push_back(name);
+  return ins.first->second;
+}
+
+// A cluster of sections, used while ordering them.  Each section
+// starts in a cluster of its own.  The sections of a cluster form a
+// circular list, which is linked through the clusters of the
+// sections.  When one cluster is appended to another, the size and
+// weight of the appended cluster move to the one it joins.
+
+struct Call_graph_cluster
+{
+  Call_graph_cluster(const Section_id& a_section, uint64_t a_size)
+    : section(a_section), next(0), prev(0), size(a_size), weight(0),
+      initial_weight(0), best_pred(-1U), best_pred_weight(0)
+  { }
+
+  // The number of calls per byte.
+  double
+  density() const
+  {
+    if (this->size == 0)
+      return 0;
+    return static_cast<double>(this->weight) / this->size;
+  }
+
+  // The section which started in this cluster.
+  Section_id section;
+  // The next and previous sections in the circular list.
+  unsigned int next;
+  unsigned int prev;
+  // The total size of the sections in the cluster.
+  uint64_t size;
+  // The total number of calls into the sections of the cluster.
+  uint64_t weight;
+  // The number of calls into the section which started here.
+  uint64_t initial_weight;
+  // The section which calls this one most often, or -1U.
+  unsigned int best_pred;
+  // The number of calls from best_pred.
+  uint64_t best_pred_weight;
+};
+
+// Sort clusters by decreasing density, keeping the order in which we
+// found them for clusters of equal density.
+
+class Call_graph_density_compare
+{
+ public:
+  Call_graph_density_compare(const std::vector<Call_graph_cluster>& clusters)
+    : clusters_(clusters)
+  { }
+
+  bool
+  operator()(unsigned int i1, unsigned int i2) const
+  { return this->clusters_[i1].density() > this->clusters_[i2].density(); }
+
+ private:
+  const std::vector<Call_graph_cluster>& clusters_;
+};
+
+// Return the cluster which now holds the section which started in
+// cluster I.
+
+static unsigned int
+call_graph_leader(std::vector<unsigned int>* leaders, unsigned int i)
+{
+  unsigned int leader = i;
+  while ((*leaders)[leader] != leader)
+    leader = (*leaders)[leader];
+  while ((*leaders)[i] != leader)
+    {
+      unsigned int next = (*leaders)[i];
+      (*leaders)[i] = leader;
+      i = next;
+    }
+  return leader;
+}
+
+// Order the sections which define the functions in the profile.  We
+// build a graph whose nodes are sections, and whose edges are weighted
+// by the number of calls.  Edges between sections which go to
+// different output sections are ignored, since we can't move those
+// sections next to each other.  Then, in order of decreasing density,
+// we append each section's cluster to the cluster of its most frequent
+// caller, unless that would make the cluster too large or too sparse.
+// The clusters are finally laid out in order of decreasing density.
+
+void
+Call_graph::order_sections(const Task* task, const Symbol_table* symtab,
+			   Section_order* order) const
+{
+  // Find the section which defines each symbol.  Symbols which are
+  // not defined in a regular object, or whose section was discarded,
+  // are left out.
+  std::vector<Section_id> sections(this->names_.size(),
+				   Section_id(NULL, 0));
+  for (size_t i = 0; i < this->names_.size(); ++i)
+    {
+      const Symbol* sym = symtab->lookup(this->names_[i].c_str());
+      if (sym == NULL
+	  || sym->source() != Symbol::FROM_OBJECT
+	  || !sym->is_defined()
+	  || sym->object()->is_dynamic()
+	  || sym->object()->pluginobj() != NULL)
+	continue;
+      bool is_ordinary;
+      unsigned int shndx = sym->shndx(&is_ordinary);
+      if (!is_ordinary || shndx == elfcpp::SHN_UNDEF)
+	continue;
+      Relobj* relobj = static_cast<Relobj*>(sym->object());
+      if (relobj->output_section(shndx) == NULL)
+	continue;
+      sections[i] = Section_id(relobj, shndx);
+    }
+
+  // Make a cluster for each section, in the order we first see them,
+  // and add up the calls between each pair of sections.
+  std::vector<Call_graph_cluster> clusters;
+  Unordered_map<Section_id, unsigned int, Section_id_hash> cluster_indexes;
+  std::vector<Edge> edges;
+  Unordered_map<uint64_t, size_t> edge_indexes;
+  for (std::vector<Edge>::const_iterator p = this->edges_.begin();
+       p != this->edges_.end();
+       ++p)
+    {
+      const Section_id& from(sections[p->caller]);
+      const Section_id& to(sections[p->callee]);
+      if (from.first == NULL
+	  || to.first == NULL
+	  || (from.first->output_section(from.second)
+	      != to.first->output_section(to.second)))
+	continue;
+
+      unsigned int ends[2];
+      const Section_id* ids[2] = { &from, &to };
+      for (int j = 0; j < 2; ++j)
+	{
+	  std::pair<Unordered_map<Section_id, unsigned int,
+				  Section_id_hash>::iterator, bool> ins =
+	    cluster_indexes.insert(std::make_pair(*ids[j], clusters.size()));
+	  if (ins.second)
+	    {
+	      Relobj* relobj = ids[j]->first;
+	      Task_lock_obj<Object> tl(task, relobj);
+	      uint64_t size = relobj->section_size(ids[j]->second);
+	      unsigned int index = clusters.size();
+	      clusters.push_back(Call_graph_cluster(*ids[j], size));
+	      clusters.back().next = index;
+	      clusters.back().prev = index;
+	    }
+	  ends[j] = ins.first->second;
+	}
+
+      uint64_t key = (static_cast<uint64_t>(ends[0]) << 32) | ends[1];
+      std::pair<Unordered_map<uint64_t, size_t>::iterator, bool> ins =
+	edge_indexes.insert(std::make_pair(key, edges.size()));
+      if (ins.second)
+	edges.push_back(Edge(ends[0], ends[1], p->count));
+      else
+	edges[ins.first->second].count += p->count;
+    }
+
+  if (clusters.empty())
+    return;
+
+  // Find the most frequent caller of each section.  Calls of a
+  // section from itself count toward its weight, but it can't be its
+  // own caller.
+  for (std::vector<Edge>::const_iterator p = edges.begin();
+       p != edges.end();
+       ++p)
+    {
+      Call_graph_cluster& to(clusters[p->callee]);
+      to.weight += p->count;
+      if (p->caller == p->callee)
+	continue;
+      if (to.best_pred == -1U || to.best_pred_weight < p->count)
+	{
+	  to.best_pred = p->caller;
+	  to.best_pred_weight = p->count;
+	}
+    }
+  for (std::vector<Call_graph_cluster>::iterator p = clusters.begin();
+       p != clusters.end();
+       ++p)
+    p->initial_weight = p->weight;
+
+  const unsigned int nclusters = clusters.size();
+  std::vector<unsigned int> sorted(nclusters);
+  std::vector<unsigned int> leaders(nclusters);
+  for (unsigned int i = 0; i < nclusters; ++i)
+    {
+      sorted[i] = i;
+      leaders[i] = i;
+    }
+  std::stable_sort(sorted.begin(), sorted.end(),
+		   Call_graph_density_compare(clusters));
+
+  for (std::vector<unsigned int>::const_iterator p = sorted.begin();
+       p != sorted.end();
+       ++p)
+    {
+      unsigned int i = *p;
+      Call_graph_cluster& c(clusters[i]);
+
+      // Don't follow a caller which makes few of the calls.
+      if (c.best_pred == -1U || c.best_pred_weight * 10 <= c.initial_weight)
+	continue;
+
+      unsigned int pred = call_graph_leader(&leaders, c.best_pred);
+      if (pred == i)
+	continue;
+      Call_graph_cluster& pc(clusters[pred]);
+      if (c.size + pc.size > max_cluster_size)
+	continue;
+
+      // Don't let the density of the caller's cluster drop too much.
+      double new_density = (static_cast<double>(pc.weight + c.weight)
+			    / (pc.size + c.size));
+      if (new_density * max_density_degradation < pc.density())
+	continue;
+
+      // Append the sections of cluster I to those of PRED.
+      leaders[i] = pred;
+      unsigned int tail1 = pc.prev;
+      unsigned int tail2 = c.prev;
+      pc.prev = tail2;
+      clusters[tail2].next = pred;
+      c.prev = tail1;
+      clusters[tail1].next = i;
+      pc.size += c.size;
+      pc.weight += c.weight;
+      c.size = 0;
+      c.weight = 0;
+    }
+
+  // Lay out the clusters which are left, densest first.
+  std::vector<unsigned int> heads;
+  for (unsigned int i = 0; i < nclusters; ++i)
+    if (leaders[i] == i)
+      heads.push_back(i);
+  std::stable_sort(heads.begin(), heads.end(),
+		   Call_graph_density_compare(clusters));
+
+  unsigned int position = 1;
+  for (std::vector<unsigned int>::const_iterator p = heads.begin();
+       p != heads.end();
+       ++p)
+    {
+      unsigned int i = *p;
+      do
+	{
+	  (*order)[clusters[i].section] = position;
+	  ++position;
+	  i = clusters[i].next;
+	}
+      while (i != *p);
+    }
+}
+
+} // End namespace gold.
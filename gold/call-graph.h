@@ -0,0 +1,97 @@
+// call-graph.h -- order sections using a call graph profile  -*- C++ -*-
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_CALL_GRAPH_H
+#define GOLD_CALL_GRAPH_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "object.h"
+
+namespace gold
+{
+
+class Task;
+class Symbol_table;
+
+// This class holds the call graph profile read from the file named by
+// --call-graph-ordering-file.  Each line of the file names a caller,
+// a callee, and the number of calls, separated by white space.  Once
+// the symbols have been resolved, we use the profile to order the
+// sections which define the functions, so that functions which call
+// each other often are near each other in the output.  This is the
+// C3 heuristic used by hfsort, from "Optimizing Function Placement
+// for Large-Scale Data-Center Applications" by Ottoni and Maher.
+
+class Call_graph
+{
+ public:
+  // A map from a section to its position in the order.  This is the
+  // same as Output_section::Section_layout_order.
+  typedef std::map<Section_id, unsigned int> Section_order;
+
+  Call_graph()
+    : names_(), name_indexes_(), edges_()
+  { }
+
+  // Read the profile from FILENAME.
+  void
+  read(const char* filename);
+
+  // Find the sections which define the functions in the profile, and
+  // add them to *ORDER in the order that they should appear.  Each
+  // section is given a position starting at 1.  TASK is used to lock
+  // objects while we look at their section headers.
+  void
+  order_sections(const Task* task, const Symbol_table* symtab,
+		 Section_order* order) const;
+
+ private:
+  // An edge read from the profile, with the caller and callee given
+  // as indexes into names_.
+  struct Edge
+  {
+    Edge(unsigned int a_caller, unsigned int a_callee, uint64_t a_count)
+      : caller(a_caller), callee(a_callee), count(a_count)
+    { }
+
+    unsigned int caller;
+    unsigned int callee;
+    uint64_t count;
+  };
+
+  // Return the index in names_ of NAME, adding it if it is new.
+  unsigned int
+  name_index(const std::string& name);
+
+  // The symbol names in the profile.
+  std::vector<std::string> names_;
+  // Map a symbol name to its index in names_.
+  Unordered_map<std::string, unsigned int> name_indexes_;
+  // The edges in the profile, in the order they were read.
+  std::vector<Edge> edges_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_CALL_GRAPH_H)
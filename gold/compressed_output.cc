@@ -22,56 +22,158 @@
 
 #include "gold.h"
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "parameters.h"
 #include "options.h"
+#include "workqueue.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
-// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
-// if it successfully compressed, false if it failed for any reason
-// (including not having zlib support in the library).  If it returns
-// true, it allocates memory for the compressed data using new, and
-// sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.
-// It also writes a header before COMPRESSED_DATA: 4 bytes saying
-// "ZLIB", and 8 bytes indicating the uncompressed size, in big-endian
-// order.
+// Return the zlib compression level to use.
 
-static bool
-zlib_compress(int header_size,
-              const unsigned char* uncompressed_data,
-              unsigned long uncompressed_size,
-              unsigned char** compressed_data,
-              unsigned long* compressed_size)
+static int
+zlib_compress_level()
 {
-  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
-  *compressed_data = new unsigned char[*compressed_size + header_size];
-
-  int compress_level;
+  int level = parameters->options().compress_debug_sections_level();
+  if (level > 0)
+    return level < Z_BEST_COMPRESSION ? level : Z_BEST_COMPRESSION;
   if (parameters->options().optimize() >= 1)
-    compress_level = 9;
+    return 9;
   else
-    compress_level = 1;
-
-  int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
-                     compressed_size,
-                     reinterpret_cast<const Bytef*>(uncompressed_data),
-                     uncompressed_size,
-                     compress_level);
-  if (rc == Z_OK)
+    return 1;
+}
+
+// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE as raw deflate
+// data, without a zlib header or trailer.  DICTIONARY, of size
+// DICTIONARY_SIZE, is the uncompressed data which immediately
+// precedes UNCOMPRESSED_DATA in the stream; it may be empty.  If
+// IS_LAST is true this is the end of the stream; otherwise the data
+// is ended with a sync flush, so that it ends on a byte boundary and
+// may be followed by more raw deflate data.  Returns true if it
+// successfully compressed, false if it failed for any reason.  If it
+// returns true, it allocates memory for the compressed data using
+// new, and sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate
+// values.
+
+static bool
+zlib_compress_raw(const unsigned char* uncompressed_data,
+		  unsigned long uncompressed_size,
+		  const unsigned char* dictionary,
+		  unsigned long dictionary_size,
+		  bool is_last,
+		  unsigned char** compressed_data,
+		  unsigned long* compressed_size)
+{
+  z_stream strm;
+  strm.zalloc = NULL;
+  strm.zfree = NULL;
+  strm.opaque = NULL;
+
+  // A negative window size requests raw deflate data.
+  if (deflateInit2(&strm, zlib_compress_level(), Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  if (dictionary_size > 0
+      && deflateSetDictionary(&strm, const_cast<Bytef*>(dictionary),
+			      dictionary_size) != Z_OK)
     {
-      *compressed_size += header_size;
-      return true;
+      deflateEnd(&strm);
+      return false;
+    }
+
+  // deflateBound does not account for the empty stored block written
+  // by a sync flush.
+  unsigned long bound = deflateBound(&strm, uncompressed_size) + 16;
+  unsigned char* buf = new unsigned char[bound];
+
+  strm.next_in = const_cast<Bytef*>(uncompressed_data);
+  strm.avail_in = uncompressed_size;
+  strm.next_out = buf;
+  strm.avail_out = bound;
+
+  int rc = deflate(&strm, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool ok = (is_last
+	     ? rc == Z_STREAM_END
+	     : rc == Z_OK && strm.avail_in == 0 && strm.avail_out > 0);
+  unsigned long size = bound - strm.avail_out;
+  deflateEnd(&strm);
+
+  if (!ok)
+    {
+      delete[] buf;
+      return false;
     }
+
+  *compressed_data = buf;
+  *compressed_size = size;
+  return true;
+}
+
+#ifdef HAVE_ZSTD
+
+// Return the zstd compression level to use.
+
+static int
+zstd_compress_level()
+{
+  int level = parameters->options().compress_debug_sections_level();
+  if (level > 0)
+    return level < ZSTD_maxCLevel() ? level : ZSTD_maxCLevel();
+  if (parameters->options().optimize() >= 1)
+    return 9;
   else
+    return 3;
+}
+
+// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE as a single
+// zstd frame.  Concatenated zstd frames decompress as the
+// concatenation of their contents, so each chunk of a section can be
+// compressed independently.  Returns true if it successfully
+// compressed, in which case it allocates memory for the compressed
+// data using new, and sets *COMPRESSED_DATA and *COMPRESSED_SIZE.
+
+static bool
+zstd_compress(const unsigned char* uncompressed_data,
+	      unsigned long uncompressed_size,
+	      unsigned char** compressed_data,
+	      unsigned long* compressed_size)
+{
+  size_t bound = ZSTD_compressBound(uncompressed_size);
+  unsigned char* buf = new unsigned char[bound];
+  size_t rc = ZSTD_compress(buf, bound, uncompressed_data, uncompressed_size,
+			    zstd_compress_level());
+  if (ZSTD_isError(rc))
     {
-      delete[] *compressed_data;
-      *compressed_data = NULL;
+      delete[] buf;
       return false;
     }
+  *compressed_data = buf;
+  *compressed_size = rc;
+  return true;
+}
+
+// Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, which may hold
+// several zstd frames, into UNCOMPRESSED_DATA of size
+// UNCOMPRESSED_SIZE.  Returns true if it decompressed successfully.
+
+static bool
+zstd_decompress(const unsigned char* compressed_data,
+		unsigned long compressed_size,
+		unsigned char* uncompressed_data,
+		unsigned long uncompressed_size)
+{
+  size_t rc = ZSTD_decompress(uncompressed_data, uncompressed_size,
+			      compressed_data, compressed_size);
+  return !ZSTD_isError(rc) && rc == uncompressed_size;
 }
 
+#endif // defined(HAVE_ZSTD)
+
 // Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, into a buffer
 // UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns TRUE if it
 // decompressed successfully, false if it failed.  The buffer, of
@@ -148,20 +250,19 @@ decompress_input_section(const unsigned char* compressed_data,
   if ((sh_flags & elfcpp::SHF_COMPRESSED) != 0)
     {
       unsigned int compression_header_size;
+      elfcpp::Elf_Word ch_type;
       if (size == 32)
 	{
 	  compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<32, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<32, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else if (size == 64)
@@ -170,23 +271,34 @@ decompress_input_section(const unsigned char* compressed_data,
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<64, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<64, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else
 	gold_unreachable();
 
-      return zlib_decompress(compressed_data + compression_header_size,
-			     compressed_size - compression_header_size,
-			     uncompressed_data,
-			     uncompressed_size);
+      switch (ch_type)
+	{
+	case elfcpp::ELFCOMPRESS_ZLIB:
+	  return zlib_decompress(compressed_data + compression_header_size,
+				 compressed_size - compression_header_size,
+				 uncompressed_data,
+				 uncompressed_size);
+#ifdef HAVE_ZSTD
+	case elfcpp::ELFCOMPRESS_ZSTD:
+	  return zstd_decompress(compressed_data + compression_header_size,
+				 compressed_size - compression_header_size,
+				 uncompressed_data,
+				 uncompressed_size);
+#endif
+	default:
+	  return false;
+	}
     }
 
   const unsigned int zlib_header_size = 12;
@@ -209,36 +321,245 @@ decompress_input_section(const unsigned char* compressed_data,
   return false;
 }
 
+// A task to compress one chunk of an Output_compressed_section.
+
+class Compress_chunk_task : public Task
+{
+ public:
+  Compress_chunk_task(Output_compressed_section* os, size_t chunk,
+		      Task_token* final_blocker)
+    : os_(os), chunk_(chunk), final_blocker_(final_blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->os_->compress_chunk(this->chunk_); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  // Unblock FINAL_BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  std::string
+  get_name() const
+  { return "Compress_chunk_task " + std::string(this->os_->name()); }
+
+ private:
+  Output_compressed_section* os_;
+  const size_t chunk_;
+  Task_token* const final_blocker_;
+};
+
 // Class Output_compressed_section.
 
-// Set the final data size of a compressed section.  This is where
-// we actually compress the section data.
+Output_compressed_section::~Output_compressed_section()
+{
+  this->free_chunks();
+  if (this->data_ != NULL)
+    delete[] this->data_;
+}
+
+// Return whether we are compressing with zstd rather than zlib.
+
+bool
+Output_compressed_section::use_zstd() const
+{
+  return strcmp(this->options_->compress_debug_sections(), "zstd") == 0;
+}
+
+// At this point the contents of all regular input sections will have
+// been copied into the postprocessing buffer, and relocations will
+// have been applied.  Copy in the contents of anything other than a
+// regular input section, and split the buffer into chunks.
 
 void
-Output_compressed_section::set_final_data_size()
+Output_compressed_section::setup_chunks()
 {
+  gold_assert(this->chunks_.empty());
+
+  this->write_to_postprocessing_buffer();
+
   off_t uncompressed_size = this->postprocessing_buffer_size();
+  const off_t csize = chunk_size;
+  size_t count = (uncompressed_size + csize - 1) / csize;
+  if (count == 0)
+    count = 1;
+  this->chunks_.resize(count);
+}
 
-  // (Try to) compress the data.
-  unsigned long compressed_size;
-  unsigned char* uncompressed_data = this->postprocessing_buffer();
+// Queue the tasks to compress the section contents.
 
-  // At this point the contents of all regular input sections will
-  // have been copied into the postprocessing buffer, and relocations
-  // will have been applied.  Now we need to copy in the contents of
-  // anything other than a regular input section.
-  this->write_to_postprocessing_buffer();
+void
+Output_compressed_section::queue_compression_tasks(Workqueue* workqueue,
+						   Task_token* blocker)
+{
+  this->setup_chunks();
+  size_t count = this->chunks_.size();
+  blocker->add_blockers(count);
+  for (size_t i = 0; i < count; ++i)
+    workqueue->queue(new Compress_chunk_task(this, i, blocker));
+}
+
+// Compress chunk I.  Each chunk is primed with up to 32K of the
+// preceding uncompressed data, which is what the decompressor will
+// have in its window at that point, so that splitting the data into
+// chunks costs very little in compression ratio.
+
+void
+Output_compressed_section::compress_chunk(size_t i)
+{
+  gold_assert(i < this->chunks_.size());
+  Compressed_chunk* chunk = &this->chunks_[i];
+
+  const unsigned char* buffer = this->postprocessing_buffer();
+  const off_t uncompressed_size = this->postprocessing_buffer_size();
+  const off_t start = static_cast<off_t>(i) * chunk_size;
+  off_t len = uncompressed_size - start;
+  if (len > chunk_size)
+    len = chunk_size;
+  const off_t dictsize = start < 32768 ? start : 32768;
+  const bool is_last = i + 1 == this->chunks_.size();
+
+#ifdef HAVE_ZSTD
+  if (this->use_zstd())
+    {
+      chunk->ok = zstd_compress(buffer + start, len, &chunk->data,
+				&chunk->size);
+      return;
+    }
+#endif
+
+  chunk->adler = adler32(adler32(0, NULL, 0), buffer + start, len);
+  chunk->ok = zlib_compress_raw(buffer + start, len,
+				buffer + start - dictsize, dictsize,
+				is_last, &chunk->data, &chunk->size);
+}
+
+// Combine the compressed chunks into DATA_.  For zlib this is a zlib
+// stream: a two byte header, the raw deflate data, and the Adler-32
+// checksum of the uncompressed data in big-endian order.  This is the
+// same format produced by compress2.  For zstd this is simply the
+// sequence of zstd frames.
+
+bool
+Output_compressed_section::combine_chunks(int header_size,
+					  unsigned long* compressed_size)
+{
+  unsigned long size = 0;
+  for (std::vector<Compressed_chunk>::const_iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    {
+      if (!p->ok)
+	return false;
+      size += p->size;
+    }
 
+  if (this->use_zstd())
+    {
+      *compressed_size = header_size + size;
+      this->data_ = new unsigned char[*compressed_size];
+      unsigned char* pov = this->data_ + header_size;
+      for (std::vector<Compressed_chunk>::const_iterator p =
+	     this->chunks_.begin();
+	   p != this->chunks_.end();
+	   ++p)
+	{
+	  memcpy(pov, p->data, p->size);
+	  pov += p->size;
+	}
+      return true;
+    }
+
+  // The compression method is deflate with a 32K window, which is
+  // 0x78.  The second byte records the compression level, and is
+  // chosen so that the header is a multiple of 31.
+  const int level = zlib_compress_level();
+  const unsigned int cmf = 0x78;
+  unsigned int flg;
+  if (level < 2)
+    flg = 0 << 6;
+  else if (level < 6)
+    flg = 1 << 6;
+  else if (level == 6)
+    flg = 2 << 6;
+  else
+    flg = 3 << 6;
+  flg += 31 - (cmf * 256 + flg) % 31;
+
+  *compressed_size = header_size + 2 + size + 4;
+  this->data_ = new unsigned char[*compressed_size];
+  unsigned char* pov = this->data_ + header_size;
+  *pov++ = cmf;
+  *pov++ = flg;
+
+  unsigned long adler = adler32(0, NULL, 0);
+  const off_t uncompressed_size = this->postprocessing_buffer_size();
+  off_t start = 0;
+  for (std::vector<Compressed_chunk>::const_iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    {
+      memcpy(pov, p->data, p->size);
+      pov += p->size;
+      off_t len = uncompressed_size - start;
+      if (len > chunk_size)
+	len = chunk_size;
+      adler = adler32_combine(adler, p->adler, len);
+      start += len;
+    }
+  elfcpp::Swap_unaligned<32, true>::writeval(pov, adler);
+  pov += 4;
+  gold_assert(pov == this->data_ + *compressed_size);
+
+  return true;
+}
+
+// Free the compressed chunks.
+
+void
+Output_compressed_section::free_chunks()
+{
+  for (std::vector<Compressed_chunk>::iterator p = this->chunks_.begin();
+       p != this->chunks_.end();
+       ++p)
+    if (p->data != NULL)
+      delete[] p->data;
+  std::vector<Compressed_chunk>().swap(this->chunks_);
+}
+
+// Set the final data size of a compressed section.  This is where we
+// combine the compressed chunks.  If compression tasks were not
+// queued, we compress the chunks here.
+
+void
+Output_compressed_section::set_final_data_size()
+{
+  off_t uncompressed_size = this->postprocessing_buffer_size();
+
+  if (this->chunks_.empty())
+    {
+      this->setup_chunks();
+      for (size_t i = 0; i < this->chunks_.size(); ++i)
+	this->compress_chunk(i);
+    }
+
+  unsigned long compressed_size;
   bool success = false;
-  enum { none, gnu_zlib, gabi_zlib } compress;
+  enum { none, gnu_zlib, gabi_zlib, gabi_zstd } compress;
   int compression_header_size = 12;
   const int size = parameters->target().get_size();
   if (strcmp(this->options_->compress_debug_sections(), "zlib-gnu") == 0)
     compress = gnu_zlib;
   else if (strcmp(this->options_->compress_debug_sections(), "zlib-gabi") == 0
-	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0)
+	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0
+	   || this->use_zstd())
     {
-      compress = gabi_zlib;
+      compress = this->use_zstd() ? gabi_zstd : gabi_zlib;
       if (size == 32)
 	compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
       else if (size == 64)
@@ -249,14 +570,16 @@ Output_compressed_section::set_final_data_size()
   else
     compress = none;
   if (compress != none)
-    success = zlib_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
+    success = this->combine_chunks(compression_header_size, &compressed_size);
+  this->free_chunks();
   if (success)
     {
       elfcpp::Elf_Xword flags = this->flags();
-      if (compress == gabi_zlib)
+      if (compress == gabi_zlib || compress == gabi_zstd)
 	{
+	  const elfcpp::Elf_Word ch_type = (compress == gabi_zstd
+					    ? elfcpp::ELFCOMPRESS_ZSTD
+					    : elfcpp::ELFCOMPRESS_ZLIB);
 	  // Set the SHF_COMPRESSED bit.
 	  flags |= elfcpp::SHF_COMPRESSED;
 	  const bool is_big_endian = parameters->target().is_big_endian();
@@ -266,14 +589,14 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<32, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<32, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -283,7 +606,7 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<64, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		  // Clear the reserved field.
@@ -292,7 +615,7 @@ Output_compressed_section::set_final_data_size()
 	      else
 		{
 		  elfcpp::Chdr_write<64, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		  // Clear the reserved field.
@@ -317,7 +640,8 @@ Output_compressed_section::set_final_data_size()
     }
   else
     {
-      gold_warning(_("not compressing section data: zlib error"));
+      gold_warning(_("not compressing section data: %s error"),
+		   this->use_zstd() ? "zstd" : "zlib");
       gold_assert(this->data_ == NULL);
       this->set_data_size(uncompressed_size);
     }
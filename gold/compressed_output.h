@@ -29,6 +29,7 @@
 #define GOLD_COMPRESSED_OUTPUT_H
 
 #include <string>
+#include <vector>
 
 #include "output.h"
 
@@ -36,9 +37,11 @@ namespace gold
 {
 
 class General_options;
+class Workqueue;
+class Task_token;
 
-// Read the compression header of a compressed debug section and return
-// the uncompressed size.
+// Read the compression header of a .zdebug section and return the
+// uncompressed size.
 
 extern uint64_t
 get_uncompressed_size(const unsigned char*, section_size_type);
@@ -53,6 +56,15 @@ decompress_input_section(const unsigned char*, unsigned long, unsigned char*,
 // a regular Output_section which computes its contents into a buffer
 // and then postprocesses it.
 
+// The contents are compressed in independent chunks, so that the
+// chunks may be compressed in parallel.  For zlib each chunk is
+// compressed as raw deflate data, primed with the preceding
+// uncompressed data as a dictionary, and ended with a sync flush, so
+// that concatenating the chunks yields a single valid zlib stream.
+// For zstd each chunk is a separate zstd frame.  The chunk boundaries do
+// not depend on the number of threads, so the output is the same
+// however many threads are used.
+
 class Output_compressed_section : public Output_section
 {
  public:
@@ -60,9 +72,22 @@ class Output_compressed_section : public Output_section
 			    const char* name, elfcpp::Elf_Word flags,
 			    elfcpp::Elf_Xword type)
     : Output_section(name, flags, type),
-      options_(options)
+      options_(options), data_(NULL), chunks_()
   { this->set_requires_postprocessing(); }
 
+  ~Output_compressed_section();
+
+  // Queue a task to compress each chunk of the section contents.
+  // This must be called after all the input sections have been
+  // written to the postprocessing buffer.  Each task releases a
+  // blocker on BLOCKER when it completes.
+  void
+  queue_compression_tasks(Workqueue*, Task_token* blocker);
+
+  // Compress chunk I of the section contents.
+  void
+  compress_chunk(size_t i);
+
  protected:
   // Set the final data size.
   void
@@ -73,10 +98,51 @@ class Output_compressed_section : public Output_section
   do_write(Output_file*);
 
  private:
+  // The compressed form of one chunk of the section contents.
+  struct Compressed_chunk
+  {
+    Compressed_chunk()
+      : data(NULL), size(0), adler(0), ok(false)
+    { }
+
+    // The raw deflate data, allocated with new[].
+    unsigned char* data;
+    // The size of DATA in bytes.
+    unsigned long size;
+    // The Adler-32 checksum of the uncompressed chunk.
+    unsigned long adler;
+    // Whether the chunk was compressed successfully.
+    bool ok;
+  };
+
+  // The size of the uncompressed data in each chunk.
+  static const off_t chunk_size = 4 * 1024 * 1024;
+
+  // Return whether we are compressing with zstd rather than zlib.
+  bool
+  use_zstd() const;
+
+  // Finish writing the postprocessing buffer and split it into
+  // chunks.
+  void
+  setup_chunks();
+
+  // Combine the compressed chunks into a single zlib stream preceded
+  // by HEADER_SIZE bytes of space for a header.  Return false if any
+  // chunk could not be compressed.
+  bool
+  combine_chunks(int header_size, unsigned long* compressed_size);
+
+  // Free the compressed chunks.
+  void
+  free_chunks();
+
   // The options--this includes the compression type.
   const General_options* options_;
   // The compressed data.
   unsigned char* data_;
+  // The compressed chunks, before they are combined into DATA_.
+  std::vector<Compressed_chunk> chunks_;
   // The new section name if we do compress.
   std::string new_section_name_;
 };
@@ -28,6 +28,12 @@
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #include <vector>
 #include <algorithm>
@@ -45,6 +51,7 @@
 #include "compressed_output.h"
 #include "stringpool.h"
 #include "dwarf_reader.h"
+#include "workqueue.h"
 
 static void
 usage(FILE* fd, int) ATTRIBUTE_NORETURN;
@@ -99,29 +106,77 @@ struct Unit_set
   { }
 };
 
+// A compilation unit or type unit found in an input section.
+
+struct Dwo_unit
+{
+  // The offset and length of the unit within the input section.
+  section_offset_type offset;
+  section_size_type length;
+  // The DWO id of a compilation unit, or the signature of a type unit.
+  uint64_t signature;
+
+  Dwo_unit(section_offset_type o, section_size_type l, uint64_t s)
+    : offset(o), length(l), signature(s)
+  { }
+};
+typedef std::vector<Dwo_unit> Unit_list;
+
 // An input file.
 // This class may represent a .dwo file, a .dwp file
 // produced by an earlier run, or an executable file whose
 // debug section identifies a set of .dwo files to read.
 
+// A .dwo or .dwp file is packaged in three steps.  read() reads the
+// debug sections into memory, hashes the strings and finds the units,
+// without touching the output file, so that several files may be
+// read at once.  add_to_output() then adds the strings, sections and
+// units to the output file; this is done for each file in turn, in
+// the order of the input files, so that the output file does not
+// depend on the number of threads.  Finally, once the output file
+// has been laid out, write_contributions() copies the sections into
+// it, again for several files at once.
+
 class Dwo_file
 {
  public:
   Dwo_file(const char* name)
     : name_(name), obj_(NULL), input_file_(NULL), is_compressed_(),
-      sect_offsets_(), str_offset_map_()
-  { }
+      sect_offsets_(), str_offset_map_(), machine_(0), size_(0),
+      big_endian_(false), osabi_(0), abiversion_(0), contents_(),
+      debug_types_(), debug_str_(0), debug_cu_index_(0),
+      debug_tu_index_(0), strings_(), units_(), contributions_()
+  {
+    for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+      this->debug_shndx_[i] = 0;
+  }
 
   ~Dwo_file();
 
+  // Return the file name.
+  const char*
+  name() const
+  { return this->name_; }
+
   // Read the input executable file and extract the list of .dwo files
   // that it references.
   void
   read_executable(File_list* files);
 
-  // Read the input file and send its contents to OUTPUT_FILE.
+  // Read the debug sections of the input file into memory and find
+  // the strings and units.  This may be called for several files at
+  // once.
   void
-  read(Dwp_output_file* output_file);
+  read();
+
+  // Add the contents of the input file to OUTPUT_FILE.
+  void
+  add_to_output(Dwp_output_file* output_file);
+
+  // Copy the sections added by add_to_output into OUTPUT_FILE, which
+  // has been laid out.  This may be called for several files at once.
+  void
+  write_contributions(Dwp_output_file* output_file);
 
   // Verify a .dwp file given a list of .dwo files referenced by the
   // corresponding executable file.  Returns true if no problems
@@ -144,16 +199,47 @@ class Dwo_file
     { return i1.first < i2.first; }
   };
 
+  // The contents of a debug section, read into memory.
+  struct Section_contents
+  {
+    const unsigned char* data;
+    section_size_type len;
+
+    Section_contents()
+      : data(NULL), len(0)
+    { }
+  };
+
+  // A string in the input string table, with its hash code.
+  struct Input_string
+  {
+    section_offset_type offset;
+    size_t length;
+    size_t hash_code;
+  };
+
+  // A contribution of this file to an output section.
+  struct Contribution
+  {
+    elfcpp::DW_SECT section_id;
+    section_offset_type output_offset;
+    const unsigned char* contents;
+    section_size_type size;
+  };
+
   // Create a Sized_relobj_dwo of the given size and endianness,
   // and record the target info.  P is a pointer to the ELF header
   // in memory.
   Relobj*
-  make_object(Dwp_output_file* output_file);
+  make_object();
 
   template <int size, bool big_endian>
   Relobj*
-  sized_make_object(const unsigned char* p, Input_file* input_file,
-		    Dwp_output_file* output_file);
+  sized_make_object(const unsigned char* p, Input_file* input_file);
+
+  // Read the contents of a section into memory.
+  void
+  read_section_contents(unsigned int shndx);
 
   // Return the number of sections in the input object file.
   unsigned int
@@ -177,6 +263,15 @@ class Dwo_file
   section_contents(unsigned int shndx, section_size_type* plen, bool* is_new)
   { return this->obj_->decompressed_section_contents(shndx, plen, is_new); }
 
+  // Check the header of the .debug_cu_index or .debug_tu_index
+  // section of a .dwp file.
+  void
+  check_unit_index(unsigned int shndx);
+
+  template <bool big_endian>
+  void
+  sized_check_unit_index(unsigned int shndx);
+
   // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
   // and process the CU or TU sets.
   void
@@ -198,22 +293,36 @@ class Dwo_file
   bool
   sized_verify_dwo_list(unsigned int, const File_list& files);
 
+  // Find the strings in the input string table section and compute
+  // their hash codes.
+  void
+  read_strings();
+
   // Merge the input string table section into the output file.
   void
-  add_strings(Dwp_output_file*, unsigned int);
+  add_strings(Dwp_output_file*);
+
+  // Add a contribution to an output section, to be copied by
+  // write_contributions, and return its offset in the output section.
+  section_offset_type
+  add_contribution(Dwp_output_file* output_file, elfcpp::DW_SECT section_id,
+		   const unsigned char* contents, section_size_type len);
 
   // Copy a section from the input file to the output file.
   Section_bounds
   copy_section(Dwp_output_file* output_file, unsigned int shndx,
 	       elfcpp::DW_SECT section_id);
 
-  // Remap the string offsets in the .debug_str_offsets.dwo section.
-  const unsigned char*
-  remap_str_offsets(const unsigned char* contents, section_size_type len);
+  // Remap the string offsets in the .debug_str_offsets.dwo section,
+  // writing the result to REMAPPED.
+  void
+  remap_str_offsets(const unsigned char* contents, section_size_type len,
+		    unsigned char* remapped);
 
   template <bool big_endian>
-  const unsigned char*
-  sized_remap_str_offsets(const unsigned char* contents, section_size_type len);
+  void
+  sized_remap_str_offsets(const unsigned char* contents, section_size_type len,
+			  unsigned char* remapped);
 
   // Remap a single string offsets from an offset in the input string table
   // to an offset in the output string table.
@@ -221,10 +330,10 @@ class Dwo_file
   remap_str_offset(section_offset_type val);
 
   // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-  // to OUTPUT_FILE.
+  // to OUTPUT_FILE.  UNITS are the units in the section.
   void
   add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-	       bool is_debug_types);
+	       bool is_debug_types, const Unit_list& units);
 
   // The filename.
   const char* name_;
@@ -238,6 +347,29 @@ class Dwo_file
   std::vector<Section_bounds> sect_offsets_;
   // Map input string offsets to output string offsets.
   Str_offset_map str_offset_map_;
+  // The target info from the ELF header.
+  int machine_;
+  int size_;
+  bool big_endian_;
+  int osabi_;
+  int abiversion_;
+  // The contents of the debug sections, indexed by section index.
+  std::vector<Section_contents> contents_;
+  // The section indexes of the debug sections, indexed by DW_SECT.
+  unsigned int debug_shndx_[elfcpp::DW_SECT_MAX + 1];
+  // The section indexes of the .debug_types.dwo sections.
+  std::vector<unsigned int> debug_types_;
+  // The section indexes of the string table and the .dwp index sections.
+  unsigned int debug_str_;
+  unsigned int debug_cu_index_;
+  unsigned int debug_tu_index_;
+  // The strings in the input string table.
+  std::vector<Input_string> strings_;
+  // The units in the .debug_info.dwo section, followed by the units
+  // in each of the .debug_types.dwo sections.
+  std::vector<Unit_list> units_;
+  // The contributions to the output file, in the order they were added.
+  std::vector<Contribution> contributions_;
 };
 
 // An ELF input file.
@@ -449,8 +581,10 @@ class Dwp_output_file
  public:
   Dwp_output_file(const char* name)
     : name_(name), machine_(0), size_(0), big_endian_(false), osabi_(0),
-      abiversion_(0), fd_(NULL), next_file_offset_(0), shnum_(1), sections_(),
-      section_id_map_(), shoff_(0), shstrndx_(0), have_strings_(false),
+      abiversion_(0), fd_(-1), file_size_(0), view_(NULL),
+      view_is_allocated_(false), next_file_offset_(0), shnum_(1),
+      sections_(), section_id_map_(), shoff_(0), shstrndx_(0),
+      shstrtab_offset_(0), shstrtab_name_(NULL), have_strings_(false),
       stringpool_(), shstrtab_(), cu_index_(), tu_index_(), last_type_sig_(0),
       last_tu_slot_(0)
   {
@@ -463,14 +597,17 @@ class Dwp_output_file
   record_target_info(const char* name, int machine, int size, bool big_endian,
 		     int osabi, int abiversion);
 
-  // Add a string to the debug strings section.
+  // Add a string to the debug strings section.  HASH_CODE is the
+  // value that Stringpool::string_hash returns for STR.
   section_offset_type
-  add_string(const char* str, size_t len);
+  add_string(const char* str, size_t len, size_t hash_code);
 
-  // Add a section to the output file, and return the new section offset.
+  // Reserve space for a contribution of LEN bytes to an output section,
+  // and return its offset in the output section.  The contents are
+  // copied in by the input file once the output file has been laid out.
   section_offset_type
-  add_contribution(elfcpp::DW_SECT section_id, const unsigned char* contents,
-		   section_size_type len, int align);
+  add_contribution(elfcpp::DW_SECT section_id, section_size_type len,
+		   int align);
 
   // Add a set of .debug_info and related sections to the output file.
   void
@@ -484,20 +621,23 @@ class Dwp_output_file
   void
   add_tu_set(Unit_set* tu_set);
 
+  // Lay out the string tables, the index sections and the section
+  // header table, and create and map the output file.
+  void
+  layout();
+
+  // Return a pointer to LEN bytes at OFFSET within the output section
+  // for SECTION_ID, in the mapped output file.
+  unsigned char*
+  contribution_view(elfcpp::DW_SECT section_id, section_offset_type offset,
+		    section_size_type len);
+
   // Finalize the file, write the string tables and index sections,
   // and close the file.
   void
   finalize();
 
  private:
-  // Contributions to output sections.
-  struct Contribution
-  {
-    section_offset_type output_offset;
-    section_size_type size;
-    const unsigned char* contents;
-  };
-
   // Sections in the output file.
   struct Section
   {
@@ -505,10 +645,12 @@ class Dwp_output_file
     off_t offset;
     section_size_type size;
     int align;
-    std::vector<Contribution> contributions;
+    // The contents of a section created by the output file itself,
+    // which are written by finalize().
+    unsigned char* contents;
 
     Section(const char* n, int a)
-      : name(n), offset(0), size(0), align(a), contributions()
+      : name(n), offset(0), size(0), align(a), contents(NULL)
     { }
   };
 
@@ -605,41 +747,52 @@ class Dwp_output_file
   unsigned int
   add_output_section(const char* section_name, int align);
 
-  // Write a new section to the output file.
+  // Assign a file offset to SECT, following the sections laid out
+  // so far.
   void
-  write_new_section(const char* section_name, const unsigned char* contents,
-		    section_size_type len, int align);
+  assign_section_offset(Section* sect);
 
-  // Write the ELF header.
+  // Add a new section with the given contents to the output file,
+  // taking ownership of CONTENTS.
   void
-  write_ehdr();
+  add_new_section(const char* section_name, unsigned char* contents,
+		  section_size_type len, int align);
 
-  template<unsigned int size, bool big_endian>
+  // Create the output file with size FILE_SIZE and map it.
   void
-  sized_write_ehdr();
+  open_output_file(off_t file_size);
 
-  // Write a section header.
+  // Unmap and close the output file.
   void
-  write_shdr(const char* name, unsigned int type, unsigned int flags,
-	     uint64_t addr, off_t offset, section_size_type sect_size,
-	     unsigned int link, unsigned int info,
-	     unsigned int align, unsigned int ent_size);
+  close_output_file();
 
-  template<unsigned int size, bool big_endian>
+  // Write the ELF header.
   void
-  sized_write_shdr(const char* name, unsigned int type, unsigned int flags,
-		   uint64_t addr, off_t offset, section_size_type sect_size,
-		   unsigned int link, unsigned int info,
-		   unsigned int align, unsigned int ent_size);
+  write_ehdr();
 
-  // Write the contributions to an output section.
+  template<unsigned int size, bool big_endian>
   void
-  write_contributions(const Section& sect);
+  sized_write_ehdr();
 
-  // Write a CU or TU index section.
+  // Write a section header at POV, and return a pointer past it.
+  unsigned char*
+  write_shdr(unsigned char* pov, const char* name, unsigned int type,
+	     unsigned int flags, uint64_t addr, off_t offset,
+	     section_size_type sect_size, unsigned int link,
+	     unsigned int info, unsigned int align, unsigned int ent_size);
+
+  template<unsigned int size, bool big_endian>
+  unsigned char*
+  sized_write_shdr(unsigned char* pov, const char* name, unsigned int type,
+		   unsigned int flags, uint64_t addr, off_t offset,
+		   section_size_type sect_size, unsigned int link,
+		   unsigned int info, unsigned int align,
+		   unsigned int ent_size);
+
+  // Add a CU or TU index section.
   template<bool big_endian>
   void
-  write_index(const char* sect_name, const Dwp_index& index);
+  add_index(const char* sect_name, const Dwp_index& index);
 
   // The output filename.
   const char* name_;
@@ -650,7 +803,13 @@ class Dwp_output_file
   int osabi_;
   int abiversion_;
   // The output file descriptor.
-  FILE* fd_;
+  int fd_;
+  // The size of the output file.
+  off_t file_size_;
+  // The mapped output file.
+  unsigned char* view_;
+  // Whether VIEW_ was allocated because the file could not be mapped.
+  bool view_is_allocated_;
   // Next available file offset.
   off_t next_file_offset_;
   // The number of sections.
@@ -663,6 +822,10 @@ class Dwp_output_file
   off_t shoff_;
   // Section index of the section string table.
   unsigned int shstrndx_;
+  // File offset of the section string table.
+  off_t shstrtab_offset_;
+  // The name of the section string table, in the section string table.
+  const char* shstrtab_name_;
   // TRUE if we have added any strings to the string pool.
   bool have_strings_;
   // String pool for the output .debug_str.dwo section.
@@ -711,23 +874,23 @@ class Dwo_name_info_reader : public Dwarf_info_reader
   File_list* files_;
 };
 
-// A specialization of Dwarf_info_reader, for reading DWARF CUs and TUs
-// and adding them to the output file.
+// A specialization of Dwarf_info_reader, for finding the DWARF CUs
+// and TUs in a section.
 
 class Unit_reader : public Dwarf_info_reader
 {
  public:
   Unit_reader(bool is_type_unit, Relobj* object, unsigned int shndx)
     : Dwarf_info_reader(is_type_unit, object, NULL, 0, shndx, 0, 0),
-      output_file_(NULL), sections_(NULL)
+      units_(NULL)
   { }
 
   ~Unit_reader()
   { }
 
-  // Read the CUs or TUs and add them to the output file.
+  // Read the CUs or TUs and add them to UNITS.
   void
-  add_units(Dwp_output_file*, unsigned int debug_abbrev, Section_bounds*);
+  read_units(unsigned int debug_abbrev, Unit_list* units);
 
  protected:
   // Visit a compilation unit.
@@ -740,8 +903,7 @@ class Unit_reader : public Dwarf_info_reader
 		  uint64_t signature, Dwarf_die*);
 
  private:
-  Dwp_output_file* output_file_;
-  Section_bounds* sections_;
+  Unit_list* units_;
 };
 
 // Return the name of a DWARF .dwo section.
@@ -832,6 +994,8 @@ Dwo_file::~Dwo_file()
     delete this->obj_;
   if (this->input_file_ != NULL)
     delete this->input_file_;
+  for (unsigned int i = 0; i < this->contents_.size(); ++i)
+    delete[] this->contents_[i].data;
 }
 
 // Read the input executable file and extract the list of .dwo files
@@ -840,7 +1004,7 @@ Dwo_file::~Dwo_file()
 void
 Dwo_file::read_executable(File_list* files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -880,25 +1044,19 @@ Dwo_file::read_executable(File_list* files)
     }
 }
 
-// Read the input file and send its contents to OUTPUT_FILE.
+// Read the debug sections of the input file into memory, find the
+// strings in the string table and compute their hash codes, and find
+// the units in a .dwo file.  Then close the input file.
 
 void
-Dwo_file::read(Dwp_output_file* output_file)
+Dwo_file::read()
 {
-  this->obj_ = this->make_object(output_file);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
   this->sect_offsets_.resize(shnum);
-
-  typedef std::vector<unsigned int> Types_list;
-  Types_list debug_types;
-  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
-  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
-    debug_shndx[i] = 0;
-  unsigned int debug_str = 0;
-  unsigned int debug_cu_index = 0;
-  unsigned int debug_tu_index = 0;
+  this->contents_.resize(shnum);
 
   // Scan the section table and collect debug sections.
   // (Section index 0 is a dummy section; skip it.)
@@ -918,63 +1076,144 @@ Dwo_file::read(Dwp_output_file* output_file)
       else
 	continue;
       if (strcmp(suffix, "info.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_INFO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_INFO] = i;
       else if (strcmp(suffix, "types.dwo") == 0)
-	debug_types.push_back(i);
+	this->debug_types_.push_back(i);
       else if (strcmp(suffix, "abbrev.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_ABBREV] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_ABBREV] = i;
       else if (strcmp(suffix, "line.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_LINE] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_LINE] = i;
       else if (strcmp(suffix, "loc.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_LOC] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_LOC] = i;
       else if (strcmp(suffix, "str.dwo") == 0)
-	debug_str = i;
+	this->debug_str_ = i;
       else if (strcmp(suffix, "str_offsets.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_STR_OFFSETS] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_STR_OFFSETS] = i;
       else if (strcmp(suffix, "macinfo.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_MACINFO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_MACINFO] = i;
       else if (strcmp(suffix, "macro.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_MACRO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_MACRO] = i;
       else if (strcmp(suffix, "cu_index") == 0)
-	debug_cu_index = i;
+	this->debug_cu_index_ = i;
       else if (strcmp(suffix, "tu_index") == 0)
-	debug_tu_index = i;
+	this->debug_tu_index_ = i;
+      else
+	continue;
+      this->read_section_contents(i);
     }
 
+  // Find the strings in the input string table.
+  this->read_strings();
+
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
+    {
+      // This is a .dwp file.  The units are found from the index
+      // sections when they are added to the output file.
+      if (this->debug_cu_index_ > 0)
+	this->check_unit_index(this->debug_cu_index_);
+      if (this->debug_tu_index_ > 0)
+	{
+	  if (this->debug_types_.size() > 1)
+	    gold_fatal(_("%s: .dwp file must have no more than one "
+			 ".debug_types.dwo section"), this->name_);
+	  this->check_unit_index(this->debug_tu_index_);
+	}
+    }
+  else
+    {
+      // This is a .dwo file.  Find the units in the .debug_info.dwo
+      // and .debug_types.dwo sections.
+      unsigned int debug_info = this->debug_shndx_[elfcpp::DW_SECT_INFO];
+      unsigned int debug_abbrev = this->debug_shndx_[elfcpp::DW_SECT_ABBREV];
+      if ((debug_info > 0 || !this->debug_types_.empty())
+	  && debug_abbrev == 0)
+	gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
+
+      this->units_.resize(this->debug_types_.size() + 1);
+      if (debug_info > 0)
+	{
+	  Unit_reader reader(false, this->obj_, debug_info);
+	  reader.read_units(debug_abbrev, &this->units_[0]);
+	}
+      for (unsigned int i = 0; i < this->debug_types_.size(); ++i)
+	{
+	  Unit_reader reader(true, this->obj_, this->debug_types_[i]);
+	  reader.read_units(debug_abbrev, &this->units_[i + 1]);
+	}
+    }
+
+  // We have everything we need in memory, so close the input file.
+  delete this->obj_;
+  this->obj_ = NULL;
+  delete this->input_file_;
+  this->input_file_ = NULL;
+}
+
+// Add the contents of the input file to OUTPUT_FILE.
+
+void
+Dwo_file::add_to_output(Dwp_output_file* output_file)
+{
+  output_file->record_target_info(this->name_, this->machine_, this->size_,
+				  this->big_endian_, this->osabi_,
+				  this->abiversion_);
+
+  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
+  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+    debug_shndx[i] = this->debug_shndx_[i];
+
   // Merge the input string table into the output string table.
-  this->add_strings(output_file, debug_str);
+  this->add_strings(output_file);
 
   // If we found any .dwp index sections, read those and add the section
   // sets to the output file.
-  if (debug_cu_index > 0 || debug_tu_index > 0)
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
     {
-      if (debug_cu_index > 0)
-	this->read_unit_index(debug_cu_index, debug_shndx, output_file, false);
-      if (debug_tu_index > 0)
+      if (this->debug_cu_index_ > 0)
+	this->read_unit_index(this->debug_cu_index_, debug_shndx, output_file,
+			      false);
+      if (this->debug_tu_index_ > 0)
         {
-	  if (debug_types.size() > 1)
-	    gold_fatal(_("%s: .dwp file must have no more than one "
-			 ".debug_types.dwo section"), this->name_);
-          if (debug_types.size() == 1)
-            debug_shndx[elfcpp::DW_SECT_TYPES] = debug_types[0];
+          if (this->debug_types_.size() == 1)
+            debug_shndx[elfcpp::DW_SECT_TYPES] = this->debug_types_[0];
           else
             debug_shndx[elfcpp::DW_SECT_TYPES] = 0;
-	  this->read_unit_index(debug_tu_index, debug_shndx, output_file, true);
+	  this->read_unit_index(this->debug_tu_index_, debug_shndx,
+				output_file, true);
 	}
       return;
     }
 
   // If we found no index sections, this is a .dwo file.
   if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
-    this->add_unit_set(output_file, debug_shndx, false);
+    this->add_unit_set(output_file, debug_shndx, false, this->units_[0]);
 
   debug_shndx[elfcpp::DW_SECT_INFO] = 0;
-  for (Types_list::const_iterator tp = debug_types.begin();
-       tp != debug_types.end();
-       ++tp)
+  for (unsigned int i = 0; i < this->debug_types_.size(); ++i)
     {
-      debug_shndx[elfcpp::DW_SECT_TYPES] = *tp;
-      this->add_unit_set(output_file, debug_shndx, true);
+      debug_shndx[elfcpp::DW_SECT_TYPES] = this->debug_types_[i];
+      this->add_unit_set(output_file, debug_shndx, true,
+			 this->units_[i + 1]);
+    }
+}
+
+// Copy the contributions of this file into the output file.  The
+// .debug_str_offsets.dwo section is remapped to the output string
+// table as it is copied.
+
+void
+Dwo_file::write_contributions(Dwp_output_file* output_file)
+{
+  for (unsigned int i = 0; i < this->contributions_.size(); ++i)
+    {
+      const Contribution& c(this->contributions_[i]);
+      unsigned char* view = output_file->contribution_view(c.section_id,
+							   c.output_offset,
+							   c.size);
+      if (c.section_id == elfcpp::DW_SECT_STR_OFFSETS)
+	this->remap_str_offsets(c.contents, c.size, view);
+      else
+	memcpy(view, c.contents, c.size);
     }
 }
 
@@ -985,7 +1224,7 @@ Dwo_file::read(Dwp_output_file* output_file)
 bool
 Dwo_file::verify(const File_list& files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -1024,7 +1263,7 @@ Dwo_file::verify(const File_list& files)
 // and record the target info.
 
 Relobj*
-Dwo_file::make_object(Dwp_output_file* output_file)
+Dwo_file::make_object()
 {
   // Open the input file.
   Input_file* input_file = new Input_file(this->name_);
@@ -1058,15 +1297,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_32_BIG
-	return this->sized_make_object<32, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<32, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_32_LITTLE
-	return this->sized_make_object<32, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<32, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1075,15 +1312,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_64_BIG
-	return this->sized_make_object<64, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<64, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_64_LITTLE
-	return this->sized_make_object<64, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<64, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1097,29 +1332,120 @@ Dwo_file::make_object(Dwp_output_file* output_file)
 
 template <int size, bool big_endian>
 Relobj*
-Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
-			    Dwp_output_file* output_file)
+Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file)
 {
   elfcpp::Ehdr<size, big_endian> ehdr(p);
   Sized_relobj_dwo<size, big_endian>* obj =
       new Sized_relobj_dwo<size, big_endian>(this->name_, input_file, ehdr);
   obj->setup();
-  if (output_file != NULL)
-    output_file->record_target_info(
-	this->name_, ehdr.get_e_machine(), size, big_endian,
-	ehdr.get_e_ident()[elfcpp::EI_OSABI],
-	ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
+  this->machine_ = ehdr.get_e_machine();
+  this->size_ = size;
+  this->big_endian_ = big_endian;
+  this->osabi_ = ehdr.get_e_ident()[elfcpp::EI_OSABI];
+  this->abiversion_ = ehdr.get_e_ident()[elfcpp::EI_ABIVERSION];
   return obj;
 }
 
+// Read the contents of a section into memory, decompressing them if
+// necessary, so that they remain available after the input file has
+// been closed.
+
+void
+Dwo_file::read_section_contents(unsigned int shndx)
+{
+  section_size_type len;
+  bool is_new;
+  const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
+  if (!is_new)
+    {
+      unsigned char* copy = new unsigned char[len];
+      memcpy(copy, contents, len);
+      contents = copy;
+    }
+  this->contents_[shndx].data = contents;
+  this->contents_[shndx].len = len;
+}
+
+// Check the header of the .debug_cu_index or .debug_tu_index section
+// of a .dwp file.
+
+void
+Dwo_file::check_unit_index(unsigned int shndx)
+{
+  if (this->obj_->is_big_endian())
+    this->sized_check_unit_index<true>(shndx);
+  else
+    this->sized_check_unit_index<false>(shndx);
+}
+
+template <bool big_endian>
+void
+Dwo_file::sized_check_unit_index(unsigned int shndx)
+{
+  gold_assert(shndx > 0);
+
+  const unsigned char* contents = this->contents_[shndx].data;
+  section_size_type index_len = this->contents_[shndx].len;
+
+  if (index_len < 4 * sizeof(uint32_t))
+    gold_fatal(_("%s: section %s is corrupt"), this->name_,
+	       this->section_name(shndx).c_str());
+
+  unsigned int version =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(contents);
+
+  // We don't support version 1 anymore because it was experimental
+  // and because in normal use, dwp is not expected to read .dwp files
+  // produced by an earlier version of the tool.
+  if (version != 2)
+    gold_fatal(_("%s: section %s has unsupported version number %d"),
+	       this->name_, this->section_name(shndx).c_str(), version);
+
+  unsigned int ncols =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(contents
+						      + sizeof(uint32_t));
+  unsigned int nused =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(contents
+						      + 2 * sizeof(uint32_t));
+  if (ncols == 0 || nused == 0)
+    return;
+
+  unsigned int nslots =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(contents
+						      + 3 * sizeof(uint32_t));
+
+  const unsigned char* phash = contents + 4 * sizeof(uint32_t);
+  const unsigned char* pindex = phash + nslots * sizeof(uint64_t);
+  const unsigned char* pcolhdrs = pindex + nslots * sizeof(uint32_t);
+  const unsigned char* poffsets = pcolhdrs + ncols * sizeof(uint32_t);
+  const unsigned char* psizes = poffsets + nused * ncols * sizeof(uint32_t);
+  const unsigned char* pend = psizes + nused * ncols * sizeof(uint32_t);
+
+  if (pend > contents + index_len)
+    gold_fatal(_("%s: section %s is corrupt"), this->name_,
+	       this->section_name(shndx).c_str());
+
+  // Check the section numbers in the column headers.
+  for (unsigned int j = 0; j < ncols; j++)
+    {
+      unsigned int dw_sect =
+	  elfcpp::Swap_unaligned<32, big_endian>::readval(pcolhdrs);
+      if (dw_sect < elfcpp::DW_SECT_INFO || dw_sect > elfcpp::DW_SECT_MAX)
+	gold_fatal(_("%s: section %s is corrupt"), this->name_,
+		   this->section_name(shndx).c_str());
+      pcolhdrs += sizeof(uint32_t);
+    }
+}
+
 // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
-// and process the CU or TU sets.
+// and process the CU or TU sets.  The section was checked by
+// check_unit_index.
 
 void
 Dwo_file::read_unit_index(unsigned int shndx, unsigned int *debug_shndx,
 			  Dwp_output_file* output_file, bool is_tu_index)
 {
-  if (this->obj_->is_big_endian())
+  if (this->big_endian_)
     this->sized_read_unit_index<true>(shndx, debug_shndx, output_file,
 				      is_tu_index);
   else
@@ -1141,20 +1467,7 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 
   gold_assert(shndx > 0);
 
-  section_size_type index_len;
-  bool index_is_new;
-  const unsigned char* contents =
-      this->section_contents(shndx, &index_len, &index_is_new);
-
-  unsigned int version =
-      elfcpp::Swap_unaligned<32, big_endian>::readval(contents);
-
-  // We don't support version 1 anymore because it was experimental
-  // and because in normal use, dwp is not expected to read .dwp files
-  // produced by an earlier version of the tool.
-  if (version != 2)
-    gold_fatal(_("%s: section %s has unsupported version number %d"),
-	       this->name_, this->section_name(shndx).c_str(), version);
+  const unsigned char* contents = this->contents_[shndx].data;
 
   unsigned int ncols =
       elfcpp::Swap_unaligned<32, big_endian>::readval(contents
@@ -1176,11 +1489,6 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
   const unsigned char* pcolhdrs = pindex + nslots * sizeof(uint32_t);
   const unsigned char* poffsets = pcolhdrs + ncols * sizeof(uint32_t);
   const unsigned char* psizes = poffsets + nused * ncols * sizeof(uint32_t);
-  const unsigned char* pend = psizes + nused * ncols * sizeof(uint32_t);
-
-  if (pend > contents + index_len)
-    gold_fatal(_("%s: section %s is corrupt"), this->name_,
-	       this->section_name(shndx).c_str());
 
   // Copy the related sections and track the section offsets and sizes.
   Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
@@ -1192,10 +1500,7 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
     }
 
   // Get the contents of the .debug_info.dwo or .debug_types.dwo section.
-  section_size_type info_len;
-  bool info_is_new;
-  const unsigned char* info_contents =
-      this->section_contents(info_shndx, &info_len, &info_is_new);
+  const unsigned char* info_contents = this->contents_[info_shndx].data;
 
   // Loop over the slots of the hash table.
   for (unsigned int i = 0; i < nslots; ++i)
@@ -1216,14 +1521,14 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 
 	  // Adjust the offset of each contribution within the input section
 	  // by the offset of the input section within the output section.
-	  for (unsigned int j = 0; j <= ncols; j++)
+	  for (unsigned int j = 0; j < ncols; j++)
 	    {
 	      unsigned int dw_sect =
-		  elfcpp::Swap_unaligned<64, big_endian>::readval(pch);
+		  elfcpp::Swap_unaligned<32, big_endian>::readval(pch);
 	      unsigned int offset =
-		  elfcpp::Swap_unaligned<64, big_endian>::readval(porow);
+		  elfcpp::Swap_unaligned<32, big_endian>::readval(porow);
 	      unsigned int size =
-		  elfcpp::Swap_unaligned<64, big_endian>::readval(psrow);
+		  elfcpp::Swap_unaligned<32, big_endian>::readval(psrow);
 	      unit_set->sections[dw_sect].offset = (sections[dw_sect].offset
 						    + offset);
 	      unit_set->sections[dw_sect].size = size;
@@ -1236,18 +1541,9 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 	      info_contents + unit_set->sections[info_sect].offset;
 	  section_size_type unit_length = unit_set->sections[info_sect].size;
 
-	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
-	  // section directly to the output file, so we only need to
-	  // duplicate contributions for .debug_types.dwo section.
-	  if (is_tu_index)
-	    {
-	      unsigned char *copy = new unsigned char[unit_length];
-	      memcpy(copy, unit_start, unit_length);
-	      unit_start = copy;
-	    }
 	  section_offset_type off =
-	      output_file->add_contribution(info_sect, unit_start,
-					    unit_length, 1);
+	      this->add_contribution(output_file, info_sect, unit_start,
+				     unit_length);
 	  unit_set->sections[info_sect].offset = off;
 	  if (is_tu_index)
 	    output_file->add_tu_set(unit_set);
@@ -1257,11 +1553,6 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
       phash += sizeof(uint64_t);
       pindex += sizeof(uint32_t);
     }
-
-  if (index_is_new)
-    delete[] contents;
-  if (info_is_new)
-    delete[] info_contents;
 }
 
 // Verify the .debug_cu_index section of a .dwp file, comparing it
@@ -1360,52 +1651,86 @@ Dwo_file::sized_verify_dwo_list(unsigned int shndx, const File_list& files)
   return nmissing == 0;
 }
 
-// Merge the input string table section into the output file.
+// Find the strings in the input string table section, and compute
+// their hash codes, so that they can be added to the output string
+// table quickly.
 
 void
-Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
+Dwo_file::read_strings()
 {
-  section_size_type len;
-  bool is_new;
-  const unsigned char* pdata = this->section_contents(debug_str, &len, &is_new);
-  const char* p = reinterpret_cast<const char*>(pdata);
-  const char* pend = p + len;
+  if (this->debug_str_ == 0)
+    return;
+
+  const Section_contents& sc(this->contents_[this->debug_str_]);
+  if (sc.len == 0)
+    return;
+  const char* p = reinterpret_cast<const char*>(sc.data);
+  const char* pend = p + sc.len;
 
   // Check that the last string is null terminated.
   if (pend[-1] != '\0')
     gold_fatal(_("%s: last entry in string section '%s' "
 		 "is not null terminated"),
 	       this->name_,
-	       this->section_name(debug_str).c_str());
-
-  // Count the number of strings in the section, and size the map.
-  size_t count = 0;
-  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
-    ++count;
-  this->str_offset_map_.reserve(count + 1);
+	       this->section_name(this->debug_str_).c_str());
 
-  // Add the strings to the output string table, and record the new offsets
-  // in the map.
   section_offset_type i = 0;
-  section_offset_type new_offset;
   while (p < pend)
     {
       size_t len = strlen(p);
-      new_offset = output_file->add_string(p, len);
-      this->str_offset_map_.push_back(std::make_pair(i, new_offset));
+      Input_string s = { i, len, Stringpool::string_hash(p, len) };
+      this->strings_.push_back(s);
       p += len + 1;
       i += len + 1;
     }
+}
+
+// Merge the input string table section into the output file.
+
+void
+Dwo_file::add_strings(Dwp_output_file* output_file)
+{
+  const char* p =
+      reinterpret_cast<const char*>(this->contents_[this->debug_str_].data);
+
+  // Add the strings to the output string table, and record the new offsets
+  // in the map.
+  this->str_offset_map_.reserve(this->strings_.size() + 1);
+  section_offset_type i = 0;
+  section_offset_type new_offset;
+  for (unsigned int j = 0; j < this->strings_.size(); ++j)
+    {
+      const Input_string& s(this->strings_[j]);
+      new_offset = output_file->add_string(p + s.offset, s.length,
+					   s.hash_code);
+      this->str_offset_map_.push_back(std::make_pair(s.offset, new_offset));
+      i = s.offset + s.length + 1;
+    }
   new_offset = 0;
   this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-  if (is_new)
-    delete[] pdata;
+}
+
+// Add a contribution of LEN bytes at CONTENTS to the output section
+// for SECTION_ID, and return its offset in the output section.  The
+// contents are copied by write_contributions.
+
+section_offset_type
+Dwo_file::add_contribution(Dwp_output_file* output_file,
+			   elfcpp::DW_SECT section_id,
+			   const unsigned char* contents,
+			   section_size_type len)
+{
+  section_offset_type off = output_file->add_contribution(section_id, len, 1);
+  Contribution c = { section_id, off, contents, len };
+  this->contributions_.push_back(c);
+  return off;
 }
 
 // Copy a section from the input file to the output file.
 // Return the offset and length of this input section's contribution
-// in the output section.  If copying .debug_str_offsets.dwo, remap
-// the string offsets for the output string table.
+// in the output section.  If copying .debug_str_offsets.dwo, the
+// string offsets are remapped for the output string table when the
+// section is written.
 
 Section_bounds
 Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -1416,61 +1741,41 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   if (this->sect_offsets_[shndx].size > 0)
     return this->sect_offsets_[shndx];
 
-  // Get the section contents. Upon return, if IS_NEW is true, the memory
-  // has been allocated via new; if false, the memory is part of the mapped
-  // input file, and we will need to duplicate it so that it will persist
-  // after we close the input file.
-  section_size_type len;
-  bool is_new;
-  const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
+  const Section_contents& sc(this->contents_[shndx]);
 
-  if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
-    {
-      const unsigned char* remapped = this->remap_str_offsets(contents, len);
-      if (is_new)
-	delete[] contents;
-      contents = remapped;
-    }
-  else if (!is_new)
-    {
-      unsigned char* copy = new unsigned char[len];
-      memcpy(copy, contents, len);
-      contents = copy;
-    }
+  if (section_id == elfcpp::DW_SECT_STR_OFFSETS && (sc.len & 3) != 0)
+    gold_fatal(_("%s: .debug_str_offsets.dwo section size not a multiple of 4"),
+	       this->name_);
 
-  // Add the contents of the input section to the output section.
-  // The output file takes ownership of the memory pointed to by CONTENTS.
-  section_offset_type off = output_file->add_contribution(section_id, contents,
-							  len, 1);
+  section_offset_type off = this->add_contribution(output_file, section_id,
+						   sc.data, sc.len);
 
   // Store the output section bounds.
-  Section_bounds bounds(off, len);
+  Section_bounds bounds(off, sc.len);
   this->sect_offsets_[shndx] = bounds;
 
   return bounds;
 }
 
-// Remap the 
-const unsigned char*
+// Remap the string offsets in the .debug_str_offsets.dwo section
+// at CONTENTS, writing the result to REMAPPED.
+
+void
 Dwo_file::remap_str_offsets(const unsigned char* contents,
-			    section_size_type len)
+			    section_size_type len, unsigned char* remapped)
 {
-  if ((len & 3) != 0)
-    gold_fatal(_("%s: .debug_str_offsets.dwo section size not a multiple of 4"),
-	       this->name_);
-
-  if (this->obj_->is_big_endian())
-    return this->sized_remap_str_offsets<true>(contents, len);
+  if (this->big_endian_)
+    this->sized_remap_str_offsets<true>(contents, len, remapped);
   else
-    return this->sized_remap_str_offsets<false>(contents, len);
+    this->sized_remap_str_offsets<false>(contents, len, remapped);
 }
 
 template <bool big_endian>
-const unsigned char*
+void
 Dwo_file::sized_remap_str_offsets(const unsigned char* contents,
-				  section_size_type len)
+				  section_size_type len,
+				  unsigned char* remapped)
 {
-  unsigned char* remapped = new unsigned char[len];
   const unsigned char* p = contents;
   unsigned char* q = remapped;
   while (len > 0)
@@ -1482,7 +1787,6 @@ Dwo_file::sized_remap_str_offsets(const unsigned char* contents,
       p += 4;
       q += 4;
     }
-  return remapped;
 }
 
 unsigned int
@@ -1508,20 +1812,20 @@ Dwo_file::remap_str_offset(section_offset_type val)
 }
 
 // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-// to OUTPUT_FILE.
+// to OUTPUT_FILE.  UNITS are the compilation or type units found in
+// the section by read().
 
 void
 Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-		       bool is_debug_types)
+		       bool is_debug_types, const Unit_list& units)
 {
-  unsigned int shndx = (is_debug_types
-			? debug_shndx[elfcpp::DW_SECT_TYPES]
-			: debug_shndx[elfcpp::DW_SECT_INFO]);
+  elfcpp::DW_SECT info_sect = (is_debug_types
+			       ? elfcpp::DW_SECT_TYPES
+			       : elfcpp::DW_SECT_INFO);
+  unsigned int shndx = debug_shndx[info_sect];
 
   gold_assert(shndx != 0);
-
-  if (debug_shndx[elfcpp::DW_SECT_ABBREV] == 0)
-    gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
+  gold_assert(debug_shndx[elfcpp::DW_SECT_ABBREV] != 0);
 
   // Copy the related sections and track the section offsets and sizes.
   Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
@@ -1532,11 +1836,32 @@ Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
 					 static_cast<elfcpp::DW_SECT>(i));
     }
 
-  // Parse the .debug_info or .debug_types section and add each compilation
-  // or type unit to the output file, along with the contributions to the
-  // related sections.
-  Unit_reader reader(is_debug_types, this->obj_, shndx);
-  reader.add_units(output_file, debug_shndx[elfcpp::DW_SECT_ABBREV], sections);
+  // Add each compilation or type unit to the output file, along with
+  // the contributions to the related sections.  A type unit which
+  // has already been added by an earlier input file is dropped.
+  const unsigned char* info_contents = this->contents_[shndx].data;
+  for (Unit_list::const_iterator p = units.begin(); p != units.end(); ++p)
+    {
+      if (is_debug_types && output_file->lookup_tu(p->signature))
+	continue;
+
+      Unit_set* unit_set = new Unit_set();
+      unit_set->signature = p->signature;
+      for (unsigned int i = elfcpp::DW_SECT_ABBREV;
+	   i <= elfcpp::DW_SECT_MAX;
+	   ++i)
+	unit_set->sections[i] = sections[i];
+
+      section_offset_type off =
+	  this->add_contribution(output_file, info_sect,
+				 info_contents + p->offset, p->length);
+      Section_bounds bounds(off, p->length);
+      unit_set->sections[info_sect] = bounds;
+      if (is_debug_types)
+	output_file->add_tu_set(unit_set);
+      else
+	output_file->add_cu_set(unit_set);
+    }
 }
 
 // Class Dwp_output_file.
@@ -1566,26 +1891,15 @@ Dwp_output_file::record_target_info(const char*, int machine,
     this->next_file_offset_ = elfcpp::Elf_sizes<64>::ehdr_size;
   else
     gold_unreachable();
-
-  this->fd_ = ::fopen(this->name_, "wb");
-  if (this->fd_ == NULL)
-    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
-
-  // Write zeroes for the ELF header initially.  We'll write
-  // the actual header during finalize().
-  static const char buf[elfcpp::Elf_sizes<64>::ehdr_size] = { 0 };
-  if (::fwrite(buf, 1, this->next_file_offset_, this->fd_)
-      < (size_t) this->next_file_offset_)
-    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
 }
 
 // Add a string to the debug strings section.
 
 section_offset_type
-Dwp_output_file::add_string(const char* str, size_t len)
+Dwp_output_file::add_string(const char* str, size_t len, size_t hash_code)
 {
   Stringpool::Key key;
-  this->stringpool_.add_with_length(str, len, true, &key);
+  this->stringpool_.add_prehashed(str, len, hash_code, true, &key);
   this->have_strings_ = true;
   // We aren't supposed to call get_offset() until after
   // calling set_string_offsets(), but the offsets will
@@ -1612,15 +1926,12 @@ Dwp_output_file::add_output_section(const char* section_name, int align)
 }
 
 // Add a contribution to a section in the output file, and return the offset
-// of the contribution within the output section.  The .debug_info.dwo section
-// is expected to be the largest one, so we will write the contents of this
-// section directly to the output file as we receive contributions, allowing
-// us to free that memory as soon as possible. We will save the remaining
-// contributions until we finalize the layout of the output file.
+// of the contribution within the output section.  Only the space for the
+// contribution is reserved here; the contents are copied into the mapped
+// output file after layout().
 
 section_offset_type
 Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
-				  const unsigned char* contents,
 				  section_size_type len,
 				  int align)
 {
@@ -1640,50 +1951,11 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
 
   Section& section = this->sections_[shndx - 1];
 
-  section_offset_type section_offset;
-
-  if (section_id == elfcpp::DW_SECT_INFO)
-    {
-      // Write the .debug_info.dwo section directly.
-      // We do not need to free the memory in this case.
-      off_t file_offset = this->next_file_offset_;
-      gold_assert(this->size_ > 0 && file_offset > 0);
-
-      file_offset = align_offset(file_offset, align);
-      if (section.offset == 0)
-	section.offset = file_offset;
-
-      if (align > section.align)
-	{
-	  // Since we've already committed to the layout for this
-	  // section, an unexpected large alignment boundary may
-	  // be impossible to honor.
-	  if (align_offset(section.offset, align) != section.offset)
-	    gold_fatal(_("%s: alignment (%d) for section '%s' "
-			 "cannot be honored"),
-		       this->name_, align, section_name);
-	  section.align = align;
-	}
-
-      section_offset = file_offset - section.offset;
-      section.size = file_offset + len - section.offset;
-
-      ::fseek(this->fd_, file_offset, SEEK_SET);
-      if (::fwrite(contents, 1, len, this->fd_) < len)
-	gold_fatal(_("%s: error writing section '%s'"), this->name_,
-		   section_name);
-      this->next_file_offset_ = file_offset + len;
-    }
-  else
-    {
-      // Collect the contributions and keep track of the total size.
-      if (align > section.align)
-	section.align = align;
-      section_offset = align_offset(section.size, align);
-      section.size = section_offset + len;
-      Contribution contrib = { section_offset, len, contents };
-      section.contributions.push_back(contrib);
-    }
+  // Keep track of the total size.
+  if (align > section.align)
+    section.align = align;
+  section_offset_type section_offset = align_offset(section.size, align);
+  section.size = section_offset + len;
 
   return section_offset;
 }
@@ -1830,145 +2102,239 @@ Dwp_output_file::Dwp_index::grow()
   delete[] old_index_table;
 }
 
-// Finalize the file, write the string tables and index sections,
-// and close the file.
+// Assign a file offset to SECT, following the sections laid out so far.
 
 void
-Dwp_output_file::finalize()
+Dwp_output_file::assign_section_offset(Section* sect)
 {
-  unsigned char* buf;
+  off_t file_offset = align_offset(this->next_file_offset_, sect->align);
+  sect->offset = file_offset;
+  this->next_file_offset_ = file_offset + sect->size;
+}
+
+// Lay out the output file once all the input files have been added.
+// The .debug_info.dwo section comes first, followed by the other
+// debug sections in the order they were created, the debug string
+// table, the CU and TU indexes, the section string table and the
+// section header table.  Then create the output file and map it, so
+// that the input files can copy their contributions into it.
+
+void
+Dwp_output_file::layout()
+{
+  unsigned int info_shndx = this->section_id_map_[elfcpp::DW_SECT_INFO];
+  if (info_shndx > 0)
+    this->assign_section_offset(&this->sections_[info_shndx - 1]);
 
-  // Write the accumulated output sections.
   for (unsigned int i = 0; i < this->sections_.size(); i++)
     {
       Section& sect = this->sections_[i];
-      // If the offset has already been assigned, the section has been written.
       if (sect.offset > 0 || sect.size == 0)
 	continue;
-      off_t file_offset = this->next_file_offset_;
-      file_offset = align_offset(file_offset, sect.align);
-      sect.offset = file_offset;
-      this->write_contributions(sect);
-      this->next_file_offset_ = file_offset + sect.size;
+      this->assign_section_offset(&sect);
     }
 
-  // Write the debug string table.
+  // Build the debug string table.
   if (this->have_strings_)
     {
       this->stringpool_.set_string_offsets();
       section_size_type len = this->stringpool_.get_strtab_size();
-      buf = new unsigned char[len];
+      unsigned char* buf = new unsigned char[len];
       this->stringpool_.write_to_buffer(buf, len);
-      this->write_new_section(".debug_str.dwo", buf, len, 1);
-      delete[] buf;
+      this->add_new_section(".debug_str.dwo", buf, len, 1);
     }
 
-  // Write the CU and TU indexes.
+  // Build the CU and TU indexes.
   if (this->big_endian_)
     {
-      this->write_index<true>(".debug_cu_index", this->cu_index_);
-      this->write_index<true>(".debug_tu_index", this->tu_index_);
+      this->add_index<true>(".debug_cu_index", this->cu_index_);
+      this->add_index<true>(".debug_tu_index", this->tu_index_);
     }
   else
     {
-      this->write_index<false>(".debug_cu_index", this->cu_index_);
-      this->write_index<false>(".debug_tu_index", this->tu_index_);
+      this->add_index<false>(".debug_cu_index", this->cu_index_);
+      this->add_index<false>(".debug_tu_index", this->tu_index_);
     }
 
-  off_t file_offset = this->next_file_offset_;
-
-  // Write the section string table.
+  // Lay out the section string table, and the section header table.
+  // The first entry of the section header table is a NULL entry.
+  // This is followed by the debug sections, and finally the
+  // .shstrtab section header.
   this->shstrndx_ = this->shnum_++;
-  const char* shstrtab_name =
+  this->shstrtab_name_ =
       this->shstrtab_.add_with_length(".shstrtab", sizeof(".shstrtab") - 1,
 				      false, NULL);
   this->shstrtab_.set_string_offsets();
-  section_size_type shstrtab_len = this->shstrtab_.get_strtab_size();
-  buf = new unsigned char[shstrtab_len];
-  this->shstrtab_.write_to_buffer(buf, shstrtab_len);
-  off_t shstrtab_off = file_offset;
-  ::fseek(this->fd_, file_offset, 0);
-  if (::fwrite(buf, 1, shstrtab_len, this->fd_) < shstrtab_len)
-    gold_fatal(_("%s: error writing section '.shstrtab'"), this->name_);
-  delete[] buf;
-  file_offset += shstrtab_len;
-
-  // Write the section header table.  The first entry is a NULL entry.
-  // This is followed by the debug sections, and finally we write the
-  // .shstrtab section header.
+  this->shstrtab_offset_ = this->next_file_offset_;
+  off_t file_offset = (this->shstrtab_offset_
+		       + this->shstrtab_.get_strtab_size());
   file_offset = align_offset(file_offset, this->size_ == 32 ? 4 : 8);
   this->shoff_ = file_offset;
-  ::fseek(this->fd_, file_offset, 0);
+  if (this->size_ == 32)
+    file_offset += this->shnum_ * elfcpp::Elf_sizes<32>::shdr_size;
+  else
+    file_offset += this->shnum_ * elfcpp::Elf_sizes<64>::shdr_size;
+
+  this->open_output_file(file_offset);
+}
+
+// Return a pointer to LEN bytes at OFFSET within the output section
+// for SECTION_ID.
+
+unsigned char*
+Dwp_output_file::contribution_view(elfcpp::DW_SECT section_id,
+				   section_offset_type offset,
+				   section_size_type len)
+{
+  gold_assert(static_cast<size_t>(section_id) < this->section_id_map_.size());
+  unsigned int shndx = this->section_id_map_[section_id];
+  gold_assert(shndx > 0 && this->view_ != NULL);
+  const Section& sect = this->sections_[shndx - 1];
+  gold_assert(offset + len <= sect.size);
+  return this->view_ + sect.offset + offset;
+}
+
+// Finalize the file, write the string tables, the index sections and
+// the headers, and close the file.  The input files have already
+// copied their contributions into the file.
+
+void
+Dwp_output_file::finalize()
+{
+  // Write the sections which we created ourselves.
+  for (unsigned int i = 0; i < this->sections_.size(); i++)
+    {
+      Section& sect = this->sections_[i];
+      if (sect.contents == NULL)
+	continue;
+      memcpy(this->view_ + sect.offset, sect.contents, sect.size);
+      delete[] sect.contents;
+      sect.contents = NULL;
+    }
+
+  // Write the section string table.
+  this->shstrtab_.write_to_buffer(this->view_ + this->shstrtab_offset_,
+				  this->shstrtab_.get_strtab_size());
+
+  // Write the section header table.
+  unsigned char* pov = this->view_ + this->shoff_;
   section_size_type sh0_size = 0;
   unsigned int sh0_link = 0;
   if (this->shnum_ >= elfcpp::SHN_LORESERVE)
     sh0_size = this->shnum_;
   if (this->shstrndx_ >= elfcpp::SHN_LORESERVE)
     sh0_link = this->shstrndx_;
-  this->write_shdr(NULL, 0, 0, 0, 0, sh0_size, sh0_link, 0, 0, 0);
+  pov = this->write_shdr(pov, NULL, 0, 0, 0, 0, sh0_size, sh0_link, 0, 0, 0);
   for (unsigned int i = 0; i < this->sections_.size(); ++i)
     {
       Section& sect = this->sections_[i];
-      this->write_shdr(sect.name, elfcpp::SHT_PROGBITS, 0, 0, sect.offset,
-		       sect.size, 0, 0, sect.align, 0);
+      pov = this->write_shdr(pov, sect.name, elfcpp::SHT_PROGBITS, 0, 0,
+			     sect.offset, sect.size, 0, 0, sect.align, 0);
     }
-  this->write_shdr(shstrtab_name, elfcpp::SHT_STRTAB, 0, 0,
-		   shstrtab_off, shstrtab_len, 0, 0, 1, 0);
+  pov = this->write_shdr(pov, this->shstrtab_name_, elfcpp::SHT_STRTAB, 0, 0,
+			 this->shstrtab_offset_,
+			 this->shstrtab_.get_strtab_size(), 0, 0, 1, 0);
+  gold_assert(pov == this->view_ + this->file_size_);
 
   // Write the ELF header.
   this->write_ehdr();
 
-  // Close the file.
-  if (this->fd_ != NULL)
-    {
-      if (::fclose(this->fd_) != 0)
-	gold_fatal(_("%s: %s"), this->name_, strerror(errno));
-    }
-  this->fd_ = NULL;
+  this->close_output_file();
+}
+
+// Add a new section with the given contents to the output file.  The
+// output file takes ownership of CONTENTS, and writes them in
+// finalize().
+
+void
+Dwp_output_file::add_new_section(const char* section_name,
+				 unsigned char* contents,
+				 section_size_type len, int align)
+{
+  section_name = this->shstrtab_.add_with_length(section_name,
+						 strlen(section_name),
+						 false, NULL);
+  unsigned int shndx = this->add_output_section(section_name, align);
+  Section& section = this->sections_[shndx - 1];
+  section.size = len;
+  section.contents = contents;
+  this->assign_section_offset(&section);
 }
 
-// Write the contributions to an output section.
+// Create the output file with size FILE_SIZE and map it into memory.
+// If the file cannot be mapped, we build it in an allocated buffer
+// and write the buffer when the file is closed.
 
 void
-Dwp_output_file::write_contributions(const Section& sect)
+Dwp_output_file::open_output_file(off_t file_size)
 {
-  for (unsigned int i = 0; i < sect.contributions.size(); ++i)
+  this->fd_ = ::open(this->name_, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (this->fd_ < 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
+  this->file_size_ = file_size;
+
+#ifdef HAVE_MMAP
+  // Make sure that the disk space is available, so that we do not
+  // get an error when writing to the mapped file.
+  int err = ENOSYS;
+#ifdef HAVE_POSIX_FALLOCATE
+  err = ::posix_fallocate(this->fd_, 0, file_size);
+#endif
+  if (err == EINVAL || err == ENOSYS || err == EOPNOTSUPP)
+    err = ::ftruncate(this->fd_, file_size) < 0 ? errno : 0;
+  if (err != 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(err));
+
+  void* base = ::mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		      this->fd_, 0);
+  if (base != MAP_FAILED)
     {
-      const Contribution& c = sect.contributions[i];
-      ::fseek(this->fd_, sect.offset + c.output_offset, SEEK_SET);
-      if (::fwrite(c.contents, 1, c.size, this->fd_) < c.size)
-	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
-      delete[] c.contents;
+      this->view_ = static_cast<unsigned char*>(base);
+      return;
     }
+#endif
+
+  this->view_ = new unsigned char[file_size];
+  memset(this->view_, 0, file_size);
+  this->view_is_allocated_ = true;
 }
 
-// Write a new section to the output file.
+// Unmap and close the output file, writing it first if it was not
+// mapped.
 
 void
-Dwp_output_file::write_new_section(const char* section_name,
-				   const unsigned char* contents,
-				   section_size_type len, int align)
+Dwp_output_file::close_output_file()
 {
-  section_name = this->shstrtab_.add_with_length(section_name,
-						 strlen(section_name),
-						 false, NULL);
-  unsigned int shndx = this->add_output_section(section_name, align);
-  Section& section = this->sections_[shndx - 1];
-  off_t file_offset = this->next_file_offset_;
-  file_offset = align_offset(file_offset, align);
-  section.offset = file_offset;
-  section.size = len;
-  ::fseek(this->fd_, file_offset, SEEK_SET);
-  if (::fwrite(contents, 1, len, this->fd_) < len)
-    gold_fatal(_("%s: error writing section '%s'"), this->name_, section_name);
-  this->next_file_offset_ = file_offset + len;
+  if (this->view_is_allocated_)
+    {
+      const unsigned char* p = this->view_;
+      off_t bytes_to_write = this->file_size_;
+      while (bytes_to_write > 0)
+	{
+	  ssize_t bytes_written = ::write(this->fd_, p, bytes_to_write);
+	  if (bytes_written < 0)
+	    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
+	  p += bytes_written;
+	  bytes_to_write -= bytes_written;
+	}
+      delete[] this->view_;
+    }
+#ifdef HAVE_MMAP
+  else if (::munmap(this->view_, this->file_size_) < 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
+#endif
+  this->view_ = NULL;
+
+  if (::close(this->fd_) < 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
+  this->fd_ = -1;
 }
 
-// Write a CU or TU index section.
+// Add a CU or TU index section.
 
 template<bool big_endian>
 void
-Dwp_output_file::write_index(const char* sect_name, const Dwp_index& index)
+Dwp_output_file::add_index(const char* sect_name, const Dwp_index& index)
 {
   const unsigned int nslots = index.hash_table_total_slots();
   const unsigned int nused = index.hash_table_used_slots();
@@ -2067,9 +2433,7 @@ Dwp_output_file::write_index(const char* sect_name, const Dwp_index& index)
 
   gold_assert(p == buf + index_size);
 
-  this->write_new_section(sect_name, buf, index_size, sizeof(uint64_t));
-
-  delete[] buf;
+  this->add_new_section(sect_name, buf, index_size, sizeof(uint64_t));
 }
 
 // Write the ELF header.
@@ -2100,8 +2464,8 @@ void
 Dwp_output_file::sized_write_ehdr()
 {
   const unsigned int ehdr_size = elfcpp::Elf_sizes<size>::ehdr_size;
-  unsigned char buf[ehdr_size];
-  elfcpp::Ehdr_write<size, big_endian> ehdr(buf);
+  gold_assert(this->file_size_ >= ehdr_size);
+  elfcpp::Ehdr_write<size, big_endian> ehdr(this->view_);
 
   unsigned char e_ident[elfcpp::EI_NIDENT];
   memset(e_ident, 0, elfcpp::EI_NIDENT);
@@ -2136,17 +2500,14 @@ Dwp_output_file::sized_write_ehdr()
   ehdr.put_e_shstrndx(this->shstrndx_ < elfcpp::SHN_LORESERVE
 		      ? this->shstrndx_
 		      : static_cast<unsigned int>(elfcpp::SHN_XINDEX));
-
-  ::fseek(this->fd_, 0, 0);
-  if (::fwrite(buf, 1, ehdr_size, this->fd_) < ehdr_size)
-    gold_fatal(_("%s: error writing ELF header"), this->name_);
 }
 
-// Write a section header.
+// Write a section header at POV, and return a pointer past it.
 
-void
-Dwp_output_file::write_shdr(const char* name, unsigned int type,
-			    unsigned int flags, uint64_t addr, off_t offset,
+unsigned char*
+Dwp_output_file::write_shdr(unsigned char* pov, const char* name,
+			    unsigned int type, unsigned int flags,
+			    uint64_t addr, off_t offset,
 			    section_size_type sect_size, unsigned int link,
 			    unsigned int info, unsigned int align,
 			    unsigned int ent_size)
@@ -2154,22 +2515,22 @@ Dwp_output_file::write_shdr(const char* name, unsigned int type,
   if (this->size_ == 32)
     {
       if (this->big_endian_)
-	return this->sized_write_shdr<32, true>(name, type, flags, addr,
+	return this->sized_write_shdr<32, true>(pov, name, type, flags, addr,
 						offset, sect_size, link, info,
 						align, ent_size);
       else
-	return this->sized_write_shdr<32, false>(name, type, flags, addr,
+	return this->sized_write_shdr<32, false>(pov, name, type, flags, addr,
 						 offset, sect_size, link, info,
 						 align, ent_size);
     }
   else if (this->size_ == 64)
     {
       if (this->big_endian_)
-	return this->sized_write_shdr<64, true>(name, type, flags, addr,
+	return this->sized_write_shdr<64, true>(pov, name, type, flags, addr,
 						offset, sect_size, link, info,
 						align, ent_size);
       else
-	return this->sized_write_shdr<64, false>(name, type, flags, addr,
+	return this->sized_write_shdr<64, false>(pov, name, type, flags, addr,
 						 offset, sect_size, link, info,
 						 align, ent_size);
     }
@@ -2178,16 +2539,15 @@ Dwp_output_file::write_shdr(const char* name, unsigned int type,
 }
 
 template<unsigned int size, bool big_endian>
-void
-Dwp_output_file::sized_write_shdr(const char* name, unsigned int type,
-				  unsigned int flags, uint64_t addr,
-				  off_t offset, section_size_type sect_size,
+unsigned char*
+Dwp_output_file::sized_write_shdr(unsigned char* pov, const char* name,
+				  unsigned int type, unsigned int flags,
+				  uint64_t addr, off_t offset,
+				  section_size_type sect_size,
 				  unsigned int link, unsigned int info,
 				  unsigned int align, unsigned int ent_size)
 {
-  const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
-  unsigned char buf[shdr_size];
-  elfcpp::Shdr_write<size, big_endian> shdr(buf);
+  elfcpp::Shdr_write<size, big_endian> shdr(pov);
 
   shdr.put_sh_name(name == NULL ? 0 : this->shstrtab_.get_offset(name));
   shdr.put_sh_type(type);
@@ -2199,8 +2559,7 @@ Dwp_output_file::sized_write_shdr(const char* name, unsigned int type,
   shdr.put_sh_info(info);
   shdr.put_sh_addralign(align);
   shdr.put_sh_entsize(ent_size);
-  if (::fwrite(buf, 1, shdr_size, this->fd_) < shdr_size)
-    gold_fatal(_("%s: error writing section header table"), this->name_);
+  return pov + elfcpp::Elf_sizes<size>::shdr_size;
 }
 
 // Class Dwo_name_info_reader.
@@ -2220,68 +2579,217 @@ Dwo_name_info_reader::visit_compilation_unit(off_t, off_t, Dwarf_die* die)
 
 // Class Unit_reader.
 
-// Read the CUs or TUs and add them to the output file.
+// Read the CUs or TUs and add them to UNITS.
 
 void
-Unit_reader::add_units(Dwp_output_file* output_file,
-		       unsigned int debug_abbrev,
-		       Section_bounds* sections)
+Unit_reader::read_units(unsigned int debug_abbrev, Unit_list* units)
 {
-  this->output_file_ = output_file;
-  this->sections_ = sections;
+  this->units_ = units;
   this->set_abbrev_shndx(debug_abbrev);
   this->parse();
 }
 
-// Visit a compilation unit.
+// Visit a compilation unit.  The unit offset is relative to the start
+// of the section, since the sections of a .dwo file are not placed in
+// an output section.
 
 void
-Unit_reader::visit_compilation_unit(off_t, off_t cu_length, Dwarf_die* die)
+Unit_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
+				    Dwarf_die* die)
 {
   if (cu_length == 0)
     return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  // Dwp_output_file::add_contribution writes the .debug_info.dwo section
-  // directly to the output file, so we do not need to duplicate the
-  // section contents, and add_contribution does not need to free the memory.
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_INFO,
-					   this->buffer_at_offset(0),
-					   cu_length, 1);
-  Section_bounds bounds(off, cu_length);
-  unit_set->sections[elfcpp::DW_SECT_INFO] = bounds;
-  this->output_file_->add_cu_set(unit_set);
+  uint64_t dwo_id = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
+  this->units_->push_back(Dwo_unit(cu_offset, cu_length, dwo_id));
 }
 
 // Visit a type unit.
 
 void
-Unit_reader::visit_type_unit(off_t, off_t tu_length, off_t,
+Unit_reader::visit_type_unit(off_t tu_offset, off_t tu_length, off_t,
 			     uint64_t signature, Dwarf_die*)
 {
   if (tu_length == 0)
     return;
-  if (this->output_file_->lookup_tu(signature))
-    return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = signature;
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  unsigned char* contents = new unsigned char[tu_length];
-  memcpy(contents, this->buffer_at_offset(0), tu_length);
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES, contents,
-					   tu_length, 1);
-  Section_bounds bounds(off, tu_length);
-  unit_set->sections[elfcpp::DW_SECT_TYPES] = bounds;
-  this->output_file_->add_tu_set(unit_set);
+  this->units_->push_back(Dwo_unit(tu_offset, tu_length, signature));
+}
+
+// Tasks.
+
+// A task to read an input file.  These tasks run in parallel.
+
+class Dwp_read_task : public Task
+{
+ public:
+  Dwp_read_task(Dwo_file* dwo_file, bool verbose, Task_token* next_blocker)
+    : dwo_file_(dwo_file), verbose_(verbose), next_blocker_(next_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  {
+    if (this->verbose_)
+      fprintf(stderr, "%s\n", this->dwo_file_->name());
+    this->dwo_file_->read();
+  }
+
+  std::string
+  get_name() const
+  { return std::string("Dwp_read_task ") + this->dwo_file_->name(); }
+
+ private:
+  Dwo_file* dwo_file_;
+  bool verbose_;
+  Task_token* next_blocker_;
+};
+
+// A task to copy the contributions of an input file into the output
+// file.  These tasks run in parallel.
+
+class Dwp_write_task : public Task
+{
+ public:
+  Dwp_write_task(Dwo_file* dwo_file, Dwp_output_file* output_file,
+		 Task_token* next_blocker)
+    : dwo_file_(dwo_file), output_file_(output_file),
+      next_blocker_(next_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->dwo_file_->write_contributions(this->output_file_); }
+
+  std::string
+  get_name() const
+  { return std::string("Dwp_write_task ") + this->dwo_file_->name(); }
+
+ private:
+  Dwo_file* dwo_file_;
+  Dwp_output_file* output_file_;
+  Task_token* next_blocker_;
+};
+
+// A task to finish the output file once all the input files have
+// been written.
+
+class Dwp_finalize_task : public Task
+{
+ public:
+  Dwp_finalize_task(Dwp_output_file* output_file, Task_token* this_blocker)
+    : output_file_(output_file), this_blocker_(this_blocker)
+  { }
+
+  ~Dwp_finalize_task()
+  { delete this->this_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->output_file_->finalize(); }
+
+  std::string
+  get_name() const
+  { return "Dwp_finalize_task"; }
+
+ private:
+  Dwp_output_file* output_file_;
+  Task_token* this_blocker_;
+};
+
+// A task to add the input files to the output file, in order, once
+// they have all been read.  This then queues the tasks to write the
+// output file.
+
+class Dwp_add_task : public Task
+{
+ public:
+  Dwp_add_task(const std::vector<Dwo_file*>* dwo_files,
+	       Dwp_output_file* output_file, Task_token* this_blocker)
+    : dwo_files_(dwo_files), output_file_(output_file),
+      this_blocker_(this_blocker)
+  { }
+
+  ~Dwp_add_task()
+  { delete this->this_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Dwp_add_task"; }
+
+ private:
+  const std::vector<Dwo_file*>* dwo_files_;
+  Dwp_output_file* output_file_;
+  Task_token* this_blocker_;
+};
+
+void
+Dwp_add_task::run(Workqueue* workqueue)
+{
+  const std::vector<Dwo_file*>& dwo_files(*this->dwo_files_);
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    dwo_files[i]->add_to_output(this->output_file_);
+
+  this->output_file_->layout();
+
+  Task_token* next_blocker = new Task_token(true);
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    next_blocker->add_blocker();
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    workqueue->queue(new Dwp_write_task(dwo_files[i], this->output_file_,
+					next_blocker));
+  workqueue->queue(new Dwp_finalize_task(this->output_file_, next_blocker));
 }
 
 }; // End namespace gold
@@ -2292,13 +2800,19 @@ using namespace gold;
 
 enum Dwp_options {
   VERIFY_ONLY = 0x101,
+  THREADS,
+  NO_THREADS,
+  THREAD_COUNT,
 };
 
 struct option dwp_options[] =
   {
     { "exec", required_argument, NULL, 'e' },
     { "help", no_argument, NULL, 'h' },
+    { "no-threads", no_argument, NULL, NO_THREADS },
     { "output", required_argument, NULL, 'o' },
+    { "thread-count", required_argument, NULL, THREAD_COUNT },
+    { "threads", no_argument, NULL, THREADS },
     { "verbose", no_argument, NULL, 'v' },
     { "verify-only", no_argument, NULL, VERIFY_ONLY },
     { "version", no_argument, NULL, 'V' },
@@ -2315,6 +2829,10 @@ usage(FILE* fd, int exit_status)
   fprintf(fd, _("  -e EXE, --exec EXE       Get list of dwo files from EXE"
 					   " (defaults output to EXE.dwp)\n"));
   fprintf(fd, _("  -o FILE, --output FILE   Set output dwp file name\n"));
+  fprintf(fd, _("  --threads                Read and write files in"
+					   " parallel\n"));
+  fprintf(fd, _("  --no-threads             Do not use threads (default)\n"));
+  fprintf(fd, _("  --thread-count COUNT     Number of threads to use\n"));
   fprintf(fd, _("  -v, --verbose            Verbose output\n"));
   fprintf(fd, _("  --verify-only            Verify output file against"
 					   " exec file\n"));
@@ -2378,6 +2896,8 @@ main(int argc, char** argv)
   const char* exe_filename = NULL;
   bool verbose = false;
   bool verify_only = false;
+  bool threads = false;
+  int thread_count = 0;
   int c;
   while ((c = getopt_long(argc, argv, "e:ho:vV", dwp_options, NULL)) != -1)
     {
@@ -2397,6 +2917,20 @@ main(int argc, char** argv)
 	  case VERIFY_ONLY:
 	    verify_only = true;
 	    break;
+	  case THREADS:
+	    threads = true;
+	    break;
+	  case NO_THREADS:
+	    threads = false;
+	    break;
+	  case THREAD_COUNT:
+	    {
+	      char* endptr;
+	      thread_count = strtol(optarg, &endptr, 0);
+	      if (*endptr != '\0' || thread_count < 0)
+		gold_fatal(_("invalid thread count: %s"), optarg);
+	    }
+	    break;
 	  case 'V':
 	    print_version();
 	  case '?':
@@ -2413,6 +2947,11 @@ main(int argc, char** argv)
       output_filename.append(".dwp");
     }
 
+  // This must be done before we read any files, since the locks used
+  // by libgold are created on first use.
+  if (threads)
+    options.enable_threads(thread_count);
+
   // Get list of .dwo files from the executable.
   if (exe_filename != NULL)
     {
@@ -2436,16 +2975,34 @@ main(int argc, char** argv)
       return ok ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-  // Process each file, adding its contents to the output file.
+  // Read the input files, then add their contents to the output file
+  // in order, then copy their contributions into the output file.
+  // With --threads, the input files are read and copied in parallel.
   Dwp_output_file output_file(output_filename.c_str());
+  std::vector<Dwo_file*> dwo_files;
+  dwo_files.reserve(files.size());
   for (File_list::const_iterator f = files.begin(); f != files.end(); ++f)
-    {
-      if (verbose)
-	fprintf(stderr, "%s\n", f->dwo_name.c_str());
-      Dwo_file dwo_file(f->dwo_name.c_str());
-      dwo_file.read(&output_file);
-    }
-  output_file.finalize();
+    dwo_files.push_back(new Dwo_file(f->dwo_name.c_str()));
+
+  Workqueue workqueue(options);
+  if (options.threads())
+    workqueue.set_thread_count(thread_count > 0
+			       ? thread_count
+			       : static_cast<int>(dwo_files.size()));
+
+  Task_token* next_blocker = new Task_token(true);
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    next_blocker->add_blocker();
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    workqueue.queue(new Dwp_read_task(dwo_files[i], verbose, next_blocker));
+  workqueue.queue(new Dwp_add_task(&dwo_files, &output_file, next_blocker));
+
+  workqueue.process(0);
+
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    delete dwo_files[i];
 
-  return EXIT_SUCCESS;
+  // Exit without destroying the workqueue, since its threads may still
+  // be waiting on its lock; ld does the same.
+  gold_exit(GOLD_OK);
 }
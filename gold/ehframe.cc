@@ -29,6 +29,7 @@
 #include "dwarf.h"
 #include "symtab.h"
 #include "reloc.h"
+#include "workqueue.h"
 #include "ehframe.h"
 
 namespace gold
@@ -76,6 +77,46 @@ namespace gold
 
 const int eh_frame_hdr_size = 4;
 
+// When using threads, the FDE addresses are read and sorted in chunks
+// of this many FDEs, and the sorted chunks are then merged.
+
+static const size_t eh_frame_hdr_chunk_size = 65536;
+
+// A task to read and sort the addresses of one chunk of the FDEs for
+// an Eh_frame_hdr.
+
+class Eh_frame_hdr_sort_task : public Task
+{
+ public:
+  Eh_frame_hdr_sort_task(Eh_frame_hdr* hdr, Output_file* of, size_t chunk,
+			 Task_token* blocker)
+    : hdr_(hdr), of_(of), chunk_(chunk), blocker_(blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->hdr_->sort_chunk(this->of_, this->chunk_); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  // Unblock BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->blocker_); }
+
+  std::string
+  get_name() const
+  { return "Eh_frame_hdr_sort_task"; }
+
+ private:
+  Eh_frame_hdr* hdr_;
+  Output_file* of_;
+  const size_t chunk_;
+  Task_token* const blocker_;
+};
+
 // Construct the exception frame header.
 
 Eh_frame_hdr::Eh_frame_hdr(Output_section* eh_frame_section,
@@ -84,6 +125,8 @@ Eh_frame_hdr::Eh_frame_hdr(Output_section* eh_frame_section,
     eh_frame_section_(eh_frame_section),
     eh_frame_data_(eh_frame_data),
     fde_offsets_(),
+    fde_addresses_(),
+    sorted_run_size_(0),
     any_unrecognized_eh_frame_sections_(false)
 {
 }
@@ -104,6 +147,71 @@ Eh_frame_hdr::set_final_data_size()
   this->set_data_size(data_size);
 }
 
+// Queue the tasks to read and sort the FDE addresses.  The
+// relocations have been applied to the .eh_frame section, and the
+// FDE offsets have been recorded when it was written, so the chunks
+// can be handled independently.  Small tables are handled when the
+// header is written.
+
+bool
+Eh_frame_hdr::queue_sort_tasks(Output_file* of, Workqueue* workqueue,
+			       Task_token* blocker)
+{
+  if (!parameters->options().threads()
+      || this->any_unrecognized_eh_frame_sections_
+      || this->sorted_run_size_ != 0
+      || this->fde_offsets_.size() <= eh_frame_hdr_chunk_size)
+    return false;
+
+  size_t count = this->fde_offsets_.size();
+  this->fde_addresses_.resize(count);
+  this->sorted_run_size_ = eh_frame_hdr_chunk_size;
+
+  size_t chunks = (count + eh_frame_hdr_chunk_size - 1)
+		  / eh_frame_hdr_chunk_size;
+  blocker->add_blockers(chunks);
+  for (size_t i = 0; i < chunks; ++i)
+    workqueue->queue(new Eh_frame_hdr_sort_task(this, of, i, blocker));
+  return true;
+}
+
+// Read and sort the addresses of the FDEs in chunk CHUNK.
+
+void
+Eh_frame_hdr::sort_chunk(Output_file* of, size_t chunk)
+{
+  size_t first = chunk * eh_frame_hdr_chunk_size;
+  gold_assert(first < this->fde_offsets_.size());
+  size_t count = std::min(eh_frame_hdr_chunk_size,
+			  this->fde_offsets_.size() - first);
+
+  switch (parameters->size_and_endianness())
+    {
+#ifdef HAVE_TARGET_32_LITTLE
+    case Parameters::TARGET_32_LITTLE:
+      this->sort_fde_addresses<32, false>(of, first, count);
+      break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+    case Parameters::TARGET_32_BIG:
+      this->sort_fde_addresses<32, true>(of, first, count);
+      break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+    case Parameters::TARGET_64_LITTLE:
+      this->sort_fde_addresses<64, false>(of, first, count);
+      break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+    case Parameters::TARGET_64_BIG:
+      this->sort_fde_addresses<64, true>(of, first, count);
+      break;
+#endif
+    default:
+      gold_unreachable();
+    }
+}
+
 // Write the data to the file.
 
 void
@@ -174,29 +282,39 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
       oview[2] = elfcpp::DW_EH_PE_udata4;
       oview[3] = elfcpp::DW_EH_PE_datarel | elfcpp::DW_EH_PE_sdata4;
 
-      elfcpp::Swap<32, big_endian>::writeval(oview + 8,
-					     this->fde_offsets_.size());
+      size_t count = this->fde_offsets_.size();
+      elfcpp::Swap<32, big_endian>::writeval(oview + 8, count);
 
       // We have the offsets of the FDEs in the .eh_frame section.  We
       // couldn't easily get the PC values before, as they depend on
       // relocations which are, of course, target specific.  This code
       // is run after all those relocations have been applied to the
       // output file.  Here we read the output file again to find the
-      // PC values.  Then we sort the list and write it out.
+      // PC values, unless that was already done by the tasks queued
+      // by queue_sort_tasks.  Then we merge the sorted runs and write
+      // out the list.
 
-      Fde_addresses<size> fde_addresses(this->fde_offsets_.size());
-      this->get_fde_addresses<size, big_endian>(of, &this->fde_offsets_,
-						&fde_addresses);
+      if (this->sorted_run_size_ == 0)
+	{
+	  this->fde_addresses_.resize(count);
+	  this->sort_fde_addresses<size, big_endian>(of, 0, count);
+	  this->sorted_run_size_ = count;
+	}
 
-      std::sort(fde_addresses.begin(), fde_addresses.end(),
-		Fde_address_compare<size>());
+      Fde_addresses::iterator begin = this->fde_addresses_.begin();
+      for (size_t run = this->sorted_run_size_; run < count; run *= 2)
+	{
+	  for (size_t i = 0; i + run < count; i += 2 * run)
+	    std::inplace_merge(begin + i, begin + i + run,
+			       begin + std::min(i + 2 * run, count),
+			       Fde_address_compare());
+	}
 
-      typename elfcpp::Elf_types<size>::Elf_Addr output_address;
-      output_address = this->address();
+      uint64_t output_address = this->address();
 
       unsigned char* pfde = oview + 12;
-      for (typename Fde_addresses<size>::iterator p = fde_addresses.begin();
-	   p != fde_addresses.end();
+      for (Fde_addresses::const_iterator p = this->fde_addresses_.begin();
+	   p != this->fde_addresses_.end();
 	   ++p)
 	{
 	  elfcpp::Swap<32, big_endian>::writeval(pfde,
@@ -207,28 +325,31 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
 	}
 
       gold_assert(pfde - oview == oview_size);
+
+      Fde_addresses().swap(this->fde_addresses_);
     }
 
   of->write_output_view(off, oview_size, oview);
 }
 
 // Given the offset FDE_OFFSET of an FDE in the .eh_frame section, and
-// the contents of the .eh_frame section EH_FRAME_CONTENTS, where the
-// FDE's encoding is FDE_ENCODING, return the output address of the
-// FDE's PC.
+// the contents of the .eh_frame section EH_FRAME_CONTENTS starting at
+// CONTENTS_OFFSET, where the FDE's encoding is FDE_ENCODING, return
+// the output address of the FDE's PC.
 
 template<int size, bool big_endian>
 typename elfcpp::Elf_types<size>::Elf_Addr
 Eh_frame_hdr::get_fde_pc(
     typename elfcpp::Elf_types<size>::Elf_Addr eh_frame_address,
     const unsigned char* eh_frame_contents,
+    section_offset_type contents_offset,
     section_offset_type fde_offset,
     unsigned char fde_encoding)
 {
   // The FDE starts with a 4 byte length and a 4 byte offset to the
   // CIE.  The PC follows.
-  const unsigned char* p = eh_frame_contents + fde_offset + 8;
-
+  const unsigned char* p = (eh_frame_contents
+			    + (fde_offset - contents_offset) + 8);
   typename elfcpp::Elf_types<size>::Elf_Addr pc;
   bool is_signed = (fde_encoding & elfcpp::DW_EH_PE_signed) != 0;
   int pc_size = fde_encoding & 7;
@@ -290,37 +411,55 @@ Eh_frame_hdr::get_fde_pc(
   return pc;
 }
 
-// Given an array of FDE offsets in the .eh_frame section, return an
-// array of offsets from the exception frame header to the FDE's
-// output PC and to the output address of the FDE itself.  We get the
-// FDE's PC by actually looking in the .eh_frame section we just wrote
-// to the output file.
+// Convert the FDE offsets in [FIRST, FIRST + COUNT) of fde_offsets_
+// to the output addresses of the FDE's PC and of the FDE itself, and
+// store them in the same elements of fde_addresses_ in sorted order.
+// We get the FDE's PC by actually looking in the .eh_frame section we
+// just wrote to the output file.  This only reads the part of the
+// section which holds these FDEs.
 
 template<int size, bool big_endian>
 void
-Eh_frame_hdr::get_fde_addresses(Output_file* of,
-				const Fde_offsets* fde_offsets,
-				Fde_addresses<size>* fde_addresses)
+Eh_frame_hdr::sort_fde_addresses(Output_file* of, size_t first, size_t count)
 {
+  gold_assert(count > 0 && first + count <= this->fde_addresses_.size());
+
   typename elfcpp::Elf_types<size>::Elf_Addr eh_frame_address;
   eh_frame_address = this->eh_frame_section_->address();
   off_t eh_frame_offset = this->eh_frame_section_->offset();
   off_t eh_frame_size = this->eh_frame_section_->data_size();
-  const unsigned char* eh_frame_contents = of->get_input_view(eh_frame_offset,
-							      eh_frame_size);
 
-  for (Fde_offsets::const_iterator p = fde_offsets->begin();
-       p != fde_offsets->end();
-       ++p)
+  const Fde_offsets::const_iterator pbegin =
+    this->fde_offsets_.begin() + first;
+  const Fde_offsets::const_iterator pend = pbegin + count;
+  section_offset_type start = pbegin->first;
+  section_offset_type end = pbegin->first;
+  for (Fde_offsets::const_iterator p = pbegin; p != pend; ++p)
+    {
+      start = std::min(start, p->first);
+      end = std::max(end, p->first);
+    }
+  // Each FDE has a length, a CIE offset and a PC of at most 8 bytes.
+  end = std::min(static_cast<off_t>(end + 16), eh_frame_size);
+  const unsigned char* eh_frame_contents =
+    of->get_input_view(eh_frame_offset + start, end - start);
+
+  Fde_addresses::iterator q = this->fde_addresses_.begin() + first;
+  for (Fde_offsets::const_iterator p = pbegin; p != pend; ++p, ++q)
     {
       typename elfcpp::Elf_types<size>::Elf_Addr fde_pc;
       fde_pc = this->get_fde_pc<size, big_endian>(eh_frame_address,
-						  eh_frame_contents,
+						  eh_frame_contents, start,
 						  p->first, p->second);
-      fde_addresses->push_back(fde_pc, eh_frame_address + p->first);
+      *q = std::make_pair(fde_pc, eh_frame_address + p->first);
     }
 
-  of->free_input_view(eh_frame_offset, eh_frame_size, eh_frame_contents);
+  of->free_input_view(eh_frame_offset + start, end - start,
+		      eh_frame_contents);
+
+  std::sort(this->fde_addresses_.begin() + first,
+	    this->fde_addresses_.begin() + first + count,
+	    Fde_address_compare());
 }
 
 // Class Fde.
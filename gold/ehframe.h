@@ -37,6 +37,8 @@ template<int size, bool big_endian>
 class Track_relocs;
 
 class Eh_frame;
+class Workqueue;
+class Task_token;
 
 // This class manages the .eh_frame_hdr section, which holds the data
 // for the PT_GNU_EH_FRAME segment.  gcc's unwind support code uses
@@ -63,6 +65,18 @@ class Eh_frame_hdr : public Output_section_data
       this->fde_offsets_.push_back(std::make_pair(fde_offset, fde_encoding));
   }
 
+  // When using threads, queue tasks to read and sort the FDE
+  // addresses for a large table, using BLOCKER to wait for them.
+  // This is called after the relocations have been applied to the
+  // .eh_frame section.  Return whether any tasks were queued.
+  bool
+  queue_sort_tasks(Output_file*, Workqueue*, Task_token* blocker);
+
+  // Read and sort the addresses of the FDEs in one chunk of the
+  // table.  This is run by a task queued by queue_sort_tasks.
+  void
+  sort_chunk(Output_file*, size_t chunk);
+
  protected:
   // Set the final data size.
   void
@@ -91,46 +105,18 @@ class Eh_frame_hdr : public Output_section_data
   typedef std::vector<Fde_offset> Fde_offsets;
 
   // When writing out the header, we convert the FDE offsets into FDE
-  // addresses.  This is a list of pairs of the offset from the header
-  // to the FDE PC and to the FDE itself.
-  template<int size>
-  class Fde_addresses
-  {
-   public:
-    typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
-    typedef typename std::pair<Address, Address> Fde_address;
-    typedef typename std::vector<Fde_address> Fde_address_list;
-    typedef typename Fde_address_list::iterator iterator;
-
-    Fde_addresses(unsigned int reserve)
-      : fde_addresses_()
-    { this->fde_addresses_.reserve(reserve); }
-
-    void
-    push_back(Address pc_address, Address fde_address)
-    {
-      this->fde_addresses_.push_back(std::make_pair(pc_address, fde_address));
-    }
-
-    iterator
-    begin()
-    { return this->fde_addresses_.begin(); }
+  // addresses.  This is a pair of the output address of the FDE PC
+  // and of the FDE itself.
+  typedef std::pair<uint64_t, uint64_t> Fde_address;
 
-    iterator
-    end()
-    { return this->fde_addresses_.end(); }
-
-   private:
-    Fde_address_list fde_addresses_;
-  };
+  // The list of FDE addresses, in the same order as fde_offsets_.
+  typedef std::vector<Fde_address> Fde_addresses;
 
   // Compare Fde_address objects.
-  template<int size>
   struct Fde_address_compare
   {
     bool
-    operator()(const typename Fde_addresses<size>::Fde_address& f1,
-	       const typename Fde_addresses<size>::Fde_address& f2) const
+    operator()(const Fde_address& f1, const Fde_address& f2) const
     { return f1.first < f2.first; }
   };
 
@@ -139,14 +125,14 @@ class Eh_frame_hdr : public Output_section_data
   typename elfcpp::Elf_types<size>::Elf_Addr
   get_fde_pc(typename elfcpp::Elf_types<size>::Elf_Addr eh_frame_address,
 	     const unsigned char* eh_frame_contents,
+	     section_offset_type contents_offset,
 	     section_offset_type fde_offset, unsigned char fde_encoding);
 
-  // Convert Fde_offsets to Fde_addresses.
+  // Convert the Fde_offsets in [FIRST, FIRST + COUNT) to
+  // Fde_addresses, and sort them.
   template<int size, bool big_endian>
   void
-  get_fde_addresses(Output_file* of,
-		    const Fde_offsets* fde_offsets,
-		    Fde_addresses<size>* fde_addresses);
+  sort_fde_addresses(Output_file* of, size_t first, size_t count);
 
   // The .eh_frame section.
   Output_section* eh_frame_section_;
@@ -154,6 +140,11 @@ class Eh_frame_hdr : public Output_section_data
   const Eh_frame* eh_frame_data_;
   // Data from the FDEs in the .eh_frame sections.
   Fde_offsets fde_offsets_;
+  // The addresses of the FDEs, once they have been read.
+  Fde_addresses fde_addresses_;
+  // The number of FDEs in each sorted run of fde_addresses_, or zero
+  // if they have not been read yet.  The last run may be shorter.
+  size_t sorted_run_size_;
   // Whether we found any .eh_frame sections which we could not
   // process.
   bool any_unrecognized_eh_frame_sections_;
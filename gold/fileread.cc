@@ -425,6 +425,7 @@ File_read::do_read(off_t start, section_size_type size, void* p)
 void
 File_read::read(off_t start, section_size_type size, void* p)
 {
+  Hold_optional_lock hl(this->lock_);
   const File_read::View* pv = this->find_view(start, size, -1U, NULL);
   if (pv != NULL)
     {
@@ -615,6 +616,7 @@ const unsigned char*
 File_read::get_view(off_t offset, off_t start, section_size_type size,
 		    bool aligned, bool cache)
 {
+  Hold_optional_lock hl(this->lock_);
   File_read::View* pv = this->find_or_make_view(offset, start, size,
 						aligned, cache);
   return pv->data() + (offset + start - pv->start() + pv->byteshift());
@@ -624,6 +626,7 @@ File_view*
 File_read::get_lasting_view(off_t offset, off_t start, section_size_type size,
 			    bool aligned, bool cache)
 {
+  Hold_optional_lock hl(this->lock_);
   File_read::View* pv = this->find_or_make_view(offset, start, size,
 						aligned, cache);
   pv->lock();
@@ -762,6 +765,25 @@ File_read::read_multiple(off_t base, const Read_multiple& rm)
     }
 }
 
+// Permit several tasks to get views at once.
+
+void
+File_read::share_views()
+{
+  gold_assert(this->lock_ == NULL);
+  if (parameters->options().threads())
+    this->lock_ = new Lock();
+}
+
+// Stop sharing views.
+
+void
+File_read::unshare_views()
+{
+  delete this->lock_;
+  this->lock_ = NULL;
+}
+
 // Mark all views as no longer cached.
 
 void
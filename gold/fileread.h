@@ -62,6 +62,7 @@ class Position_dependent_options;
 class Input_file_argument;
 class Dirsearch;
 class File_view;
+class Lock;
 
 // File_read manages a file descriptor and mappings for a file we are
 // reading.
@@ -72,7 +73,7 @@ class File_read
   File_read()
     : name_(), descriptor_(-1), is_descriptor_opened_(false), object_count_(0),
       size_(0), token_(false), views_(), saved_views_(), mapped_bytes_(0),
-      released_(true), whole_file_view_(NULL)
+      released_(true), whole_file_view_(NULL), lock_(NULL)
   { }
 
   ~File_read();
@@ -168,6 +169,17 @@ class File_read
   get_lasting_view(off_t offset, off_t start, section_size_type size,
 		   bool aligned, bool cache);
 
+  // Permit tasks other than the one which locked the file to get
+  // views and read data at the same time, until unshare_views is
+  // called.  This is used when the task which locked the file hands
+  // part of its work to other tasks.
+  void
+  share_views();
+
+  // Stop sharing views.
+  void
+  unshare_views();
+
   // Mark all views as no longer cached.
   void
   clear_view_cache_marks();
@@ -442,6 +454,9 @@ class File_read
   // - The contents was specified in the constructor.  Used only for
   //   testing purposes).
   View* whole_file_view_;
+  // A lock held while getting views when they are shared by several
+  // tasks; NULL otherwise.
+  Lock* lock_;
 };
 
 // A view of file data that persists even when the file is unlocked.
@@ -22,46 +22,251 @@
 
 
 #include "gold.h"
+
+#include <algorithm>
+
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
+#include "workqueue.h"
 
 namespace gold
 {
 
-// Garbage collection uses a worklist style algorithm to determine the 
-// transitive closure of all referenced sections.
-void 
-Garbage_collection::do_transitive_closure()
+// When using threads, the references from a frontier of at least
+// twice this many sections are followed by several tasks, each
+// handling this many sections.
+
+static const size_t gc_mark_chunk_size = 4096;
+
+// Class Gc_refs.
+
+// Merge the pending references into the compressed form.  The
+// references from each section are sorted and duplicates removed.
+
+void
+Gc_refs::finalize(unsigned int shnum)
 {
-  while (!this->worklist().empty())
+  if (this->marks_.size() < shnum)
+    this->marks_.resize(shnum, 0);
+
+  if (this->pending_.empty() && this->index_.size() == shnum + 1)
+    return;
+
+  // Count the references from each section.
+  std::vector<unsigned int> index(shnum + 1, 0);
+  unsigned int old_shnum = (this->index_.empty()
+			    ? 0
+			    : this->index_.size() - 1);
+  for (unsigned int i = 0; i < old_shnum && i < shnum; ++i)
+    index[i + 1] = this->index_[i + 1] - this->index_[i];
+  for (Pending_refs::const_iterator p = this->pending_.begin();
+       p != this->pending_.end();
+       ++p)
+    if (p->first < shnum)
+      ++index[p->first + 1];
+  for (unsigned int i = 0; i < shnum; ++i)
+    index[i + 1] += index[i];
+
+  // Put the references into place.
+  std::vector<Section_id> refs(index[shnum]);
+  std::vector<unsigned int> fill(index.begin(), index.end() - 1);
+  for (unsigned int i = 0; i < old_shnum && i < shnum; ++i)
+    for (unsigned int j = this->index_[i]; j < this->index_[i + 1]; ++j)
+      refs[fill[i]++] = this->refs_[j];
+  for (Pending_refs::const_iterator p = this->pending_.begin();
+       p != this->pending_.end();
+       ++p)
+    if (p->first < shnum)
+      refs[fill[p->first]++] = p->second;
+
+  // Remove duplicates, moving the references down as we go.
+  unsigned int out = 0;
+  unsigned int start = 0;
+  for (unsigned int i = 0; i < shnum; ++i)
     {
-      // Add elements from the work list to the referenced list
-      // one by one.
-      Section_id entry = this->worklist().back();
-      this->worklist().pop_back();
-      if (!this->referenced_list().insert(entry).second)
-        continue;
-      Garbage_collection::Section_ref::iterator find_it = 
-                this->section_reloc_map().find(entry);
-      if (find_it == this->section_reloc_map().end()) 
-          continue;
-      const Garbage_collection::Sections_reachable &v = find_it->second;
-      // Scan the vector of references for each work_list entry. 
-      for (Garbage_collection::Sections_reachable::const_iterator it_v =
-               v.begin();
-           it_v != v.end();
-           ++it_v)
-        {
-          // Do not add already processed sections to the work_list. 
-          if (this->referenced_list().find(*it_v)
-              == this->referenced_list().end())
-            {
-              this->worklist().push_back(*it_v);
-            }
-        }
+      unsigned int end = index[i + 1];
+      std::sort(refs.begin() + start, refs.begin() + end);
+      std::vector<Section_id>::iterator last =
+	std::unique(refs.begin() + start, refs.begin() + end);
+      index[i] = out;
+      for (std::vector<Section_id>::iterator p = refs.begin() + start;
+	   p != last;
+	   ++p)
+	refs[out++] = *p;
+      start = end;
     }
+  index[shnum] = out;
+  refs.resize(out);
+
+  this->index_.swap(index);
+  this->refs_.swap(refs);
+  Pending_refs().swap(this->pending_);
+}
+
+// Free the references once they are no longer needed.
+
+void
+Gc_refs::clear_refs()
+{
+  Pending_refs().swap(this->pending_);
+  std::vector<unsigned int>().swap(this->index_);
+  std::vector<Section_id>().swap(this->refs_);
+}
+
+// A task to follow the references from part of the frontier.
+
+class Gc_mark_task : public Task
+{
+ public:
+  Gc_mark_task(Garbage_collection* gc, size_t begin, size_t end,
+	       Garbage_collection::Worklist_type* next, Task_token* blocker)
+    : gc_(gc), begin_(begin), end_(end), next_(next), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->gc_->mark_sections(this->begin_, this->end_, this->next_); }
+
+  std::string
+  get_name() const
+  { return "Gc_mark_task"; }
+
+ private:
+  Garbage_collection* gc_;
+  size_t begin_;
+  size_t end_;
+  Garbage_collection::Worklist_type* next_;
+  Task_token* blocker_;
+};
+
+// Class Garbage_collection.
+
+// Make sure that every object has its references in compressed form
+// and room for its marks, and mark the sections on the work list,
+// which are the roots of the transitive closure.
+
+void
+Garbage_collection::start_transitive_closure(
+    const Input_objects* input_objects)
+{
+  this->input_objects_ = input_objects;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Gc_refs* refs = (*p)->gc_refs();
+      if (refs == NULL)
+	{
+	  refs = new Gc_refs();
+	  (*p)->set_gc_refs(refs);
+	}
+      refs->finalize((*p)->shnum());
+    }
+
+  this->frontier_.clear();
+  for (Worklist_type::const_iterator p = this->worklist().begin();
+       p != this->worklist().end();
+       ++p)
+    {
+      Gc_refs* refs = p->first->gc_refs();
+      if (refs != NULL && refs->mark(p->second))
+	this->frontier_.push_back(*p);
+    }
+  this->worklist().clear();
+}
+
+// Garbage collection marks the transitive closure of all referenced
+// sections, one frontier at a time.  Small frontiers are handled
+// here; large ones are split among tasks.
+
+Task_token*
+Garbage_collection::do_transitive_closure(Workqueue* workqueue)
+{
+  // Collect the sections marked by the tasks we queued last time.
+  if (!this->next_frontiers_.empty())
+    {
+      this->frontier_.clear();
+      for (size_t i = 0; i < this->next_frontiers_.size(); ++i)
+	this->frontier_.insert(this->frontier_.end(),
+			       this->next_frontiers_[i].begin(),
+			       this->next_frontiers_[i].end());
+      this->next_frontiers_.clear();
+    }
+
+  // Without an atomic compare and swap, two tasks could both add the
+  // same section to their frontiers, so we don't use tasks.
+  bool use_tasks = parameters->options().threads();
+#ifndef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_1
+  use_tasks = false;
+#endif
+
+  while (!this->frontier_.empty())
+    {
+      size_t size = this->frontier_.size();
+      if (use_tasks && size >= 2 * gc_mark_chunk_size)
+	{
+	  size_t count = (size + gc_mark_chunk_size - 1) / gc_mark_chunk_size;
+	  this->next_frontiers_.resize(count);
+	  Task_token* blocker = new Task_token(true);
+	  for (size_t i = 0; i < count; ++i)
+	    {
+	      size_t begin = i * gc_mark_chunk_size;
+	      size_t end = std::min(begin + gc_mark_chunk_size, size);
+	      blocker->add_blocker();
+	      workqueue->queue(new Gc_mark_task(this, begin, end,
+						&this->next_frontiers_[i],
+						blocker));
+	    }
+	  return blocker;
+	}
+
+      Worklist_type next;
+      this->mark_sections(0, size, &next);
+      this->frontier_.swap(next);
+    }
+
+  // The references are no longer needed; only the marks are.
+  for (Input_objects::Relobj_iterator p = this->input_objects_->relobj_begin();
+       p != this->input_objects_->relobj_end();
+       ++p)
+    (*p)->gc_refs()->clear_refs();
+  Worklist_type().swap(this->frontier_);
+
   this->worklist_ready();
+  return NULL;
+}
+
+// Follow the references from part of the frontier.
+
+void
+Garbage_collection::mark_sections(size_t begin, size_t end,
+				  Worklist_type* next)
+{
+  for (size_t i = begin; i < end; ++i)
+    {
+      const Section_id& entry(this->frontier_[i]);
+      const Section_id* p;
+      const Section_id* pend;
+      entry.first->gc_refs()->refs(entry.second, &p, &pend);
+      for (; p != pend; ++p)
+	{
+	  // Do not add already marked sections to the frontier.
+	  Gc_refs* refs = p->first->gc_refs();
+	  if (refs != NULL && refs->mark(p->second))
+	    next->push_back(*p);
+	}
+    }
 }
 
 } // End namespace gold.
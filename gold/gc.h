@@ -41,13 +41,106 @@ class Sized_relobj_file;
 class Output_section;
 class General_options;
 class Layout;
+class Input_objects;
+class Workqueue;
+class Task_token;
+
+// The references from the sections of a single Relobj to other
+// sections, used for garbage collection.  References are collected
+// in a list while the relocations of the object are processed, and
+// are then converted into compressed sparse row form: the sections
+// referenced by section SHNDX are refs_[index_[SHNDX]] up to but not
+// including refs_[index_[SHNDX + 1]].  This also holds a mark for
+// each section of the object, which is set once the section is known
+// to be referenced.
+
+class Gc_refs
+{
+ public:
+  Gc_refs()
+    : pending_(), index_(), refs_(), marks_()
+  { }
+
+  // Add a reference from section SRC_SHNDX to DST.  This may not be
+  // called by two threads at once.
+  void
+  add(unsigned int src_shndx, const Section_id& dst)
+  { this->pending_.push_back(std::make_pair(src_shndx, dst)); }
+
+  // Return whether there are references which have been added since
+  // the last call to finalize.
+  bool
+  has_pending() const
+  { return !this->pending_.empty(); }
+
+  // Merge the references added since the last call into the
+  // compressed form, for an object with SHNUM sections, and make room
+  // for the marks.
+  void
+  finalize(unsigned int shnum);
+
+  // Set *PBEGIN and *PEND to the range of sections referenced by
+  // section SHNDX.
+  void
+  refs(unsigned int shndx, const Section_id** pbegin,
+       const Section_id** pend) const
+  {
+    if (shndx + 1 >= this->index_.size())
+      {
+	*pbegin = NULL;
+	*pend = NULL;
+	return;
+      }
+    const Section_id* base = this->refs_.empty() ? NULL : &this->refs_[0];
+    *pbegin = base + this->index_[shndx];
+    *pend = base + this->index_[shndx + 1];
+  }
+
+  // Mark section SHNDX as referenced.  Return true if it was not
+  // already marked.  This may be called by several threads at once.
+  bool
+  mark(unsigned int shndx)
+  {
+    if (shndx >= this->marks_.size())
+      return false;
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_1
+    return __sync_bool_compare_and_swap(&this->marks_[shndx], 0, 1);
+#else
+    if (this->marks_[shndx] != 0)
+      return false;
+    this->marks_[shndx] = 1;
+    return true;
+#endif
+  }
+
+  // Return whether section SHNDX has been marked.
+  bool
+  is_marked(unsigned int shndx) const
+  { return shndx < this->marks_.size() && this->marks_[shndx] != 0; }
+
+  // Free the references, keeping the marks.
+  void
+  clear_refs();
+
+ private:
+  typedef std::vector<std::pair<unsigned int, Section_id> > Pending_refs;
+
+  // References added since the last call to finalize.
+  Pending_refs pending_;
+  // For each section, the index in refs_ of its first reference.
+  // This has one more entry than there are sections.
+  std::vector<unsigned int> index_;
+  // The referenced sections.
+  std::vector<Section_id> refs_;
+  // Nonzero for each section which is known to be referenced.
+  std::vector<unsigned char> marks_;
+};
 
 class Garbage_collection
 {
  public:
 
   typedef Unordered_set<Section_id, Section_id_hash> Sections_reachable;
-  typedef std::map<Section_id, Sections_reachable> Section_ref;
   typedef std::vector<Section_id> Worklist_type;
   // This maps the name of the section which can be represented as a C
   // identifier (cident) to the list of sections that have that name.
@@ -55,19 +148,12 @@ class Garbage_collection
   typedef std::map<std::string, Sections_reachable> Cident_section_map;
 
   Garbage_collection()
-  : is_worklist_ready_(false)
+  : is_worklist_ready_(false), input_objects_(NULL), frontier_(),
+    next_frontiers_()
   { }
 
   // Accessor methods for the private members.
 
-  Sections_reachable&
-  referenced_list()
-  { return referenced_list_; }
-
-  Section_ref&
-  section_reloc_map()
-  { return this->section_reloc_map_; }
-
   Worklist_type&
   worklist()
   { return this->work_list_; }
@@ -80,13 +166,41 @@ class Garbage_collection
   worklist_ready()
   { this->is_worklist_ready_ = true; }
 
+  // Get ready to find the sections reachable from the work list.
+  // This must be called once all references have been added.
+  void
+  start_transitive_closure(const Input_objects*);
+
+  // Mark the sections reachable from the work list.  If the marking
+  // is split among tasks, queue them and return a blocker; the caller
+  // must call this again once the blocker is unblocked.  Return NULL
+  // once all reachable sections are marked.
+  Task_token*
+  do_transitive_closure(Workqueue*);
+
+  // Mark the sections referenced by the entries BEGIN up to END of the
+  // current frontier, and add the newly marked ones to *NEXT.  This
+  // may be called by several tasks at once.
+  void
+  mark_sections(size_t begin, size_t end, Worklist_type* next);
+
+  // Convert the references found in OBJ into their compressed form.
+  // This is called by the task which processed the relocations of
+  // OBJ.
   void
-  do_transitive_closure();
+  finalize_references(Relobj* obj)
+  {
+    Gc_refs* refs = obj->gc_refs();
+    if (refs != NULL)
+      refs->finalize(obj->shnum());
+  }
 
   bool
   is_section_garbage(Relobj* obj, unsigned int shndx)
-  { return (this->referenced_list().find(Section_id(obj, shndx))
-            == this->referenced_list().end()); }
+  {
+    Gc_refs* refs = obj->gc_refs();
+    return refs == NULL || !refs->is_marked(shndx);
+  }
 
   Cident_section_map*
   cident_sections()
@@ -98,24 +212,34 @@ class Garbage_collection
   { this->cident_sections_[section_name].insert(secn); }
 
   // Add a reference from the SRC_SHNDX-th section of SRC_OBJECT to
-  // DST_SHNDX-th section of DST_OBJECT.
+  // DST_SHNDX-th section of DST_OBJECT.  This may be called by
+  // several threads at once for different SRC_OBJECTs.
   void
   add_reference(Relobj* src_object, unsigned int src_shndx,
 		Relobj* dst_object, unsigned int dst_shndx)
   {
-    Section_id src_id(src_object, src_shndx);
-    Section_id dst_id(dst_object, dst_shndx);
-    Sections_reachable& reachable = this->section_reloc_map_[src_id];
-    reachable.insert(dst_id);
+    Gc_refs* refs = src_object->gc_refs();
+    if (refs == NULL)
+      {
+	refs = new Gc_refs();
+	src_object->set_gc_refs(refs);
+      }
+    refs->add(src_shndx, Section_id(dst_object, dst_shndx));
   }
 
  private:
 
   Worklist_type work_list_;
   bool is_worklist_ready_;
-  Section_ref section_reloc_map_;
-  Sections_reachable referenced_list_;
   Cident_section_map cident_sections_;
+  // The input objects, set by start_transitive_closure.
+  const Input_objects* input_objects_;
+  // The sections marked by the last step of the transitive closure,
+  // whose references have not yet been followed.
+  Worklist_type frontier_;
+  // The sections marked by each of the tasks following the
+  // references from frontier_.
+  std::vector<Worklist_type> next_frontiers_;
 };
 
 // Data to pass between successive invocations of do_layout
@@ -352,16 +476,14 @@ gc_process_relocs(
                 symtab->gc()->cident_sections()->find(std::string(cident_section_name));
               if (ele == symtab->gc()->cident_sections()->end())
                 continue;
-	      Section_id src_id(src_obj, src_indx);
-              Garbage_collection::Sections_reachable&
-                v(symtab->gc()->section_reloc_map()[src_id]);
               Garbage_collection::Sections_reachable& cident_secn(ele->second);
               for (Garbage_collection::Sections_reachable::iterator it_v
                      = cident_secn.begin();
                    it_v != cident_secn.end();
                    ++it_v)
                 {
-                  v.insert(*it_v);
+		  symtab->gc()->add_reference(src_obj, src_indx,
+					      it_v->first, it_v->second);
                 }
             }
         }
@@ -28,6 +28,7 @@
 #include "object.h"
 #include "output.h"
 #include "demangle.h"
+#include "workqueue.h"
 
 namespace gold
 {
@@ -171,6 +172,217 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+// The .gdb_index tables built from the .debug_info and .debug_types
+// sections of a single object.  The compilation unit and type unit
+// indexes are local to the object; they are adjusted when the tables
+// are merged.
+
+class Gdb_index_tables
+{
+ public:
+  Gdb_index_tables(Relobj* object)
+    : object_(object), sections_(), symbols_(NULL), symbols_size_(0),
+      comp_units_(), type_units_(), ranges_(), symbol_map_(),
+      symbol_list_(), cu_pubname_map_(), cu_pubtype_map_(),
+      pubnames_table_(NULL), pubtypes_table_(NULL), pubnames_object_(NULL),
+      stmt_list_offset_(-1), dwarf_cu_count_(0),
+      dwarf_cu_nopubnames_count_(0), dwarf_tu_count_(0),
+      dwarf_tu_nopubnames_count_(0)
+  { }
+
+  ~Gdb_index_tables()
+  {
+    delete[] this->symbols_;
+    delete this->pubnames_table_;
+    delete this->pubtypes_table_;
+  }
+
+  // Return the object.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Add a section to scan later.  SYMBOLS is copied the first time
+  // this is called.
+  void
+  add_section(bool is_type_unit, const unsigned char* symbols,
+	      off_t symbols_size, unsigned int shndx,
+	      unsigned int reloc_shndx, unsigned int reloc_type);
+
+  // Return whether there are sections to scan.
+  bool
+  has_sections() const
+  { return !this->sections_.empty(); }
+
+  // Scan the sections added by add_section.
+  void
+  scan();
+
+  // Scan a .debug_info or .debug_types input section.
+  void
+  scan_debug_info(bool is_type_unit,
+		  const unsigned char* symbols,
+		  off_t symbols_size,
+		  unsigned int shndx,
+		  unsigned int reloc_shndx,
+		  unsigned int reloc_type);
+
+  // Add a compilation unit.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    ++this->dwarf_cu_count_;
+    this->comp_units_.push_back(Gdb_index::Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    ++this->dwarf_tu_count_;
+    this->type_units_.push_back(Gdb_index::Type_unit(tu_offset, type_offset,
+						     signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Record that a compilation unit or type unit had no pubnames.
+  void
+  add_nopubnames(bool is_type_unit)
+  {
+    if (is_type_unit)
+      ++this->dwarf_tu_nopubnames_count_;
+    else
+      ++this->dwarf_cu_nopubnames_count_;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(unsigned int cu_index, Dwarf_range_list* ranges)
+  {
+    this->ranges_.push_back(Gdb_index::Per_cu_range_list(this->object_,
+							 cu_index, ranges));
+  }
+
+  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
+  // the high-byte of the cu_index field.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set for the CUs and TUS associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset) const
+  {
+    return (this->pubnames_object_ == this->object_
+	    && this->stmt_list_offset_ == offset);
+  }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  {
+    this->pubnames_object_ = this->object_;
+    this->stmt_list_offset_ = offset;
+  }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return this->pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return this->pubtypes_table_; }
+
+ private:
+  friend class Gdb_index;
+  friend class Gdb_index_info_reader;
+
+  // A section to scan.
+  struct Section
+  {
+    Section(bool is_type, unsigned int index, unsigned int rel_shndx,
+	    unsigned int rel_type)
+      : is_type_unit(is_type), shndx(index), reloc_shndx(rel_shndx),
+	reloc_type(rel_type)
+    { }
+
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  // A symbol, with the units which refer to it in the order in
+  // which they were found.
+  struct Symbol_entry
+  {
+    std::string name;
+    unsigned int hashval;
+    Gdb_index::Cu_vector cu_vector;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Create a map from dies to pubnames.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+                       Gdb_index_info_reader* dwinfo,
+                       const unsigned char* symbols,
+                       off_t symbols_size);
+
+  // Wrapper for map_pubtable_to_dies
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+                                 const unsigned char* symbols,
+                                 off_t symbols_size);
+
+  // The object.
+  Relobj* object_;
+  // The sections to scan.
+  std::vector<Section> sections_;
+  // A copy of the symbol table of the object.
+  unsigned char* symbols_;
+  off_t symbols_size_;
+  // The compilation units, type units and address ranges.
+  std::vector<Gdb_index::Comp_unit> comp_units_;
+  std::vector<Gdb_index::Type_unit> type_units_;
+  std::vector<Gdb_index::Per_cu_range_list> ranges_;
+  // Map from a symbol name to its index in symbol_list_.
+  Unordered_map<std::string, unsigned int> symbol_map_;
+  // The symbols, in the order in which they were first found.
+  std::vector<Symbol_entry> symbol_list_;
+  // Maps from CU offsets to offsets in the pubnames and pubtypes
+  // tables.
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // The pubnames and pubtypes tables of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  // Object, stmt list offset of the CUs and TUs associated with the
+  // last read pubnames and pubtypes sections.
+  const Relobj* pubnames_object_;
+  off_t stmt_list_offset_;
+  // Statistics.
+  unsigned int dwarf_cu_count_;
+  unsigned int dwarf_cu_nopubnames_count_;
+  unsigned int dwarf_tu_count_;
+  unsigned int dwarf_tu_nopubnames_count_;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,15 +395,19 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_tables* tables)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      tables_(tables), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
+  // Add the statistics for TABLES.
+  static void
+  add_stats(const Gdb_index_tables* tables);
+
   // Print usage statistics.
   static void
   print_stats();
@@ -285,8 +501,8 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
+  // The tables for the object.
+  Gdb_index_tables* tables_;
   // The current CU index (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
@@ -321,8 +537,7 @@ void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  this->cu_index_ = this->tables_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +548,9 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->tables_->add_type_unit(tu_offset, type_offset,
+						      signature);
   this->visit_top_die(root_die);
 }
 
@@ -380,10 +594,8 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 			     this->object()->name().c_str());
 		return;
 	      }
-	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
-	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	    this->tables_->add_nopubnames(die->tag()
+					  == elfcpp::DW_TAG_type_unit);
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -437,8 +649,8 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
-                                           full_name.c_str(), 0);
+	      this->tables_->add_symbol(this->cu_index_,
+					full_name.c_str(), 0);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -477,8 +689,8 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str(), 0);
+		this->tables_->add_symbol(this->cu_index_,
+					  full_name.c_str(), 0);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -825,8 +1037,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->tables_->add_address_range_list(this->cu_index_, ranges);
       return;
     }
 
@@ -851,8 +1062,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->tables_->add_address_range_list(this->cu_index_, ranges);
         }
     }
 }
@@ -877,7 +1087,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->tables_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -916,8 +1126,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
+          return this->tables_->pubnames_read(stmt_list_off);
         }
       else
         {
@@ -928,10 +1137,10 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 
   // We found the attribute, so we can check if the corresponding
   // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  if (this->tables_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->tables_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -939,12 +1148,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->tables_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->tables_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->tables_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->tables_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -964,6 +1173,20 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
+// Add the statistics for TABLES.  This is called when the tables are
+// merged, so it need not be thread safe.
+
+void
+Gdb_index_info_reader::add_stats(const Gdb_index_tables* tables)
+{
+  Gdb_index_info_reader::dwarf_cu_count += tables->dwarf_cu_count_;
+  Gdb_index_info_reader::dwarf_cu_nopubnames_count
+    += tables->dwarf_cu_nopubnames_count_;
+  Gdb_index_info_reader::dwarf_tu_count += tables->dwarf_tu_count_;
+  Gdb_index_info_reader::dwarf_tu_nopubnames_count
+    += tables->dwarf_tu_nopubnames_count_;
+}
+
 // Print usage statistics.
 void
 Gdb_index_info_reader::print_stats()
@@ -978,41 +1201,66 @@ Gdb_index_info_reader::print_stats()
           program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
 }
 
-// Class Gdb_index.
+// Class Gdb_index_tables.
 
-// Construct the .gdb_index section.
+// Add a section to scan later.
 
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
+void
+Gdb_index_tables::add_section(bool is_type_unit,
+			      const unsigned char* symbols,
+			      off_t symbols_size,
+			      unsigned int shndx,
+			      unsigned int reloc_shndx,
+			      unsigned int reloc_type)
 {
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  // The symbol table of the object is freed once the object is laid
+  // out, so we keep our own copy for the scan.
+  if (this->sections_.empty() && this->symbols_ == NULL)
+    {
+      this->symbols_ = new unsigned char[symbols_size];
+      memcpy(this->symbols_, symbols, symbols_size);
+      this->symbols_size_ = symbols_size;
+    }
+  this->sections_.push_back(Section(is_type_unit, shndx, reloc_shndx,
+				    reloc_type));
 }
 
-Gdb_index::~Gdb_index()
+// Scan the sections added by add_section, and free the copy of the
+// symbol table.  The object must be locked.
+
+void
+Gdb_index_tables::scan()
 {
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
+  for (std::vector<Section>::const_iterator p = this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    this->scan_debug_info(p->is_type_unit, this->symbols_,
+			  this->symbols_size_, p->shndx, p->reloc_shndx,
+			  p->reloc_type);
+  std::vector<Section>().swap(this->sections_);
+  delete[] this->symbols_;
+  this->symbols_ = NULL;
+  this->symbols_size_ = 0;
 }
 
+// Scan a .debug_info or .debug_types input section.
+
+void
+Gdb_index_tables::scan_debug_info(bool is_type_unit,
+				  const unsigned char* symbols,
+				  off_t symbols_size,
+				  unsigned int shndx,
+				  unsigned int reloc_shndx,
+				  unsigned int reloc_type)
+{
+  Gdb_index_info_reader dwinfo(is_type_unit, this->object_,
+			       symbols, symbols_size,
+			       shndx, reloc_shndx,
+			       reloc_type, this);
+  if (this->pubnames_object_ != this->object_)
+    this->map_pubnames_and_types_to_dies(&dwinfo, symbols, symbols_size);
+  dwinfo.parse();
+}
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1020,11 +1268,10 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index_tables::map_pubtable_to_dies(unsigned int attr,
+				       Gdb_index_info_reader* dwinfo,
+				       const unsigned char* symbols,
+				       off_t symbols_size)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1042,7 +1289,7 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
+  if (!table->read_section(this->object_, symbols, symbols_size))
     return NULL;
 
   while (table->read_header(section_offset))
@@ -1057,30 +1304,31 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
 // Wrapper for map_pubtable_to_dies
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index_tables::map_pubnames_and_types_to_dies(
+    Gdb_index_info_reader* dwinfo,
+    const unsigned char* symbols,
+    off_t symbols_size)
 {
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
+  // This is the first section of the object, so reset the relevant
+  // variables.
+  this->pubnames_object_ = this->object_;
   this->stmt_list_offset_ = -1;
 
   delete this->pubnames_table_;
   this->pubnames_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
+                                   symbols, symbols_size);
   delete this->pubtypes_table_;
   this->pubtypes_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+                                   symbols, symbols_size);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index_tables::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1092,7 +1340,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index_tables::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1100,81 +1348,274 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
   return -1;
 }
 
-// Scan a .debug_info or .debug_types input section.
+// Add a symbol.  Like Gdb_index::merge_tables, we only add CU_INDEX
+// to the list for the symbol if it differs from the last entry.
 
 void
-Gdb_index::scan_debug_info(bool is_type_unit,
-			   Relobj* object,
-			   const unsigned char* symbols,
-			   off_t symbols_size,
-			   unsigned int shndx,
-			   unsigned int reloc_shndx,
-			   unsigned int reloc_type)
+Gdb_index_tables::add_symbol(int cu_index, const char* sym_name,
+			     uint8_t flags)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  std::pair<Unordered_map<std::string, unsigned int>::iterator, bool> ins =
+    this->symbol_map_.insert(std::make_pair(std::string(sym_name),
+					    this->symbol_list_.size()));
+  if (ins.second)
+    {
+      this->symbol_list_.push_back(Symbol_entry());
+      Symbol_entry& entry(this->symbol_list_.back());
+      entry.name = ins.first->first;
+      entry.hashval = mapped_index_string_hash(
+	  reinterpret_cast<const unsigned char*>(sym_name));
+    }
+
+  Gdb_index::Cu_vector& cu_vec(this->symbol_list_[ins.first->second].cu_vector);
+  if (cu_vec.size() == 0
+      || cu_vec.back().first != cu_index
+      || cu_vec.back().second != flags)
+    cu_vec.push_back(std::make_pair(cu_index, flags));
 }
 
-// Add a symbol.
+// A task to scan the debug info of one object.
+
+class Gdb_index_scan_task : public Task
+{
+ public:
+  Gdb_index_scan_task(Gdb_index_tables* tables, Task_token* next_blocker)
+    : tables_(tables), next_blocker_(next_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->tables_->object()->is_locked())
+      return this->tables_->object()->token();
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->tables_->object()->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->next_blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->tables_->scan();
+    this->tables_->object()->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->tables_->object()->name(); }
+
+ private:
+  Gdb_index_tables* tables_;
+  Task_token* next_blocker_;
+};
+
+// A task which does nothing but wait for THIS_BLOCKER, so that a
+// single blocker covers both the tasks it follows and the scan
+// tasks.
+
+class Gdb_index_wait_task : public Task
+{
+ public:
+  Gdb_index_wait_task(Task_token* this_blocker, Task_token* next_blocker)
+    : this_blocker_(this_blocker), next_blocker_(next_blocker)
+  { }
+
+  ~Gdb_index_wait_task()
+  { delete this->this_blocker_; }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  { }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_wait_task"; }
+
+ private:
+  Task_token* this_blocker_;
+  Task_token* next_blocker_;
+};
+
+// Class Gdb_index.
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    tables_(),
+    gdb_index_section_(gdb_index_section),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0)
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  for (unsigned int i = 0; i < this->tables_.size(); ++i)
+    delete this->tables_[i];
+}
+
+// Add a .debug_info or .debug_types input section.  The sections of
+// an object are all added at once, so we only need to check the
+// last tables.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+Gdb_index::add_debug_info(bool is_type_unit,
+			  Relobj* object,
+			  const unsigned char* symbols,
+			  off_t symbols_size,
+			  unsigned int shndx,
+			  unsigned int reloc_shndx,
+			  unsigned int reloc_type)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
-  Gdb_symbol* sym = new Gdb_symbol();
-  this->stringpool_.add(sym_name, true, &sym->name_key);
-  sym->hashval = hash;
-  sym->cu_vector_index = 0;
-
-  Gdb_symbol* found = this->gdb_symtab_->add(sym);
-  if (found == sym)
-    {
-      // New symbol -- allocate a new CU index vector.
-      found->cu_vector_index = this->cu_vector_list_.size();
-      this->cu_vector_list_.push_back(new Cu_vector());
-    }
+  if (this->tables_.empty() || this->tables_.back()->object() != object)
+    this->tables_.push_back(new Gdb_index_tables(object));
+  Gdb_index_tables* tables = this->tables_.back();
+
+  // Without a symbol table, as for an incremental update, we scan
+  // the section now.
+  if (symbols == NULL)
+    tables->scan_debug_info(is_type_unit, symbols, symbols_size, shndx,
+			    reloc_shndx, reloc_type);
   else
-    {
-      // Found an existing symbol -- append to the existing
-      // CU index vector.
-      delete sym;
-    }
-
-  // Add the CU index to the vector list for this symbol,
-  // if it's not already on the list.  We only need to
-  // check the last added entry.
-  Cu_vector* cu_vec = this->cu_vector_list_[found->cu_vector_index];
-  if (cu_vec->size() == 0
-      || cu_vec->back().first != cu_index
-      || cu_vec->back().second != flags)
-    cu_vec->push_back(std::make_pair(cu_index, flags));
+    tables->add_section(is_type_unit, symbols, symbols_size, shndx,
+			reloc_shndx, reloc_type);
 }
 
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
+// Queue a task for each object with sections to scan.
 
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
+Task_token*
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* this_blocker)
 {
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
+  Task_token* next_blocker = new Task_token(true);
+  next_blocker->add_blocker();
+  for (unsigned int i = 0; i < this->tables_.size(); ++i)
+    if (this->tables_[i]->has_sections())
+      next_blocker->add_blocker();
+
+  workqueue->queue(new Gdb_index_wait_task(this_blocker, next_blocker));
+  for (unsigned int i = 0; i < this->tables_.size(); ++i)
+    if (this->tables_[i]->has_sections())
+      workqueue->queue(new Gdb_index_scan_task(this->tables_[i],
+					       next_blocker));
+  return next_blocker;
 }
 
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
+// Merge the tables of each object in turn.  We add the units and
+// symbols in the order in which they were found, so the result is
+// the same as scanning all the objects in order.
 
 void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
+Gdb_index::merge_tables()
 {
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
+  for (unsigned int i = 0; i < this->tables_.size(); ++i)
+    {
+      Gdb_index_tables* tables = this->tables_[i];
+      gold_assert(!tables->has_sections());
+      Gdb_index_info_reader::add_stats(tables);
+
+      // Indexes of type units are negative.
+      int cu_base = this->comp_units_.size();
+      int tu_base = this->type_units_.size();
+      this->comp_units_.insert(this->comp_units_.end(),
+			       tables->comp_units_.begin(),
+			       tables->comp_units_.end());
+      this->type_units_.insert(this->type_units_.end(),
+			       tables->type_units_.begin(),
+			       tables->type_units_.end());
+      for (std::vector<Per_cu_range_list>::iterator p =
+	     tables->ranges_.begin();
+	   p != tables->ranges_.end();
+	   ++p)
+	{
+	  int cu_index = static_cast<int>(p->cu_index);
+	  cu_index = cu_index < 0 ? cu_index - tu_base : cu_index + cu_base;
+	  this->ranges_.push_back(Per_cu_range_list(p->object, cu_index,
+						    p->ranges));
+	}
+
+      for (std::vector<Gdb_index_tables::Symbol_entry>::const_iterator p =
+	     tables->symbol_list_.begin();
+	   p != tables->symbol_list_.end();
+	   ++p)
+	{
+	  Gdb_symbol* sym = new Gdb_symbol();
+	  this->stringpool_.add(p->name.c_str(), true, &sym->name_key);
+	  sym->hashval = p->hashval;
+	  sym->cu_vector_index = 0;
+
+	  Gdb_symbol* found = this->gdb_symtab_->add(sym);
+	  if (found == sym)
+	    {
+	      // New symbol -- allocate a new CU index vector.
+	      found->cu_vector_index = this->cu_vector_list_.size();
+	      this->cu_vector_list_.push_back(new Cu_vector());
+	    }
+	  else
+	    {
+	      // Found an existing symbol -- append to the existing
+	      // CU index vector.
+	      delete sym;
+	    }
+
+	  // Add the CU indexes to the vector list for this symbol.
+	  // We only need to check the last added entry for
+	  // duplicates.
+	  Cu_vector* cu_vec = this->cu_vector_list_[found->cu_vector_index];
+	  for (Cu_vector::const_iterator q = p->cu_vector.begin();
+	       q != p->cu_vector.end();
+	       ++q)
+	    {
+	      int cu_index = q->first;
+	      cu_index = cu_index < 0 ? cu_index - tu_base : cu_index + cu_base;
+	      if (cu_vec->size() == 0
+		  || cu_vec->back().first != cu_index
+		  || cu_vec->back().second != q->second)
+		cu_vec->push_back(std::make_pair(cu_index, q->second));
+	    }
+	}
+
+      delete tables;
+    }
+  this->tables_.clear();
 }
 
 // Set the size of the .gdb_index section.
@@ -1182,6 +1623,8 @@ Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
 void
 Gdb_index::set_final_data_size()
 {
+  this->merge_tables();
+
   // Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
@@ -134,6 +134,88 @@ Middle_runner::run(Workqueue* workqueue, const Task* task)
 		     this->layout_, workqueue, this->mapfile_);
 }
 
+// This class runs identical code folding once the contents of the
+// candidate sections have been computed, and then queues the rest of
+// the middle tasks.
+
+class Icf_runner : public Task_function_runner
+{
+ public:
+  Icf_runner(const General_options& options,
+	     const Input_objects* input_objects,
+	     Symbol_table* symtab,
+	     Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Icf_runner::run(Workqueue* workqueue, const Task* task)
+{
+  this->symtab_->icf()->find_identical_sections(this->input_objects_,
+						this->symtab_);
+  queue_middle_layout_tasks(this->options_, task, this->input_objects_,
+			    this->symtab_, this->layout_, workqueue,
+			    this->mapfile_);
+}
+
+// This class continues marking the sections which are not garbage
+// once the marking tasks queued so far are done, and then queues the
+// rest of the middle tasks.
+
+class Gc_mark_runner : public Task_function_runner
+{
+ public:
+  Gc_mark_runner(const General_options& options,
+		 const Input_objects* input_objects,
+		 Symbol_table* symtab,
+		 Layout* layout, Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      layout_(layout), mapfile_(mapfile)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
+void
+Gc_mark_runner::run(Workqueue* workqueue, const Task* task)
+{
+  Task_token* blocker = this->symtab_->gc()->do_transitive_closure(workqueue);
+  if (blocker != NULL)
+    {
+      workqueue->queue(new Task_function(new Gc_mark_runner(this->options_,
+							    this->input_objects_,
+							    this->symtab_,
+							    this->layout_,
+							    this->mapfile_),
+					 blocker,
+					 "Task_function Gc_mark_runner"));
+      return;
+    }
+  queue_middle_icf_tasks(this->options_, task, this->input_objects_,
+			 this->symtab_, this->layout_, workqueue,
+			 this->mapfile_);
+}
+
 // This class arranges the tasks to process the relocs for garbage collection.
 
 class Gc_runner : public Task_function_runner
@@ -223,6 +305,13 @@ queue_initial_tasks(const General_options& options,
 	}
     }
 
+  // Index the input section specs of a SECTIONS clause given on the
+  // command line, so that Read_symbols can match the input sections
+  // against them in parallel.
+  Script_sections* ss = layout->script_options()->script_sections();
+  if (ss->saw_sections_clause())
+    ss->build_input_section_index();
+
   // Read the input files.  We have to add the symbols to the symbol
   // table in order.  We do this by creating a separate blocker for
   // each input file.  We associate the blocker with the following
@@ -445,17 +534,38 @@ queue_middle_gc_tasks(const General_options& options,
 {
   // Read_relocs for all the objects must be done and processed to find
   // unused sections before any scanning of the relocs can take place.
+  // When only garbage collecting, each object only records the
+  // references from its own sections, so the objects may be processed
+  // in parallel.  Otherwise we process them one at a time.
   Task_token* this_blocker = NULL;
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
-       ++p)
+  if (!options.icf_enabled()
+      && input_objects->number_of_relobjs() > 0
+      && parameters->target().may_gc_process_relocs_in_parallel())
     {
       Task_token* next_blocker = new Task_token(true);
-      next_blocker->add_blocker();
-      workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
-				       next_blocker));
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  next_blocker->add_blocker();
+	  workqueue->queue(new Read_relocs(symtab, layout, *p, NULL,
+					   next_blocker));
+	}
       this_blocker = next_blocker;
     }
+  else
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  Task_token* next_blocker = new Task_token(true);
+	  next_blocker->add_blocker();
+	  workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
+					   next_blocker));
+	  this_blocker = next_blocker;
+	}
+    }
 
   // If we are given only archives in input, we have no regular
   // objects and THIS_BLOCKER is NULL here.  Create a dummy
@@ -521,18 +631,76 @@ queue_middle_tasks(const General_options& options,
       // Symbols named with -u should not be considered garbage.
       symtab->gc_mark_undef_symbols(layout);
       gold_assert(symtab->gc() != NULL);
-      // Do a transitive closure on all references to determine the worklist.
-      symtab->gc()->do_transitive_closure();
+      // Do a transitive closure on all references to determine the
+      // worklist.  If this is split among tasks, Gc_mark_runner
+      // queues the rest of the middle tasks once they are done.
+      symtab->gc()->start_transitive_closure(input_objects);
+      Task_token* blocker = symtab->gc()->do_transitive_closure(workqueue);
+      if (blocker != NULL)
+	{
+	  workqueue->queue(new Task_function(new Gc_mark_runner(options,
+								input_objects,
+								symtab,
+								layout,
+								mapfile),
+					     blocker,
+					     "Task_function Gc_mark_runner"));
+	  return;
+	}
     }
 
+  queue_middle_icf_tasks(options, task, input_objects, symtab, layout,
+			 workqueue, mapfile);
+}
+
+// Queue up the rest of the middle set of tasks, once garbage
+// collection, if any, has been done.
+
+void
+queue_middle_icf_tasks(const General_options& options,
+		       const Task* task,
+		       const Input_objects* input_objects,
+		       Symbol_table* symtab,
+		       Layout* layout,
+		       Workqueue* workqueue,
+		       Mapfile* mapfile)
+{
   // If identical code folding (--icf) is chosen it makes sense to do it
   // only after garbage collection (--gc-sections) as we do not want to
-  // be folding sections that will be garbage.
+  // be folding sections that will be garbage.  The contents of the
+  // candidate sections are computed by tasks, and the rest of the
+  // middle tasks are queued by Icf_runner once they are done.
   if (parameters->options().icf_enabled())
     {
-      symtab->icf()->find_identical_sections(input_objects, symtab);
+      Task_token* icf_blocker =
+	symtab->icf()->queue_section_contents_tasks(input_objects, symtab,
+						    workqueue);
+      workqueue->queue(new Task_function(new Icf_runner(options,
+							input_objects,
+							symtab,
+							layout,
+							mapfile),
+					 icf_blocker,
+					 "Task_function Icf_runner"));
+      return;
     }
 
+  queue_middle_layout_tasks(options, task, input_objects, symtab, layout,
+			    workqueue, mapfile);
+}
+
+// Queue up the rest of the middle set of tasks, once identical code
+// folding, if any, has been done.
+
+void
+queue_middle_layout_tasks(const General_options& options,
+			  const Task* task,
+			  const Input_objects* input_objects,
+			  Symbol_table* symtab,
+			  Layout* layout,
+			  Workqueue* workqueue,
+			  Mapfile* mapfile)
+{
   // Call Object::layout for the second time to determine the
   // output_sections for all referenced input sections.  When
   // --gc-sections or --icf is turned on, or when certain input
@@ -563,12 +731,20 @@ queue_middle_tasks(const General_options& options,
   // Finalize the .eh_frame section.
   layout->finalize_eh_frame_section();
 
-  /* If plugins have specified a section order, re-arrange input sections
-     according to a specified section order.  If --section-ordering-file is
-     also specified, do not do anything here.  */
-  if (parameters->options().has_plugins()
+  // With --call-graph-ordering-file, compute the section order now that
+  // we know which sections define the functions in the profile.
+  if (parameters->options().call_graph_ordering_file())
+    layout->order_sections_by_call_graph(task, symtab);
+
+  /* If plugins or a call graph profile have specified a section order,
+     re-arrange input sections according to a specified section order.
+     If --section-ordering-file or --symbol-ordering-file is also
+     specified, do not do anything here.  */
+  if ((parameters->options().has_plugins()
+       || parameters->options().call_graph_ordering_file())
       && layout->is_section_ordering_specified()
-      && !parameters->options().section_ordering_file ())
+      && !parameters->options().section_ordering_file ()
+      && !parameters->options().symbol_ordering_file ())
     {
       for (Layout::Section_list::const_iterator p
 	     = layout->section_list().begin();
@@ -771,6 +947,10 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
+  // Scan the debug info for the .gdb_index section while the
+  // relocations are being scanned.
+  this_blocker = layout->queue_gdb_index_tasks(workqueue, this_blocker);
+
   // When all those tasks are complete, we can start laying out the
   // output file.
   workqueue->queue(new Task_function(new Layout_task_runner(options,
@@ -872,15 +1052,28 @@ queue_final_tasks(const General_options& options,
     {
       Task_token* new_final_blocker = new Task_token(true);
       new_final_blocker->add_blocker();
-      Task* t = new Write_after_input_sections_task(layout, of,
-						    final_blocker,
-						    new_final_blocker);
+      Task* t;
+      if (layout->any_compressed_sections())
+	{
+	  // Compress the debug sections in parallel before writing
+	  // out the postprocessing sections.
+	  t = new Task_function(new Compress_sections_task_runner(layout, of,
+								  new_final_blocker),
+				final_blocker,
+				"Task_function Compress_sections_task_runner");
+	}
+      else
+	t = new Write_after_input_sections_task(layout, of,
+						final_blocker,
+						new_final_blocker);
       workqueue->queue(t);
       final_blocker = new_final_blocker;
     }
 
-  // Create tasks for tree-style build ID computation, if necessary.
-  if (strcmp(options.build_id(), "tree") == 0)
+  // Create tasks for tree-style or fast build ID computation, if
+  // necessary.
+  if (strcmp(options.build_id(), "tree") == 0
+      || strcmp(options.build_id(), "fast") == 0)
     {
       // Queue a task to compute the build id.  This will be blocked by
       // FINAL_BLOCKER, and will in turn schedule the task to close
@@ -232,6 +232,28 @@ queue_middle_tasks(const General_options&,
 		   Workqueue*,
 		   Mapfile*);
 
+// Queue up the rest of the middle set of tasks, after garbage
+// collection.
+extern void
+queue_middle_icf_tasks(const General_options&,
+		       const Task*,
+		       const Input_objects*,
+		       Symbol_table*,
+		       Layout*,
+		       Workqueue*,
+		       Mapfile*);
+
+// Queue up the rest of the middle set of tasks, after identical code
+// folding.
+extern void
+queue_middle_layout_tasks(const General_options&,
+			  const Task*,
+			  const Input_objects*,
+			  Symbol_table*,
+			  Layout*,
+			  Workqueue*,
+			  Mapfile*);
+
 // Queue up the final set of tasks.
 extern void
 queue_final_tasks(const General_options&,
@@ -1014,6 +1014,16 @@ Target_i386::rel_dyn_section(Layout* layout)
       layout->add_output_section_data(".rel.dyn", elfcpp::SHT_REL,
 				      elfcpp::SHF_ALLOC, this->rel_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<32, false>* relr =
+	    new Output_data_relr<32, false>(elfcpp::R_386_RELATIVE);
+	  layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+					  elfcpp::SHF_ALLOC, relr,
+					  ORDER_DYNAMIC_RELOCS, false);
+	  this->rel_dyn_->set_relr_section(relr);
+	}
     }
   return this->rel_dyn_;
 }
@@ -1410,11 +1420,16 @@ Output_data_plt_i386::do_write(Output_file* of)
   gold_assert(parameters->incremental_update()
 	      || (got_file_offset + this->got_plt_->data_size()
 		  == this->got_irelative_->offset()));
+  // The first three entries in the GOT are reserved, and are written
+  // by Output_data_got_plt_i386::do_write, so our view of the GOT
+  // starts after them.
+  const off_t got_view_offset = got_file_offset + 12;
   const section_size_type got_size =
     convert_to_section_size_type(this->got_plt_->data_size()
-				 + this->got_irelative_->data_size());
+				 + this->got_irelative_->data_size()
+				 - 12);
 
-  unsigned char* const got_view = of->get_output_view(got_file_offset,
+  unsigned char* const got_view = of->get_output_view(got_view_offset,
 						      got_size);
 
   unsigned char* pov = oview;
@@ -1425,9 +1440,7 @@ Output_data_plt_i386::do_write(Output_file* of)
   this->fill_first_plt_entry(pov, got_address);
   pov += this->get_plt_entry_size();
 
-  // The first three entries in the GOT are reserved, and are written
-  // by Output_data_got_plt_i386::do_write.
-  unsigned char* got_pov = got_view + 12;
+  unsigned char* got_pov = got_view;
 
   const int rel_size = elfcpp::Elf_sizes<32>::rel_size;
 
@@ -1487,7 +1500,7 @@ Output_data_plt_i386::do_write(Output_file* of)
   gold_assert(static_cast<section_size_type>(got_pov - got_view) == got_size);
 
   of->write_output_view(offset, oview_size, oview);
-  of->write_output_view(got_file_offset, got_size, got_view);
+  of->write_output_view(got_view_offset, got_size, got_view);
 }
 
 // Create the PLT section.
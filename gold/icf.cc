@@ -93,6 +93,20 @@
 // frequent and Algorithm I wins because of its ability to be stopped
 // arbitrarily.
 //
+// Finding identical sections in parallel :
+// ---------------------------------------
+//
+// The expensive part of the checksumming is reading each section's text
+// and stringifying its relocs.  The relocs to sections that cannot be
+// folded never change, so this is done only once, by a task per object,
+// and the tasks run in parallel.  Relocs to sections that might be folded
+// are recorded as a list of section numbers instead.  The sections are
+// then sorted into buckets with identical text and relocs to non-foldable
+// sections.  Only sections in the same bucket can be identical, and
+// within a bucket only the lists of relocs to foldable sections need to
+// be compared on each iteration.  A bucket whose sections have all been
+// folded together is final and is not looked at again.
+//
 // Caveat with using function pointers :
 // ------------------------------------
 //
@@ -143,6 +157,7 @@
 #include "gc.h"
 #include "icf.h"
 #include "symtab.h"
+#include "workqueue.h"
 #include "libiberty.h"
 #include "demangle.h"
 #include "elfcpp.h"
@@ -151,68 +166,6 @@
 namespace gold
 {
 
-// This function determines if a section or a group of identical
-// sections has unique contents.  Such unique sections or groups can be
-// declared final and need not be processed any further.
-// Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
-// IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
-//                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
-
-static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
-{
-  Unordered_map<uint32_t, unsigned int> uniq_map;
-  std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
-    uniq_map_insert;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
-    {
-      if ((*is_secn_or_group_unique)[i])
-        continue;
-
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
-      uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
-      if (uniq_map_insert.second)
-        {
-          (*is_secn_or_group_unique)[i] = true;
-        }
-      else
-        {
-          (*is_secn_or_group_unique)[i] = false;
-          (*is_secn_or_group_unique)[uniq_map_insert.first->second] = false;
-        }
-    }
-}
-
 // For SHF_MERGE sections that use REL relocations, the addend is stored in
 // the text section at the relocation offset.  Read  the addend value given
 // the pointer to the addend in the text section and the addend size.
@@ -252,48 +205,37 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
     }
 }
 
-// This returns the buffer containing the section's contents, both
-// text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
-// subsequent invocations of this function.
+// This computes the section's contents, both text and relocs, into
+// BUFFER.  Relocs are differentiated as those pointing to sections
+// that could be folded and those that cannot.  Relocs pointing to
+// sections that cannot be folded are stringified into BUFFER.  Relocs
+// pointing to sections that could be folded are recorded in ICF_RELOCS
+// instead, as whether they match another section's relocs changes as
+// sections are folded.  The object containing the section must be
+// locked.
 // Parameters  :
-// FIRST_ITERATION    : true if it is the first invocation.
 // SECN               : Section for which contents are desired.
-// SECTION_NUM        : Unique section number of this section.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
+// IN_TASK            : true if called from a task that may run in
+//                      parallel with tasks for other objects.
+// BUFFER             : Store the section's text and relocs to non-ICF
 //                      sections.
+// ICF_RELOCS         : Store the relocs to ICF sections.
+// Returns false if IN_TASK is true and the contents could not be
+// computed because a reloc points to a merge section in another object.
 
-static std::string
-get_section_contents(bool first_iteration,
-                     const Section_id& secn,
-                     unsigned int section_num,
-                     unsigned int* num_tracked_relocs,
+static bool
+get_section_contents(const Section_id& secn,
+                     bool in_task,
                      Symbol_table* symtab,
-                     const std::vector<unsigned int>& kept_section_id,
-                     std::vector<std::string>* section_contents)
+                     std::string* buffer,
+                     Icf::Icf_reloc_list* icf_relocs)
 {
-  // Lock the object so we can read from it.  This is only called
-  // single-threaded from queue_middle_tasks, so it is OK to lock.
-  // Unfortunately we have no way to pass in a Task token.
-  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-  Task_lock_obj<Object> tl(dummy_task, secn.first);
-
   section_size_type plen;
-  const unsigned char* contents = NULL;
-  if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
-
-  // The buffer to hold all the contents including relocs.  A checksum
-  // is then computed on this buffer.
-  std::string buffer;
-  std::string icf_reloc_buffer;
+  const unsigned char* contents;
+  contents = secn.first->section_contents(secn.second, &plen, false);
 
-  if (num_tracked_relocs)
-    *num_tracked_relocs = 0;
+  buffer->clear();
+  icf_relocs->clear();
 
   Icf::Reloc_info_list& reloc_info_list = 
     symtab->icf()->reloc_info_list();
@@ -301,9 +243,6 @@ get_section_contents(bool first_iteration,
   Icf::Reloc_info_list::iterator it_reloc_info_list =
     reloc_info_list.find(secn);
 
-  buffer.clear();
-  icf_reloc_buffer.clear();
-
   // Process relocs and put them into the buffer.
 
   if (it_reloc_info_list != reloc_info_list.end())
@@ -327,8 +266,7 @@ get_section_contents(bool first_iteration,
 
       for (; it_v != v.end(); ++it_v, ++it_s, ++it_a, ++it_o, ++it_addend_size)
         {
-	  if (first_iteration
-	      && it_v->first != NULL)
+	  if (it_v->first != NULL)
 	    {
 	      Symbol_location loc;
 	      loc.object = it_v->first;
@@ -364,15 +302,12 @@ get_section_contents(bool first_iteration,
 	  // object is NULL.
 	  if (it_v->first == NULL)
             {
-	      if (first_iteration)
-                {
-		  // If the symbol name is available, use it.
-                  if ((*it_s) != NULL)
-                      buffer.append((*it_s)->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
-		}
+	      // If the symbol name is available, use it.
+	      if ((*it_s) != NULL)
+		buffer->append((*it_s)->name());
+	      // Append the addend.
+	      buffer->append(addend_str);
+	      buffer->append("@");
 	      continue;
 	    }
 
@@ -383,12 +318,9 @@ get_section_contents(bool first_iteration,
           if (reloc_secn.first == secn.first
               && reloc_secn.second == secn.second)
             {
-              if (first_iteration)
-                {
-                  buffer.append("R");
-                  buffer.append(addend_str);
-                  buffer.append("@");
-                }
+	      buffer->append("R");
+	      buffer->append(addend_str);
+	      buffer->append("@");
               continue;
             }
           Icf::Uniq_secn_id_map& section_id_map =
@@ -403,36 +335,29 @@ get_section_contents(bool first_iteration,
               && section_id_map_it != section_id_map.end())
             {
               // This is a reloc to a section that might be folded.
-              if (num_tracked_relocs)
-                (*num_tracked_relocs)++;
-
-              char kept_section_str[10];
-              unsigned int secn_id = section_id_map_it->second;
-              snprintf(kept_section_str, sizeof(kept_section_str), "%u",
-                       kept_section_id[secn_id]);
-              if (first_iteration)
-                {
-                  buffer.append("ICF_R");
-                  buffer.append(addend_str);
-                }
-              icf_reloc_buffer.append(kept_section_str);
-              // Append the addend.
-              icf_reloc_buffer.append(addend_str);
-              icf_reloc_buffer.append("@");
+	      buffer->append("ICF_R");
+	      buffer->append(addend_str);
+
+	      Icf::Icf_reloc icf_reloc;
+	      icf_reloc.section_num = section_id_map_it->second;
+	      icf_reloc.symval = it_a->first;
+	      icf_reloc.addend = it_a->second;
+	      icf_reloc.offset = *it_o;
+	      icf_relocs->push_back(icf_reloc);
             }
           else
             {
               // This is a reloc to a section that cannot be folded.
-              // Process it only in the first iteration.
-              if (!first_iteration)
-                continue;
-
               uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
               // This reloc points to a merge section.  Hash the
               // contents of this section.
               if ((secn_flags & elfcpp::SHF_MERGE) != 0
 		  && parameters->target().can_icf_inline_merge_sections())
                 {
+		  // A task may only read the object it has locked.
+		  if (in_task && it_v->first != secn.first)
+		    return false;
+
                   uint64_t entsize =
                     (it_v->first)->section_entsize(it_v->second);
 		  long long offset = it_a->first;
@@ -475,7 +400,7 @@ get_section_contents(bool first_iteration,
                         {
                         case 1:
                           {
-                            buffer.append(str_char);
+                            buffer->append(str_char);
                             break;
                           }
                         case 2:
@@ -486,7 +411,7 @@ get_section_contents(bool first_iteration,
                             // Find the NULL character.
                             while(*(ptr_16 + strlen_16) != 0)
                                 strlen_16++;
-                            buffer.append(str_char, strlen_16 * 2);
+                            buffer->append(str_char, strlen_16 * 2);
                           }
                           break;
                         case 4:
@@ -497,7 +422,7 @@ get_section_contents(bool first_iteration,
                             // Find the NULL character.
                             while(*(ptr_32 + strlen_32) != 0)
                                 strlen_32++;
-                            buffer.append(str_char, strlen_32 * 4);
+                            buffer->append(str_char, strlen_32 * 4);
                           }
                           break;
                         default:
@@ -511,199 +436,181 @@ get_section_contents(bool first_iteration,
 		      // If entsize is too big, copy all the remaining bytes.
 		      if ((offset + entsize) > secn_len)
 			bufsize = secn_len - offset;
-                      buffer.append(reinterpret_cast<const
-                                                     char*>(str_contents),
-                                    bufsize);
+                      buffer->append(reinterpret_cast<const
+                                                      char*>(str_contents),
+                                     bufsize);
                     }
-		  buffer.append("@");
+		  buffer->append("@");
                 }
               else if ((*it_s) != NULL)
                 {
                   // If symbol name is available use that.
-                  buffer.append((*it_s)->name());
+                  buffer->append((*it_s)->name());
                   // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
+                  buffer->append(addend_str);
+                  buffer->append("@");
                 }
               else
                 {
                   // Symbol name is not available, like for a local symbol,
                   // use object and section id.
-                  buffer.append(it_v->first->name());
+                  buffer->append(it_v->first->name());
                   char secn_id[10];
                   snprintf(secn_id, sizeof(secn_id), "%u",it_v->second);
-                  buffer.append(secn_id);
+                  buffer->append(secn_id);
                   // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
+                  buffer->append(addend_str);
+                  buffer->append("@");
                 }
             }
         }
     }
 
-  if (first_iteration)
+  buffer->append("Contents = ");
+  buffer->append(reinterpret_cast<const char*>(contents), plen);
+  return true;
+}
+
+// This returns the checksum of the section's contents computed by
+// get_section_contents.
+
+static inline uint32_t
+section_contents_cksum(const std::string& contents)
+{
+  const unsigned char* contents_array =
+    reinterpret_cast<const unsigned char*>(contents.data());
+  return xcrc32(contents_array, contents.length(), 0xffffffff);
+}
+
+// This returns a hash code for the bucket of a section and its relocs
+// to ICF sections, using the kept section for the section each reloc
+// points to.
+
+static size_t
+icf_relocs_hash(unsigned int bucket,
+                const Icf::Icf_reloc_list& icf_relocs,
+                const std::vector<unsigned int>& kept_section_id)
+{
+  size_t hash = bucket;
+  hash = hash * 37 + icf_relocs.size();
+  for (Icf::Icf_reloc_list::const_iterator p = icf_relocs.begin();
+       p != icf_relocs.end();
+       ++p)
     {
-      buffer.append("Contents = ");
-      buffer.append(reinterpret_cast<const char*>(contents), plen);
-      // Store the section contents that don't change to avoid recomputing
-      // during the next call to this function.
-      (*section_contents)[section_num] = buffer;
+      hash = hash * 37 + kept_section_id[p->section_num];
+      hash = hash * 37 + static_cast<size_t>(p->symval);
+      hash = hash * 37 + static_cast<size_t>(p->addend);
+      hash = hash * 37 + static_cast<size_t>(p->offset);
     }
-  else
+  return hash;
+}
+
+// This returns true if two lists of relocs to ICF sections point to
+// the same kept sections with the same addends at the same offsets.
+
+static bool
+icf_relocs_equal(const Icf::Icf_reloc_list& icf_relocs1,
+                 const Icf::Icf_reloc_list& icf_relocs2,
+                 const std::vector<unsigned int>& kept_section_id)
+{
+  if (icf_relocs1.size() != icf_relocs2.size())
+    return false;
+  for (size_t i = 0; i < icf_relocs1.size(); ++i)
     {
-      gold_assert(buffer.empty());
-      // Reuse the contents computed in the previous iteration.
-      buffer.append((*section_contents)[section_num]);
+      const Icf::Icf_reloc& r1(icf_relocs1[i]);
+      const Icf::Icf_reloc& r2(icf_relocs2[i]);
+      if (kept_section_id[r1.section_num] != kept_section_id[r2.section_num]
+          || r1.symval != r2.symval
+          || r1.addend != r2.addend
+          || r1.offset != r2.offset)
+        return false;
     }
-
-  buffer.append(icf_reloc_buffer);
-  return buffer;
+  return true;
 }
 
-// This function computes a checksum on each section to detect and form
-// groups of identical sections.  The first iteration does this for all 
-// sections.
-// Further iterations do this only for the kept sections from each group to
-// determine if larger groups of identical sections could be formed.  The
-// first section in each group is the kept section for that group.
+// This function forms groups of identical sections.  The sections
+// have already been sorted into buckets of sections whose text and
+// relocs to non-ICF sections are identical, so only the relocs to ICF
+// sections need to be compared, and only against sections in the same
+// bucket.  Two sections in a bucket are identical if their relocs to
+// ICF sections point to the same kept sections.  The first section in
+// each group is the kept section for that group.
 //
-// CRC32 is the checksumming algorithm and can have collisions.  That is,
-// two sections with different contents can have the same checksum. Hence,
-// a multimap is used to maintain more than one group of checksum
-// identical sections.  A section is added to a group only after its
-// contents are explicitly compared with the kept section of the group.
+// Only the kept sections from each group are looked at on further
+// iterations, to determine if larger groups of identical sections
+// could be formed.  A bucket whose sections have all been folded
+// into one group can not change any more, so its kept section is
+// dropped from the sections looked at.
 //
 // Parameters  :
-// ITERATION_NUM           : Invocation instance of this function.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
 // KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// ID_SECTION         : Vector mapping a section to an unique integer.
-// IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
-//                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
+// ICF_RELOCS         : Vector mapping a section to its relocs to ICF
 //                      sections.
+// SECTION_ADDRALIGNS : Vector mapping a section to its alignment.
+// SECTION_BUCKET     : Vector mapping a section to its bucket.
+// ACTIVE_SECTIONS    : The sections to look at, in increasing order.
+//                      This is updated for the next iteration.
+//
+// Returns true if no section was folded.
 
 static bool
-match_sections(unsigned int iteration_num,
-               Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
-               std::vector<unsigned int>* kept_section_id,
-               const std::vector<Section_id>& id_section,
+match_sections(std::vector<unsigned int>* kept_section_id,
+               const std::vector<Icf::Icf_reloc_list>& icf_relocs,
 	       const std::vector<uint64_t>& section_addraligns,
-               std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+               const std::vector<unsigned int>& section_bucket,
+               std::vector<unsigned int>* active_sections)
 {
-  Unordered_multimap<uint32_t, unsigned int> section_cksum;
-  std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
-            Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
+  Unordered_multimap<size_t, unsigned int> section_hash;
+  std::pair<Unordered_multimap<size_t, unsigned int>::iterator,
+            Unordered_multimap<size_t, unsigned int>::iterator> key_range;
   bool converged = true;
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
-
-  std::vector<std::string> full_section_contents;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (std::vector<unsigned int>::const_iterator p = active_sections->begin();
+       p != active_sections->end();
+       ++p)
     {
-      full_section_contents.push_back("");
-      if ((*is_secn_or_group_unique)[i])
-        continue;
-
-      Section_id secn = id_section[i];
-      std::string this_secn_contents;
-      uint32_t cksum;
-      if (iteration_num == 1)
-        {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, secn, i, &num_relocs,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-          (*num_tracked_relocs)[i] = num_relocs;
-        }
-      else
+      unsigned int i = *p;
+      unsigned int bucket = section_bucket[i];
+      size_t hash = icf_relocs_hash(bucket, icf_relocs[i], *kept_section_id);
+
+      key_range = section_hash.equal_range(hash);
+      Unordered_multimap<size_t, unsigned int>::iterator it;
+      // Search all the groups with this hash for a match.
+      for (it = key_range.first; it != key_range.second; ++it)
         {
-          if ((*kept_section_id)[i] != i)
-            {
-              // This section is already folded into something.
-              continue;
-            }
-          this_secn_contents = get_section_contents(false, secn, i, NULL,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-        }
+          unsigned int kept_section = it->second;
+          if (section_bucket[kept_section] != bucket
+              || !icf_relocs_equal(icf_relocs[kept_section], icf_relocs[i],
+                                   *kept_section_id))
+            continue;
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
-      size_t count = section_cksum.count(cksum);
+	  // Check section alignment here.
+	  // The section with the larger alignment requirement
+	  // should be kept.  We assume alignment can only be 
+	  // zero or positive integral powers of two.
+	  uint64_t align_i = section_addraligns[i];
+	  uint64_t align_kept = section_addraligns[kept_section];
+	  if (align_i <= align_kept)
+	    (*kept_section_id)[i] = kept_section;
+	  else
+	    {
+	      (*kept_section_id)[kept_section] = i;
+	      it->second = i;
+	    }
 
-      if (count == 0)
-        {
-          // Start a group with this cksum.
-          section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
+          converged = false;
+          break;
         }
-      else
+      if (it == key_range.second)
         {
-          key_range = section_cksum.equal_range(cksum);
-          Unordered_multimap<uint32_t, unsigned int>::iterator it;
-          // Search all the groups with this cksum for a match.
-          for (it = key_range.first; it != key_range.second; ++it)
-            {
-              unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
-                  continue;
-
-	      // Check section alignment here.
-	      // The section with the larger alignment requirement
-	      // should be kept.  We assume alignment can only be 
-	      // zero or positive integral powers of two.
-	      uint64_t align_i = section_addraligns[i];
-	      uint64_t align_kept = section_addraligns[kept_section];
-	      if (align_i <= align_kept)
-		{
-		  (*kept_section_id)[i] = kept_section;
-		}
-	      else
-		{
-		  (*kept_section_id)[kept_section] = i;
-		  it->second = i;
-		  full_section_contents[kept_section].swap(
-		      full_section_contents[i]);
-		}
-
-              converged = false;
-              break;
-            }
-          if (it == key_range.second)
-            {
-              // Create a new group for this cksum.
-              section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
-            }
+          // Create a new group for this hash.
+          section_hash.insert(std::make_pair(hash, i));
         }
-      // If there are no relocs to foldable sections do not process
-      // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
-        (*is_secn_or_group_unique)[i] = true;
     }
 
   // If a section was folded into another section that was later folded
   // again then the former has to be updated.
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (unsigned int i = 0; i < kept_section_id->size(); i++)
     {
       // Find the end of the folding chain
       unsigned int kept = i;
@@ -721,6 +628,24 @@ match_sections(unsigned int iteration_num,
         }
     }
 
+  // Find the kept sections to look at on the next iteration.  These
+  // are the ones whose bucket still has more than one group.
+  Unordered_map<unsigned int, unsigned int> bucket_groups;
+  for (std::vector<unsigned int>::const_iterator p = active_sections->begin();
+       p != active_sections->end();
+       ++p)
+    if ((*kept_section_id)[*p] == *p)
+      ++bucket_groups[section_bucket[*p]];
+
+  size_t num_active = 0;
+  for (size_t j = 0; j < active_sections->size(); ++j)
+    {
+      unsigned int i = (*active_sections)[j];
+      if ((*kept_section_id)[i] == i && bucket_groups[section_bucket[i]] > 1)
+        (*active_sections)[num_active++] = i;
+    }
+  active_sections->resize(num_active);
+
   return converged;
 }
 
@@ -742,20 +667,69 @@ is_function_ctor_or_dtor(const std::string& section_name)
   return false;
 }
 
-// This is the main ICF function called in gold.cc.  This does the
-// initialization and calls match_sections repeatedly (twice by default)
-// which computes the crc checksums and detects identical functions.
+// This task computes the contents of the candidate sections in one
+// object.  Running one task per object lets the contents be computed
+// in parallel.
 
-void
-Icf::find_identical_sections(const Input_objects* input_objects,
-                             Symbol_table* symtab)
+class Icf_section_contents_task : public Task
+{
+ public:
+  Icf_section_contents_task(Icf* icf, Symbol_table* symtab, Relobj* object,
+                            unsigned int first, unsigned int last,
+                            Task_token* blocker)
+    : icf_(icf), symtab_(symtab), object_(object), first_(first),
+      last_(last), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return this->object_->is_locked() ? this->object_->token() : NULL; }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->object_->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->blocker_);
+  }
+
+  void
+  run(Workqueue*)
+  {
+    this->icf_->compute_section_contents(this->symtab_, this->first_,
+                                         this->last_);
+    this->object_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Icf_section_contents_task " + this->object_->name(); }
+
+ private:
+  Icf* icf_;
+  Symbol_table* symtab_;
+  Relobj* object_;
+  unsigned int first_;
+  unsigned int last_;
+  Task_token* blocker_;
+};
+
+// This decides which sections are candidates for folding, and queues
+// a task per object to compute the contents of its candidate sections.
+
+Task_token*
+Icf::queue_section_contents_tasks(const Input_objects* input_objects,
+                                  Symbol_table* symtab,
+                                  Workqueue* workqueue)
 {
   unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
-  std::vector<uint64_t> section_addraligns;
-  std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
   const Target& target = parameters->target();
+  // The objects with candidate sections, and the number of the first
+  // candidate section in each.
+  std::vector<std::pair<Relobj*, unsigned int> > object_first_section;
 
   // Decide which sections are possible candidates first.
 
@@ -769,6 +743,7 @@ Icf::find_identical_sections(const Input_objects* input_objects,
       const Task* dummy_task = reinterpret_cast<const Task*>(-1);
       Task_lock_obj<Object> tl(dummy_task, *p);
 
+      unsigned int first_section_num = section_num;
       for (unsigned int i = 0;i < (*p)->shnum(); ++i)
         {
 	  const std::string section_name = (*p)->section_name(i);
@@ -792,13 +767,133 @@ Icf::find_identical_sections(const Input_objects* input_objects,
           this->id_section_.push_back(Section_id(*p, i));
           this->section_id_[Section_id(*p, i)] = section_num;
           this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
-	  section_addraligns.push_back((*p)->section_addralign(i));
-          is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
+	  this->section_addraligns_.push_back((*p)->section_addralign(i));
           section_num++;
         }
+      if (section_num > first_section_num)
+        object_first_section.push_back(std::make_pair(*p, first_section_num));
+    }
+
+  this->section_contents_.resize(section_num);
+  this->section_cksum_.resize(section_num);
+  this->icf_relocs_.resize(section_num);
+  this->contents_deferred_.resize(section_num);
+
+  // The tasks may only be queued once all the candidates are known,
+  // since the contents of a section depend upon which of the sections
+  // its relocs point to are candidates.
+  Task_token* blocker = new Task_token(true);
+  for (size_t i = 0; i < object_first_section.size(); ++i)
+    {
+      Relobj* object = object_first_section[i].first;
+      unsigned int first = object_first_section[i].second;
+      unsigned int last = (i + 1 < object_first_section.size()
+                           ? object_first_section[i + 1].second
+                           : section_num);
+      blocker->add_blocker();
+      workqueue->queue(new Icf_section_contents_task(this, symtab, object,
+                                                     first, last, blocker));
+    }
+
+  return blocker;
+}
+
+// Compute the contents of the candidate sections numbered FIRST up to
+// LAST.  This is called by Icf_section_contents_task, possibly in
+// parallel with other tasks, so it only writes to the entries for
+// its own sections.
+
+void
+Icf::compute_section_contents(Symbol_table* symtab, unsigned int first,
+                              unsigned int last)
+{
+  for (unsigned int i = first; i < last; ++i)
+    {
+      if (!get_section_contents(this->id_section_[i], true, symtab,
+                                &this->section_contents_[i],
+                                &this->icf_relocs_[i]))
+        {
+          this->contents_deferred_[i] = 1;
+          continue;
+        }
+      this->section_cksum_[i] =
+        section_contents_cksum(this->section_contents_[i]);
     }
+}
+
+// This is the main ICF function called in gold.cc once the section
+// contents have been computed.  This sorts the sections into buckets
+// with identical contents and calls match_sections repeatedly (twice
+// by default) to detect identical functions within each bucket.
+
+void
+Icf::find_identical_sections(const Input_objects*,
+                             Symbol_table* symtab)
+{
+  unsigned int num_sections = this->id_section_.size();
+
+  // Compute the contents of the sections which the tasks could not
+  // handle because they refer to merge sections in other objects.
+  for (unsigned int i = 0; i < num_sections; ++i)
+    {
+      if (!this->contents_deferred_[i])
+        continue;
+
+      Section_id secn = this->id_section_[i];
+      // Lock the object so we can read from it.  This is only called
+      // single-threaded once the Icf_section_contents_task tasks have
+      // completed, so it is OK to lock.
+      // Unfortunately we have no way to pass in a Task token.
+      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
+      Task_lock_obj<Object> tl(dummy_task, secn.first);
+      get_section_contents(secn, false, symtab, &this->section_contents_[i],
+                           &this->icf_relocs_[i]);
+      this->section_cksum_[i] =
+        section_contents_cksum(this->section_contents_[i]);
+    }
+
+  // Sort the sections into buckets with identical contents, using the
+  // checksums to find candidate buckets.  The first section in each
+  // bucket is used for comparisons.
+  std::vector<unsigned int> section_bucket(num_sections);
+  std::vector<unsigned int> bucket_first;
+  std::vector<unsigned int> bucket_size;
+  Unordered_multimap<uint32_t, unsigned int> bucket_cksum;
+  for (unsigned int i = 0; i < num_sections; ++i)
+    {
+      const std::string& contents(this->section_contents_[i]);
+      std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
+                Unordered_multimap<uint32_t, unsigned int>::iterator>
+        key_range = bucket_cksum.equal_range(this->section_cksum_[i]);
+      Unordered_multimap<uint32_t, unsigned int>::iterator it;
+      for (it = key_range.first; it != key_range.second; ++it)
+        if (this->section_contents_[bucket_first[it->second]] == contents)
+          break;
+      if (it != key_range.second)
+        {
+          section_bucket[i] = it->second;
+          ++bucket_size[it->second];
+        }
+      else
+        {
+          section_bucket[i] = bucket_first.size();
+          bucket_cksum.insert(std::make_pair(this->section_cksum_[i],
+                                             section_bucket[i]));
+          bucket_first.push_back(i);
+          bucket_size.push_back(1);
+        }
+    }
+
+  // The contents are no longer needed.
+  std::vector<std::string>().swap(this->section_contents_);
+  std::vector<uint32_t>().swap(this->section_cksum_);
+
+  // A section with unique contents can never be folded, so only look
+  // at the sections in buckets with more than one section.
+  std::vector<unsigned int> active_sections;
+  for (unsigned int i = 0; i < num_sections; ++i)
+    if (bucket_size[section_bucket[i]] > 1)
+      active_sections.push_back(i);
 
   unsigned int num_iterations = 0;
 
@@ -812,10 +907,9 @@ Icf::find_identical_sections(const Input_objects* input_objects,
   while (!converged && (num_iterations < max_iterations))
     {
       num_iterations++;
-      converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, section_addraligns,
-                                 &is_secn_or_group_unique, &section_contents);
+      converged = match_sections(&this->kept_section_id_, this->icf_relocs_,
+                                 this->section_addraligns_, section_bucket,
+                                 &active_sections);
     }
 
   if (parameters->options().print_icf_sections())
@@ -854,6 +948,9 @@ Icf::find_identical_sections(const Input_objects* input_objects,
 
     }
 
+  std::vector<Icf_reloc_list>().swap(this->icf_relocs_);
+  std::vector<unsigned char>().swap(this->contents_deferred_);
+
   this->icf_ready();
 }
 
@@ -35,6 +35,8 @@ namespace gold
 class Object;
 class Input_objects;
 class Symbol_table;
+class Task_token;
+class Workqueue;
 
 class Icf
 {
@@ -64,20 +66,59 @@ class Icf
   typedef Unordered_map<Section_id, Reloc_info,
                         Section_id_hash> Reloc_info_list;
 
+  // A relocation from a candidate section to another section which
+  // might be folded.  Two sections can only be folded if their
+  // relocations of this kind refer to sections which are folded
+  // together.
+  struct Icf_reloc
+  {
+    // The unique number of the section the relocation refers to.
+    unsigned int section_num;
+    // The symbol value.
+    long long symval;
+    // The addend.
+    long long addend;
+    // The offset of the relocation.
+    uint64_t offset;
+  };
+
+  typedef std::vector<Icf_reloc> Icf_reloc_list;
+
   Icf()
   : id_section_(), section_id_(), kept_section_id_(),
     fptr_section_id_(),
     icf_ready_(false),
-    reloc_info_list_()
+    reloc_info_list_(),
+    section_contents_(), section_cksum_(), section_addraligns_(),
+    icf_relocs_(), contents_deferred_()
   { }
 
+  // Selects the sections which are candidates for folding, and queues
+  // tasks which compute their contents in parallel, one task per
+  // object.  Returns a blocker which is unblocked when all the tasks
+  // have completed.  This must be called before
+  // find_identical_sections.
+  Task_token*
+  queue_section_contents_tasks(const Input_objects* input_objects,
+                               Symbol_table* symtab,
+                               Workqueue* workqueue);
+
+  // Computes the contents of the candidate sections numbered FIRST
+  // up to LAST, all of which are in the same object.  The object
+  // must be locked by the calling task.
+  void
+  compute_section_contents(Symbol_table* symtab, unsigned int first,
+                           unsigned int last);
+
   // Returns the kept folded identical section corresponding to
   // dup_obj and dup_shndx.
   Section_id
   get_folded_section(Relobj* dup_obj, unsigned int dup_shndx);
 
   // Forms groups of identical sections where the first member
-  // of each group is the kept section during folding.
+  // of each group is the kept section during folding.  This uses the
+  // section contents computed by the tasks queued by
+  // queue_section_contents_tasks.
   void
   find_identical_sections(const Input_objects* input_objects,
                           Symbol_table* symtab);
@@ -160,6 +201,21 @@ class Icf
   bool icf_ready_;
   // This list is populated by gc_process_relocs in gc.h.
   Reloc_info_list reloc_info_list_;
+  // Given a section id, the section's text and relocs to sections
+  // that cannot be folded.  This is freed once the sections have been
+  // sorted into groups with the same contents.
+  std::vector<std::string> section_contents_;
+  // Given a section id, the checksum of section_contents_.
+  std::vector<uint32_t> section_cksum_;
+  // Given a section id, the alignment of the section.
+  std::vector<uint64_t> section_addraligns_;
+  // Given a section id, the relocs to sections that might be folded.
+  std::vector<Icf_reloc_list> icf_relocs_;
+  // Given a section id, whether the section contents could not be
+  // computed by a task and must be computed by find_identical_sections.
+  // This is not a std::vector<bool> because the tasks update it
+  // concurrently.
+  std::vector<unsigned char> contents_deferred_;
 };
 
 // This function returns true if this section corresponds to a function that
@@ -0,0 +1,263 @@
+// input_cache.cc -- on-disk cache of input file metadata for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "parameters.h"
+#include "options.h"
+#include "descriptors.h"
+#include "fileread.h"
+#include "object.h"
+#include "input_cache.h"
+
+namespace gold
+{
+
+// The header of a cache entry.  It has no padding, so that two
+// headers can be compared with memcmp.
+
+struct Input_cache_header
+{
+  // Always input_cache_magic.
+  char magic[8];
+  // The size of each record.  This changes if the layout of the
+  // records changes.
+  uint32_t record_size;
+  // The kind of data in the entry.
+  uint32_t kind;
+  // The size of the input file.
+  uint64_t file_size;
+  // The modification time of the input file.
+  int64_t mtime_seconds;
+  int64_t mtime_nanoseconds;
+  // The offset of the object in the input file.
+  uint64_t offset;
+  // The number of records following the header.
+  uint64_t count;
+  // A checksum of the records, to catch a damaged entry.
+  uint64_t checksum;
+};
+
+static const char input_cache_magic[8] =
+{
+  'g', 'o', 'l', 'd', 'I', 'C', '1', '\0'
+};
+
+// The kinds of data in an entry.
+
+enum Input_cache_kind
+{
+  // An array of Symbol_name_hash.
+  INPUT_CACHE_SYMBOL_NAME_HASHES = 1
+};
+
+// Whether an input cache directory was specified.
+
+bool
+input_cache_enabled()
+{
+  return parameters->options().input_cache() != NULL;
+}
+
+// Find the cache entry of kind KIND, holding COUNT records of size
+// RECORD_SIZE, for OBJECT.  Set *PATH to the name of the entry and
+// *HDR to the header it should have.  Return false if we can not
+// find out the identity of the file holding OBJECT.
+
+static bool
+input_cache_entry(const Object* object, Input_cache_kind kind,
+		  size_t record_size, size_t count, std::string* path,
+		  Input_cache_header* hdr)
+{
+  const std::string& filename(object->input_file()->file().filename());
+  struct stat st;
+  if (::stat(filename.c_str(), &st) < 0)
+    return false;
+
+  memset(hdr, 0, sizeof *hdr);
+  memcpy(hdr->magic, input_cache_magic, sizeof hdr->magic);
+  hdr->record_size = record_size;
+  hdr->kind = kind;
+  hdr->file_size = st.st_size;
+#ifdef HAVE_STAT_ST_MTIM
+  hdr->mtime_seconds = st.st_mtim.tv_sec;
+  hdr->mtime_nanoseconds = st.st_mtim.tv_nsec;
+#else
+  hdr->mtime_seconds = st.st_mtime;
+  hdr->mtime_nanoseconds = 0;
+#endif
+  hdr->offset = object->offset();
+  hdr->count = count;
+
+  char buf[100];
+  snprintf(buf, sizeof buf, "/%llx-%llx-%llx-%u",
+	   static_cast<unsigned long long>(st.st_dev),
+	   static_cast<unsigned long long>(st.st_ino),
+	   static_cast<unsigned long long>(object->offset()),
+	   static_cast<unsigned int>(kind));
+  path->assign(parameters->options().input_cache());
+  path->append(buf);
+  return true;
+}
+
+// Compute the checksum of LEN bytes at P, which must be a multiple of
+// the word size.
+
+static uint64_t
+input_cache_checksum(const void* p, size_t len)
+{
+  const size_t* words = static_cast<const size_t*>(p);
+  uint64_t checksum = 0;
+  for (size_t i = 0; i < len / sizeof(size_t); ++i)
+    checksum = (checksum ^ words[i]) * 0x100000001b3ULL;
+  return checksum;
+}
+
+// Read exactly LEN bytes from DESCRIPTOR into BUF.
+
+static bool
+input_cache_read_all(int descriptor, void* buf, size_t len)
+{
+  unsigned char* p = static_cast<unsigned char*>(buf);
+  while (len > 0)
+    {
+      ssize_t got = ::read(descriptor, p, len);
+      if (got < 0 && errno == EINTR)
+	continue;
+      if (got <= 0)
+	return false;
+      p += got;
+      len -= got;
+    }
+  return true;
+}
+
+// Write LEN bytes from BUF to DESCRIPTOR.
+
+static bool
+input_cache_write_all(int descriptor, const void* buf, size_t len)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(buf);
+  while (len > 0)
+    {
+      ssize_t written = ::write(descriptor, p, len);
+      if (written < 0 && errno == EINTR)
+	continue;
+      if (written <= 0)
+	return false;
+      p += written;
+      len -= written;
+    }
+  return true;
+}
+
+// Read the symbol name hashes for OBJECT.
+
+bool
+input_cache_read_symbol_name_hashes(const Object* object, size_t count,
+				    std::vector<Symbol_name_hash>* hashes)
+{
+  std::string path;
+  Input_cache_header expected;
+  if (!input_cache_entry(object, INPUT_CACHE_SYMBOL_NAME_HASHES,
+			 sizeof(Symbol_name_hash), count, &path, &expected))
+    return false;
+
+  int descriptor = open_descriptor(-1, path.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    return false;
+
+  // The checksum is the one field we can not predict.
+  Input_cache_header hdr;
+  bool ok = input_cache_read_all(descriptor, &hdr, sizeof hdr);
+  if (ok)
+    {
+      expected.checksum = hdr.checksum;
+      ok = memcmp(&hdr, &expected, sizeof hdr) == 0;
+    }
+  if (ok && count > 0)
+    {
+      const size_t len = count * sizeof(Symbol_name_hash);
+      hashes->resize(count);
+      ok = (input_cache_read_all(descriptor, &(*hashes)[0], len)
+	    && input_cache_checksum(&(*hashes)[0], len) == hdr.checksum);
+      if (!ok)
+	hashes->clear();
+    }
+
+  release_descriptor(descriptor, true);
+  return ok;
+}
+
+// Write the symbol name hashes for OBJECT.  We write to a temporary
+// file whose name is unique to this process and object, and rename
+// it, so that a reader never sees a partial entry.
+
+void
+input_cache_write_symbol_name_hashes(
+    const Object* object,
+    const std::vector<Symbol_name_hash>& hashes)
+{
+  std::string path;
+  Input_cache_header hdr;
+  if (!input_cache_entry(object, INPUT_CACHE_SYMBOL_NAME_HASHES,
+			 sizeof(Symbol_name_hash), hashes.size(), &path,
+			 &hdr))
+    return;
+
+  char buf[100];
+  snprintf(buf, sizeof buf, ".%ld-%p.tmp", static_cast<long>(getpid()),
+	   static_cast<const void*>(object));
+  std::string tmp(path + buf);
+
+  int descriptor = open_descriptor(-1, tmp.c_str(),
+				   O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (descriptor < 0 && errno == ENOENT)
+    {
+      // Create the cache directory the first time we use it.
+      ::mkdir(parameters->options().input_cache(), 0777);
+      descriptor = open_descriptor(-1, tmp.c_str(),
+				   O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+  if (descriptor < 0)
+    return;
+
+  const size_t len = hashes.size() * sizeof(Symbol_name_hash);
+  if (len > 0)
+    hdr.checksum = input_cache_checksum(&hashes[0], len);
+  bool ok = input_cache_write_all(descriptor, &hdr, sizeof hdr);
+  if (ok && len > 0)
+    ok = input_cache_write_all(descriptor, &hashes[0], len);
+  release_descriptor(descriptor, true);
+
+  if (!ok || ::rename(tmp.c_str(), path.c_str()) < 0)
+    ::unlink(tmp.c_str());
+}
+
+} // End namespace gold.
@@ -0,0 +1,67 @@
+// input_cache.h -- on-disk cache of input file metadata for gold  -*- C++ -*-
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_INPUT_CACHE_H
+#define GOLD_INPUT_CACHE_H
+
+#include <vector>
+
+namespace gold
+{
+
+class Object;
+struct Symbol_name_hash;
+
+// With --input-cache=DIR, metadata which gold computes from an input
+// object is saved in DIR, so that later links using the same object
+// need not compute it again.  Each entry is a file named after the
+// device and inode of the input file and the offset of the object
+// within it (nonzero for an archive member).  The entry starts with a
+// header which records the size and modification time of the input
+// file and a checksum of the data, and is ignored if those no longer
+// match.  The data follows
+// the header as an array of fixed-size records in native byte order,
+// so reading an entry needs no parsing.  Entries are written to a
+// temporary file and renamed into place, so concurrent links may
+// share a cache directory.
+
+// Whether an input cache directory was specified.
+extern bool
+input_cache_enabled();
+
+// Read the symbol name hashes for the COUNT external symbols of
+// OBJECT from the cache into *HASHES.  Return false if there is no
+// valid entry.  This may be called from several threads at once.
+extern bool
+input_cache_read_symbol_name_hashes(const Object* object, size_t count,
+				    std::vector<Symbol_name_hash>* hashes);
+
+// Write the symbol name hashes for OBJECT to the cache.  Failures
+// are silently ignored.  This may be called from several threads at
+// once.
+extern void
+input_cache_write_symbol_name_hashes(
+    const Object* object,
+    const std::vector<Symbol_name_hash>& hashes);
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_INPUT_CACHE_H)
@@ -56,6 +56,7 @@
 #include "descriptors.h"
 #include "plugin.h"
 #include "incremental.h"
+#include "call-graph.h"
 #include "layout.h"
 
 namespace gold
@@ -239,7 +240,107 @@ Free_list::print_stats()
 	  program_name, Free_list::num_allocate_visits);
 }
 
-// A Hash_task computes the MD5 checksum of an array of char.
+// A function which computes a checksum of a buffer, with the same
+// interface as md5_buffer.
+
+typedef void* (*Hash_buffer_function)(const char*, size_t, void*);
+
+// The 64-bit xxHash (XXH64) is much faster than MD5 or SHA-1, and is
+// used for --build-id=fast.
+
+static const uint64_t xxhash64_prime1 = 0x9e3779b185ebca87ULL;
+static const uint64_t xxhash64_prime2 = 0xc2b2ae3d27d4eb4fULL;
+static const uint64_t xxhash64_prime3 = 0x165667b19e3779f9ULL;
+static const uint64_t xxhash64_prime4 = 0x85ebca77c2b2ae63ULL;
+static const uint64_t xxhash64_prime5 = 0x27d4eb2f165667c5ULL;
+
+inline uint64_t
+xxhash64_rotl(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t
+xxhash64_round(uint64_t acc, uint64_t input)
+{
+  return xxhash64_rotl(acc + input * xxhash64_prime2, 31) * xxhash64_prime1;
+}
+
+inline uint64_t
+xxhash64_read64(const unsigned char* p)
+{
+  return elfcpp::Swap_unaligned<64, false>::readval(p);
+}
+
+// Compute the xxHash of BUFFER, with a seed of zero, and store it in
+// little-endian order in RESBLOCK.
+
+static void*
+xxhash64_buffer(const char* buffer, size_t len, void* resblock)
+{
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer);
+  const unsigned char* pend = p + len;
+  uint64_t h;
+
+  if (len >= 32)
+    {
+      uint64_t v1 = xxhash64_prime1 + xxhash64_prime2;
+      uint64_t v2 = xxhash64_prime2;
+      uint64_t v3 = 0;
+      uint64_t v4 = -xxhash64_prime1;
+      do
+	{
+	  v1 = xxhash64_round(v1, xxhash64_read64(p));
+	  v2 = xxhash64_round(v2, xxhash64_read64(p + 8));
+	  v3 = xxhash64_round(v3, xxhash64_read64(p + 16));
+	  v4 = xxhash64_round(v4, xxhash64_read64(p + 24));
+	  p += 32;
+	}
+      while (pend - p >= 32);
+
+      h = (xxhash64_rotl(v1, 1) + xxhash64_rotl(v2, 7)
+	   + xxhash64_rotl(v3, 12) + xxhash64_rotl(v4, 18));
+      h = (h ^ xxhash64_round(0, v1)) * xxhash64_prime1 + xxhash64_prime4;
+      h = (h ^ xxhash64_round(0, v2)) * xxhash64_prime1 + xxhash64_prime4;
+      h = (h ^ xxhash64_round(0, v3)) * xxhash64_prime1 + xxhash64_prime4;
+      h = (h ^ xxhash64_round(0, v4)) * xxhash64_prime1 + xxhash64_prime4;
+    }
+  else
+    h = xxhash64_prime5;
+
+  h += len;
+
+  for (; pend - p >= 8; p += 8)
+    {
+      h ^= xxhash64_round(0, xxhash64_read64(p));
+      h = xxhash64_rotl(h, 27) * xxhash64_prime1 + xxhash64_prime4;
+    }
+  if (pend - p >= 4)
+    {
+      uint64_t k = elfcpp::Swap_unaligned<32, false>::readval(p);
+      h ^= k * xxhash64_prime1;
+      h = xxhash64_rotl(h, 23) * xxhash64_prime2 + xxhash64_prime3;
+      p += 4;
+    }
+  for (; p < pend; ++p)
+    {
+      h ^= *p * xxhash64_prime5;
+      h = xxhash64_rotl(h, 11) * xxhash64_prime1;
+    }
+
+  h ^= h >> 33;
+  h *= xxhash64_prime2;
+  h ^= h >> 29;
+  h *= xxhash64_prime3;
+  h ^= h >> 32;
+
+  elfcpp::Swap_unaligned<64, false>::writeval(
+      static_cast<unsigned char*>(resblock), h);
+  return resblock;
+}
+
+// A Hash_task computes a checksum of an array of char, using
+// HASH_FUNCTION.
 
 class Hash_task : public Task
 {
@@ -248,9 +349,10 @@ class Hash_task : public Task
 	    size_t offset,
 	    size_t size,
 	    unsigned char* dst,
+	    Hash_buffer_function hash_function,
 	    Task_token* final_blocker)
     : of_(of), offset_(offset), size_(size), dst_(dst),
-      final_blocker_(final_blocker)
+      hash_function_(hash_function), final_blocker_(final_blocker)
   { }
 
   void
@@ -258,7 +360,8 @@ class Hash_task : public Task
   {
     const unsigned char* iv =
 	this->of_->get_input_view(this->offset_, this->size_);
-    md5_buffer(reinterpret_cast<const char*>(iv), this->size_, this->dst_);
+    this->hash_function_(reinterpret_cast<const char*>(iv), this->size_,
+			 this->dst_);
     this->of_->free_input_view(this->offset_, this->size_, iv);
   }
 
@@ -280,9 +383,57 @@ class Hash_task : public Task
   const size_t offset_;
   const size_t size_;
   unsigned char* const dst_;
+  const Hash_buffer_function hash_function_;
   Task_token* const final_blocker_;
 };
 
+// A Count_local_symbols_task counts the local symbols of one object,
+// adding their names to string pools which belong to the object, so
+// that the objects can be handled in parallel.
+
+class Count_local_symbols_task : public Task
+{
+ public:
+  Count_local_symbols_task(Relobj* object,
+			   Stringpool* pool,
+			   Stringpool* dynpool,
+			   Task_token* final_blocker)
+    : object_(object), pool_(pool), dynpool_(dynpool),
+      final_blocker_(final_blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  {
+    this->object_->count_local_symbols(this->pool_, this->dynpool_);
+    this->object_->release();
+  }
+
+  Task_token*
+  is_runnable()
+  { return this->object_->is_locked() ? this->object_->token() : NULL; }
+
+  // Lock the object, and unblock FINAL_BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->object_->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->final_blocker_);
+  }
+
+  std::string
+  get_name() const
+  { return "Count_local_symbols_task " + this->object_->name(); }
+
+ private:
+  Relobj* object_;
+  Stringpool* pool_;
+  Stringpool* dynpool_;
+  Task_token* final_blocker_;
+};
+
 // Layout::Relaxation_debug_check methods.
 
 // Check that sections and special data are in reset states.
@@ -371,10 +522,35 @@ Layout_task_runner::run(Workqueue* workqueue, const Task* task)
   // TODO: if this is too slow, do this as a task, rather than inline.
   this->symtab_->detect_odr_violations(task, this->options_.output_file_name());
 
+  this->target_->finalize_sections(this->layout_, this->input_objects_,
+				   this->symtab_);
+
+  Task_token* blocker = new Task_token(true);
+  this->layout_->count_local_symbols(task, this->input_objects_, workqueue,
+				     blocker);
+  this->layout_->queue_merge_tasks(workqueue, blocker);
+
+  Layout_finalize_runner* runner =
+    new Layout_finalize_runner(this->options_, this->input_objects_,
+			       this->symtab_, this->target_, this->layout_,
+			       this->mapfile_);
+  workqueue->queue(new Task_function(runner, blocker,
+				     "Task_function Layout_finalize_runner"));
+}
+
+// Layout_finalize_runner methods.
+
+// Lay out the sections.  This is called after all the input objects
+// have been read, and the local symbols have been counted.
+
+void
+Layout_finalize_runner::run(Workqueue* workqueue, const Task* task)
+{
   Layout* layout = this->layout_;
   off_t file_size = layout->finalize(this->input_objects_,
 				     this->symtab_,
 				     this->target_,
+				     workqueue,
 				     task);
 
   // Now we know the final size of the output file and we know where
@@ -424,6 +600,8 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     namepool_(),
     sympool_(),
     dynpool_(),
+    local_sympools_(),
+    local_dynpools_(),
     signatures_(),
     section_name_map_(),
     segment_list_(),
@@ -447,10 +625,12 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     eh_frame_data_(NULL),
     added_eh_frame_data_(false),
     eh_frame_hdr_section_(NULL),
+    eh_frame_hdr_data_(NULL),
     gdb_index_data_(NULL),
     build_id_note_(NULL),
     debug_abbrev_(NULL),
     debug_info_(NULL),
+    compressed_sections_(),
     group_signatures_(),
     output_file_size_(-1),
     have_added_input_section_(false),
@@ -473,6 +653,9 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     section_segment_map_(),
     input_section_position_(),
     input_section_glob_(),
+    input_section_glob_index_(FNM_NOESCAPE),
+    symbol_position_(),
+    call_graph_(NULL),
     incremental_base_(NULL),
     free_list_()
 {
@@ -903,7 +1086,7 @@ Layout::keep_input_section(const Relobj* relobj, const char* name)
   bool keep;
 
   name = ss->output_section_name(file_name, name, &output_section_slot,
-				 &script_section_type, &keep, true);
+				 &script_section_type, &keep, true, -1);
   return name != NULL && keep;
 }
 
@@ -937,14 +1120,15 @@ Layout::get_output_section_flags(elfcpp::Elf_Xword input_section_flags)
 // sections.  IS_RELRO is true for a relro section.  This will return
 // NULL if the input section should be discarded.  MATCH_INPUT_SPEC
 // is true if the section name should be matched against input specs
-// in a linker script.
+// in a linker script.  INPUT_SPEC is the input spec which matches the
+// section, from Script_sections::find_input_section_spec, or -1.
 
 Output_section*
 Layout::choose_output_section(const Relobj* relobj, const char* name,
 			      elfcpp::Elf_Word type, elfcpp::Elf_Xword flags,
 			      bool is_input_section, Output_section_order order,
 			      bool is_relro, bool is_reloc,
-			      bool match_input_spec)
+			      bool match_input_spec, int input_spec)
 {
   // We should not see any input sections after we have attached
   // sections to segments.
@@ -965,7 +1149,7 @@ Layout::choose_output_section(const Relobj* relobj, const char* name,
       bool keep;
       name = ss->output_section_name(file_name, name, &output_section_slot,
 				     &script_section_type, &keep,
-				     match_input_spec);
+				     match_input_spec, input_spec);
 
       if (name == NULL)
 	{
@@ -1209,10 +1393,11 @@ Layout::layout(Sized_relobj_file<size, big_endian>* object, unsigned int shndx,
 	    = this->section_segment_map_.find(Const_section_id(object, shndx));
 	  if (it == this->section_segment_map_.end())
 	    {
+	      int input_spec = object->script_input_spec(shndx);
 	      os = this->choose_output_section(object, name, sh_type,
 					       shdr.get_sh_flags(), true,
 					       ORDER_INVALID, false, false,
-					       true);
+					       true, input_spec);
 	    }
 	  else
 	    {
@@ -1342,7 +1527,7 @@ Layout::layout_reloc(Sized_relobj_file<size, big_endian>* object,
       || (data_section->flags() & elfcpp::SHF_GROUP) == 0)
     os = this->choose_output_section(object, name.c_str(), sh_type,
 				     shdr.get_sh_flags(), false,
-				     ORDER_INVALID, false, true, false);
+				     ORDER_INVALID, false, true, false, -1);
   else
     {
       const char* n = this->namepool_.add(name.c_str(), true, NULL);
@@ -1536,7 +1721,7 @@ Layout::make_eh_frame_section(const Relobj* object)
 						   elfcpp::SHT_PROGBITS,
 						   elfcpp::SHF_ALLOC, false,
 						   ORDER_EHFRAME, false, false,
-						   false);
+						   false, -1);
   if (os == NULL)
     return NULL;
 
@@ -1554,7 +1739,7 @@ Layout::make_eh_frame_section(const Relobj* object)
 					elfcpp::SHT_PROGBITS,
 					elfcpp::SHF_ALLOC, false,
 					ORDER_EHFRAME, false, false,
-					false);
+					false, -1);
 
 	  if (hdr_os != NULL)
 	    {
@@ -1574,6 +1759,8 @@ Layout::make_eh_frame_section(const Relobj* object)
 		}
 
 	      this->eh_frame_data_->set_eh_frame_hdr(hdr_posd);
+	      this->eh_frame_hdr_section_ = hdr_os;
+	      this->eh_frame_hdr_data_ = hdr_posd;
 	    }
 	}
     }
@@ -1640,7 +1827,7 @@ Layout::add_to_gdb_index(bool is_type_unit,
       Output_section* os = this->choose_output_section(NULL, ".gdb_index",
 						       elfcpp::SHT_PROGBITS, 0,
 						       false, ORDER_INVALID,
-						       false, false, false);
+						       false, false, false, -1);
       if (os == NULL)
 	return;
 
@@ -1649,9 +1836,20 @@ Layout::add_to_gdb_index(bool is_type_unit,
       os->set_after_input_sections();
     }
 
-  this->gdb_index_data_->scan_debug_info(is_type_unit, object, symbols,
-					 symbols_size, shndx, reloc_shndx,
-					 reloc_type);
+  this->gdb_index_data_->add_debug_info(is_type_unit, object, symbols,
+					symbols_size, shndx, reloc_shndx,
+					reloc_type);
+}
+
+// Queue the tasks which scan the debug info for the .gdb_index
+// section.
+
+Task_token*
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* this_blocker)
+{
+  if (this->gdb_index_data_ == NULL)
+    return this_blocker;
+  return this->gdb_index_data_->queue_scan_tasks(workqueue, this_blocker);
 }
 
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
@@ -1665,7 +1863,7 @@ Layout::add_output_section_data(const char* name, elfcpp::Elf_Word type,
 {
   Output_section* os = this->choose_output_section(NULL, name, type, flags,
 						   false, order, is_relro,
-						   false, false);
+						   false, false, -1);
   if (os != NULL)
     os->add_output_section_data(posd);
   return os;
@@ -1698,8 +1896,13 @@ Layout::make_output_section(const char* name, elfcpp::Elf_Word type,
   if ((flags & elfcpp::SHF_ALLOC) == 0
       && strcmp(parameters->options().compress_debug_sections(), "none") != 0
       && is_compressible_debug_section(name))
-    os = new Output_compressed_section(&parameters->options(), name, type,
-				       flags);
+    {
+      Output_compressed_section* cos =
+	new Output_compressed_section(&parameters->options(), name, type,
+				      flags);
+      this->compressed_sections_.push_back(cos);
+      os = cos;
+    }
   else if ((flags & elfcpp::SHF_ALLOC) == 0
 	   && parameters->options().strip_debug_non_line()
 	   && strcmp(".debug_abbrev", name) == 0)
@@ -2206,7 +2409,7 @@ Layout::create_initial_dynamic_sections(Symbol_table* symtab)
 						       (elfcpp::SHF_ALLOC
 							| elfcpp::SHF_WRITE),
 						       false, ORDER_RELRO,
-						       true, false, false);
+						       true, false, false, -1);
 
   // A linker script may discard .dynamic, so check for NULL.
   if (this->dynamic_section_ != NULL)
@@ -2647,20 +2850,13 @@ Layout::find_section_order_index(const std::string& section_name)
   if (map_it != this->input_section_position_.end())
     return map_it->second;
 
-  // Absolute match failed.  Linear search the glob patterns.
-  std::vector<std::string>::iterator it;
-  for (it = this->input_section_glob_.begin();
-       it != this->input_section_glob_.end();
-       ++it)
-    {
-       if (fnmatch((*it).c_str(), section_name.c_str(), FNM_NOESCAPE) == 0)
-	 {
-	   map_it = this->input_section_position_.find(*it);
-	   gold_assert(map_it != this->input_section_position_.end());
-	   return map_it->second;
-	 }
-    }
-  return 0;
+  // Absolute match failed.  Find the first glob pattern which matches.
+  int i = this->input_section_glob_index_.first_match(section_name.c_str());
+  if (i < 0)
+    return 0;
+  map_it = this->input_section_position_.find(this->input_section_glob_[i]);
+  gold_assert(map_it != this->input_section_position_.end());
+  return map_it->second;
 }
 
 // Read the sequence of input sections from the file specified with
@@ -2692,20 +2888,104 @@ Layout::read_layout_from_file()
 	  std::getline(in, line);
 	  continue;
 	}
+      // Store all glob patterns in a vector, once each.  A pattern
+      // which appears more than once gets its last position, but is
+      // tried in the order of its first appearance.
+      if (is_wildcard_string(line.c_str())
+	  && (this->input_section_position_.find(line)
+	      == this->input_section_position_.end()))
+	{
+	  this->input_section_glob_index_.add(line,
+					      this->input_section_glob_.size());
+	  this->input_section_glob_.push_back(line);
+	}
       this->input_section_position_[line] = position;
-      // Store all glob patterns in a vector.
-      if (is_wildcard_string(line.c_str()))
-	this->input_section_glob_.push_back(line);
       position++;
       std::getline(in, line);
     }
 }
 
+// Return the position of symbol NAME in the symbol ordering file, or
+// 0 if it is not there.  The map is not changed after
+// read_symbol_order_from_file, so this is safe to call from the
+// Read_symbols tasks.
+
+unsigned int
+Layout::find_symbol_order_index(const char* name) const
+{
+  Unordered_map<std::string, unsigned int>::const_iterator p =
+    this->symbol_position_.find(name);
+  if (p == this->symbol_position_.end())
+    return 0;
+  return p->second;
+}
+
+// Read the sequence of symbols from the file specified with option
+// --symbol-ordering-file.  There is one symbol name per line.
+// Leading and trailing white space and anything after a '#' are
+// ignored.  If a symbol appears more than once, its first position is
+// used.
+
+void
+Layout::read_symbol_order_from_file()
+{
+  const char* filename = parameters->options().symbol_ordering_file();
+  std::ifstream in;
+  std::string line;
+
+  in.open(filename);
+  if (!in)
+    gold_fatal(_("unable to open --symbol-ordering-file file %s: %s"),
+	       filename, strerror(errno));
+
+  unsigned int position = 1;
+  this->set_section_ordering_specified();
+
+  while (std::getline(in, line))
+    {
+      std::string::size_type hash = line.find('#');
+      if (hash != std::string::npos)
+	line.resize(hash);
+      std::string::size_type start = line.find_first_not_of(" \t\r");
+      if (start == std::string::npos)
+	continue;
+      std::string::size_type end = line.find_last_not_of(" \t\r");
+      std::string name(line, start, end + 1 - start);
+      if (this->symbol_position_.insert(std::make_pair(name, position)).second)
+	++position;
+    }
+}
+
+// Read the call graph profile from the file specified with option
+// --call-graph-ordering-file.
+
+void
+Layout::read_call_graph_from_file()
+{
+  gold_assert(this->call_graph_ == NULL);
+  this->call_graph_ = new Call_graph();
+  this->call_graph_->read(parameters->options().call_graph_ordering_file());
+  this->set_section_ordering_specified();
+}
+
+// Order the sections which define the functions in the call graph
+// profile.  The order goes in section_order_map_, as though a plugin
+// had specified it.
+
+void
+Layout::order_sections_by_call_graph(const Task* task,
+				     const Symbol_table* symtab)
+{
+  gold_assert(this->call_graph_ != NULL);
+  this->call_graph_->order_sections(task, symtab, &this->section_order_map_);
+}
+
 // Finalize the layout.  When this is called, we have created all the
 // output sections and all the output segments which are based on
-// input sections.  We have several things to do, and we have to do
-// them in the right order, so that we get the right results correctly
-// and efficiently.
+// input sections, the target has finalized its sections, and the
+// local symbols have been counted.  We have several things to do,
+// and we have to do them in the right order, so that we get the
+// right results correctly and efficiently.
 
 // 1) Finalize the list of output segments and create the segment
 // table header.
@@ -2735,14 +3015,12 @@ Layout::read_layout_from_file()
 
 off_t
 Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
-		 Target* target, const Task* task)
+		 Target* target, Workqueue* workqueue, const Task* task)
 {
   unsigned int local_dynamic_count = 0;
   unsigned int forced_local_dynamic_count = 0;
 
-  target->finalize_sections(this, input_objects, symtab);
-
-  this->count_local_symbols(task, input_objects);
+  this->merge_local_symbol_pools();
 
   this->link_stabs_sections();
 
@@ -2824,6 +3102,11 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   if (target->may_relax())
     this->prepare_for_relaxation();
 
+  // The target may scan the objects in parallel while relaxing.
+  Workqueue* relax_workqueue = (parameters->options().threads()
+				? workqueue
+				: NULL);
+
   // Run the relaxation loop to lay out sections.
   do
     {
@@ -2833,7 +3116,8 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
       pass++;
     }
   while (target->may_relax()
-	 && target->relax(pass, input_objects, symtab, this, task));
+	 && target->relax(pass, input_objects, symtab, this, relax_workqueue,
+			  task));
 
   // If there is a load segment that contains the file and program headers,
   // provide a symbol __ehdr_start pointing there.
@@ -2996,7 +3280,7 @@ Layout::create_note(const char* name, int note_type,
   Output_section* os = this->choose_output_section(NULL, section_name,
 						   elfcpp::SHT_NOTE,
 						   flags, false, order, false,
-						   false, true);
+						   false, true, -1);
   if (os == NULL)
     return NULL;
 
@@ -3126,6 +3410,8 @@ Layout::create_build_id()
     descsz = 128 / 8;
   else if ((strcmp(style, "sha1") == 0) || (strcmp(style, "tree") == 0))
     descsz = 160 / 8;
+  else if (strcmp(style, "fast") == 0)
+    descsz = 64 / 8;
   else if (strcmp(style, "uuid") == 0)
     {
 #ifndef __MINGW32__
@@ -4011,11 +4297,18 @@ Layout::place_orphan_sections_in_script()
 }
 
 // Count the local symbols in the regular symbol table and the dynamic
-// symbol table, and build the respective string pools.
+// symbol table, and build the respective string pools.  When using
+// threads, each object is handled by a task which adds the names to
+// string pools of its own and unblocks BLOCKER, and
+// merge_local_symbol_pools later merges them in the order of the
+// objects.  This gives the same string tables as adding the names
+// directly.
 
 void
 Layout::count_local_symbols(const Task* task,
-			    const Input_objects* input_objects)
+			    const Input_objects* input_objects,
+			    Workqueue* workqueue,
+			    Task_token* blocker)
 {
   // First, figure out an upper bound on the number of symbols we'll
   // be inserting into each pool.  This helps us create the pools with
@@ -4036,15 +4329,52 @@ Layout::count_local_symbols(const Task* task,
   this->sympool_.reserve(symbol_count);
   this->dynpool_.reserve(symbol_count);
 
+  // An incremental update reads the local symbols from the base file,
+  // so we don't try to do that in parallel.
+  if (!parameters->options().threads() || parameters->incremental_update())
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  Task_lock_obj<Object> tlo(task, *p);
+	  (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+	}
+      return;
+    }
+
   for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
        p != input_objects->relobj_end();
        ++p)
     {
-      Task_lock_obj<Object> tlo(task, *p);
-      (*p)->count_local_symbols(&this->sympool_, &this->dynpool_);
+      Stringpool* pool = new Stringpool();
+      Stringpool* dynpool = new Stringpool();
+      this->local_sympools_.push_back(pool);
+      this->local_dynpools_.push_back(dynpool);
+      blocker->add_blocker();
+      workqueue->queue(new Count_local_symbols_task(*p, pool, dynpool,
+						    blocker));
     }
 }
 
+// Merge the string pools built by the tasks queued by
+// count_local_symbols, in the order of the objects.
+
+void
+Layout::merge_local_symbol_pools()
+{
+  gold_assert(this->local_sympools_.size() == this->local_dynpools_.size());
+  for (size_t i = 0; i < this->local_sympools_.size(); ++i)
+    {
+      this->sympool_.merge(this->local_sympools_[i]);
+      this->dynpool_.merge(this->local_dynpools_[i]);
+      delete this->local_sympools_[i];
+      delete this->local_dynpools_[i];
+    }
+  this->local_sympools_.clear();
+  this->local_dynpools_.clear();
+}
+
 // Create the symbol table sections.  Here we also set the final
 // values of the symbols.  At this point all the loadable sections are
 // fully laid out.  SHNUM is the number of sections so far.
@@ -4368,7 +4698,7 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 						       elfcpp::SHF_ALLOC,
 						       false,
 						       ORDER_DYNAMIC_LINKER,
-						       false, false, false);
+						       false, false, false, -1);
 
   // Check for NULL as a linker script may discard .dynsym.
   if (dynsym != NULL)
@@ -4406,7 +4736,7 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 				    elfcpp::SHT_SYMTAB_SHNDX,
 				    elfcpp::SHF_ALLOC,
 				    false, ORDER_DYNAMIC_LINKER, false, false,
-				    false);
+				    false, -1);
 
       if (dynsym_xindex != NULL)
 	{
@@ -4434,7 +4764,7 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 						       elfcpp::SHF_ALLOC,
 						       false,
 						       ORDER_DYNAMIC_LINKER,
-						       false, false, false);
+						       false, false, false, -1);
   *pdynstr = dynstr;
   if (dynstr != NULL)
     {
@@ -4470,7 +4800,7 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 	this->choose_output_section(NULL, ".gnu.hash", elfcpp::SHT_GNU_HASH,
 				    elfcpp::SHF_ALLOC, false,
 				    ORDER_DYNAMIC_LINKER, false, false,
-				    false);
+				    false, -1);
 
       Output_section_data* hashdata = new Output_data_const_buffer(phash,
 								   hashlen,
@@ -4508,7 +4838,7 @@ Layout::create_dynamic_symtab(const Input_objects* input_objects,
 	this->choose_output_section(NULL, ".hash", elfcpp::SHT_HASH,
 				    elfcpp::SHF_ALLOC, false,
 				    ORDER_DYNAMIC_LINKER, false, false,
-				    false);
+				    false, -1);
 
       Output_section_data* hashdata = new Output_data_const_buffer(phash,
 								   hashlen,
@@ -4615,7 +4945,7 @@ Layout::sized_create_version_sections(
 						     elfcpp::SHF_ALLOC,
 						     false,
 						     ORDER_DYNAMIC_LINKER,
-						     false, false, false);
+						     false, false, false, -1);
 
   // Check for NULL since a linker script may discard this section.
   if (vsec != NULL)
@@ -4647,7 +4977,7 @@ Layout::sized_create_version_sections(
 					  elfcpp::SHT_GNU_verdef,
 					  elfcpp::SHF_ALLOC,
 					  false, ORDER_DYNAMIC_LINKER, false,
-					  false, false);
+					  false, false, -1);
 
       if (vdsec != NULL)
 	{
@@ -4680,7 +5010,7 @@ Layout::sized_create_version_sections(
 					  elfcpp::SHT_GNU_verneed,
 					  elfcpp::SHF_ALLOC,
 					  false, ORDER_DYNAMIC_LINKER, false,
-					  false, false);
+					  false, false, -1);
 
       if (vnsec != NULL)
 	{
@@ -4729,7 +5059,7 @@ Layout::create_interp(const Target* target)
 						     elfcpp::SHT_PROGBITS,
 						     elfcpp::SHF_ALLOC,
 						     false, ORDER_INTERP,
-						     false, false, false);
+						     false, false, false, -1);
   if (osec != NULL)
     osec->add_output_section_data(odata);
 }
@@ -4830,6 +5160,17 @@ Layout::add_target_dynamic_tags(bool use_rel, const Output_data* plt_got,
 	}
     }
 
+  if (dyn_rel != NULL
+      && dyn_rel->relr_section() != NULL
+      && dyn_rel->relr_section()->output_section() != NULL)
+    {
+      Output_section* relr = dyn_rel->relr_section()->output_section();
+      odyn->add_section_address(elfcpp::DT_RELR, relr);
+      odyn->add_section_size(elfcpp::DT_RELRSZ, relr);
+      odyn->add_constant(elfcpp::DT_RELRENT,
+			 parameters->target().get_size() / 8);
+    }
+
   if (add_debug && !parameters->options().shared())
     {
       // The value of the DT_DEBUG tag is filled in by the dynamic
@@ -5512,9 +5853,49 @@ Layout::write_sections_after_input_sections(Output_file* of)
   this->section_headers_->write(of);
 }
 
-// If a tree-style build ID was requested, the parallel part of that computation
-// is already done, and the final hash-of-hashes is computed here.  For other
-// types of build IDs, all the work is done here.
+// Queue the tasks to merge the input sections of merge sections.
+// Without threads the merging is simply done when the sections are
+// finalized.
+
+void
+Layout::queue_merge_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (!parameters->options().threads())
+    return;
+
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    (*p)->queue_merge_tasks(workqueue, blocker);
+}
+
+// Queue the tasks to compress the compressed debug sections.
+
+void
+Layout::queue_compression_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  for (std::vector<Output_compressed_section*>::const_iterator p =
+	 this->compressed_sections_.begin();
+       p != this->compressed_sections_.end();
+       ++p)
+    (*p)->queue_compression_tasks(workqueue, blocker);
+}
+
+// Queue the tasks to sort the .eh_frame_hdr table.
+
+bool
+Layout::queue_eh_frame_hdr_tasks(Output_file* of, Workqueue* workqueue,
+				 Task_token* blocker)
+{
+  if (this->eh_frame_hdr_data_ == NULL)
+    return false;
+  return this->eh_frame_hdr_data_->queue_sort_tasks(of, workqueue, blocker);
+}
+
+// If a tree-style or fast build ID was requested, the parallel part
+// of that computation is already done, and the final hash-of-hashes
+// is computed here.  For other types of build IDs, all the work is
+// done here.
 
 void
 Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
@@ -5525,30 +5906,72 @@ Layout::write_build_id(Output_file* of, unsigned char* array_of_hashes,
 
   unsigned char* ov = of->get_output_view(this->build_id_note_->offset(),
 					  this->build_id_note_->data_size());
+  const char* style = parameters->options().build_id();
 
   if (array_of_hashes == NULL)
     {
       const size_t output_file_size = this->output_file_size();
-      const unsigned char* iv = of->get_input_view(0, output_file_size);
-      const char* style = parameters->options().build_id();
 
       // If we get here with style == "tree" then the output must be
       // too small for chunking, and we use SHA-1 in that case.
-      if ((strcmp(style, "sha1") == 0) || (strcmp(style, "tree") == 0))
-	sha1_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
-      else if (strcmp(style, "md5") == 0)
-	md5_buffer(reinterpret_cast<const char*>(iv), output_file_size, ov);
+      const bool is_sha1 = ((strcmp(style, "sha1") == 0)
+			    || (strcmp(style, "tree") == 0));
+      if (of->is_streaming() && (is_sha1 || strcmp(style, "md5") == 0))
+	{
+	  // Read the file a piece at a time, rather than reading all
+	  // of it into memory.
+	  const size_t piece_size = 16 * 1024 * 1024;
+	  struct sha1_ctx sha1_ctx;
+	  struct md5_ctx md5_ctx;
+	  if (is_sha1)
+	    sha1_init_ctx(&sha1_ctx);
+	  else
+	    md5_init_ctx(&md5_ctx);
+	  for (size_t off = 0; off < output_file_size; off += piece_size)
+	    {
+	      size_t len = std::min(piece_size, output_file_size - off);
+	      const unsigned char* iv = of->get_input_view(off, len);
+	      if (is_sha1)
+		sha1_process_bytes(iv, len, &sha1_ctx);
+	      else
+		md5_process_bytes(iv, len, &md5_ctx);
+	      of->free_input_view(off, len, iv);
+	    }
+	  if (is_sha1)
+	    sha1_finish_ctx(&sha1_ctx, ov);
+	  else
+	    md5_finish_ctx(&md5_ctx, ov);
+	}
       else
-	gold_unreachable();
+	{
+	  const unsigned char* iv = of->get_input_view(0, output_file_size);
 
-      of->free_input_view(0, output_file_size, iv);
+	  if (is_sha1)
+	    sha1_buffer(reinterpret_cast<const char*>(iv), output_file_size,
+			ov);
+	  else if (strcmp(style, "md5") == 0)
+	    md5_buffer(reinterpret_cast<const char*>(iv), output_file_size,
+		       ov);
+	  else if (strcmp(style, "fast") == 0)
+	    xxhash64_buffer(reinterpret_cast<const char*>(iv),
+			    output_file_size, ov);
+	  else
+	    gold_unreachable();
+
+	  of->free_input_view(0, output_file_size, iv);
+	}
     }
   else
     {
       // Non-overlapping substrings of the output file have been hashed.
-      // Compute SHA-1 hash of the hashes.
-      sha1_buffer(reinterpret_cast<const char*>(array_of_hashes),
-		  size_of_hashes, ov);
+      // Compute the hash of the hashes: xxHash for a fast build ID,
+      // SHA-1 otherwise.
+      if (strcmp(style, "fast") == 0)
+	xxhash64_buffer(reinterpret_cast<const char*>(array_of_hashes),
+			size_of_hashes, ov);
+      else
+	sha1_buffer(reinterpret_cast<const char*>(array_of_hashes),
+		    size_of_hashes, ov);
       delete[] array_of_hashes;
     }
 
@@ -5743,14 +6166,50 @@ Write_after_input_sections_task::locks(Task_locker* tl)
 // Run the task.
 
 void
-Write_after_input_sections_task::run(Workqueue*)
+Write_after_input_sections_task::run(Workqueue* workqueue)
 {
+  Task_token* eh_frame_hdr_blocker = new Task_token(true);
+  if (this->layout_->queue_eh_frame_hdr_tasks(this->of_, workqueue,
+					      eh_frame_hdr_blocker))
+    {
+      // Write the sections once the table is sorted.  Since
+      // FINAL_BLOCKER may be shared with other tasks, we need to
+      // increment the count with the workqueue lock held.
+      workqueue->add_blocker(this->final_blocker_);
+      workqueue->queue(new Write_after_input_sections_task(this->layout_,
+							   this->of_,
+							   eh_frame_hdr_blocker,
+							   this->final_blocker_));
+      return;
+    }
+  delete eh_frame_hdr_blocker;
+
   this->layout_->write_sections_after_input_sections(this->of_);
 }
 
+// Compress_sections_task_runner methods.
+
+// Compress the debug sections in parallel, and then write out the
+// sections which require postprocessing.
+
+void
+Compress_sections_task_runner::run(Workqueue* workqueue, const Task*)
+{
+  Task_token* post_compress_tasks_blocker = new Task_token(true);
+  this->layout_->queue_compression_tasks(workqueue,
+					 post_compress_tasks_blocker);
+  workqueue->queue(new Write_after_input_sections_task(this->layout_,
+						       this->of_,
+						       post_compress_tasks_blocker,
+						       this->final_blocker_));
+}
+
 // Build IDs can be computed as a "flat" sha1 or md5 of a string of bytes,
 // or as a "tree" where each chunk of the string is hashed and then those
 // hashes are put into a (much smaller) string which is hashed with sha1.
+// A "fast" build ID is always computed as a tree, using xxHash for both
+// the chunks and the final hash, so that it uses all the threads even
+// for small files.
 // We compute a checksum over the entire file because that is simplest.
 
 void
@@ -5764,27 +6223,40 @@ Build_id_task_runner::run(Workqueue* workqueue, const Task*)
   unsigned char* array_of_hashes = NULL;
   size_t size_of_hashes = 0;
 
-  if (strcmp(this->options_->build_id(), "tree") == 0
+  const char* style = this->options_->build_id();
+  const bool is_fast = strcmp(style, "fast") == 0;
+
+  if ((is_fast
+       || (strcmp(style, "tree") == 0
+	   && (filesize
+	       >= this->options_->build_id_min_file_size_for_treehash())))
       && this->options_->build_id_chunk_size_for_treehash() > 0
-      && filesize > 0
-      && (filesize >= this->options_->build_id_min_file_size_for_treehash()))
+      && filesize > 0)
     {
       static const size_t MD5_OUTPUT_SIZE_IN_BYTES = 16;
+      static const size_t XXHASH64_OUTPUT_SIZE_IN_BYTES = 8;
+      const size_t hash_size = (is_fast
+				? XXHASH64_OUTPUT_SIZE_IN_BYTES
+				: MD5_OUTPUT_SIZE_IN_BYTES);
+      const Hash_buffer_function hash_function = (is_fast
+						  ? xxhash64_buffer
+						  : md5_buffer);
       const size_t chunk_size =
 	  this->options_->build_id_chunk_size_for_treehash();
       const size_t num_hashes = ((filesize - 1) / chunk_size) + 1;
       post_hash_tasks_blocker->add_blockers(num_hashes);
-      size_of_hashes = num_hashes * MD5_OUTPUT_SIZE_IN_BYTES;
+      size_of_hashes = num_hashes * hash_size;
       array_of_hashes = new unsigned char[size_of_hashes];
       unsigned char *dst = array_of_hashes;
       for (size_t i = 0, src_offset = 0; i < num_hashes;
-	   i++, dst += MD5_OUTPUT_SIZE_IN_BYTES, src_offset += chunk_size)
+	   i++, dst += hash_size, src_offset += chunk_size)
 	{
 	  size_t size = std::min(chunk_size, filesize - src_offset);
 	  workqueue->queue(new Hash_task(of,
 					 src_offset,
 					 size,
 					 dst,
+					 hash_function,
 					 post_hash_tasks_blocker));
 	}
     }
@@ -57,9 +57,12 @@ class Output_data_dynamic;
 class Output_symtab_xindex;
 class Output_reduced_debug_abbrev_section;
 class Output_reduced_debug_info_section;
+class Output_compressed_section;
 class Eh_frame;
+class Eh_frame_hdr;
 class Gdb_index;
 class Target;
+class Call_graph;
 struct Timespec;
 
 // Return TRUE if SECNAME is the name of a compressed debug section.
@@ -163,8 +166,9 @@ class Free_list
   static unsigned int num_allocate_visits;
 };
 
-// This task function handles mapping the input sections to output
-// sections and laying them out in memory.
+// This task function lets the target finalize its sections, and
+// counts the local symbols and merges the merge sections, possibly in
+// parallel.  It then queues a Layout_finalize_runner.
 
 class Layout_task_runner : public Task_function_runner
 {
@@ -198,6 +202,41 @@ class Layout_task_runner : public Task_function_runner
   Mapfile* mapfile_;
 };
 
+// This task function handles mapping the input sections to output
+// sections and laying them out in memory.
+
+class Layout_finalize_runner : public Task_function_runner
+{
+ public:
+  // OPTIONS is the command line options, INPUT_OBJECTS is the list of
+  // input objects, SYMTAB is the symbol table, LAYOUT is the layout
+  // object.
+  Layout_finalize_runner(const General_options& options,
+			 const Input_objects* input_objects,
+			 Symbol_table* symtab,
+			 Target* target,
+			 Layout* layout,
+			 Mapfile* mapfile)
+    : options_(options), input_objects_(input_objects), symtab_(symtab),
+      target_(target), layout_(layout), mapfile_(mapfile)
+  { }
+
+  // Run the operation.
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Layout_finalize_runner(const Layout_finalize_runner&);
+  Layout_finalize_runner& operator=(const Layout_finalize_runner&);
+
+  const General_options& options_;
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Target* target_;
+  Layout* layout_;
+  Mapfile* mapfile_;
+};
+
 // This class holds information about the comdat group or
 // .gnu.linkonce section that will be kept for a given signature.
 
@@ -594,6 +633,27 @@ class Layout
   void
   read_layout_from_file();
 
+  // Return the position of symbol NAME in the file specified with
+  // linker option --symbol-ordering-file, or 0 if it is not there.
+  // This may be called from multiple threads at once.
+  unsigned int
+  find_symbol_order_index(const char* name) const;
+
+  // Read the sequence of symbols from the file specified with linker
+  // option --symbol-ordering-file.
+  void
+  read_symbol_order_from_file();
+
+  // Read the call graph profile from the file specified with linker
+  // option --call-graph-ordering-file.
+  void
+  read_call_graph_from_file();
+
+  // Use the call graph profile to set the section order map, once
+  // all the input sections have been laid out.
+  void
+  order_sections_by_call_graph(const Task*, const Symbol_table*);
+
   // Layout an input reloc section when doing a relocatable link.  The
   // section is RELOC_SHNDX in OBJECT, with data in SHDR.
   // DATA_SECTION is the reloc section to which it refers.  RR is the
@@ -672,6 +732,12 @@ class Layout
 		   unsigned int reloc_shndx,
 		   unsigned int reloc_type);
 
+  // Queue the tasks which scan the sections added by add_to_gdb_index
+  // once THIS_BLOCKER is unblocked, and return a blocker which is
+  // unblocked when both are done.
+  Task_token*
+  queue_gdb_index_tasks(Workqueue*, Task_token* this_blocker);
+
   // Handle a GNU stack note.  This is called once per input object
   // file.  SEEN_GNU_STACK is true if the object file has a
   // .note.GNU-stack section.  GNU_STACK_FLAGS is the section flags
@@ -799,9 +865,32 @@ class Layout
 			   unsigned int shndx, bool is_comdat,
 			   bool is_group_name, Kept_section** kept_section);
 
-  // Finalize the layout after all the input sections have been added.
+  // Record the signature of a type unit in an input .debug_types or
+  // .debug_info section, for --dedup-type-units.  Return true if this
+  // is the first time we have seen SIGNATURE.
+  bool
+  add_type_unit_signature(uint64_t signature)
+  { return this->type_unit_signatures_.insert(signature).second; }
+
+  // Count the local symbols in the regular symbol table and the
+  // dynamic symbol table, and build the respective string pools.
+  // When using threads this queues a task for each object, which
+  // unblocks BLOCKER when done.
+  void
+  count_local_symbols(const Task*, const Input_objects*, Workqueue*,
+		      Task_token* blocker);
+
+  // Queue tasks to merge the input sections of merge sections.  Each
+  // task releases a blocker on BLOCKER when it completes.
+  void
+  queue_merge_tasks(Workqueue*, Task_token* blocker);
+
+  // Finalize the layout after all the input sections have been added
+  // and the local symbols have been counted.  The Workqueue is used
+  // to scan objects in parallel when relaxing.
   off_t
-  finalize(const Input_objects*, Symbol_table*, Target*, const Task*);
+  finalize(const Input_objects*, Symbol_table*, Target*, Workqueue*,
+	   const Task*);
 
   // Return whether any sections require postprocessing.
   bool
@@ -862,6 +951,22 @@ class Layout
   void
   write_sections_after_input_sections(Output_file* of);
 
+  // Return whether there are any compressed debug sections.
+  bool
+  any_compressed_sections() const
+  { return !this->compressed_sections_.empty(); }
+
+  // Queue tasks to compress the contents of the compressed debug
+  // sections.  Each task releases a blocker on BLOCKER.
+  void
+  queue_compression_tasks(Workqueue*, Task_token* blocker);
+
+  // Queue tasks to read and sort the FDE addresses for a large
+  // .eh_frame_hdr section.  Each task releases a blocker on BLOCKER.
+  // Return whether any tasks were queued.
+  bool
+  queue_eh_frame_hdr_tasks(Output_file*, Workqueue*, Task_token* blocker);
+
   // Return an output section named NAME, or NULL if there is none.
   Output_section*
   find_output_section(const char* name) const;
@@ -1066,10 +1171,10 @@ class Layout
   Output_segment*
   find_first_load_seg(const Target*);
 
-  // Count the local symbols in the regular symbol table and the dynamic
-  // symbol table, and build the respective string pools.
+  // Merge the string pools built by the tasks queued by
+  // count_local_symbols.
   void
-  count_local_symbols(const Task*, const Input_objects*);
+  merge_local_symbol_pools();
 
   // Create the output sections for the symbol table.
   void
@@ -1157,7 +1262,8 @@ class Layout
   choose_output_section(const Relobj* relobj, const char* name,
 			elfcpp::Elf_Word type, elfcpp::Elf_Xword flags,
 			bool is_input_section, Output_section_order order,
-			bool is_relro, bool is_reloc, bool match_input_spec);
+			bool is_relro, bool is_reloc, bool match_input_spec,
+			int input_spec);
 
   // Create a new Output_section.
   Output_section*
@@ -1336,8 +1442,16 @@ class Layout
   Stringpool sympool_;
   // The dynamic strings, if needed.
   Stringpool dynpool_;
+  // The output symbol names of the local symbols of each object, if
+  // counted by tasks; merged into sympool_ in order.
+  std::vector<Stringpool*> local_sympools_;
+  // Likewise for the dynamic strings.
+  std::vector<Stringpool*> local_dynpools_;
   // The list of group sections and linkonce sections which we have seen.
   Signatures signatures_;
+  // The signatures of the type units we have seen, for
+  // --dedup-type-units.
+  Unordered_set<uint64_t> type_unit_signatures_;
   // The mapping from input section name/type/flags to output sections.
   Section_name_map section_name_map_;
   // The list of output segments.
@@ -1386,6 +1500,8 @@ class Layout
   bool added_eh_frame_data_;
   // The exception frame header output section if there is one.
   Output_section* eh_frame_hdr_section_;
+  // The exception frame header data if there is one.
+  Eh_frame_hdr* eh_frame_hdr_data_;
   // The data for the .gdb_index section.
   Gdb_index* gdb_index_data_;
   // The space for the build ID checksum if there is one.
@@ -1394,6 +1510,8 @@ class Layout
   Output_reduced_debug_abbrev_section* debug_abbrev_;
   // The output section containing the dwarf debug info tree
   Output_reduced_debug_info_section* debug_info_;
+  // The compressed debug sections.
+  std::vector<Output_compressed_section*> compressed_sections_;
   // A list of group sections and their signatures.
   Group_signatures group_signatures_;
   // The size of the output file.
@@ -1446,8 +1564,16 @@ class Layout
   Section_segment_map section_segment_map_;
   // Hash a pattern to its position in the section ordering file.
   Unordered_map<std::string, unsigned int> input_section_position_;
-  // Vector of glob only patterns in the section_ordering file.
+  // Vector of glob only patterns in the section_ordering file, each
+  // appearing once, in the order they first appear.
   std::vector<std::string> input_section_glob_;
+  // Index of the patterns in input_section_glob_, numbered by their
+  // position in that vector.
+  Glob_index input_section_glob_index_;
+  // Hash a symbol name to its position in the symbol ordering file.
+  Unordered_map<std::string, unsigned int> symbol_position_;
+  // The call graph profile, if --call-graph-ordering-file was used.
+  Call_graph* call_graph_;
   // For incremental links, the base file to be modified.
   Incremental_binary* incremental_base_;
   // For incremental links, a list of free space within the file.
@@ -1571,7 +1697,9 @@ class Write_symbols_task : public Task
 // This task handles writing out data in output sections which can't
 // be written out until all the input sections have been handled.
 // This is for sections whose contents is based on the contents of
-// other output sections.
+// other output sections.  When a large .eh_frame_hdr table is sorted
+// by other tasks, this hands FINAL_BLOCKER over to a second
+// Write_after_input_sections_task which waits for them.
 
 class Write_after_input_sections_task : public Task
 {
@@ -1606,6 +1734,29 @@ class Write_after_input_sections_task : public Task
   Task_token* final_blocker_;
 };
 
+// This task function queues the tasks which compress the contents
+// of the compressed debug sections, followed by a
+// Write_after_input_sections_task which waits for them.  This can
+// not run until all the input sections have been written.
+
+class Compress_sections_task_runner : public Task_function_runner
+{
+ public:
+  Compress_sections_task_runner(Layout* layout, Output_file* of,
+				Task_token* final_blocker)
+    : layout_(layout), of_(of), final_blocker_(final_blocker)
+  { }
+
+  // Run the operation.
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  Layout* layout_;
+  Output_file* of_;
+  Task_token* final_blocker_;
+};
+
 // This task function handles computation of the build id.
 // When using --build-id=tree, it schedules the tasks that
 // compute the hashes for each chunk of the file. This task
@@ -29,6 +29,11 @@
 #include <malloc.h>
 #endif
 
+#ifdef HAVE_GETRUSAGE
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
 #include "libiberty.h"
 
 #include "script.h"
@@ -49,6 +54,7 @@
 #include "incremental.h"
 #include "gdb-index.h"
 #include "timer.h"
+#include "tracefile.h"
 
 using namespace gold;
 
@@ -203,6 +209,20 @@ main(int argc, char** argv)
   // The work queue.
   Workqueue workqueue(command_line.options());
 
+  // If the user asked for a trace file, open it.
+  Tracefile* tracefile = NULL;
+  if (command_line.options().user_set_trace_file())
+    {
+      tracefile = new Tracefile();
+      if (!tracefile->open(command_line.options().trace_file()))
+	{
+	  delete tracefile;
+	  tracefile = NULL;
+	}
+      else
+	workqueue.set_tracefile(tracefile);
+    }
+
   // The list of input objects.
   Input_objects input_objects;
 
@@ -234,6 +254,10 @@ main(int argc, char** argv)
 
   if (parameters->options().section_ordering_file())
     layout.read_layout_from_file();
+  else if (parameters->options().symbol_ordering_file())
+    layout.read_symbol_order_from_file();
+  else if (parameters->options().call_graph_ordering_file())
+    layout.read_call_graph_from_file();
 
   // Load plugin libraries.
   if (command_line.options().has_plugins())
@@ -294,6 +318,12 @@ main(int argc, char** argv)
       struct mallinfo m = mallinfo();
       fprintf(stderr, _("%s: total space allocated by malloc: %d bytes\n"),
 	      program_name, m.arena);
+#endif
+#ifdef HAVE_GETRUSAGE
+      struct rusage ru;
+      if (getrusage(RUSAGE_SELF, &ru) == 0)
+	fprintf(stderr, _("%s: peak resident set size: %ld kbytes\n"),
+		program_name, static_cast<long>(ru.ru_maxrss));
 #endif
       File_read::print_stats();
       Archive::print_stats();
@@ -318,6 +348,9 @@ main(int argc, char** argv)
   if (mapfile != NULL)
     mapfile->close();
 
+  if (tracefile != NULL)
+    tracefile->close();
+
   if (parameters->options().fatal_warnings()
       && errors.warning_count() > 0
       && errors.error_count() == 0)
@@ -25,6 +25,9 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "parameters.h"
+#include "options.h"
+#include "workqueue.h"
 #include "merge.h"
 #include "compressed_output.h"
 
@@ -431,23 +434,145 @@ Output_merge_data::do_print_merge_stats(const char* section_name)
 
 // Class Output_merge_string.
 
-// Add an input section to a merged string section.
+// Merging strings is done in two steps, both of which may be split
+// across tasks.  First we compute the hash code of each string, in
+// chunks of input sections.  Then we find the duplicate strings.  For
+// that the strings are split into shards by hash code; each shard has
+// its own hash table, so the shards may be processed in parallel.
+// Each shard looks at the input sections in order, so that for each
+// string we find its first occurrence, just as if we had processed
+// the strings serially.  Finally, finalize_merged_data assigns the
+// output offsets in the order of first occurrence, or in suffix order
+// when optimizing, which gives the same output as a Stringpool.
+
+// A task to compute the hash codes of the strings in some of the
+// input sections.
+
+template<typename Char_type>
+class Merge_string_hash_task : public Task
+{
+ public:
+  Merge_string_hash_task(Output_merge_string<Char_type>* pomb,
+			 size_t first, size_t last, Task_token* hash_blocker)
+    : pomb_(pomb), first_(first), last_(last), hash_blocker_(hash_blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->pomb_->hash_strings(this->first_, this->last_); }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  // Unblock HASH_BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->hash_blocker_); }
+
+  std::string
+  get_name() const
+  { return "Merge_string_hash_task"; }
+
+ private:
+  Output_merge_string<Char_type>* pomb_;
+  const size_t first_;
+  const size_t last_;
+  Task_token* const hash_blocker_;
+};
+
+// A task to find the duplicate strings in one shard.  This runs
+// after all the hash codes have been computed.
+
+template<typename Char_type>
+class Merge_string_find_task : public Task
+{
+ public:
+  Merge_string_find_task(Output_merge_string<Char_type>* pomb,
+			 unsigned int shard, size_t count,
+			 Task_token* hash_blocker, Task_token* final_blocker)
+    : pomb_(pomb), shard_(shard), count_(count), hash_blocker_(hash_blocker),
+      final_blocker_(final_blocker)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->pomb_->find_duplicate_strings(this->shard_, 0, this->count_); }
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->hash_blocker_->is_blocked())
+      return this->hash_blocker_;
+    return NULL;
+  }
+
+  // Unblock FINAL_BLOCKER_ when done.
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->final_blocker_); }
+
+  std::string
+  get_name() const
+  { return "Merge_string_find_task"; }
+
+ private:
+  Output_merge_string<Char_type>* pomb_;
+  const unsigned int shard_;
+  const size_t count_;
+  Task_token* const hash_blocker_;
+  Task_token* const final_blocker_;
+};
+
+// Constructor.  We share the tails of strings under the same
+// conditions as a Stringpool does.
+
+template<typename Char_type>
+Output_merge_string<Char_type>::Output_merge_string(uint64_t addralign)
+  : Output_merge_base(sizeof(Char_type), addralign),
+    merged_strings_lists_(), string_sets_(), hashed_count_(0),
+    merged_count_(0), hash_blocker_(NULL), contents_(NULL),
+    contents_size_(0), optimize_(false), finalized_(false),
+    input_count_(0), input_size_(0), output_count_(0)
+{
+  if (parameters->options_valid()
+      && parameters->options().optimize() >= 2
+      && addralign <= sizeof(Char_type))
+    this->optimize_ = true;
+}
+
+// Destructor.
+
+template<typename Char_type>
+Output_merge_string<Char_type>::~Output_merge_string()
+{
+  for (typename Merged_strings_lists::iterator l =
+	 this->merged_strings_lists_.begin();
+       l != this->merged_strings_lists_.end();
+       ++l)
+    delete *l;
+  if (this->hash_blocker_ != NULL)
+    delete this->hash_blocker_;
+  if (this->contents_ != NULL)
+    delete[] this->contents_;
+}
+
+// Add an input section to a merged string section.  We keep the
+// contents of the input section until the strings have been merged.
 
 template<typename Char_type>
 bool
 Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 						     unsigned int shndx)
 {
+  gold_assert(!this->finalized_);
+
   section_size_type sec_len;
   bool is_new;
   const unsigned char* pdata = object->decompressed_section_contents(shndx,
 								     &sec_len,
 								     &is_new);
 
-  const Char_type* p = reinterpret_cast<const Char_type*>(pdata);
-  const Char_type* pend = p + sec_len / sizeof(Char_type);
-  const Char_type* pend0 = pend;
-
   if (sec_len % sizeof(Char_type) != 0)
     {
       object->error(_("mergeable string section length not multiple of "
@@ -457,69 +582,76 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
       return false;
     }
 
+  const Char_type* pend = (reinterpret_cast<const Char_type*>(pdata)
+			   + sec_len / sizeof(Char_type));
   if (pend[-1] != 0)
+    gold_warning(_("%s: last entry in mergeable string section '%s' "
+		   "not null terminated"),
+		 object->name().c_str(),
+		 object->section_name(shndx).c_str());
+
+  // Copy the contents, unless they were allocated for us.  The copy
+  // has a null character at the end, so that every string in it is
+  // null terminated.
+  const unsigned char* contents = pdata;
+  if (!is_new || pend[-1] != 0)
     {
-      gold_warning(_("%s: last entry in mergeable string section '%s' "
-		     "not null terminated"),
-		   object->name().c_str(),
-		   object->section_name(shndx).c_str());
-      // Find the end of the last NULL-terminated string in the buffer.
-      while (pend0 > p && pend0[-1] != 0)
-	--pend0;
+      unsigned char* copy = new unsigned char[sec_len + sizeof(Char_type)];
+      memcpy(copy, pdata, sec_len);
+      memset(copy + sec_len, 0, sizeof(Char_type));
+      if (is_new)
+	delete[] pdata;
+      contents = copy;
     }
 
+  const Char_type* p = reinterpret_cast<const Char_type*>(contents);
+  pend = p + sec_len / sizeof(Char_type);
+
   Merged_strings_list* merged_strings_list =
-      new Merged_strings_list(object, shndx);
+      new Merged_strings_list(object, shndx, contents);
   this->merged_strings_lists_.push_back(merged_strings_list);
   Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
-  // Count the number of non-null strings in the section and size the list.
+  // Count the number of strings in the section and size the list.
   size_t count = 0;
+  size_t nonnull_count = 0;
   const Char_type* pt = p;
-  while (pt < pend0)
+  while (pt < pend)
     {
       size_t len = string_length(pt);
       if (len != 0)
-	++count;
+	++nonnull_count;
+      ++count;
       pt += len + 1;
     }
-  if (pend0 < pend)
-    ++count;
   merged_strings.reserve(count + 1);
 
   // The index I is in bytes, not characters.
   section_size_type i = 0;
 
   // We assume here that the beginning of the section is correctly
-  // aligned, so each string within the section must retain the same
-  // modulo.
-  uintptr_t init_align_modulo = (reinterpret_cast<uintptr_t>(pdata)
-				 & (this->addralign() - 1));
+  // aligned, so each string within the section must be aligned
+  // relative to the beginning of the section.
   bool has_misaligned_strings = false;
 
   while (p < pend)
     {
-      size_t len = p < pend0 ? string_length(p) : pend - p;
+      size_t len = string_length(p);
 
       // Within merge input section each string must be aligned.
-      if (len != 0
-	  && ((reinterpret_cast<uintptr_t>(p) & (this->addralign() - 1))
-	      != init_align_modulo))
-	  has_misaligned_strings = true;
-
-      Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
+      if (len != 0 && (i & (this->addralign() - 1)) != 0)
+	has_misaligned_strings = true;
 
-      merged_strings.push_back(Merged_string(i, key));
+      merged_strings.push_back(Merged_string(p, len, i));
       p += len + 1;
       i += (len + 1) * sizeof(Char_type);
     }
 
   // Record the last offset in the input section so that we can
   // compute the length of the last string.
-  merged_strings.push_back(Merged_string(i, 0));
+  merged_strings.push_back(Merged_string(NULL, 0, i));
 
-  this->input_count_ += count;
+  this->input_count_ += nonnull_count;
   this->input_size_ += i;
 
   if (has_misaligned_strings)
@@ -532,12 +664,251 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   if (this->keeps_input_sections())
     record_input_section(object, shndx);
 
-  if (is_new)
-    delete[] pdata;
-
   return true;
 }
 
+// Queue the tasks to hash the strings and to find the duplicates.
+// The input sections are hashed in chunks of about HASH_CHUNK_SIZE
+// bytes.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::do_queue_merge_tasks(Workqueue* workqueue,
+						     Task_token* blocker)
+{
+  gold_assert(this->string_sets_.empty() && !this->finalized_);
+
+  const size_t count = this->merged_strings_lists_.size();
+  if (count == 0)
+    return;
+
+  std::vector<size_t> chunk_ends;
+  size_t size = 0;
+  for (size_t i = 0; i < count; ++i)
+    {
+      size += this->merged_strings_lists_[i]->merged_strings.back().offset;
+      if (size >= hash_chunk_size || i + 1 == count)
+	{
+	  chunk_ends.push_back(i + 1);
+	  size = 0;
+	}
+    }
+
+  this->hash_blocker_ = new Task_token(true);
+  this->hash_blocker_->add_blockers(chunk_ends.size());
+  size_t first = 0;
+  for (std::vector<size_t>::const_iterator p = chunk_ends.begin();
+       p != chunk_ends.end();
+       ++p)
+    {
+      workqueue->queue(new Merge_string_hash_task<Char_type>(this, first, *p,
+							     this->hash_blocker_));
+      first = *p;
+    }
+  this->hashed_count_ = count;
+
+  this->string_sets_.resize(shard_count);
+  blocker->add_blockers(shard_count);
+  for (unsigned int shard = 0; shard < shard_count; ++shard)
+    workqueue->queue(new Merge_string_find_task<Char_type>(this, shard, count,
+							   this->hash_blocker_,
+							   blocker));
+  this->merged_count_ = count;
+}
+
+// Compute the hash codes of the strings in input sections FIRST up
+// to LAST.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::hash_strings(size_t first, size_t last)
+{
+  for (size_t i = first; i < last; ++i)
+    {
+      Merged_strings& merged_strings =
+	this->merged_strings_lists_[i]->merged_strings;
+      for (typename Merged_strings::iterator p = merged_strings.begin();
+	   p != merged_strings.end();
+	   ++p)
+	{
+	  if (p->string != NULL)
+	    p->hash_code = string_hash<Char_type>(p->string, p->length);
+	}
+    }
+}
+
+// Find the first occurrence of each string in shard SHARD in input
+// sections FIRST up to LAST.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::find_duplicate_strings(unsigned int shard,
+						       size_t first,
+						       size_t last)
+{
+  const size_t nshards = this->string_sets_.size();
+  gold_assert(shard < nshards);
+  Merged_string_set& string_set(this->string_sets_[shard]);
+
+  for (size_t i = first; i < last; ++i)
+    {
+      Merged_strings& merged_strings =
+	this->merged_strings_lists_[i]->merged_strings;
+      for (typename Merged_strings::iterator p = merged_strings.begin();
+	   p != merged_strings.end();
+	   ++p)
+	{
+	  if (p->string == NULL || p->hash_code % nshards != shard)
+	    continue;
+	  std::pair<typename Merged_string_set::iterator, bool> ins =
+	    string_set.insert(&*p);
+	  p->canonical = *ins.first;
+	}
+    }
+}
+
+// Sort the strings so that a string immediately follows the strings
+// of which it is a suffix, by comparing the strings backward.  This
+// is the order used by Stringpool.
+
+template<typename Char_type>
+bool
+Output_merge_string<Char_type>::Merged_string_sort_comparison::operator()(
+    const Merged_string* ms1,
+    const Merged_string* ms2) const
+{
+  const size_t len1 = ms1->length;
+  const size_t len2 = ms2->length;
+  const size_t minlen = len1 < len2 ? len1 : len2;
+  const Char_type* p1 = ms1->string + len1 - 1;
+  const Char_type* p2 = ms2->string + len2 - 1;
+  for (size_t i = minlen; i > 0; --i, --p1, --p2)
+    {
+      if (*p1 != *p2)
+	return *p1 > *p2;
+    }
+  return len1 > len2;
+}
+
+// Assign the output offsets of the strings, and set CONTENTS_SIZE_.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::set_string_offsets()
+{
+  const size_t charsize = sizeof(Char_type);
+  const uint64_t addralign = this->addralign();
+
+  std::vector<Merged_string*> v;
+  for (typename Merged_strings_lists::const_iterator l =
+	 this->merged_strings_lists_.begin();
+       l != this->merged_strings_lists_.end();
+       ++l)
+    {
+      Merged_strings& merged_strings = (*l)->merged_strings;
+      for (typename Merged_strings::iterator p = merged_strings.begin();
+	   p != merged_strings.end();
+	   ++p)
+	{
+	  if (p->string != NULL && p->canonical == &*p)
+	    v.push_back(&*p);
+	}
+    }
+  this->output_count_ = v.size();
+
+  section_offset_type offset = 0;
+  if (!this->optimize_)
+    {
+      for (typename std::vector<Merged_string*>::iterator p = v.begin();
+	   p != v.end();
+	   ++p)
+	{
+	  offset = align_address(offset, addralign);
+	  (*p)->output_offset = offset;
+	  offset += ((*p)->length + 1) * charsize;
+	}
+    }
+  else
+    {
+      // Share the tails of strings.  As in Stringpool, this is only
+      // done when the user asks for heavy optimization.
+      std::sort(v.begin(), v.end(), Merged_string_sort_comparison());
+
+      section_offset_type last_offset = -1;
+      for (typename std::vector<Merged_string*>::iterator last = v.end(),
+	     curr = v.begin();
+	   curr != v.end();
+	   last = curr++)
+	{
+	  section_offset_type this_offset;
+	  if (last != v.end()
+	      && ((((*curr)->length - (*last)->length) % addralign) == 0)
+	      && (*curr)->length <= (*last)->length
+	      && memcmp((*curr)->string,
+			(*last)->string + (*last)->length - (*curr)->length,
+			(*curr)->length * charsize) == 0)
+	    this_offset = (last_offset
+			   + ((*last)->length - (*curr)->length) * charsize);
+	  else
+	    {
+	      this_offset = align_address(offset, addralign);
+	      offset = this_offset + ((*curr)->length + 1) * charsize;
+	    }
+	  (*curr)->output_offset = this_offset;
+	  last_offset = this_offset;
+	}
+    }
+  this->contents_size_ = offset;
+
+  // Now that the first occurrences have their offsets, set the
+  // offsets of the duplicates.
+  for (typename Merged_strings_lists::const_iterator l =
+	 this->merged_strings_lists_.begin();
+       l != this->merged_strings_lists_.end();
+       ++l)
+    {
+      Merged_strings& merged_strings = (*l)->merged_strings;
+      for (typename Merged_strings::iterator p = merged_strings.begin();
+	   p != merged_strings.end();
+	   ++p)
+	{
+	  if (p->string != NULL && p->canonical != &*p)
+	    p->output_offset = p->canonical->output_offset;
+	}
+    }
+}
+
+// Build the contents of the output section from the first
+// occurrences of the strings.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::build_contents()
+{
+  const section_size_type size = this->contents_size_;
+  this->contents_ = new unsigned char[size];
+  memset(this->contents_, 0, size);
+
+  for (typename Merged_strings_lists::const_iterator l =
+	 this->merged_strings_lists_.begin();
+       l != this->merged_strings_lists_.end();
+       ++l)
+    {
+      const Merged_strings& merged_strings = (*l)->merged_strings;
+      for (typename Merged_strings::const_iterator p = merged_strings.begin();
+	   p != merged_strings.end();
+	   ++p)
+	{
+	  if (p->string == NULL || p->canonical != &*p)
+	    continue;
+	  const section_size_type len = (p->length + 1) * sizeof(Char_type);
+	  gold_assert(static_cast<section_size_type>(p->output_offset) + len
+		      <= size);
+	  memcpy(this->contents_ + p->output_offset, p->string, len);
+	}
+    }
+}
+
 // Finalize the mappings from the input sections to the output
 // section, and return the final data size.
 
@@ -545,7 +916,29 @@ template<typename Char_type>
 section_size_type
 Output_merge_string<Char_type>::finalize_merged_data()
 {
-  this->stringpool_.set_string_offsets();
+  // This function may be called twice, as may happen if
+  // Layout::set_segment_offsets finds a better alignment.
+  if (this->finalized_)
+    return this->contents_size_;
+
+  // Any tasks we queued are done by now.  Do the work for the input
+  // sections which they did not handle, which is all of them if we
+  // are not using threads.
+  if (this->hash_blocker_ != NULL)
+    {
+      delete this->hash_blocker_;
+      this->hash_blocker_ = NULL;
+    }
+  if (this->string_sets_.empty())
+    this->string_sets_.resize(1);
+  const size_t count = this->merged_strings_lists_.size();
+  this->hash_strings(this->hashed_count_, count);
+  for (unsigned int shard = 0; shard < this->string_sets_.size(); ++shard)
+    this->find_duplicate_strings(shard, this->merged_count_, count);
+  this->string_sets_.clear();
+
+  this->set_string_offsets();
+  this->build_contents();
 
   for (typename Merged_strings_lists::const_iterator l =
 	 this->merged_strings_lists_.begin();
@@ -569,19 +962,17 @@ Output_merge_string<Char_type>::finalize_merged_data()
 	    input_merge_map->add_mapping(last_input_offset, length,
                                          last_output_offset);
 	  last_input_offset = p->offset;
-	  if (p->stringpool_key != 0)
-	    last_output_offset =
-	        this->stringpool_.get_offset_from_key(p->stringpool_key);
+	  if (p->string != NULL)
+	    last_output_offset = p->output_offset;
 	}
       delete *l;
     }
 
-  // Save some memory.  This also ensures that this function will work
-  // if called twice, as may happen if Layout::set_segment_offsets
-  // finds a better alignment.
+  // Save some memory.
   this->merged_strings_lists_.clear();
+  this->finalized_ = true;
 
-  return this->stringpool_.get_strtab_size();
+  return this->contents_size_;
 }
 
 template<typename Char_type>
@@ -598,7 +989,7 @@ template<typename Char_type>
 void
 Output_merge_string<Char_type>::do_write(Output_file* of)
 {
-  this->stringpool_.write(of, this->offset());
+  of->write(this->offset(), this->contents_, this->contents_size_);
 }
 
 // Write a merged string section to a buffer.
@@ -607,7 +998,7 @@ template<typename Char_type>
 void
 Output_merge_string<Char_type>::do_write_to_buffer(unsigned char* buffer)
 {
-  this->stringpool_.write_to_buffer(buffer, this->data_size());
+  memcpy(buffer, this->contents_, this->contents_size_);
 }
 
 // Return the name of the types of string to use with
@@ -654,7 +1045,8 @@ Output_merge_string<Char_type>::do_print_merge_stats(const char* section_name)
 	  program_name, buf, this->input_size_);
   fprintf(stderr, _("%s: %s input strings: %zu\n"),
 	  program_name, buf, this->input_count_);
-  this->stringpool_.print_stats(buf);
+  fprintf(stderr, _("%s: %s output strings: %zu\n"),
+	  program_name, buf, this->output_count_);
 }
 
 // Instantiate the templates we need.
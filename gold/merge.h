@@ -400,18 +400,30 @@ template<typename Char_type>
 class Output_merge_string : public Output_merge_base
 {
  public:
-  Output_merge_string(uint64_t addralign)
-    : Output_merge_base(sizeof(Char_type), addralign), stringpool_(addralign),
-      merged_strings_lists_(), input_count_(0), input_size_(0)
-  {
-    this->stringpool_.set_no_zero_null();
-  }
+  Output_merge_string(uint64_t addralign);
+
+  ~Output_merge_string();
+
+  // Compute the hash codes of the strings in the input sections
+  // FIRST up to LAST.  This may be called by a task.
+  void
+  hash_strings(size_t first, size_t last);
+
+  // Find the duplicate strings in the input sections FIRST up to
+  // LAST, looking only at strings which fall in shard SHARD.  This
+  // may be called by a task, in parallel with calls for other shards.
+  void
+  find_duplicate_strings(unsigned int shard, size_t first, size_t last);
 
  protected:
   // Add an input section.
   bool
   do_add_input_section(Relobj* object, unsigned int shndx);
 
+  // Queue tasks to find the duplicate strings.
+  void
+  do_queue_merge_tasks(Workqueue*, Task_token* blocker);
+
   // Do all the final processing after the input sections are read in.
   // Returns the final data size.
   section_size_type
@@ -438,16 +450,6 @@ class Output_merge_string : public Output_merge_base
   void
   do_print_merge_stats(const char* section_name);
 
-  // Writes the stringpool to a buffer.
-  void
-  stringpool_to_buffer(unsigned char* buffer, section_size_type buffer_size)
-  { this->stringpool_.write_to_buffer(buffer, buffer_size); }
-
-  // Clears all the data in the stringpool, to save on memory.
-  void
-  clear_stringpool()
-  { this->stringpool_.clear(); }
-
   // Whether this is a merge string section.
   virtual bool
   do_is_string()
@@ -470,13 +472,25 @@ class Output_merge_string : public Output_merge_base
   // index and offset to strings.
   struct Merged_string
   {
+    // The string, which points into the contents of the input
+    // section.  This is NULL for the entry which records the end of
+    // the input section.
+    const Char_type* string;
+    // The length of the string in characters.
+    size_t length;
+    // The hash code of the string.
+    size_t hash_code;
     // The offset in the input section.
     section_offset_type offset;
-    // The key in the Stringpool.
-    Stringpool::Key stringpool_key;
+    // The first occurrence of the same string.
+    const Merged_string* canonical;
+    // The offset in the output section.
+    section_offset_type output_offset;
 
-    Merged_string(section_offset_type offseta, Stringpool::Key stringpool_keya)
-      : offset(offseta), stringpool_key(stringpool_keya)
+    Merged_string(const Char_type* stringa, size_t lengtha,
+		  section_offset_type offseta)
+      : string(stringa), length(lengtha), hash_code(0), offset(offseta),
+	canonical(NULL), output_offset(0)
     { }
   };
 
@@ -488,25 +502,93 @@ class Output_merge_string : public Output_merge_base
     Relobj* object;
     // The input section in the input object.
     unsigned int shndx;
+    // The contents of the input section, allocated with new[].
+    const unsigned char* contents;
     // The list of merged strings.
     Merged_strings merged_strings;
 
-    Merged_strings_list(Relobj* objecta, unsigned int shndxa)
-      : object(objecta), shndx(shndxa), merged_strings()
+    Merged_strings_list(Relobj* objecta, unsigned int shndxa,
+			const unsigned char* contentsa)
+      : object(objecta), shndx(shndxa), contents(contentsa), merged_strings()
     { }
+
+    ~Merged_strings_list()
+    { delete[] this->contents; }
   };
 
   typedef std::vector<Merged_strings_list*> Merged_strings_lists;
 
-  // As we see the strings, we add them to a Stringpool.
-  Stringpool_template<Char_type> stringpool_;
-  // Map from a location in an input object to an entry in the
-  // Stringpool.
+  // Hashing and equality for a set of strings.
+  struct Merged_string_hash
+  {
+    size_t
+    operator()(const Merged_string* ms) const
+    { return ms->hash_code; }
+  };
+
+  struct Merged_string_eq
+  {
+    bool
+    operator()(const Merged_string* ms1, const Merged_string* ms2) const
+    {
+      return (ms1->length == ms2->length
+	      && memcmp(ms1->string, ms2->string,
+			ms1->length * sizeof(Char_type)) == 0);
+    }
+  };
+
+  typedef Unordered_set<const Merged_string*, Merged_string_hash,
+			Merged_string_eq> Merged_string_set;
+
+  // Sort strings so that a string immediately follows the strings
+  // it is a suffix of.
+  struct Merged_string_sort_comparison
+  {
+    bool
+    operator()(const Merged_string*, const Merged_string*) const;
+  };
+
+  // The number of shards used to find duplicate strings when using
+  // threads.
+  static const unsigned int shard_count = 16;
+
+  // The amount of input section data to hash in one task.
+  static const size_t hash_chunk_size = 4 * 1024 * 1024;
+
+  // Assign the output offsets of the strings.
+  void
+  set_string_offsets();
+
+  // Build the contents of the output section.
+  void
+  build_contents();
+
+  // The input sections, with the strings they contain.
   Merged_strings_lists merged_strings_lists_;
+  // The first occurrence of each distinct string, split into shards
+  // by hash code.
+  std::vector<Merged_string_set> string_sets_;
+  // The number of input sections whose strings have been hashed.
+  size_t hashed_count_;
+  // The number of input sections whose strings have been looked up
+  // in STRING_SETS_.
+  size_t merged_count_;
+  // Blocker which is released when all the strings have been hashed.
+  Task_token* hash_blocker_;
+  // The contents of the output section, allocated with new[].
+  unsigned char* contents_;
+  // The size of CONTENTS_.
+  section_size_type contents_size_;
+  // Whether to share the tails of strings.
+  bool optimize_;
+  // Whether finalize_merged_data has been called.
+  bool finalized_;
   // The number of entries seen in input files.
   size_t input_count_;
   // The total size of input sections.
   size_t input_size_;
+  // The number of distinct strings.
+  size_t output_count_;
 };
 
 } // End namespace gold.
@@ -41,6 +41,7 @@
 #include "plugin.h"
 #include "compressed_output.h"
 #include "incremental.h"
+#include "input_cache.h"
 #include "merge.h"
 
 namespace gold
@@ -479,7 +480,9 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
     is_deferred_layout_(false),
     deferred_layout_(),
     deferred_layout_relocs_(),
-    output_views_(NULL)
+    script_input_specs_(),
+    output_views_(NULL),
+    split_relocs_(NULL)
 {
   this->e_type_ = ehdr.get_e_type();
 }
@@ -844,6 +847,11 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
 
   bool need_local_symbols = this->do_find_special_sections(sd);
 
+  // We need the local symbols to find the sections which define the
+  // symbols in a symbol ordering file.
+  if (parameters->options().symbol_ordering_file())
+    need_local_symbols = true;
+
   sd->symbols = NULL;
   sd->symbols_size = 0;
   sd->external_symbols_offset = 0;
@@ -917,6 +925,197 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
   sd->symbol_names = fvstrtab;
   sd->symbol_names_size =
     convert_to_section_size_type(strtabshdr.get_sh_size());
+
+  this->compute_symbol_name_hashes(sd);
+}
+
+// Compute the lengths and hash codes of the names of the external
+// symbols.  This is called while reading the symbols, which is done
+// in parallel for different input files.  Adding the symbols to the
+// symbol table is done in input file order, so we want to do as
+// little work there as possible.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::compute_symbol_name_hashes(
+    Read_symbols_data* sd)
+{
+  const int sym_size = This::sym_size;
+  section_size_type extsize = sd->symbols_size - sd->external_symbols_offset;
+  if (extsize % sym_size != 0)
+    {
+      // add_symbols will report the error.
+      return;
+    }
+  const size_t symcount = extsize / sym_size;
+
+  const bool use_cache = input_cache_enabled();
+  if (use_cache
+      && input_cache_read_symbol_name_hashes(this, symcount,
+					     &sd->symbol_name_hashes))
+    return;
+
+  const unsigned char* p = sd->symbols->data() + sd->external_symbols_offset;
+  const char* sym_names =
+    reinterpret_cast<const char*>(sd->symbol_names->data());
+  const section_size_type sym_names_size = sd->symbol_names_size;
+
+  sd->symbol_name_hashes.resize(symcount);
+  for (size_t i = 0; i < symcount; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      unsigned int st_name = sym.get_st_name();
+      Symbol_name_hash* snh = &sd->symbol_name_hashes[i];
+      if (st_name >= sym_names_size)
+	{
+	  // add_symbols will report the error.
+	  snh->length = 0;
+	  snh->hash_code = 0;
+	  continue;
+	}
+
+      // In an object file, an '@' in the name separates the symbol
+      // name from the version name.
+      const char* name = sym_names + st_name;
+      const char* q = name;
+      while (*q != '\0' && *q != '@')
+	++q;
+      snh->length = q - name;
+      snh->hash_code = string_hash<char>(name, snh->length);
+    }
+
+  if (use_cache)
+    input_cache_write_symbol_name_hashes(this, sd->symbol_name_hashes);
+}
+
+// Match the names of the defined external symbols against the
+// version script.  Like compute_symbol_name_hashes, this is called
+// while reading the symbols, so that the matching, which may demangle
+// each name, is done in parallel for different input files.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_match_version_script(
+    const Version_script_info& version_script,
+    Read_symbols_data* sd)
+{
+  if (version_script.empty() || sd->symbols == NULL)
+    return;
+
+  const int sym_size = This::sym_size;
+  section_size_type extsize = sd->symbols_size - sd->external_symbols_offset;
+  if (extsize % sym_size != 0)
+    return;
+  const size_t symcount = extsize / sym_size;
+
+  const unsigned char* p = sd->symbols->data() + sd->external_symbols_offset;
+  const char* sym_names =
+    reinterpret_cast<const char*>(sd->symbol_names->data());
+  const section_size_type sym_names_size = sd->symbol_names_size;
+
+  sd->version_script_matches.resize(symcount);
+  for (size_t i = 0; i < symcount; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      unsigned int st_name = sym.get_st_name();
+      if (st_name >= sym_names_size
+	  || sym.get_st_shndx() == elfcpp::SHN_UNDEF)
+	continue;
+      const char* name = sym_names + st_name;
+      if (strchr(name, '@') != NULL)
+	continue;
+      version_script.match_symbol(name, &sd->version_script_matches[i]);
+    }
+}
+
+// Find the first input section spec in the SECTIONS clause SS which
+// matches each section.  This is called while reading the symbols, so
+// that the matching is done in parallel for different input files,
+// rather than in do_layout, which runs in input file order.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_match_script_sections(
+    const Script_sections* ss,
+    Read_symbols_data* sd)
+{
+  if (!ss->has_input_section_index()
+      || sd->section_headers == NULL
+      || sd->section_names == NULL)
+    return;
+
+  const unsigned int shnum = this->shnum();
+  const char* file_name = this->name().c_str();
+  const char* pnames =
+    reinterpret_cast<const char*>(sd->section_names->data());
+
+  this->script_input_specs_.resize(shnum, -1);
+
+  // Skip the first, dummy, section.
+  const unsigned char* pshdrs = (sd->section_headers->data()
+				 + This::shdr_size);
+  for (unsigned int i = 1; i < shnum; ++i, pshdrs += This::shdr_size)
+    {
+      typename This::Shdr shdr(pshdrs);
+      if (shdr.get_sh_name() >= sd->section_names_size)
+	continue;
+      const char* name = pnames + shdr.get_sh_name();
+      this->script_input_specs_[i] = ss->find_input_section_spec(file_name,
+								 name);
+    }
+}
+
+// Record for each section the position in the --symbol-ordering-file
+// of the first listed symbol which it defines.  This is called while
+// reading the symbols, so that the lookups are done in parallel for
+// different input files.  Archive members are matched in do_layout.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_match_symbol_order(
+    const Layout* layout,
+    Read_symbols_data* sd)
+{
+  const unsigned int shnum = this->shnum();
+  std::vector<unsigned int>& indexes(this->symbol_order_indexes());
+  indexes.resize(shnum, 0);
+
+  if (sd->symbols == NULL || sd->symbol_names == NULL)
+    return;
+
+  // base_read_symbols reads the local symbols too when there is a
+  // symbol ordering file, but a target may not.
+  const unsigned int first_symndx = (sd->external_symbols_offset != 0
+				     ? 0
+				     : this->local_symbol_count_);
+  const int sym_size = This::sym_size;
+  const size_t symcount = sd->symbols_size / sym_size;
+  const unsigned char* psyms = sd->symbols->data();
+  const char* pnames =
+    reinterpret_cast<const char*>(sd->symbol_names->data());
+
+  for (size_t i = 0; i < symcount; ++i, psyms += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(psyms);
+      if (sym.get_st_type() == elfcpp::STT_SECTION
+	  || sym.get_st_type() == elfcpp::STT_FILE)
+	continue;
+      unsigned int st_name = sym.get_st_name();
+      if (st_name == 0 || st_name >= sd->symbol_names_size)
+	continue;
+
+      bool is_ordinary;
+      unsigned int shndx = this->adjust_sym_shndx(first_symndx + i,
+						  sym.get_st_shndx(),
+						  &is_ordinary);
+      if (!is_ordinary || shndx == elfcpp::SHN_UNDEF || shndx >= shnum)
+	continue;
+
+      unsigned int position = layout->find_symbol_order_index(pnames
+							      + st_name);
+      if (position != 0 && (indexes[shndx] == 0 || position < indexes[shndx]))
+	indexes[shndx] = position;
+    }
 }
 
 // Return the section index of symbol SYM.  Set *VALUE to its value in
@@ -1243,6 +1442,107 @@ Sized_relobj_file<size, big_endian>::include_linkonce_section(
   return include1 && include2;
 }
 
+// Handle a .debug_types section, or a .debug_info section which may
+// hold DWARF 5 type units, when using --dedup-type-units.  SHNDX is
+// the section index and NAME is the section name.  Return whether we
+// should include the section in the link.
+
+// A type unit is identified by its 8-byte signature, and the
+// compiler emits the same type unit in every object which uses the
+// type.  When the type units are in COMDAT groups the duplicates are
+// already discarded with the groups.  Otherwise we discard a section
+// if every unit in it is a type unit whose signature we have already
+// seen.  We can't drop part of an input section, so a section which
+// holds any other unit, or any new type unit, is kept whole.
+
+template<int size, bool big_endian>
+bool
+Sized_relobj_file<size, big_endian>::include_type_unit_section(
+    Layout* layout,
+    unsigned int shndx,
+    const char* name)
+{
+  const bool is_debug_types = (strcmp(name, ".debug_types") == 0
+			       || strcmp(name, ".zdebug_types") == 0);
+
+  section_size_type len;
+  bool is_new;
+  const unsigned char* contents =
+    this->decompressed_section_contents(shndx, &len, &is_new);
+
+  std::vector<uint64_t> signatures;
+  bool only_type_units = true;
+  const unsigned char* p = contents;
+  const unsigned char* const end = contents + len;
+  while (p < end)
+    {
+      if (end - p < 4)
+	{
+	  only_type_units = false;
+	  break;
+	}
+      uint64_t unit_length =
+	elfcpp::Swap_unaligned<32, big_endian>::readval(p);
+      unsigned int offset_size = 4;
+      p += 4;
+      if (unit_length == 0xffffffff)
+	{
+	  if (end - p < 8)
+	    {
+	      only_type_units = false;
+	      break;
+	    }
+	  unit_length = elfcpp::Swap_unaligned<64, big_endian>::readval(p);
+	  offset_size = 8;
+	  p += 8;
+	}
+      if (unit_length < 2
+	  || unit_length > static_cast<uint64_t>(end - p))
+	{
+	  only_type_units = false;
+	  break;
+	}
+      const unsigned char* unit_end = p + unit_length;
+      unsigned int version =
+	elfcpp::Swap_unaligned<16, big_endian>::readval(p);
+
+      // A .debug_types unit header is the version, the .debug_abbrev
+      // offset, the address size and the signature.  A DWARF 5 type
+      // unit header is the version, the unit type, the address size,
+      // the .debug_abbrev offset and the signature.
+      const unsigned char* psig;
+      if (is_debug_types)
+	psig = p + 2 + offset_size + 1;
+      else if (version >= 5
+	       && unit_length >= 3
+	       && p[2] == elfcpp::DW_UT_type)
+	psig = p + 4 + offset_size;
+      else
+	psig = unit_end;
+      if (unit_end - psig < 8)
+	{
+	  only_type_units = false;
+	  break;
+	}
+      signatures.push_back(
+	  elfcpp::Swap_unaligned<64, big_endian>::readval(psig));
+      p = unit_end;
+    }
+
+  if (is_new)
+    delete[] contents;
+
+  bool include = !only_type_units || signatures.empty();
+  for (std::vector<uint64_t>::const_iterator q = signatures.begin();
+       q != signatures.end();
+       ++q)
+    {
+      if (layout->add_type_unit_signature(*q))
+	include = true;
+    }
+  return include;
+}
+
 // Layout an input section.
 
 template<int size, bool big_endian>
@@ -1372,6 +1672,13 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 	}
     }
     
+  // Archive members are not matched against the symbol ordering file
+  // while reading symbols, so do that now.
+  if (sd != NULL
+      && parameters->options().symbol_ordering_file()
+      && this->symbol_order_indexes().empty())
+    this->do_match_symbol_order(layout, sd);
+
   if (shnum == 0)
     return;
 
@@ -1582,6 +1889,16 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 		  if (!this->include_linkonce_section(layout, i, name, shdr))
 		    discard = true;
 		}
+	      else if (parameters->options().dedup_type_units()
+		       && !relocatable
+		       && (strcmp(name, ".debug_types") == 0
+			   || strcmp(name, ".zdebug_types") == 0
+			   || strcmp(name, ".debug_info") == 0
+			   || strcmp(name, ".zdebug_info") == 0))
+		{
+		  if (!this->include_type_unit_section(layout, i, name))
+		    discard = true;
+		}
 	    }
 
 	  // Add the section to the incremental inputs layout.
@@ -2013,10 +2330,18 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
 
   const char* sym_names =
     reinterpret_cast<const char*>(sd->symbol_names->data());
+  const Symbol_name_hash* name_hashes = NULL;
+  if (sd->symbol_name_hashes.size() == symcount)
+    name_hashes = &sd->symbol_name_hashes[0];
+  const Version_script_info::Symbol_match* version_matches = NULL;
+  if (sd->version_script_matches.size() == symcount)
+    version_matches = &sd->version_script_matches[0];
   symtab->add_from_relobj(this,
 			  sd->symbols->data() + sd->external_symbols_offset,
 			  symcount, this->local_symbol_count_,
 			  sym_names, sd->symbol_names_size,
+			  name_hashes,
+			  version_matches,
 			  &this->symbols_,
 			  &this->defined_count_);
 
@@ -2024,6 +2349,9 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   sd->symbols = NULL;
   delete sd->symbol_names;
   sd->symbol_names = NULL;
+  std::vector<Symbol_name_hash>().swap(sd->symbol_name_hashes);
+  std::vector<Version_script_info::Symbol_match>().swap(
+      sd->version_script_matches);
 }
 
 // Find out if this object, that is a member of a lib group, should be included
@@ -2143,8 +2471,9 @@ Sized_relobj_file<size, big_endian>::set_local_plt_offset(
 
 // First pass over the local symbols.  Here we add their names to
 // *POOL and *DYNPOOL, and we store the symbol value in
-// THIS->LOCAL_VALUES_.  This function is always called from a
-// singleton thread.  This is followed by a call to
+// THIS->LOCAL_VALUES_.  When using threads, this may be called for
+// different objects in parallel, in which case *POOL and *DYNPOOL
+// belong to this object.  This is followed by a call to
 // finalize_local_symbols.
 
 template<int size, bool big_endian>
@@ -31,6 +31,7 @@
 #include "fileread.h"
 #include "target.h"
 #include "archive.h"
+#include "script.h"
 
 namespace gold
 {
@@ -48,18 +49,35 @@ class Pluginobj;
 class Dynobj;
 class Object_merge_map;
 class Relocatable_relocs;
+class Workqueue;
 struct Symbols_data;
+class Gc_refs;
 
 template<typename Stringpool_char>
 class Stringpool_template;
 
+// The length and hash code of the name of a global symbol, not
+// counting any version suffix.  These are computed by read_symbols(),
+// which may run in parallel for different input files, so that
+// add_symbols(), which must run in input file order, need not
+// compute them.
+
+struct Symbol_name_hash
+{
+  // The length of the name up to the first '@' character, if any.
+  size_t length;
+  // The hash code of that much of the name, from string_hash.
+  size_t hash_code;
+};
+
 // Data to pass from read_symbols() to add_symbols().
 
 struct Read_symbols_data
 {
   Read_symbols_data()
     : section_headers(NULL), section_names(NULL), symbols(NULL),
-      symbol_names(NULL), versym(NULL), verdef(NULL), verneed(NULL)
+      symbol_names(NULL), symbol_name_hashes(), version_script_matches(),
+      versym(NULL), verdef(NULL), verneed(NULL)
   { }
 
   ~Read_symbols_data();
@@ -82,6 +100,14 @@ struct Read_symbols_data
   File_view* symbol_names;
   // Size of symbol name data in bytes.
   section_size_type symbol_names_size;
+  // Precomputed name lengths and hash codes of the external symbols.
+  // This is empty if they have not been computed.
+  std::vector<Symbol_name_hash> symbol_name_hashes;
+  // The version script matches of the external symbols, from
+  // Object::match_version_script.  This is empty if they have not
+  // been computed.  The entries for undefined symbols and for names
+  // with versions are not set.
+  std::vector<Version_script_info::Symbol_match> version_script_matches;
 
   // Version information.  This is only used on dynamic objects.
   // Version symbol data (from SHT_GNU_versym section).
@@ -644,6 +670,28 @@ class Object
   read_symbols(Read_symbols_data* sd)
   { return this->do_read_symbols(sd); }
 
+  // Match the symbols read by read_symbols against VERSION_SCRIPT,
+  // so that add_symbols need not.  This may be called for several
+  // objects at once.
+  void
+  match_version_script(const Version_script_info& version_script,
+		       Read_symbols_data* sd)
+  { this->do_match_version_script(version_script, sd); }
+
+  // Find the input section specs in the SECTIONS clause SS which
+  // match the sections read by read_symbols, so that layout need not.
+  // This may be called for several objects at once.
+  void
+  match_script_sections(const Script_sections* ss, Read_symbols_data* sd)
+  { this->do_match_script_sections(ss, sd); }
+
+  // Find the sections which define the symbols named in the
+  // --symbol-ordering-file read by LAYOUT.  This may be called for
+  // several objects at once.
+  void
+  match_symbol_order(const Layout* layout, Read_symbols_data* sd)
+  { this->do_match_symbol_order(layout, sd); }
+
   // Pass sections which should be included in the link to the Layout
   // object, and record where the sections go in the output file.
   void
@@ -880,6 +928,24 @@ class Object
   virtual void
   do_read_symbols(Read_symbols_data*) = 0;
 
+  // Match the symbols against the version script--may be implemented
+  // by child class.
+  virtual void
+  do_match_version_script(const Version_script_info&, Read_symbols_data*)
+  { }
+
+  // Match the sections against the SECTIONS clause--may be
+  // implemented by child class.
+  virtual void
+  do_match_script_sections(const Script_sections*, Read_symbols_data*)
+  { }
+
+  // Match the symbols against the symbol ordering file--may be
+  // implemented by child class.
+  virtual void
+  do_match_symbol_order(const Layout*, Read_symbols_data*)
+  { }
+
   // Lay out sections--implemented by child class.
   virtual void
   do_layout(Symbol_table*, Layout*, Read_symbols_data*) = 0;
@@ -1099,12 +1165,24 @@ class Relobj : public Object
       object_merge_map_(NULL),
       relocs_must_follow_section_writes_(false),
       sd_(NULL),
+      gc_refs_(NULL),
       reloc_counts_(NULL),
       reloc_bases_(NULL),
       first_dyn_reloc_(0),
-      dyn_reloc_count_(0)
+      dyn_reloc_count_(0),
+      symbol_order_indexes_()
   { }
 
+  // Return the position in the --symbol-ordering-file of the first
+  // listed symbol defined in section SHNDX, or 0 if there is none.
+  unsigned int
+  symbol_order_index(unsigned int shndx) const
+  {
+    if (shndx >= this->symbol_order_indexes_.size())
+      return 0;
+    return this->symbol_order_indexes_[shndx];
+  }
+
   // During garbage collection, the Read_symbols_data pass for 
   // each object is stored as layout needs to be done after 
   // reloc processing.
@@ -1137,6 +1215,17 @@ class Relobj : public Object
   set_relocs_data(Read_relocs_data* rd)
   { this->rd_ = rd; }
 
+  // During garbage collection, the references from the sections of
+  // this object to other sections, and which of its sections are
+  // referenced.  This is NULL until a reference is added.
+  Gc_refs*
+  gc_refs()
+  { return this->gc_refs_; }
+
+  void
+  set_gc_refs(Gc_refs* refs)
+  { this->gc_refs_ = refs; }
+
   virtual bool
   is_output_section_offset_invalid(unsigned int shndx) const = 0;
 
@@ -1279,6 +1368,31 @@ class Relobj : public Object
   relocate(const Symbol_table* symtab, const Layout* layout, Output_file* of)
   { return this->do_relocate(symtab, layout, of); }
 
+  // Start relocating the input sections.  This may queue tasks on
+  // WORKQUEUE to apply ranges of relocations from large relocation
+  // sections.  If it does not, it does all the work of relocate and
+  // returns NULL.  Otherwise it returns a blocker which is unblocked
+  // when the tasks are done, after which relocate_finish must be
+  // called.
+  Task_token*
+  relocate_start(const Symbol_table* symtab, const Layout* layout,
+		 Output_file* of, Workqueue* workqueue)
+  { return this->do_relocate_start(symtab, layout, of, workqueue); }
+
+  // Apply COUNT relocations starting at relocation FIRST in the
+  // relocation section SHNDX, for a task queued by relocate_start.
+  void
+  relocate_range(const Symbol_table* symtab, const Layout* layout,
+		 unsigned int shndx, size_t first, size_t count)
+  { this->do_relocate_range(symtab, layout, shndx, first, count); }
+
+  // Finish relocating once the tasks queued by relocate_start are
+  // done, and write out the local symbols.
+  void
+  relocate_finish(const Symbol_table* symtab, const Layout* layout,
+		  Output_file* of)
+  { this->do_relocate_finish(symtab, layout, of); }
+
   // Return whether an input section is being included in the link.
   bool
   is_section_included(unsigned int shndx) const
@@ -1457,6 +1571,29 @@ class Relobj : public Object
   virtual void
   do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of) = 0;
 
+  // Start relocating the input sections--may be overridden by a child
+  // class which can split the work into several tasks.
+  virtual Task_token*
+  do_relocate_start(const Symbol_table* symtab, const Layout* layout,
+		    Output_file* of, Workqueue*)
+  {
+    this->do_relocate(symtab, layout, of);
+    return NULL;
+  }
+
+  // Apply a range of relocations--implemented by a child class which
+  // overrides do_relocate_start.
+  virtual void
+  do_relocate_range(const Symbol_table*, const Layout*, unsigned int,
+		    size_t, size_t)
+  { gold_unreachable(); }
+
+  // Finish relocating--implemented by a child class which overrides
+  // do_relocate_start.
+  virtual void
+  do_relocate_finish(const Symbol_table*, const Layout*, Output_file*)
+  { gold_unreachable(); }
+
   // Set the offset of a section--implemented by child class.
   virtual void
   do_set_section_offset(unsigned int shndx, uint64_t off) = 0;
@@ -1485,6 +1622,12 @@ class Relobj : public Object
   output_sections() const
   { return this->output_sections_; }
 
+  // The symbol ordering positions of the sections, set by
+  // do_match_symbol_order.  This is empty until that is done.
+  std::vector<unsigned int>&
+  symbol_order_indexes()
+  { return this->symbol_order_indexes_; }
+
   // Set the size of the relocatable relocs array.
   void
   size_relocatable_relocs()
@@ -1568,6 +1711,9 @@ class Relobj : public Object
   // Again used during garbage collection when laying out referenced
   // sections.
   gold::Symbols_data* sd_;
+  // Used to store the section references found during garbage
+  // collection.
+  Gc_refs* gc_refs_;
   // Per-symbol counts of relocations, for incremental links.
   unsigned int* reloc_counts_;
   // Per-symbol base indexes of relocations, for incremental links.
@@ -1576,6 +1722,9 @@ class Relobj : public Object
   unsigned int first_dyn_reloc_;
   // Count of dynamic relocations for this object.
   unsigned int dyn_reloc_count_;
+  // For each input section, the position in the --symbol-ordering-file
+  // of the first listed symbol which it defines, or 0.
+  std::vector<unsigned int> symbol_order_indexes_;
 };
 
 // This class is used to handle relocations against a section symbol
@@ -2326,6 +2475,17 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   bool is_deferred_layout() const
   { return this->is_deferred_layout_; }
 
+  // Return the number of the first input section spec in the
+  // SECTIONS clause which matches section SHNDX, as found by
+  // match_script_sections, or -1 if it is not known.
+  int
+  script_input_spec(unsigned int shndx) const
+  {
+    if (shndx >= this->script_input_specs_.size())
+      return -1;
+    return this->script_input_specs_[shndx];
+  }
+
  protected:
   typedef typename Sized_relobj<size, big_endian>::Output_sections
       Output_sections;
@@ -2343,6 +2503,23 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   base_read_symbols(Read_symbols_data*);
 
+  // Precompute the name lengths and hash codes of the external
+  // symbols read by base_read_symbols.
+  void
+  compute_symbol_name_hashes(Read_symbols_data*);
+
+  // Match the external symbols against the version script.
+  void
+  do_match_version_script(const Version_script_info&, Read_symbols_data*);
+
+  // Match the sections against the SECTIONS clause.
+  void
+  do_match_script_sections(const Script_sections*, Read_symbols_data*);
+
+  // Match the symbols against the symbol ordering file.
+  void
+  do_match_symbol_order(const Layout*, Read_symbols_data*);
+
   // Return the value of a local symbol.
   uint64_t
   do_local_symbol_value(unsigned int symndx, uint64_t addend) const
@@ -2432,6 +2609,22 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of);
 
+  // Start relocating the input sections, queueing tasks to apply
+  // ranges of relocations from large relocation sections.
+  Task_token*
+  do_relocate_start(const Symbol_table* symtab, const Layout*,
+		    Output_file* of, Workqueue*);
+
+  // Apply a range of relocations.
+  void
+  do_relocate_range(const Symbol_table* symtab, const Layout*,
+		    unsigned int shndx, size_t first, size_t count);
+
+  // Finish relocating after the range tasks are done.
+  void
+  do_relocate_finish(const Symbol_table* symtab, const Layout*,
+		     Output_file* of);
+
   // Get the size of a section.
   uint64_t
   do_section_size(unsigned int shndx)
@@ -2632,6 +2825,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   include_linkonce_section(Layout*, unsigned int, const char*,
 			   const elfcpp::Shdr<size, big_endian>&);
 
+  // Whether to include a section holding type units in the link.
+  bool
+  include_type_unit_section(Layout*, unsigned int, const char*);
+
   // Layout an input section.
   void
   layout_section(Layout* layout, unsigned int shndx, const char* name,
@@ -2660,6 +2857,65 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 		    Views* pviews)
   { this->do_relocate_sections(symtab, layout, pshdrs, of, pviews); }
 
+  // Write out the relocated views and the local symbols.
+  void
+  write_relocated_sections(const Layout*, Output_file*, Views*);
+
+  // A range of relocations applied by a separate task.
+  struct Reloc_range
+  {
+    Reloc_range(unsigned int a_shndx, size_t a_first, size_t a_count,
+		off_t a_offset)
+      : shndx(a_shndx), first(a_first), count(a_count), offset(a_offset)
+    { }
+
+    // The relocation section.
+    unsigned int shndx;
+    // The index of the first relocation.
+    size_t first;
+    // The number of relocations.
+    size_t count;
+    // The output file offset of the relocated section, used to group
+    // the tasks by the part of the output file they write.
+    off_t offset;
+  };
+
+  // Sort Reloc_ranges by output file offset.
+  struct Reloc_range_compare
+  {
+    bool
+    operator()(const Reloc_range& a, const Reloc_range& b) const
+    {
+      if (a.offset != b.offset)
+	return a.offset < b.offset;
+      if (a.shndx != b.shndx)
+	return a.shndx < b.shndx;
+      return a.first < b.first;
+    }
+  };
+
+  // Data kept while tasks apply ranges of relocations.
+  struct Split_relocs
+  {
+    // The section headers.
+    const unsigned char* pshdrs;
+    // The output views.
+    Views views;
+    // Whether each relocation section is handled by the tasks.
+    std::vector<bool> is_split;
+  };
+
+  // Add ranges for the relocation section SHNDX to *RANGES, if it is
+  // large enough to be worth splitting.  Return whether it was split.
+  template<int sh_type>
+  bool
+  split_reloc_section(const unsigned char* pshdrs, unsigned int shndx,
+		      std::vector<Reloc_range>* ranges);
+
+  // Return whether the symbol R_SYM is a TLS symbol.
+  bool
+  reloc_symbol_is_tls(const unsigned char* pshdrs, unsigned int r_sym);
+
   // Reverse the words in a section.  Used for .ctors sections mapped
   // to .init_array sections.
   void
@@ -2849,8 +3105,14 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   std::vector<Deferred_layout> deferred_layout_;
   // The list of relocation sections whose layout was deferred.
   std::vector<Deferred_layout> deferred_layout_relocs_;
+  // The first input section spec in the SECTIONS clause which matches
+  // each section, or -1; empty if match_script_sections did nothing.
+  std::vector<int> script_input_specs_;
   // Pointer to the list of output views; valid only during do_relocate().
   const Views* output_views_;
+  // Data for the tasks applying ranges of relocations; valid only
+  // between do_relocate_start() and do_relocate_finish().
+  Split_relocs* split_relocs_;
 };
 
 // A class to manage the list of all objects.
@@ -543,6 +543,24 @@ General_options::section_start(const char* secname, uint64_t* paddr) const
   return true;
 }
 
+// Use THREAD_COUNT threads without parsing a command line.
+
+void
+General_options::enable_threads(int thread_count)
+{
+  this->set_thread_count(thread_count);
+  this->set_thread_count_initial(thread_count);
+  this->set_thread_count_middle(thread_count);
+  this->set_thread_count_final(thread_count);
+#ifdef ENABLE_THREADS
+  this->set_threads(true);
+#else
+  gold_warning(_("ignoring --threads: "
+		 "%s was compiled without thread support"),
+	       program_name);
+#endif
+}
+
 void
 General_options::parse_static(const char*, const char*, Command_line*)
 {
@@ -1310,6 +1328,14 @@ General_options::finalize()
   if (this->relocatable() && this->retain_symbols_file())
     gold_fatal(_("-retain-symbols-file does not yet work with -r"));
 
+  if (this->section_ordering_file() && this->symbol_ordering_file())
+    gold_fatal(_("--section-ordering-file and --symbol-ordering-file "
+		 "are incompatible"));
+  if (this->call_graph_ordering_file()
+      && (this->section_ordering_file() || this->symbol_ordering_file()))
+    gold_fatal(_("--call-graph-ordering-file is incompatible with "
+		 "--section-ordering-file and --symbol-ordering-file"));
+
   if (this->oformat_enum() != General_options::OBJECT_FORMAT_ELF
       && (this->shared()
 	  || this->pie()
@@ -1355,6 +1381,12 @@ General_options::finalize()
 	  gold_warning(_("ignoring --icf for an incremental link"));
 	  this->set_icf_status(ICF_NONE);
 	}
+      if (this->pack_relative_relocs())
+	{
+	  gold_warning(_("ignoring -z pack-relative-relocs for an "
+			 "incremental link"));
+	  this->set_pack_relative_relocs(false);
+	}
       if (strcmp(this->compress_debug_sections(), "none") != 0)
 	{
 	  gold_warning(_("ignoring --compress-debug-sections for an "
@@ -1363,6 +1395,15 @@ General_options::finalize()
 	}
     }
 
+#ifndef HAVE_ZSTD
+  if (strcmp(this->compress_debug_sections(), "zstd") == 0)
+    gold_fatal(_("--compress-debug-sections=zstd: "
+		 "gold was built without zstd support"));
+#endif
+
+  if (this->compress_debug_sections_level() < 0)
+    gold_fatal(_("--compress-debug-sections-level: must not be negative"));
+
   // --rosegment-gap implies --rosegment.
   if (this->user_set_rosegment_gap())
     this->set_rosegment(true);
@@ -720,7 +720,8 @@ class General_options
 
   DEFINE_uint64(build_id_chunk_size_for_treehash,
 		options::TWO_DASHES, '\0', 2 << 20,
-		N_("Chunk size for '--build-id=tree'"), N_("SIZE"));
+		N_("Chunk size for '--build-id=tree' and '--build-id=fast'"),
+		N_("SIZE"));
 
   DEFINE_uint64(build_id_min_file_size_for_treehash, options::TWO_DASHES,
 		'\0', 40 << 20,
@@ -751,14 +752,23 @@ class General_options
 
   // c
 
+  DEFINE_string(call_graph_ordering_file, options::TWO_DASHES, '\0', NULL,
+		N_("Layout functions using a call graph profile"),
+		N_("FILENAME"));
+
   DEFINE_bool(check_sections, options::TWO_DASHES, '\0', true,
 	      N_("Check segment addresses for overlaps"),
 	      N_("Do not check segment addresses for overlaps"));
 
   DEFINE_enum(compress_debug_sections, options::TWO_DASHES, '\0', "none",
 	      N_("Compress .debug_* sections in the output file"),
-	      ("[none,zlib,zlib-gnu,zlib-gabi]"),
-	      {"none", "zlib", "zlib-gnu", "zlib-gabi"});
+	      ("[none,zlib,zlib-gnu,zlib-gabi,zstd]"),
+	      {"none", "zlib", "zlib-gnu", "zlib-gabi", "zstd"});
+
+  DEFINE_int(compress_debug_sections_level, options::TWO_DASHES, '\0', 0,
+	     N_("Compression level for --compress-debug-sections "
+		"(default: depends on method and -O)"),
+	     N_("LEVEL"));
 
   DEFINE_bool(copy_dt_needed_entries, options::TWO_DASHES, '\0', false,
 	      N_("Not supported"),
@@ -786,6 +796,10 @@ class General_options
 		N_("Turn on debugging"),
 		N_("[all,files,script,task][,...]"));
 
+  DEFINE_bool(dedup_type_units, options::TWO_DASHES, '\0', false,
+	      N_("Discard duplicate DWARF type units"),
+	      N_("Do not discard duplicate DWARF type units"));
+
   DEFINE_special(defsym, options::TWO_DASHES, '\0',
 		 N_("Define a symbol"), N_("SYMBOL=EXPRESSION"));
 
@@ -985,6 +999,10 @@ class General_options
   DEFINE_string(init, options::ONE_DASH, '\0', "_init",
 		N_("Call SYMBOL at load-time"), N_("SYMBOL"));
 
+  DEFINE_string(input_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Cache metadata about input files in DIR"),
+		N_("DIR"));
+
   DEFINE_string(dynamic_linker, options::TWO_DASHES, 'I', NULL,
 		N_("Set dynamic linker path"), N_("PROGRAM"));
 
@@ -1257,6 +1275,17 @@ class General_options
   DEFINE_bool(stats, options::TWO_DASHES, '\0', false,
 	      N_("Print resource usage statistics"), NULL);
 
+  DEFINE_bool(stream_output_file, options::TWO_DASHES, '\0', false,
+	      N_("Write the output file a piece at a time instead of "
+		 "keeping it in memory (default if larger than physical "
+		 "memory)"),
+	      N_("Keep the whole output file in memory"));
+
+  DEFINE_string(symbol_ordering_file, options::TWO_DASHES, '\0', NULL,
+		N_("Layout sections containing the listed symbols "
+		   "in the order specified"),
+		N_("FILENAME"));
+
   DEFINE_string(sysroot, options::TWO_DASHES, '\0', "",
 		N_("Set target system root directory"), N_("DIR"));
 
@@ -1265,6 +1294,11 @@ class General_options
   DEFINE_bool(trace, options::TWO_DASHES, 't', false,
 	      N_("Print the name of each input file"), NULL);
 
+  DEFINE_string(trace_file, options::TWO_DASHES, '\0', NULL,
+		N_("Write a trace of the tasks run to FILE in Chrome trace "
+		   "event format"),
+		N_("FILE"));
+
   DEFINE_bool(target1_abs, options::TWO_DASHES, '\0', false,
 	      N_("(ARM only) Force R_ARM_TARGET1 type to R_ARM_ABS32"),
 	      NULL);
@@ -1481,6 +1515,9 @@ class General_options
   DEFINE_bool(origin, options::DASH_Z, '\0', false,
 	      N_("Mark DSO to indicate that needs immediate $ORIGIN "
 		 "processing at runtime"), NULL);
+  DEFINE_bool(pack_relative_relocs, options::DASH_Z, '\0', false,
+	      N_("Pack relative relocations into a DT_RELR section"),
+	      N_("Do not pack relative relocations (default)"));
   DEFINE_bool(relro, options::DASH_Z, '\0', DEFAULT_LD_Z_RELRO,
 	      N_("Where possible mark variables read-only after relocation"),
 	      N_("Don't mark variables read-only after relocation"));
@@ -1679,6 +1716,13 @@ class General_options
   any_section_start() const
   { return !this->section_starts_.empty(); }
 
+  // Use THREAD_COUNT threads in each pass, as though --threads and
+  // --thread-count were given.  This is for programs other than the
+  // linker which use libgold, such as dwp, and which do not parse a
+  // linker command line.
+  void
+  enable_threads(int thread_count);
+
   enum Fix_v4bx
   {
     // Leave original instruction.
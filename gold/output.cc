@@ -44,6 +44,7 @@
 #include "merge.h"
 #include "descriptors.h"
 #include "layout.h"
+#include "gold-threads.h"
 #include "output.h"
 
 // For systems without mmap support.
@@ -1105,6 +1106,31 @@ Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::get_address() const
   return address;
 }
 
+// Return whether a relocation may go in a section of packed relative
+// relocs.  The address of the relocation is its offset plus the
+// address of an input section or Output_data, and that address is a
+// multiple of the alignment.  Input sections which are merged or
+// otherwise rewritten don't keep their offsets, so we leave them
+// alone.  This is called while scanning relocations, when the object
+// is locked.
+
+template<bool dynamic, int size, bool big_endian>
+bool
+Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>::can_be_packed()
+  const
+{
+  if (this->use_plt_offset_ || (this->address_ & 1) != 0)
+    return false;
+  if (this->shndx_ != INVALID_CODE)
+    {
+      Sized_relobj<size, big_endian>* relobj = this->u2_.relobj;
+      return (relobj->get_output_section_offset(this->shndx_)
+		!= invalid_address
+	      && relobj->section_addralign(this->shndx_) >= 2);
+    }
+  return this->u2_.od == NULL || this->u2_.od->addralign() >= 2;
+}
+
 // Write out the offset and info fields of a Rel or Rela relocation
 // entry.
 
@@ -1288,6 +1314,155 @@ Output_data_reloc_base<sh_type, dynamic, size, big_endian>::do_write(
   this->do_write_generic<Writer>(of);
 }
 
+// Class Output_data_relr.
+
+// Sort packed relocs by the input section or Output_data which holds
+// them, and then by their offset in it.
+
+template<typename Output_reloc_type>
+struct Relr_location_comparison
+{
+  bool
+  operator()(const Output_reloc_type& r1, const Output_reloc_type& r2) const
+  {
+    if (r1.location_key() != r2.location_key())
+      return r1.location_key() < r2.location_key();
+    return r1.location_offset() < r2.location_offset();
+  }
+};
+
+// Encode the addresses from P to END.
+
+template<int size, bool big_endian>
+size_t
+Output_data_relr<size, big_endian>::encode(
+    typename std::vector<Address>::const_iterator p,
+    typename std::vector<Address>::const_iterator end,
+    std::vector<Address>* words)
+{
+  const Address wordsize = size / 8;
+  // The number of words which one bitmap covers.
+  const Address nbits = size - 1;
+  size_t count = 0;
+  while (p != end)
+    {
+      gold_assert((*p & 1) == 0);
+      if (words != NULL)
+	words->push_back(*p);
+      ++count;
+      Address base = *p + wordsize;
+      ++p;
+
+      while (true)
+	{
+	  Address bitmap = 0;
+	  for (; p != end; ++p)
+	    {
+	      Address delta = *p - base;
+	      if (delta >= nbits * wordsize || delta % wordsize != 0)
+		break;
+	      bitmap |= static_cast<Address>(1) << (delta / wordsize);
+	    }
+	  if (bitmap == 0)
+	    break;
+	  if (words != NULL)
+	    words->push_back((bitmap << 1) | 1);
+	  ++count;
+	  base += nbits * wordsize;
+	}
+    }
+  return count;
+}
+
+// Set the final data size.  The addresses are not known yet, but the
+// distances between the relocs in one input section or Output_data
+// are, so we encode the relocs of each of those separately.  That
+// costs at most an extra address word for each one.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::set_final_data_size()
+{
+  std::sort(this->relocs_.begin(), this->relocs_.end(),
+	    Relr_location_comparison<Output_reloc_type>());
+
+  size_t count = 0;
+  std::vector<Address> offsets;
+  typename Relocs::const_iterator p = this->relocs_.begin();
+  while (p != this->relocs_.end())
+    {
+      std::pair<const void*, unsigned int> key = p->location_key();
+      offsets.clear();
+      for (; p != this->relocs_.end() && p->location_key() == key; ++p)
+	offsets.push_back(p->location_offset());
+      offsets.erase(std::unique(offsets.begin(), offsets.end()),
+		    offsets.end());
+      count += encode(offsets.begin(), offsets.end(), NULL);
+    }
+
+  this->set_data_size(count * (size / 8));
+}
+
+// Write out the packed relocs.  Each input section or Output_data is
+// encoded on its own, as in set_final_data_size.  We write them in
+// order of address.
+
+template<int size, bool big_endian>
+void
+Output_data_relr<size, big_endian>::do_write(Output_file* of)
+{
+  const off_t off = this->offset();
+  const off_t oview_size = this->data_size();
+  unsigned char* const oview = of->get_output_view(off, oview_size);
+
+  // The addresses of the relocs, and for each input section or
+  // Output_data, its first address and the range of its addresses.
+  typedef std::pair<size_t, size_t> Range;
+  std::vector<Address> addresses;
+  std::vector<std::pair<Address, Range> > locations;
+  addresses.reserve(this->relocs_.size());
+  typename Relocs::const_iterator p = this->relocs_.begin();
+  while (p != this->relocs_.end())
+    {
+      std::pair<const void*, unsigned int> key = p->location_key();
+      size_t start = addresses.size();
+      for (; p != this->relocs_.end() && p->location_key() == key; ++p)
+	addresses.push_back(p->get_address());
+      std::sort(addresses.begin() + start, addresses.end());
+      addresses.erase(std::unique(addresses.begin() + start,
+				  addresses.end()),
+		      addresses.end());
+      locations.push_back(std::make_pair(addresses[start],
+					 Range(start, addresses.size())));
+    }
+  std::sort(locations.begin(), locations.end());
+
+  std::vector<Address> words;
+  words.reserve(oview_size / (size / 8));
+  for (typename std::vector<std::pair<Address, Range> >::const_iterator q =
+	 locations.begin();
+       q != locations.end();
+       ++q)
+    encode(addresses.begin() + q->second.first,
+	   addresses.begin() + q->second.second,
+	   &words);
+  gold_assert(static_cast<off_t>(words.size() * (size / 8)) == oview_size);
+
+  unsigned char* pov = oview;
+  for (typename std::vector<Address>::const_iterator q = words.begin();
+       q != words.end();
+       ++q)
+    {
+      elfcpp::Swap<size, big_endian>::writeval(pov, *q);
+      pov += size / 8;
+    }
+
+  of->write_output_view(off, oview_size, oview);
+
+  // We no longer need the relocation entries.
+  this->relocs_.clear();
+}
+
 // Class Output_relocatable_relocs.
 
 template<int sh_type, int size, bool big_endian>
@@ -2561,8 +2736,9 @@ Output_section::add_input_section(Layout* layout,
   // track of sections, or if we are relaxing.  Also, if this is a
   // section which requires sorting, or which may require sorting in
   // the future, we keep track of the sections.  If the
-  // --section-ordering-file option is used to specify the order of
-  // sections, we need to keep track of sections.
+  // --section-ordering-file or --symbol-ordering-file option is used
+  // to specify the order of sections, we need to keep track of
+  // sections.
   if (this->always_keeps_input_sections_
       || have_sections_script
       || !this->input_sections_.empty()
@@ -2575,16 +2751,18 @@ Output_section::add_input_section(Layout* layout,
       Input_section isecn(object, shndx, input_section_size, addralign);
       /* If section ordering is requested by specifying a ordering file,
 	 using --section-ordering-file, match the section name with
-	 a pattern.  */
+	 a pattern.  Using --symbol-ordering-file, use the position of
+	 the first listed symbol which the section defines.  */
+      unsigned int section_order_index = 0;
       if (parameters->options().section_ordering_file())
+	section_order_index =
+	  layout->find_section_order_index(std::string(secname));
+      else if (parameters->options().symbol_ordering_file())
+	section_order_index = object->symbol_order_index(shndx);
+      if (section_order_index != 0)
 	{
-	  unsigned int section_order_index =
-	    layout->find_section_order_index(std::string(secname));
-	  if (section_order_index != 0)
-	    {
-	      isecn.set_section_order_index(section_order_index);
-	      this->set_input_section_order_specified();
-	    }
+	  isecn.set_section_order_index(section_order_index);
+	  this->set_input_section_order_specified();
 	}
       this->input_sections_.push_back(isecn);
     }
@@ -2649,12 +2827,15 @@ Output_section::add_relaxed_input_section(Layout* layout,
 {
   Input_section inp(poris);
 
-  // If the --section-ordering-file option is used to specify the order of
-  // sections, we need to keep track of sections.
+  // If the --section-ordering-file or --symbol-ordering-file option is
+  // used to specify the order of sections, we need to keep track of
+  // sections.
   if (layout->is_section_ordering_specified())
     {
       unsigned int section_order_index =
-	layout->find_section_order_index(name);
+	(parameters->options().symbol_ordering_file()
+	 ? poris->relobj()->symbol_order_index(poris->shndx())
+	 : layout->find_section_order_index(name));
       if (section_order_index != 0)
 	{
 	  inp.set_section_order_index(section_order_index);
@@ -4067,6 +4248,18 @@ Output_section::print_merge_stats()
     p->print_merge_stats(this->name_);
 }
 
+// Queue tasks to merge the input sections of merge sections.
+
+void
+Output_section::queue_merge_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  Input_section_list::iterator p;
+  for (p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    p->queue_merge_tasks(workqueue, blocker);
+}
+
 // Set a fixed layout for the section.  Used for incremental update links.
 
 void
@@ -4984,7 +5177,10 @@ Output_file::Output_file(const char* name)
     base_(NULL),
     map_is_anonymous_(false),
     map_is_allocated_(false),
-    is_temporary_(false)
+    is_temporary_(false),
+    is_streaming_(false),
+    lock_(NULL),
+    shared_views_()
 {
 }
 
@@ -5134,6 +5330,16 @@ Output_file::open(off_t file_size)
 	}
     }
 
+  if (this->should_stream())
+    {
+      int err = gold_fallocate(this->o_, 0, this->file_size_);
+      if (err != 0)
+	gold_fatal(_("%s: %s"), this->name_, strerror(err));
+      this->is_streaming_ = true;
+      this->lock_ = new Lock();
+      return;
+    }
+
   this->map();
 }
 
@@ -5142,6 +5348,22 @@ Output_file::open(off_t file_size)
 void
 Output_file::resize(off_t file_size)
 {
+  // If we are streaming, there are no views of the whole file to
+  // update, and we just need to grow the file.
+  if (this->is_streaming_)
+    {
+      int err = gold_fallocate(this->o_, this->file_size_,
+			       file_size - this->file_size_);
+      if (err == 0
+	  && file_size < this->file_size_
+	  && ::ftruncate(this->o_, file_size) < 0)
+	err = errno;
+      if (err != 0)
+	gold_fatal(_("%s: %s"), this->name_, strerror(err));
+      this->file_size_ = file_size;
+      return;
+    }
+
   // If the mmap is mapping an anonymous memory buffer, this is easy:
   // just mremap to the new size.  If it's mapping to a file, we want
   // to unmap to flush to the file, then remap after growing the file.
@@ -5287,11 +5509,188 @@ Output_file::unmap()
   this->base_ = NULL;
 }
 
+// Return whether to stream the output file, writing each view with
+// pwrite when it is released, rather than keeping the whole file in
+// memory.  This is done if the user asks for it or, by default, if
+// the file is larger than physical memory.  An incremental link
+// reads and patches the existing file in place, so it is always
+// mapped.
+
+bool
+Output_file::should_stream() const
+{
+  struct stat statbuf;
+  if (this->is_temporary_
+      || this->o_ == STDOUT_FILENO
+      || this->o_ == STDERR_FILENO
+      || ::fstat(this->o_, &statbuf) != 0
+      || !S_ISREG(statbuf.st_mode)
+      || parameters->incremental())
+    return false;
+
+  const General_options& options(parameters->options());
+  if (options.user_set_stream_output_file())
+    return options.stream_output_file();
+
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+  long pages = ::sysconf(_SC_PHYS_PAGES);
+  long page_size = ::sysconf(_SC_PAGESIZE);
+  if (pages > 0 && page_size > 0)
+    return (static_cast<unsigned long long>(this->file_size_)
+	    > (static_cast<unsigned long long>(pages)
+	       * static_cast<unsigned long long>(page_size)));
+#endif
+
+  return false;
+}
+
+// Read LEN bytes at OFFSET in the file into DATA.
+
+void
+Output_file::stream_read(off_t offset, void* data, size_t len)
+{
+  unsigned char* p = static_cast<unsigned char*>(data);
+  while (len > 0)
+    {
+      ssize_t bytes_read = ::pread(this->o_, p, len, offset);
+      if (bytes_read < 0 && errno == EINTR)
+	continue;
+      if (bytes_read < 0)
+	gold_fatal(_("%s: pread: %s"), this->name_, strerror(errno));
+      if (bytes_read == 0)
+	gold_fatal(_("%s: pread: unexpected end of file"), this->name_);
+      p += bytes_read;
+      len -= bytes_read;
+      offset += bytes_read;
+    }
+}
+
+// Write LEN bytes from DATA to OFFSET in the file.
+
+void
+Output_file::stream_write(off_t offset, const void* data, size_t len)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  while (len > 0)
+    {
+      ssize_t bytes_written = ::pwrite(this->o_, p, len, offset);
+      if (bytes_written < 0 && errno == EINTR)
+	continue;
+      if (bytes_written <= 0)
+	{
+	  if (bytes_written == 0)
+	    gold_error(_("%s: pwrite: unexpected 0 return-value"),
+		       this->name_);
+	  else
+	    gold_error(_("%s: pwrite: %s"), this->name_, strerror(errno));
+	  return;
+	}
+      p += bytes_written;
+      len -= bytes_written;
+      offset += bytes_written;
+    }
+}
+
+// Allocate a view of SIZE bytes at START.  The file was created
+// empty, so a view which is only written starts out cleared, as it
+// would be if the file were mapped.
+
+unsigned char*
+Output_file::stream_get_view(off_t start, size_t size, bool read)
+{
+  unsigned char* view = new unsigned char[size];
+  if (read)
+    this->stream_read(start, view, size);
+  else
+    memset(view, 0, size);
+  return view;
+}
+
+// Write a view back to the file and free it.
+
+void
+Output_file::stream_write_view(off_t start, size_t size,
+			       unsigned char* view)
+{
+  this->stream_write(start, view, size);
+  delete[] view;
+}
+
+// Get a read/write view of SIZE bytes at START.  All users of the
+// same region share a buffer.
+
+unsigned char*
+Output_file::stream_get_input_output_view(off_t start, size_t size)
+{
+  Hold_lock hl(*this->lock_);
+  std::pair<Shared_views::iterator, bool> ins =
+    this->shared_views_.insert(std::make_pair(start, Shared_view()));
+  Shared_view& sv(ins.first->second);
+  if (ins.second)
+    {
+      sv.size = size;
+      sv.view = this->stream_get_view(start, size, true);
+      sv.original = new unsigned char[size];
+      memcpy(sv.original, sv.view, size);
+      sv.count = 0;
+    }
+  gold_assert(sv.size == size);
+  ++sv.count;
+  return sv.view;
+}
+
+// Release a read/write view, writing each run of bytes which has
+// changed since it was read to the file.
+
+void
+Output_file::stream_write_input_output_view(off_t start, size_t size,
+					    unsigned char* view)
+{
+  Hold_lock hl(*this->lock_);
+  Shared_views::iterator p = this->shared_views_.find(start);
+  gold_assert(p != this->shared_views_.end()
+	      && p->second.size == size
+	      && p->second.view == view
+	      && p->second.count > 0);
+  unsigned char* original = p->second.original;
+  size_t i = 0;
+  while (i < size)
+    {
+      if (view[i] == original[i])
+	{
+	  ++i;
+	  continue;
+	}
+      size_t run = i + 1;
+      while (run < size && view[run] != original[run])
+	++run;
+      this->stream_write(start + i, view + i, run - i);
+      memcpy(original + i, view + i, run - i);
+      i = run;
+    }
+  --p->second.count;
+}
+
 // Close the output file.
 
 void
 Output_file::close()
 {
+  if (this->is_streaming_)
+    {
+      // Everything has already been written.
+      for (Shared_views::iterator p = this->shared_views_.begin();
+	   p != this->shared_views_.end();
+	   ++p)
+	{
+	  gold_assert(p->second.count == 0);
+	  delete[] p->second.view;
+	  delete[] p->second.original;
+	}
+      this->shared_views_.clear();
+      delete this->lock_;
+      this->lock_ = NULL;
+    }
   // If the map isn't file-backed, we need to write it now.
   if (this->map_is_anonymous_ && !this->is_temporary_)
     {
@@ -5312,7 +5711,8 @@ Output_file::close()
 	    }
 	}
     }
-  this->unmap();
+  if (!this->is_streaming_)
+    this->unmap();
 
   // We don't close stdout or stderr
   if (this->o_ != STDOUT_FILENO
@@ -5538,6 +5938,26 @@ template
 class Output_data_reloc<elfcpp::SHT_RELA, true, 64, true>;
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+class Output_data_relr<32, false>;
+#endif
+
+#ifdef HAVE_TARGET_32_BIG
+template
+class Output_data_relr<32, true>;
+#endif
+
+#ifdef HAVE_TARGET_64_LITTLE
+template
+class Output_data_relr<64, false>;
+#endif
+
+#ifdef HAVE_TARGET_64_BIG
+template
+class Output_data_relr<64, true>;
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 class Output_relocatable_relocs<elfcpp::SHT_REL, 32, false>;
@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <list>
+#include <map>
 #include <vector>
 
 #include "elfcpp.h"
@@ -36,6 +37,7 @@ namespace gold
 {
 
 class General_options;
+class Lock;
 class Object;
 class Symbol;
 class Output_merge_base;
@@ -94,13 +96,26 @@ class Output_file
   filename()
   { return this->name_; }
 
-  // We currently always use mmap which makes the view handling quite
-  // simple.  In the future we may support other approaches.
+  // Normally the whole file is mapped into memory, which makes the
+  // view handling quite simple.  When the file is streamed, each view
+  // is a separate buffer which is read from the file with pread when
+  // needed and written back with pwrite when it is released, so only
+  // the views in use need to be in memory.
+
+  // Return whether the file is being streamed rather than mapped.
+  bool
+  is_streaming() const
+  { return this->is_streaming_; }
 
   // Write data to the output file.
   void
   write(off_t offset, const void* data, size_t len)
-  { memcpy(this->base_ + offset, data, len); }
+  {
+    if (this->is_streaming_)
+      this->stream_write(offset, data, len);
+    else
+      memcpy(this->base_ + offset, data, len);
+  }
 
   // Get a buffer to use to write to the file, given the offset into
   // the file and the size.
@@ -109,38 +124,89 @@ class Output_file
   {
     gold_assert(start >= 0
 		&& start + static_cast<off_t>(size) <= this->file_size_);
+    if (this->is_streaming_)
+      return this->stream_get_view(start, size, false);
     return this->base_ + start;
   }
 
   // VIEW must have been returned by get_output_view.  Write the
   // buffer to the file, passing in the offset and the size.
   void
-  write_output_view(off_t, size_t, unsigned char*)
-  { }
+  write_output_view(off_t start, size_t size, unsigned char* view)
+  {
+    if (this->is_streaming_)
+      this->stream_write_view(start, size, view);
+  }
 
   // Get a read/write buffer.  This is used when we want to write part
   // of the file, read it in, and write it again.
   unsigned char*
   get_input_output_view(off_t start, size_t size)
-  { return this->get_output_view(start, size); }
+  {
+    if (this->is_streaming_)
+      {
+	gold_assert(start >= 0
+		    && start + static_cast<off_t>(size) <= this->file_size_);
+	return this->stream_get_input_output_view(start, size);
+      }
+    return this->get_output_view(start, size);
+  }
 
   // Write a read/write buffer back to the file.
   void
-  write_input_output_view(off_t, size_t, unsigned char*)
-  { }
+  write_input_output_view(off_t start, size_t size, unsigned char* view)
+  {
+    if (this->is_streaming_)
+      this->stream_write_input_output_view(start, size, view);
+  }
 
   // Get a read buffer.  This is used when we just want to read part
   // of the file back it in.
   const unsigned char*
   get_input_view(off_t start, size_t size)
-  { return this->get_output_view(start, size); }
+  {
+    if (this->is_streaming_)
+      {
+	gold_assert(start >= 0
+		    && start + static_cast<off_t>(size) <= this->file_size_);
+	return this->stream_get_view(start, size, true);
+      }
+    return this->get_output_view(start, size);
+  }
 
   // Release a read bfufer.
   void
-  free_input_view(off_t, size_t, const unsigned char*)
-  { }
+  free_input_view(off_t, size_t, const unsigned char* view)
+  {
+    if (this->is_streaming_)
+      delete[] view;
+  }
 
  private:
+  // A buffer for a region of the file which is being both read and
+  // written while streaming.  This is used to apply relocations to
+  // sections which were written as a whole, such as .eh_frame.  Each
+  // object which has such a section uses a view of the whole output
+  // section, but patches only its own bytes, while other parts of the
+  // output section may be written through other views.  So all users
+  // share a single buffer, which is kept until the file is closed,
+  // and each user writes back only the bytes which differ from the
+  // copy of the file contents in ORIGINAL.
+  struct Shared_view
+  {
+    // The size of the region.
+    size_t size;
+    // The buffer.
+    unsigned char* view;
+    // The contents of the file, as far as we know them.
+    unsigned char* original;
+    // The number of users of the buffer.
+    unsigned int count;
+  };
+
+  // Map from file offset to shared view.
+  typedef std::map<off_t, Shared_view> Shared_views;
+
   // Map the file into memory or, if that fails, allocate anonymous
   // memory.
   void
@@ -158,6 +224,37 @@ class Output_file
   void
   unmap();
 
+  // Return whether we should stream the file rather than map it.
+  bool
+  should_stream() const;
+
+  // Read LEN bytes at OFFSET in the file into DATA, when streaming.
+  void
+  stream_read(off_t offset, void* data, size_t len);
+
+  // Write LEN bytes from DATA to OFFSET in the file, when streaming.
+  void
+  stream_write(off_t offset, const void* data, size_t len);
+
+  // Allocate a view of SIZE bytes at START, when streaming.  If READ
+  // is true, read the current contents of the file into it;
+  // otherwise clear it.
+  unsigned char*
+  stream_get_view(off_t start, size_t size, bool read);
+
+  // Write a view back to the file and free it, when streaming.
+  void
+  stream_write_view(off_t start, size_t size, unsigned char* view);
+
+  // Get a shared read/write view, when streaming.
+  unsigned char*
+  stream_get_input_output_view(off_t start, size_t size);
+
+  // Release a shared read/write view, when streaming.
+  void
+  stream_write_input_output_view(off_t start, size_t size,
+				 unsigned char* view);
+
   // File name.
   const char* name_;
   // File descriptor.
@@ -172,6 +269,13 @@ class Output_file
   bool map_is_allocated_;
   // True if this is a temporary file which should not be output.
   bool is_temporary_;
+  // True if the file is written with pwrite as views are released,
+  // rather than mapped.  base_ is NULL in that case.
+  bool is_streaming_;
+  // Lock controlling access to shared_views_.
+  Lock* lock_;
+  // Read/write views, when streaming.
+  Shared_views shared_views_;
 };
 
 // An abtract class for data which has to go into the output file.
@@ -812,6 +916,13 @@ class Output_section_data : public Output_data
   print_merge_stats(const char* section_name)
   { this->do_print_merge_stats(section_name); }
 
+  // Queue tasks to merge the input sections.  Each task releases a
+  // blocker on BLOCKER when it completes.  This should only be called
+  // for SHF_MERGE sections.
+  void
+  queue_merge_tasks(Workqueue* workqueue, Task_token* blocker)
+  { this->do_queue_merge_tasks(workqueue, blocker); }
+
  protected:
   // The child class must implement do_write.
 
@@ -845,6 +956,12 @@ class Output_section_data : public Output_data
   do_print_merge_stats(const char*)
   { gold_unreachable(); }
 
+  // Queue merge tasks.  By default the merging is done when the
+  // final data size is set.
+  virtual void
+  do_queue_merge_tasks(Workqueue*, Task_token*)
+  { }
+
   // Return the required alignment.
   uint64_t
   do_addralign() const
@@ -1283,6 +1400,37 @@ class Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>
   Address
   get_address() const;
 
+  // Return whether this relocation may go in a section of packed
+  // relative relocs.  Its address must be even wherever the section
+  // which holds it is placed.
+  bool
+  can_be_packed() const;
+
+  // Return a key for the input section or Output_data which holds the
+  // address of this relocation.  Relocations with the same key stay
+  // the same distance apart in the output.
+  std::pair<const void*, unsigned int>
+  location_key() const
+  {
+    if (this->shndx_ != INVALID_CODE)
+      return std::make_pair(static_cast<const void*>(this->u2_.relobj),
+			    this->shndx_);
+    return std::make_pair(static_cast<const void*>(this->u2_.od),
+			  this->shndx_);
+  }
+
+  // Return the offset of the address within the input section or
+  // Output_data given by location_key.
+  Address
+  location_offset() const
+  { return this->address_; }
+
+  // Return the relocation without an addend.  This is for
+  // compatibility with the SHT_RELA version.
+  const Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>&
+  rel() const
+  { return *this; }
+
  private:
   // Record that we need a dynamic symbol index.
   void
@@ -1474,6 +1622,11 @@ class Output_reloc<elfcpp::SHT_RELA, dynamic, size, big_endian>
   get_relobj() const
   { return this->rel_.get_relobj(); }
 
+  // Return the relocation without the addend.
+  const Output_reloc<elfcpp::SHT_REL, dynamic, size, big_endian>&
+  rel() const
+  { return this->rel_; }
+
   // Write the reloc entry to an output view.
   void
   write(unsigned char* pov) const;
@@ -1509,7 +1662,8 @@ class Output_data_reloc_generic : public Output_section_data_build
  public:
   Output_data_reloc_generic(int size, bool sort_relocs)
     : Output_section_data_build(Output_data::default_alignment_for_size(size)),
-      relative_reloc_count_(0), sort_relocs_(sort_relocs)
+      relative_reloc_count_(0), sort_relocs_(sort_relocs),
+      relr_section_(NULL)
   { }
 
   // Return the number of relative relocs in this section.
@@ -1522,6 +1676,12 @@ class Output_data_reloc_generic : public Output_section_data_build
   sort_relocs() const
   { return this->sort_relocs_; }
 
+  // Return the section which holds the packed relative relocs that
+  // would otherwise go in this section, or NULL.
+  Output_section_data*
+  relr_section() const
+  { return this->relr_section_; }
+
   // Add a reloc of type TYPE against the global symbol GSYM.  The
   // relocation applies to the data at offset ADDRESS within OD.
   virtual void
@@ -1577,6 +1737,11 @@ class Output_data_reloc_generic : public Output_section_data_build
   bump_relative_reloc_count()
   { ++this->relative_reloc_count_; }
 
+  // Set the section which holds the packed relative relocs.
+  void
+  set_relr_section(Output_section_data* relr)
+  { this->relr_section_ = relr; }
+
  private:
   // The number of relative relocs added to this section.  This is to
   // support DT_RELCOUNT.
@@ -1584,6 +1749,87 @@ class Output_data_reloc_generic : public Output_section_data_build
   // Whether to sort the relocations when writing them out, to make
   // the dynamic linker more efficient.
   bool sort_relocs_;
+  // The section of packed relative relocs, for -z pack-relative-relocs.
+  Output_section_data* relr_section_;
+};
+
+// Output_data_relr is used to manage a section of packed relative
+// relocations, as used for -z pack-relative-relocs.  The section is
+// a sequence of words.  A word with the low bit clear is the address
+// of a word to relocate.  A word with the low bit set is a bitmap:
+// if bit N is set, for N from 1 to the number of bits in a word less
+// one, the word N - 1 words past the base is relocated.  The base
+// starts one word past the last address, and moves forward by one
+// word less than the number of bits in a word after each bitmap.
+// The addend is always the contents of the word, so a relocation may
+// only go here if the linker has stored its addend in place.
+
+template<int size, bool big_endian>
+class Output_data_relr : public Output_section_data
+{
+ public:
+  typedef Output_reloc<elfcpp::SHT_REL, true, size, big_endian>
+    Output_reloc_type;
+  typedef typename Output_reloc_type::Address Address;
+
+  // RELATIVE_TYPE is the target's RELATIVE relocation type.
+  Output_data_relr(unsigned int relative_type)
+    : Output_section_data(Output_data::default_alignment_for_size(size)),
+      relative_type_(relative_type), relocs_()
+  { }
+
+  // Add RELOC to this section if we can.  Return false if it must go
+  // in the ordinary dynamic reloc section.
+  bool
+  add(const Output_reloc_type& reloc)
+  {
+    if (reloc.type() != this->relative_type_
+	|| !reloc.is_relative()
+	|| !reloc.can_be_packed())
+      return false;
+    this->relocs_.push_back(reloc);
+    return true;
+  }
+
+  // Relocations which are not dynamic never go here.
+  bool
+  add(const Output_reloc<elfcpp::SHT_REL, false, size, big_endian>&)
+  { gold_unreachable(); }
+
+ protected:
+  // Set the final data size.
+  void
+  set_final_data_size();
+
+  // Write out the data.
+  void
+  do_write(Output_file*);
+
+  // Set the entry size.
+  void
+  do_adjust_output_section(Output_section* os)
+  { os->set_entsize(size / 8); }
+
+  // Write to a map file.
+  void
+  do_print_to_mapfile(Mapfile* mapfile) const
+  { mapfile->print_output_data(this, _("** packed relative relocs")); }
+
+ private:
+  typedef std::vector<Output_reloc_type> Relocs;
+
+  // Encode the sorted addresses from BEGIN to END, which must all be
+  // even, starting with an address entry.  Append the words to
+  // *WORDS if it is not NULL.  Return the number of words.
+  static size_t
+  encode(typename std::vector<Address>::const_iterator begin,
+	 typename std::vector<Address>::const_iterator end,
+	 std::vector<Address>* words);
+
+  // The target's RELATIVE relocation type.
+  unsigned int relative_type_;
+  // The relocations in this section.
+  Relocs relocs_;
 };
 
 // Output_data_reloc is used to manage a section containing relocs.
@@ -1607,6 +1853,15 @@ class Output_data_reloc_base : public Output_data_reloc_generic
     : Output_data_reloc_generic(size, sort_relocs)
   { }
 
+  // Put the relative relocs which can be packed in RELR, rather than
+  // in this section.
+  void
+  set_relr_section(Output_data_relr<size, big_endian>* relr)
+  {
+    gold_assert(dynamic);
+    Output_data_reloc_generic::set_relr_section(relr);
+  }
+
  protected:
   // Write out the data.
   void
@@ -1664,6 +1919,18 @@ class Output_data_reloc_base : public Output_data_reloc_generic
   void
   add(Output_data* od, const Output_reloc_type& reloc)
   {
+    if (dynamic && this->relr_section() != NULL)
+      {
+	Output_data_relr<size, big_endian>* relr =
+	  static_cast<Output_data_relr<size, big_endian>*>(
+	      this->relr_section());
+	if (relr->add(reloc.rel()))
+	  {
+	    od->add_dynamic_reloc();
+	    return;
+	  }
+      }
+
     this->relocs_.push_back(reloc);
     this->set_current_data_size(this->relocs_.size() * reloc_size);
     if (dynamic)
@@ -3961,6 +4228,15 @@ class Output_section : public Output_data
 	this->u2_.posd->print_merge_stats(section_name);
     }
 
+    // Queue tasks to merge the input sections of a merge section.
+    void
+    queue_merge_tasks(Workqueue* workqueue, Task_token* blocker)
+    {
+      if (this->shndx_ == MERGE_DATA_SECTION_CODE
+	  || this->shndx_ == MERGE_STRING_SECTION_CODE)
+	this->u2_.posd->queue_merge_tasks(workqueue, blocker);
+    }
+
    private:
     // Code values which appear in shndx_.  If the value is not one of
     // these codes, it is the input section index in the object file.
@@ -4056,6 +4332,16 @@ class Output_section : public Output_data
   const Output_relaxed_input_section*
   find_relaxed_input_section(const Relobj* object, unsigned int shndx) const;
 
+  // Build the maps used to find merge and relaxed input sections, if
+  // they are not already built.  This is called before several
+  // threads look up input sections at once.
+  void
+  build_lookup_maps_if_needed() const
+  {
+    if (!this->lookup_maps_->is_valid())
+      this->build_lookup_maps();
+  }
+
   // Whether section offsets need adjustment due to relaxation.
   bool
   section_offsets_need_adjustment() const
@@ -4090,6 +4376,11 @@ class Output_section : public Output_data
   void
   print_merge_stats();
 
+  // Queue tasks to merge the input sections of merge sections.
+  // Each task releases a blocker on BLOCKER when it completes.
+  void
+  queue_merge_tasks(Workqueue*, Task_token* blocker);
+
   // Set a fixed layout for the section.  Used for incremental update links.
   void
   set_fixed_layout(uint64_t sh_addr, off_t sh_offset, off_t sh_size,
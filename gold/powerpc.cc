@@ -671,7 +671,8 @@ class Target_powerpc : public Sized_target<size, big_endian>
   { return !parameters->options().relocatable(); }
 
   bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*);
 
   void
   do_plt_fde_location(const Output_data*, unsigned char*,
@@ -763,6 +764,12 @@ class Target_powerpc : public Sized_target<size, big_endian>
   do_can_check_for_function_pointers() const
   { return true; }
 
+  // References to a function descriptor in .opd are recorded in the
+  // object which defines it.
+  bool
+  do_may_gc_process_relocs_in_parallel() const
+  { return size != 64; }
+
   // Adjust -fsplit-stack code which calls non-split-stack code.
   void
   do_calls_non_split(Relobj* object, unsigned int shndx,
@@ -3291,6 +3298,7 @@ Target_powerpc<size, big_endian>::do_relax(int pass,
 					   const Input_objects*,
 					   Symbol_table* symtab,
 					   Layout* layout,
+					   Workqueue*,
 					   const Task* task)
 {
   unsigned int prev_brlt_size = 0;
@@ -400,6 +400,18 @@ Read_symbols::do_read_symbols(Workqueue* workqueue)
       Read_symbols_data* sd = new Read_symbols_data;
       elf_obj->read_symbols(sd);
 
+      // Match the symbols against the version script here, rather
+      // than in Add_symbols, since we run in parallel.
+      elf_obj->match_version_script(this->symtab_->version_script(), sd);
+
+      // Likewise for the input section specs of a SECTIONS clause.
+      elf_obj->match_script_sections(
+	  this->layout_->script_options()->script_sections(), sd);
+
+      // And for the symbols in a symbol ordering file.
+      if (parameters->options().symbol_ordering_file())
+	elf_obj->match_symbol_order(this->layout_, sd);
+
       // Opening the file locked it, so now we need to unlock it.  We
       // need to unlock it before queuing the Add_symbols task,
       // because the workqueue doesn't know about our lock on the
@@ -32,6 +32,7 @@
 #include "object.h"
 #include "target-reloc.h"
 #include "reloc.h"
+#include "gc.h"
 #include "icf.h"
 #include "compressed_output.h"
 #include "incremental.h"
@@ -134,6 +135,8 @@ void
 Gc_process_relocs::run(Workqueue*)
 {
   this->object_->gc_process_relocs(this->symtab_, this->layout_, this->rd_);
+  if (parameters->options().gc_sections())
+    this->symtab_->gc()->finalize_references(this->object_);
   this->object_->release();
 }
 
@@ -234,9 +237,28 @@ Relocate_task::locks(Task_locker* tl)
 // Run the task.
 
 void
-Relocate_task::run(Workqueue*)
+Relocate_task::run(Workqueue* workqueue)
 {
-  this->object_->relocate(this->symtab_, this->layout_, this->of_);
+  Task_token* ranges_blocker =
+    this->object_->relocate_start(this->symtab_, this->layout_, this->of_,
+				  workqueue);
+
+  if (ranges_blocker != NULL)
+    {
+      // Some relocations are being applied by other tasks.  Hand our
+      // blockers over to a task which finishes up once they are done.
+      // Since the blockers are shared with other tasks, we need to
+      // increment the counts with the workqueue lock held.
+      if (this->input_sections_blocker_ != NULL)
+	workqueue->add_blocker(this->input_sections_blocker_);
+      workqueue->add_blocker(this->final_blocker_);
+      workqueue->queue(new Relocate_finish_task(this->symtab_, this->layout_,
+						this->object_, this->of_,
+						ranges_blocker,
+						this->input_sections_blocker_,
+						this->final_blocker_));
+      return;
+    }
 
   // This is normally the last thing we will do with an object, so
   // uncache all views.
@@ -253,6 +275,92 @@ Relocate_task::get_name() const
   return "Relocate_task " + this->object_->name();
 }
 
+// Relocate_range_task methods.
+
+// Unblock the Relocate_finish_task when we are done.
+
+void
+Relocate_range_task::locks(Task_locker* tl)
+{
+  tl->add(this, this->blocker_);
+}
+
+// Run the task.
+
+void
+Relocate_range_task::run(Workqueue*)
+{
+  this->object_->relocate_range(this->symtab_, this->layout_, this->shndx_,
+				this->first_, this->count_);
+}
+
+// Return a debugging name for the task.
+
+std::string
+Relocate_range_task::get_name() const
+{
+  char buf[100];
+  snprintf(buf, sizeof buf, " section %u relocs %zu-%zu", this->shndx_,
+	   this->first_, this->first_ + this->count_ - 1);
+  return "Relocate_range_task " + this->object_->name() + buf;
+}
+
+// Relocate_finish_task methods.
+
+Relocate_finish_task::~Relocate_finish_task()
+{
+  delete this->ranges_blocker_;
+}
+
+// We have to wait for the Relocate_range_tasks, and for the
+// Relocate_task to release the object.
+
+Task_token*
+Relocate_finish_task::is_runnable()
+{
+  if (this->ranges_blocker_->is_blocked())
+    return this->ranges_blocker_;
+
+  if (this->object_->is_locked())
+    return this->object_->token();
+
+  return NULL;
+}
+
+// Lock the file, and unblock INPUT_SECTIONS_BLOCKER, which may be
+// NULL, and FINAL_BLOCKER when we are done.
+
+void
+Relocate_finish_task::locks(Task_locker* tl)
+{
+  if (this->input_sections_blocker_ != NULL)
+    tl->add(this, this->input_sections_blocker_);
+  tl->add(this, this->final_blocker_);
+  Task_token* token = this->object_->token();
+  if (token != NULL)
+    tl->add(this, token);
+}
+
+// Run the task.
+
+void
+Relocate_finish_task::run(Workqueue*)
+{
+  this->object_->relocate_finish(this->symtab_, this->layout_, this->of_);
+
+  this->object_->clear_view_cache_marks();
+
+  this->object_->release();
+}
+
+// Return a debugging name for the task.
+
+std::string
+Relocate_finish_task::get_name() const
+{
+  return "Relocate_finish_task " + this->object_->name();
+}
+
 // Read the relocs and local symbols from the object file and store
 // the information in RD.
 
@@ -634,6 +742,22 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
   // since we no longer need them.
   this->free_input_to_output_maps();
 
+  this->write_relocated_sections(layout, of, &views);
+}
+
+// Write out the views accumulated while relocating, and the local
+// symbols.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::write_relocated_sections(
+    const Layout* layout,
+    Output_file* of,
+    Views* pviews)
+{
+  Views& views(*pviews);
+  unsigned int shnum = this->shnum();
+
   // Write out the accumulated views.
   for (unsigned int i = 1; i < shnum; ++i)
     {
@@ -660,6 +784,266 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 			    layout->symtab_section_offset());
 }
 
+// The number of relocations applied by each task when the
+// relocations for a large section are split into ranges.  A section
+// is only split if it has at least twice this many relocations.
+
+static const size_t reloc_range_count = 32768;
+
+// Start relocating the input sections.  When using threads, the
+// relocations for very large sections are split into ranges, and
+// each range is applied by a Relocate_range_task.  This keeps all
+// the threads busy when one large object dominates the link.  The
+// other sections are relocated here while those tasks run.
+
+template<int size, bool big_endian>
+Task_token*
+Sized_relobj_file<size, big_endian>::do_relocate_start(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    Workqueue* workqueue)
+{
+  // A relocatable link, --emit-relocs, an incremental link and
+  // -fsplit-stack all process the relocations in order.  The file of
+  // an archive member is shared with the other members, so we can not
+  // hold on to it after this task completes.
+  if (!parameters->options().threads()
+      || parameters->options().relocatable()
+      || parameters->options().emit_relocs()
+      || parameters->incremental()
+      || this->uses_split_stack()
+      || this->offset() != 0
+      || !parameters->target().may_split_relocs())
+    {
+      this->do_relocate(symtab, layout, of);
+      return NULL;
+    }
+
+  unsigned int shnum = this->shnum();
+  const unsigned char* pshdrs = this->get_view(this->elf_file_.shoff(),
+					       shnum * This::shdr_size,
+					       true, true);
+
+  std::vector<bool> is_split(shnum);
+  std::vector<Reloc_range> ranges;
+  const unsigned char* p = pshdrs + This::shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+    {
+      typename This::Shdr shdr(p);
+      if (shdr.get_sh_type() == elfcpp::SHT_REL)
+	is_split[i] = this->split_reloc_section<elfcpp::SHT_REL>(pshdrs, i,
+								  &ranges);
+      else if (shdr.get_sh_type() == elfcpp::SHT_RELA)
+	is_split[i] = this->split_reloc_section<elfcpp::SHT_RELA>(pshdrs, i,
+								   &ranges);
+    }
+
+  if (ranges.empty())
+    {
+      this->do_relocate(symtab, layout, of);
+      return NULL;
+    }
+
+  Split_relocs* sr = new Split_relocs();
+  sr->pshdrs = pshdrs;
+  sr->views.resize(shnum);
+  sr->is_split.swap(is_split);
+  this->split_relocs_ = sr;
+
+  this->write_sections(layout, pshdrs, of, &sr->views);
+  this->initialize_input_to_output_maps();
+  this->output_views_ = &sr->views;
+
+  // From here on the range tasks read the input file at the same
+  // time as this one.
+  this->input_file()->file().share_views();
+
+  // Queue the tasks in output file order, so that the threads tend to
+  // work on nearby parts of the output file.
+  std::sort(ranges.begin(), ranges.end(), Reloc_range_compare());
+  Task_token* blocker = new Task_token(true);
+  blocker->add_blockers(ranges.size());
+  for (typename std::vector<Reloc_range>::const_iterator r = ranges.begin();
+       r != ranges.end();
+       ++r)
+    workqueue->queue(new Relocate_range_task(symtab, layout, this, r->shndx,
+					     r->first, r->count, blocker));
+
+  // relocate_section_range skips the sections which were split.
+  this->relocate_sections(symtab, layout, pshdrs, of, &sr->views);
+
+  return blocker;
+}
+
+// Add ranges of the relocations in the relocation section SHNDX to
+// *RANGES.  Sections which are small, or which are unusual in any
+// way, are left to relocate_section_range, which will report any
+// errors.
+
+template<int size, bool big_endian>
+template<int sh_type>
+bool
+Sized_relobj_file<size, big_endian>::split_reloc_section(
+    const unsigned char* pshdrs,
+    unsigned int shndx,
+    std::vector<Reloc_range>* ranges)
+{
+  typedef typename Reloc_types<sh_type, size, big_endian>::Reloc Reltype;
+  const int reloc_size = Reloc_types<sh_type, size, big_endian>::reloc_size;
+
+  typename This::Shdr shdr(pshdrs + shndx * This::shdr_size);
+  off_t sh_size = shdr.get_sh_size();
+  if (shdr.get_sh_entsize() != static_cast<unsigned int>(reloc_size)
+      || sh_size % reloc_size != 0)
+    return false;
+  size_t reloc_count = sh_size / reloc_size;
+  if (reloc_count < 2 * reloc_range_count)
+    return false;
+
+  unsigned int index = this->adjust_shndx(shdr.get_sh_info());
+  if (index >= this->shnum()
+      || this->adjust_shndx(shdr.get_sh_link()) != this->symtab_shndx_)
+    return false;
+
+  // Sections which need special offset handling, such as .eh_frame,
+  // are relocated in order.
+  Output_section* os = this->output_sections()[index];
+  Address output_offset = this->section_offsets()[index];
+  if (os == NULL || output_offset == invalid_address)
+    return false;
+  // The file offset of a section which requires postprocessing is not
+  // known yet; such sections are written to a buffer anyhow.
+  off_t offset = output_offset;
+  if (os->is_offset_valid())
+    offset += os->offset();
+
+  // Don't separate a relocation against a TLS symbol from the
+  // relocation which follows it; the target may need to handle them
+  // together.
+  const unsigned char* prelocs = this->get_view(shdr.get_sh_offset(),
+						sh_size, true, false);
+  size_t first = 0;
+  while (first < reloc_count)
+    {
+      size_t end = first + reloc_range_count;
+      while (end < reloc_count)
+	{
+	  Reltype reloc(prelocs + (end - 1) * reloc_size);
+	  unsigned int r_sym = elfcpp::elf_r_sym<size>(reloc.get_r_info());
+	  if (!this->reloc_symbol_is_tls(pshdrs, r_sym))
+	    break;
+	  ++end;
+	}
+      if (end + reloc_range_count / 2 > reloc_count)
+	end = reloc_count;
+      ranges->push_back(Reloc_range(shndx, first, end - first, offset));
+      first = end;
+    }
+
+  return true;
+}
+
+// Return whether the symbol R_SYM of this object is a TLS symbol.
+
+template<int size, bool big_endian>
+bool
+Sized_relobj_file<size, big_endian>::reloc_symbol_is_tls(
+    const unsigned char* pshdrs,
+    unsigned int r_sym)
+{
+  if (r_sym < this->local_symbol_count())
+    {
+      const Symbol_value<size>* lv = this->local_symbol(r_sym);
+      if (lv->is_tls_symbol())
+	return true;
+      if (!lv->is_section_symbol())
+	return false;
+      bool is_ordinary;
+      unsigned int shndx = lv->input_shndx(&is_ordinary);
+      if (!is_ordinary || shndx >= this->shnum())
+	return false;
+      typename This::Shdr shdr(pshdrs + shndx * This::shdr_size);
+      return (shdr.get_sh_flags() & elfcpp::SHF_TLS) != 0;
+    }
+
+  if (r_sym - this->local_symbol_count() >= this->symbols_.size())
+    return false;
+  const Symbol* gsym = this->global_symbol(r_sym);
+  return gsym != NULL && gsym->type() == elfcpp::STT_TLS;
+}
+
+// Apply COUNT relocations starting at FIRST in the relocation section
+// SHNDX.  This runs in a Relocate_range_task, possibly at the same
+// time as other tasks for this object.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_relocate_range(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    unsigned int shndx,
+    size_t first,
+    size_t count)
+{
+  Split_relocs* sr = this->split_relocs_;
+  gold_assert(sr != NULL && sr->is_split[shndx]);
+
+  const unsigned char* pshdrs = sr->pshdrs;
+  typename This::Shdr shdr(pshdrs + shndx * This::shdr_size);
+  unsigned int sh_type = shdr.get_sh_type();
+  unsigned int reloc_size;
+  if (sh_type == elfcpp::SHT_REL)
+    reloc_size = elfcpp::Elf_sizes<size>::rel_size;
+  else
+    reloc_size = elfcpp::Elf_sizes<size>::rela_size;
+
+  unsigned int index = this->adjust_shndx(shdr.get_sh_info());
+  const View_size& vs(sr->views[index]);
+  gold_assert(vs.view != NULL);
+
+  const unsigned char* prelocs =
+    this->get_view(shdr.get_sh_offset() + first * reloc_size,
+		   count * reloc_size, true, false);
+
+  Relocate_info<size, big_endian> relinfo;
+  relinfo.symtab = symtab;
+  relinfo.layout = layout;
+  relinfo.object = this;
+  relinfo.reloc_shndx = shndx;
+  relinfo.reloc_shdr = pshdrs + shndx * This::shdr_size;
+  relinfo.rr = NULL;
+  relinfo.data_shndx = index;
+  relinfo.data_shdr = pshdrs + index * This::shdr_size;
+
+  Sized_target<size, big_endian>* target =
+    parameters->sized_target<size, big_endian>();
+  target->relocate_section(&relinfo, sh_type, prelocs, count,
+			   this->output_sections()[index], false,
+			   vs.view, vs.address, vs.view_size, NULL);
+}
+
+// Finish relocating after all the Relocate_range_tasks are done.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_relocate_finish(
+    const Symbol_table*,
+    const Layout* layout,
+    Output_file* of)
+{
+  Split_relocs* sr = this->split_relocs_;
+  gold_assert(sr != NULL);
+
+  this->input_file()->file().unshare_views();
+  this->free_input_to_output_maps();
+  this->write_relocated_sections(layout, of, &sr->views);
+
+  this->output_views_ = NULL;
+  this->split_relocs_ = NULL;
+  delete sr;
+}
+
 // Sort a Read_multiple vector by file offset.
 struct Read_multiple_compare
 {
@@ -687,6 +1071,28 @@ Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
   File_read::Read_multiple rm;
   bool is_sorted = true;
 
+  // When the output file is streamed, a view of an entire output
+  // section must be read from the file, so we only get one for a
+  // section which has relocations to apply.
+  std::vector<bool> has_relocs;
+  if (of->is_streaming())
+    {
+      has_relocs.resize(shnum, false);
+      const unsigned char* p = pshdrs + This::shdr_size;
+      for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
+	{
+	  typename This::Shdr shdr(p);
+	  if ((shdr.get_sh_type() == elfcpp::SHT_REL
+	       || shdr.get_sh_type() == elfcpp::SHT_RELA)
+	      && shdr.get_sh_size() > 0)
+	    {
+	      unsigned int index = this->adjust_shndx(shdr.get_sh_info());
+	      if (index < shnum)
+		has_relocs[index] = true;
+	    }
+	}
+    }
+
   const unsigned char* p = pshdrs + This::shdr_size;
   for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
     {
@@ -787,6 +1193,12 @@ Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
       if (view_size == 0)
 	continue;
 
+      if (output_offset == invalid_address
+	  && !has_relocs.empty()
+	  && !has_relocs[i]
+	  && !os->requires_postprocessing())
+	continue;
+
       gold_assert(output_offset == invalid_address
 		  || output_offset + view_size <= output_section_size);
 
@@ -915,6 +1327,10 @@ Sized_relobj_file<size, big_endian>::relocate_section_range(
       if (sh_type != elfcpp::SHT_REL && sh_type != elfcpp::SHT_RELA)
 	continue;
 
+      // Skip sections handled by Relocate_range_tasks.
+      if (this->split_relocs_ != NULL && this->split_relocs_->is_split[i])
+	continue;
+
       off_t sh_size = shdr.get_sh_size();
       if (sh_size == 0)
 	continue;
@@ -1704,6 +2120,27 @@ void
 Sized_relobj_file<32, false>::do_relocate(const Symbol_table* symtab,
 					  const Layout* layout,
 					  Output_file* of);
+
+template
+Task_token*
+Sized_relobj_file<32, false>::do_relocate_start(const Symbol_table* symtab,
+						const Layout* layout,
+						Output_file* of,
+						Workqueue* workqueue);
+
+template
+void
+Sized_relobj_file<32, false>::do_relocate_range(const Symbol_table* symtab,
+						const Layout* layout,
+						unsigned int shndx,
+						size_t first,
+						size_t count);
+
+template
+void
+Sized_relobj_file<32, false>::do_relocate_finish(const Symbol_table* symtab,
+						 const Layout* layout,
+						 Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_32_BIG
@@ -1712,6 +2149,27 @@ void
 Sized_relobj_file<32, true>::do_relocate(const Symbol_table* symtab,
 					 const Layout* layout,
 					 Output_file* of);
+
+template
+Task_token*
+Sized_relobj_file<32, true>::do_relocate_start(const Symbol_table* symtab,
+					       const Layout* layout,
+					       Output_file* of,
+					       Workqueue* workqueue);
+
+template
+void
+Sized_relobj_file<32, true>::do_relocate_range(const Symbol_table* symtab,
+					       const Layout* layout,
+					       unsigned int shndx,
+					       size_t first,
+					       size_t count);
+
+template
+void
+Sized_relobj_file<32, true>::do_relocate_finish(const Symbol_table* symtab,
+						const Layout* layout,
+						Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_64_LITTLE
@@ -1720,6 +2178,27 @@ void
 Sized_relobj_file<64, false>::do_relocate(const Symbol_table* symtab,
 					  const Layout* layout,
 					  Output_file* of);
+
+template
+Task_token*
+Sized_relobj_file<64, false>::do_relocate_start(const Symbol_table* symtab,
+						const Layout* layout,
+						Output_file* of,
+						Workqueue* workqueue);
+
+template
+void
+Sized_relobj_file<64, false>::do_relocate_range(const Symbol_table* symtab,
+						const Layout* layout,
+						unsigned int shndx,
+						size_t first,
+						size_t count);
+
+template
+void
+Sized_relobj_file<64, false>::do_relocate_finish(const Symbol_table* symtab,
+						 const Layout* layout,
+						 Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_64_BIG
@@ -1728,6 +2207,27 @@ void
 Sized_relobj_file<64, true>::do_relocate(const Symbol_table* symtab,
 					 const Layout* layout,
 					 Output_file* of);
+
+template
+Task_token*
+Sized_relobj_file<64, true>::do_relocate_start(const Symbol_table* symtab,
+					       const Layout* layout,
+					       Output_file* of,
+					       Workqueue* workqueue);
+
+template
+void
+Sized_relobj_file<64, true>::do_relocate_range(const Symbol_table* symtab,
+					       const Layout* layout,
+					       unsigned int shndx,
+					       size_t first,
+					       size_t count);
+
+template
+void
+Sized_relobj_file<64, true>::do_relocate_finish(const Symbol_table* symtab,
+						const Layout* layout,
+						Output_file* of);
 #endif
 
 #ifdef HAVE_TARGET_32_LITTLE
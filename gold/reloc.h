@@ -214,6 +214,88 @@ class Relocate_task : public Task
   Task_token* final_blocker_;
 };
 
+// A class to apply a range of the relocations for a large section,
+// queued by Relobj::relocate_start.
+
+class Relocate_range_task : public Task
+{
+ public:
+  Relocate_range_task(const Symbol_table* symtab, const Layout* layout,
+		      Relobj* object, unsigned int shndx, size_t first,
+		      size_t count, Task_token* blocker)
+    : symtab_(symtab), layout_(layout), object_(object), shndx_(shndx),
+      first_(first), count_(count), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  const Symbol_table* symtab_;
+  const Layout* layout_;
+  Relobj* object_;
+  unsigned int shndx_;
+  size_t first_;
+  size_t count_;
+  Task_token* blocker_;
+};
+
+// A class to finish relocating an object file once the
+// Relocate_range_tasks for it are done.  This takes over the blockers
+// of the Relocate_task which queued them.
+
+class Relocate_finish_task : public Task
+{
+ public:
+  Relocate_finish_task(const Symbol_table* symtab, const Layout* layout,
+		       Relobj* object, Output_file* of,
+		       Task_token* ranges_blocker,
+		       Task_token* input_sections_blocker,
+		       Task_token* final_blocker)
+    : symtab_(symtab), layout_(layout), object_(object), of_(of),
+      ranges_blocker_(ranges_blocker),
+      input_sections_blocker_(input_sections_blocker),
+      final_blocker_(final_blocker)
+  { }
+
+  ~Relocate_finish_task();
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  const Symbol_table* symtab_;
+  const Layout* layout_;
+  Relobj* object_;
+  Output_file* of_;
+  Task_token* ranges_blocker_;
+  Task_token* input_sections_blocker_;
+  Task_token* final_blocker_;
+};
+
 // During a relocatable link, this class records how relocations
 // should be handled for a single input reloc section.  An instance of
 // this class is created while scanning relocs, and it is used while
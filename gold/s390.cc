@@ -1522,10 +1522,15 @@ Output_data_plt_s390<size>::do_write(Output_file* of)
   gold_assert(parameters->incremental_update()
 	      || (got_file_offset + this->got_plt_->data_size()
 		  == this->got_irelative_->offset()));
+  // The first three entries in the GOT are reserved, and are written
+  // by Output_data_got_plt_s390::do_write, so our view of the GOT
+  // starts after them.
+  const off_t got_view_offset = got_file_offset + 3 * size / 8;
   const section_size_type got_size =
     convert_to_section_size_type(this->got_plt_->data_size()
-				 + this->got_irelative_->data_size());
-  unsigned char* const got_view = of->get_output_view(got_file_offset,
+				 + this->got_irelative_->data_size()
+				 - 3 * size / 8);
+  unsigned char* const got_view = of->get_output_view(got_view_offset,
 						      got_size);
 
   unsigned char* pov = oview;
@@ -1549,9 +1554,6 @@ Output_data_plt_s390<size>::do_write(Output_file* of)
   unsigned int plt_rel_offset = 0;
   unsigned int got_offset = 3 * size / 8;
   const unsigned int count = this->count_ + this->irelative_count_;
-  // The first three entries in the GOT are reserved, and are written
-  // by Output_data_got_plt_s390::do_write.
-  got_pov += 3 * size / 8;
 
   for (unsigned int plt_index = 0;
        plt_index < count;
@@ -1577,7 +1579,7 @@ Output_data_plt_s390<size>::do_write(Output_file* of)
   gold_assert(static_cast<section_size_type>(got_pov - got_view) == got_size);
 
   of->write_output_view(offset, oview_size, oview);
-  of->write_output_view(got_file_offset, got_size, got_view);
+  of->write_output_view(got_view_offset, got_size, got_view);
 }
 
 // Get the GOT section, creating it if necessary.
@@ -590,6 +590,98 @@ Orphan_section_placement::last_place() const
   return this->places_[PLACE_LAST].location;
 }
 
+class Output_section_element_input;
+
+// An index of the input section specs in a SECTIONS clause, which
+// Script_sections::output_section_name uses to find the first spec
+// which matches an input section without trying each one in turn.
+// The specs are numbered in the order in which they appear in the
+// script, and their section name patterns are added to a Glob_index
+// under those numbers.  The file name of a spec is only checked once
+// one of its section name patterns has matched.
+
+class Input_section_index
+{
+ public:
+  Input_section_index()
+    : specs_(), section_names_(0), definition_count_(0)
+  { }
+
+  // Add the input section spec ISE, in the output section OSD, and
+  // return its number.
+  unsigned int
+  add_spec(Output_section_definition* osd,
+	   const Output_section_element_input* ise)
+  {
+    this->specs_.push_back(std::make_pair(osd, ise));
+    return this->specs_.size() - 1;
+  }
+
+  // Add a section name PATTERN for spec number SPEC.  IS_WILDCARD is
+  // false if the name must match the pattern exactly.
+  void
+  add_section_pattern(unsigned int spec, const std::string& pattern,
+		      bool is_wildcard)
+  {
+    if (is_wildcard)
+      this->section_names_.add(pattern, spec);
+    else
+      this->section_names_.add_literal(pattern, spec);
+  }
+
+  // Record that an output section definition was added.
+  void
+  add_definition()
+  { ++this->definition_count_; }
+
+  // Return the number of output section definitions in the index.
+  size_t
+  definition_count() const
+  { return this->definition_count_; }
+
+  // Return the number of the first spec which matches FILE_NAME and
+  // SECTION_NAME, or -1 if there is none.
+  int
+  find(const char* file_name, const char* section_name) const;
+
+  // Return the name of the output section for an input section
+  // matched by spec number SPEC, and set *SLOT, *PSECTION_TYPE and
+  // *KEEP.
+  const char*
+  output_section_name(unsigned int spec, Output_section*** slot,
+		      Script_sections::Section_type* psection_type,
+		      bool* keep) const;
+
+ private:
+  // Each spec, with the output section definition which holds it.
+  typedef std::vector<std::pair<Output_section_definition*,
+				const Output_section_element_input*> > Specs;
+
+  // Passed to Glob_index::first_match to accept a spec whose section
+  // name pattern matched only if its file name pattern matches too.
+  class Match_file_name
+  {
+   public:
+    Match_file_name(const Specs& specs, const char* file_name)
+      : specs_(specs), file_name_(file_name)
+    { }
+
+    bool
+    operator()(unsigned int spec) const;
+
+   private:
+    const Specs& specs_;
+    const char* file_name_;
+  };
+
+  // The specs, indexed by number.
+  Specs specs_;
+  // The section name patterns of the specs.
+  Glob_index section_names_;
+  // The number of output section definitions.
+  size_t definition_count_;
+};
+
 // An element in a SECTIONS clause.
 
 class Sections_element
@@ -635,6 +727,12 @@ class Sections_element
 		      Script_sections::Section_type*, bool*, bool)
   { return NULL; }
 
+  // Add any input section specs to INDEX.  The only real
+  // implementation is in Output_section_definition.
+  virtual void
+  add_to_input_section_index(Input_section_index*)
+  { }
+
   // Initialize OSP with an output section.
   virtual void
   orphan_section_init(Orphan_section_placement*,
@@ -853,6 +951,13 @@ class Output_section_element
   match_name(const char*, const char*, bool *) const
   { return false; }
 
+  // Add this element to INDEX if it is an input section spec in OSD.
+  // The only real implementation is in Output_section_element_input.
+  virtual void
+  add_to_input_section_index(Output_section_definition*,
+			     Input_section_index*) const
+  { }
+
   // Set section addresses.  This includes applying assignments if the
   // expression is an absolute value.
   virtual void
@@ -1293,6 +1398,20 @@ class Output_section_element_input : public Output_section_element
   bool
   match_name(const char* file_name, const char* section_name, bool* keep) const;
 
+  // See if we match a file name.
+  bool
+  match_file_name(const char* file_name) const;
+
+  // Whether to keep matching sections when garbage collecting.
+  bool
+  keep() const
+  { return this->keep_; }
+
+  // Add our section name patterns to INDEX.
+  void
+  add_to_input_section_index(Output_section_definition* osd,
+			     Input_section_index* index) const;
+
   // Set the section address.
   void
   set_section_addresses(Symbol_table* symtab, Layout* layout, Output_section*,
@@ -1336,10 +1455,6 @@ class Output_section_element_input : public Output_section_element
 	    : strcmp(string, pattern) == 0);
   }
 
-  // See if we match a file name.
-  bool
-  match_file_name(const char* file_name) const;
-
   // The file name pattern.  If this is the empty string, we match all
   // files.
   std::string filename_pattern_;
@@ -1474,6 +1589,24 @@ Output_section_element_input::match_name(const char* file_name,
   return false;
 }
 
+// Add our section name patterns to INDEX.  If we have none, we match
+// every section name, as "*" does.
+
+void
+Output_section_element_input::add_to_input_section_index(
+    Output_section_definition* osd,
+    Input_section_index* index) const
+{
+  unsigned int spec = index->add_spec(osd, this);
+  if (this->input_section_patterns_.empty())
+    index->add_section_pattern(spec, "*", true);
+  for (Input_section_patterns::const_iterator p =
+	 this->input_section_patterns_.begin();
+       p != this->input_section_patterns_.end();
+       ++p)
+    index->add_section_pattern(spec, p->pattern, p->pattern_is_wildcard);
+}
+
 // Information we use to sort the input sections.
 
 class Input_section_info
@@ -2005,6 +2138,21 @@ class Output_section_definition : public Sections_element
 		      Output_section***, Script_sections::Section_type*,
 		      bool*, bool);
 
+  // Add our input section specs to INDEX.
+  void
+  add_to_input_section_index(Input_section_index* index);
+
+  // Return our name, and set *SLOT and *PSECTION_TYPE, for an input
+  // section which matched one of our input section specs.
+  const char*
+  matched_output_section_name(Output_section*** slot,
+			      Script_sections::Section_type* psection_type)
+  {
+    *slot = &this->output_section_;
+    *psection_type = this->section_type();
+    return this->name_.c_str();
+  }
+
   // Initialize OSP with an output section.
   void
   orphan_section_init(Orphan_section_placement* osp,
@@ -2312,9 +2460,7 @@ Output_section_definition::output_section_name(
 	{
 	  // We found a match for NAME, which means that it should go
 	  // into this output section.
-	  *slot = &this->output_section_;
-	  *psection_type = this->section_type();
-	  return this->name_.c_str();
+	  return this->matched_output_section_name(slot, psection_type);
 	}
     }
 
@@ -2322,6 +2468,54 @@ Output_section_definition::output_section_name(
   return NULL;
 }
 
+// Add our input section specs to INDEX.
+
+void
+Output_section_definition::add_to_input_section_index(
+    Input_section_index* index)
+{
+  index->add_definition();
+  for (Output_section_elements::const_iterator p = this->elements_.begin();
+       p != this->elements_.end();
+       ++p)
+    (*p)->add_to_input_section_index(this, index);
+}
+
+// Class Input_section_index.
+
+bool
+Input_section_index::Match_file_name::operator()(unsigned int spec) const
+{
+  return this->specs_[spec].second->match_file_name(this->file_name_);
+}
+
+// Return the number of the first spec which matches FILE_NAME and
+// SECTION_NAME.
+
+int
+Input_section_index::find(const char* file_name,
+			  const char* section_name) const
+{
+  return this->section_names_.first_match(section_name,
+					  Match_file_name(this->specs_,
+							  file_name));
+}
+
+// Return the output section for an input section matched by SPEC.
+
+const char*
+Input_section_index::output_section_name(
+    unsigned int spec,
+    Output_section*** slot,
+    Script_sections::Section_type* psection_type,
+    bool* keep) const
+{
+  gold_assert(spec < this->specs_.size());
+  *keep = this->specs_[spec].second->keep();
+  return this->specs_[spec].first->matched_output_section_name(slot,
+							       psection_type);
+}
+
 // Return true if memory from START to START + LENGTH is contained
 // within a memory region.
 
@@ -3343,6 +3537,8 @@ Script_sections::Script_sections()
     memory_regions_(NULL),
     phdrs_elements_(NULL),
     orphan_section_placement_(NULL),
+    input_section_index_(NULL),
+    output_section_definition_count_(0),
     data_segment_align_start_(),
     saw_data_segment_align_(false),
     saw_relro_end_(false),
@@ -3442,6 +3638,7 @@ Script_sections::start_output_section(
 								  namelen,
 								  header);
   this->sections_elements_->push_back(posd);
+  ++this->output_section_definition_count_;
   gold_assert(this->output_section_ == NULL);
   this->output_section_ = posd;
 }
@@ -3570,29 +3767,50 @@ Script_sections::output_section_name(
     Output_section*** output_section_slot,
     Script_sections::Section_type* psection_type,
     bool* keep,
-    bool is_input_section)
+    bool is_input_section,
+    int input_spec)
 {
-  for (Sections_elements::const_iterator p = this->sections_elements_->begin();
-       p != this->sections_elements_->end();
-       ++p)
+  const char* ret = NULL;
+  const Input_section_index* index = this->input_section_index_;
+  if (is_input_section
+      && index != NULL
+      && (index->definition_count()
+	  == this->output_section_definition_count_))
+    {
+      // The index gives the first input section spec which matches,
+      // which is the one we would find by asking each element.
+      if (input_spec < 0)
+	input_spec = index->find(file_name, section_name);
+      if (input_spec >= 0)
+	ret = index->output_section_name(input_spec, output_section_slot,
+					 psection_type, keep);
+    }
+  else
     {
-      const char* ret = (*p)->output_section_name(file_name, section_name,
-						  output_section_slot,
-						  psection_type, keep,
-						  is_input_section);
+      for (Sections_elements::const_iterator p =
+	     this->sections_elements_->begin();
+	   p != this->sections_elements_->end();
+	   ++p)
+	{
+	  ret = (*p)->output_section_name(file_name, section_name,
+					  output_section_slot, psection_type,
+					  keep, is_input_section);
+	  if (ret != NULL)
+	    break;
+	}
+    }
 
-      if (ret != NULL)
+  if (ret != NULL)
+    {
+      // The special name /DISCARD/ means that the input section
+      // should be discarded.
+      if (strcmp(ret, "/DISCARD/") == 0)
 	{
-	  // The special name /DISCARD/ means that the input section
-	  // should be discarded.
-	  if (strcmp(ret, "/DISCARD/") == 0)
-	    {
-	      *output_section_slot = NULL;
-	      *psection_type = Script_sections::ST_NONE;
-	      return NULL;
-	    }
-	  return ret;
+	  *output_section_slot = NULL;
+	  *psection_type = Script_sections::ST_NONE;
+	  return NULL;
 	}
+      return ret;
     }
 
   // We have an orphan section.
@@ -3629,6 +3847,40 @@ Script_sections::output_section_name(
   return section_name;
 }
 
+// Build the index of the input section specs.  Everything that has
+// been parsed so far is in the index.  A SECTIONS clause in a script
+// read later will not be, and output_section_name will then ignore
+// the index.
+
+void
+Script_sections::build_input_section_index()
+{
+  gold_assert(this->input_section_index_ == NULL);
+  Input_section_index* index = new Input_section_index();
+  if (this->sections_elements_ != NULL)
+    {
+      for (Sections_elements::const_iterator p =
+	     this->sections_elements_->begin();
+	   p != this->sections_elements_->end();
+	   ++p)
+	(*p)->add_to_input_section_index(index);
+    }
+  this->input_section_index_ = index;
+}
+
+// Return the number of the first input section spec which matches
+// FILE_NAME and SECTION_NAME.  The index is not changed once it is
+// built, so this is safe to call from any thread.
+
+int
+Script_sections::find_input_section_spec(const char* file_name,
+					 const char* section_name) const
+{
+  if (this->input_section_index_ == NULL)
+    return -1;
+  return this->input_section_index_->find(file_name, section_name);
+}
+
 // Place a marker for an orphan output section into the SECTIONS
 // clause.
 
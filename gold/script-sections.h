@@ -44,6 +44,7 @@ class Output_section_definition;
 class Output_section;
 class Output_segment;
 class Orphan_section_placement;
+class Input_section_index;
 
 class Script_sections
 {
@@ -167,11 +168,32 @@ class Script_sections
   // MATCH_INPUT_SPEC indicates whether the section should be matched
   // with input section specs or simply against the output section name
   // (i.e., for linker-created sections like .dynamic).
+  // INPUT_SPEC is the result of find_input_section_spec for this
+  // section, if it was called, or -1.
   const char*
   output_section_name(const char* file_name, const char* section_name,
 		      Output_section*** output_section_slot,
 		      Section_type* pscript_section_type,
-		      bool* keep, bool match_input_spec);
+		      bool* keep, bool match_input_spec, int input_spec);
+
+  // Build an index of the input section specs seen so far, for
+  // output_section_name and find_input_section_spec.  This is called
+  // once, before any input files are read.
+  void
+  build_input_section_index();
+
+  // Return whether build_input_section_index was called.
+  bool
+  has_input_section_index() const
+  { return this->input_section_index_ != NULL; }
+
+  // Return the number of the first input section spec which matches
+  // FILE_NAME and SECTION_NAME, or -1 if there is none.  This may be
+  // called by several threads at once, so that the input sections of
+  // different files can be matched in parallel.
+  int
+  find_input_section_spec(const char* file_name,
+			  const char* section_name) const;
 
   // Place a marker for an orphan output section into the SECTIONS
   // clause.
@@ -313,6 +335,12 @@ class Script_sections
   Phdrs_elements* phdrs_elements_;
   // Where to put orphan sections.
   Orphan_section_placement* orphan_section_placement_;
+  // The index of the input section specs, if it has been built.
+  Input_section_index* input_section_index_;
+  // The number of output section definitions.  If this is more than
+  // the index has, the SECTIONS clause was extended by a script read
+  // after the index was built, and the index is not used.
+  size_t output_section_definition_count_;
   // A pointer to the last Sections_element when we see
   // DATA_SEGMENT_ALIGN.
   Sections_elements::iterator data_segment_align_start_;
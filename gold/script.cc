@@ -22,6 +22,7 @@
 
 #include "gold.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -1947,6 +1948,190 @@ struct Version_tree
   const struct Version_dependency_list* dependencies;
 };
 
+// Class Glob_index.
+
+Glob_index::Glob_index(int flags)
+  : flags_(flags), patterns_(), prefixes_(1), suffixes_(1), others_()
+{
+}
+
+// Add PATTERN with number ID.  A backslash may quote the next
+// character, unless FNM_NOESCAPE is used, so we stop the literal text
+// at a backslash either way.
+
+void
+Glob_index::add(const std::string& pattern, unsigned int id)
+{
+  const char* p = pattern.c_str();
+  size_t len = pattern.length();
+  size_t prefix_len = strcspn(p, "*?[\\");
+  size_t suffix_len = 0;
+  while (suffix_len < len
+	 && strchr("*?]\\", p[len - suffix_len - 1]) == NULL)
+    ++suffix_len;
+
+  Pattern_kind kind;
+  if (prefix_len == len)
+    kind = PATTERN_EXACT;
+  else if (prefix_len + 1 == len && p[prefix_len] == '*')
+    kind = PATTERN_PREFIX;
+  else
+    kind = PATTERN_GLOB;
+
+  unsigned int index = this->patterns_.size();
+  this->patterns_.push_back(Pattern(pattern, id, kind, prefix_len,
+				    suffix_len));
+  if (prefix_len > 0)
+    add_to_trie(&this->prefixes_, p, prefix_len, false, index);
+  else if (suffix_len > 0)
+    add_to_trie(&this->suffixes_, p + len - suffix_len, suffix_len, true,
+		index);
+  else
+    this->others_.push_back(index);
+}
+
+// Add NAME with number ID, to be compared with strcmp.
+
+void
+Glob_index::add_literal(const std::string& name, unsigned int id)
+{
+  size_t len = name.length();
+  unsigned int index = this->patterns_.size();
+  this->patterns_.push_back(Pattern(name, id, PATTERN_EXACT, len, 0));
+  if (len > 0)
+    add_to_trie(&this->prefixes_, name.data(), len, false, index);
+  else
+    this->others_.push_back(index);
+}
+
+// Add pattern INDEX to TRIE under the LEN characters at KEY.
+
+void
+Glob_index::add_to_trie(Trie* trie, const char* key, size_t len,
+			bool reverse, unsigned int index)
+{
+  unsigned int node = 0;
+  for (size_t i = 0; i < len; ++i)
+    {
+      unsigned char c = key[reverse ? len - i - 1 : i];
+      std::vector<std::pair<unsigned char, unsigned int> >& children =
+	(*trie)[node].children;
+      std::vector<std::pair<unsigned char, unsigned int> >::iterator p =
+	std::lower_bound(children.begin(), children.end(),
+			 std::make_pair(c, 0U));
+      if (p != children.end() && p->first == c)
+	node = p->second;
+      else
+	{
+	  unsigned int child = trie->size();
+	  children.insert(p, std::make_pair(c, child));
+	  // This may move the nodes, so we can not use CHILDREN after
+	  // this.
+	  trie->push_back(Trie_node());
+	  node = child;
+	}
+    }
+  (*trie)[node].patterns.push_back(index);
+}
+
+// Add to *CANDIDATES the patterns in TRIE whose keys are prefixes of
+// the LEN characters at NAME.
+
+void
+Glob_index::find_in_trie(const Trie& trie, const char* name, size_t len,
+			 bool reverse, std::vector<unsigned int>* candidates)
+{
+  unsigned int node = 0;
+  for (size_t i = 0; ; ++i)
+    {
+      const Trie_node& tn(trie[node]);
+      candidates->insert(candidates->end(), tn.patterns.begin(),
+			 tn.patterns.end());
+      if (i == len)
+	break;
+      unsigned char c = name[reverse ? len - i - 1 : i];
+      std::vector<std::pair<unsigned char, unsigned int> >::const_iterator p =
+	std::lower_bound(tn.children.begin(), tn.children.end(),
+			 std::make_pair(c, 0U));
+      if (p == tn.children.end() || p->first != c)
+	break;
+      node = p->second;
+    }
+}
+
+// Return whether pattern INDEX matches NAME, given that its literal
+// prefix, or if it has none its literal suffix, matches.
+
+bool
+Glob_index::pattern_matches(unsigned int index, const char* name,
+			    size_t len) const
+{
+  const Pattern& p(this->patterns_[index]);
+  switch (p.kind)
+    {
+    case PATTERN_EXACT:
+      return len == p.prefix_len;
+    case PATTERN_PREFIX:
+      return true;
+    case PATTERN_GLOB:
+      if (p.suffix_len > len
+	  || memcmp(name + len - p.suffix_len,
+		    p.pattern.data() + p.pattern.length() - p.suffix_len,
+		    p.suffix_len) != 0)
+	return false;
+      return fnmatch(p.pattern.c_str(), name, this->flags_) == 0;
+    default:
+      gold_unreachable();
+    }
+}
+
+// Find the patterns which may match NAME, and sort them by number, so
+// that the caller can try them in order and stop at the first which
+// matches.
+
+void
+Glob_index::find_candidates(
+    const char* name,
+    size_t len,
+    std::vector<std::pair<unsigned int, unsigned int> >* order) const
+{
+  std::vector<unsigned int> candidates(this->others_);
+  find_in_trie(this->prefixes_, name, len, false, &candidates);
+  find_in_trie(this->suffixes_, name, len, true, &candidates);
+
+  order->reserve(candidates.size());
+  for (std::vector<unsigned int>::const_iterator p = candidates.begin();
+       p != candidates.end();
+       ++p)
+    order->push_back(std::make_pair(this->patterns_[*p].id, *p));
+  std::sort(order->begin(), order->end());
+}
+
+// Return the lowest, or if LAST the highest, number of the patterns
+// which match NAME, or -1.
+
+int
+Glob_index::find_match(const char* name, bool last) const
+{
+  if (this->patterns_.empty())
+    return -1;
+
+  size_t len = strlen(name);
+  std::vector<std::pair<unsigned int, unsigned int> > order;
+  this->find_candidates(name, len, &order);
+
+  size_t count = order.size();
+  for (size_t i = 0; i < count; ++i)
+    {
+      const std::pair<unsigned int, unsigned int>& c(last
+						      ? order[count - i - 1]
+						      : order[i]);
+      if (this->pattern_matches(c.second, name, len))
+	return c.first;
+    }
+  return -1;
+}
+
 // Helper class that calls cplus_demangle when needed and takes care of freeing
 // the result.
 
@@ -1999,7 +2184,10 @@ Version_script_info::Version_script_info()
     default_version_(NULL), default_is_global_(false), is_finalized_(false)
 {
   for (int i = 0; i < LANGUAGE_COUNT; ++i)
-    this->exact_[i] = NULL;
+    {
+      this->exact_[i] = NULL;
+      this->glob_index_[i] = NULL;
+    }
 }
 
 Version_script_info::~Version_script_info()
@@ -2271,6 +2459,10 @@ Version_script_info::build_expression_list_lookup(
 	{
 	  if (this->unquote(&pattern))
 	    {
+	      if (this->glob_index_[exp.language] == NULL)
+		this->glob_index_[exp.language] = new Glob_index(FNM_NOESCAPE);
+	      this->glob_index_[exp.language]->add(exp.pattern,
+						   this->globs_.size());
 	      this->globs_.push_back(Glob(&exp, v, is_global));
 	      continue;
 	    }
@@ -2305,16 +2497,14 @@ Version_script_info::get_name_to_match(const char* name,
     }
 }
 
-// Look up SYMBOL_NAME in the list of versions.  Return true if the
-// symbol is found, false if not.  If the symbol is found, then if
-// PVERSION is not NULL, set *PVERSION to the version tag, and if
-// P_IS_GLOBAL is not NULL, set *P_IS_GLOBAL according to whether the
-// symbol is global or not.
+// Match SYMBOL_NAME against the version script, setting *MATCH.  The
+// name is demangled at most once for each language.  This may be
+// called by several threads at once: it does not change anything,
+// and it does not issue any warnings.
 
-bool
-Version_script_info::get_symbol_version(const char* symbol_name,
-					std::string* pversion,
-					bool* p_is_global) const
+void
+Version_script_info::match_symbol(const char* symbol_name,
+				  Symbol_match* match) const
 {
   Lazy_demangler cpp_demangled_name(symbol_name, DMGL_ANSI | DMGL_PARAMS);
   Lazy_demangler java_demangled_name(symbol_name,
@@ -2342,53 +2532,89 @@ Version_script_info::get_symbol_version(const char* symbol_name,
       if (pe != exact->end())
 	{
 	  const Version_tree_match& vtm(pe->second);
-	  if (vtm.ambiguous != NULL)
-	    gold_warning(_("using '%s' as version for '%s' which is also "
-			   "named in version '%s' in script"),
-			 vtm.real->tag.c_str(), name_to_match,
-			 vtm.ambiguous->tag.c_str());
-
-	  if (pversion != NULL)
-	    *pversion = vtm.real->tag;
-	  if (p_is_global != NULL)
-	    *p_is_global = vtm.is_global;
-
-	  // If we are using --no-undefined-version, and this is a
-	  // global symbol, we have to record that we have found this
-	  // symbol, so that we don't warn about it.  We have to do
-	  // this now, because otherwise we have no way to get from a
-	  // non-C language back to the demangled name that we
-	  // matched.
-	  if (p_is_global != NULL && vtm.is_global)
-	    vtm.expression->was_matched_by_symbol = true;
-
-	  return true;
+	  match->version = vtm.real;
+	  match->is_global = vtm.is_global;
+	  match->expression = vtm.expression;
+	  match->ambiguous = vtm.ambiguous;
+	  return;
 	}
     }
 
-  // Look through the glob patterns in reverse order.
+  // The last glob pattern which matches wins.  Each language has its
+  // own index, so we take the highest numbered match of any of them.
 
-  for (Globs::const_reverse_iterator p = this->globs_.rbegin();
-       p != this->globs_.rend();
-       ++p)
+  int glob = -1;
+  for (int i = 0; i < LANGUAGE_COUNT; ++i)
     {
-      int language = p->expression->language;
-      const char* name_to_match = this->get_name_to_match(symbol_name,
-							  language,
+      const Glob_index* index = this->glob_index_[i];
+      if (index == NULL)
+	continue;
+
+      const char* name_to_match = this->get_name_to_match(symbol_name, i,
 							  &cpp_demangled_name,
 							  &java_demangled_name);
       if (name_to_match == NULL)
 	continue;
 
-      if (fnmatch(p->expression->pattern.c_str(), name_to_match,
-		  FNM_NOESCAPE) == 0)
+      glob = std::max(glob, index->last_match(name_to_match));
+    }
+
+  if (glob >= 0)
+    {
+      const Glob& g(this->globs_[glob]);
+      match->version = g.version;
+      match->is_global = g.is_global;
+    }
+}
+
+// Look up SYMBOL_NAME in the list of versions, given MATCH, which
+// match_symbol set for it.  Return true if the symbol is found, false
+// if not.  If the symbol is found, then if PVERSION is not NULL, set
+// *PVERSION to the version tag, and if P_IS_GLOBAL is not NULL, set
+// *P_IS_GLOBAL according to whether the symbol is global or not.
+
+bool
+Version_script_info::get_symbol_version(const char* symbol_name,
+					const Symbol_match& match,
+					std::string* pversion,
+					bool* p_is_global) const
+{
+  if (match.version != NULL)
+    {
+      if (match.ambiguous != NULL)
 	{
-	  if (pversion != NULL)
-	    *pversion = p->version->tag;
-	  if (p_is_global != NULL)
-	    *p_is_global = p->is_global;
-	  return true;
+	  Lazy_demangler cpp_demangled_name(symbol_name,
+					    DMGL_ANSI | DMGL_PARAMS);
+	  Lazy_demangler java_demangled_name(symbol_name,
+					     (DMGL_ANSI | DMGL_PARAMS
+					      | DMGL_JAVA));
+	  const char* name_to_match =
+	    this->get_name_to_match(symbol_name, match.expression->language,
+				    &cpp_demangled_name,
+				    &java_demangled_name);
+	  gold_warning(_("using '%s' as version for '%s' which is also "
+			 "named in version '%s' in script"),
+		       match.version->tag.c_str(), name_to_match,
+		       match.ambiguous->tag.c_str());
 	}
+
+      if (pversion != NULL)
+	*pversion = match.version->tag;
+      if (p_is_global != NULL)
+	*p_is_global = match.is_global;
+
+      // If we are using --no-undefined-version, and this is a global
+      // symbol which we matched exactly, we have to record that we
+      // have found this symbol, so that we don't warn about it.  We
+      // have to do this now, because otherwise we have no way to get
+      // from a non-C language back to the demangled name that we
+      // matched.
+      if (p_is_global != NULL
+	  && match.is_global
+	  && match.expression != NULL)
+	match.expression->was_matched_by_symbol = true;
+
+      return true;
     }
 
   // Finally, there may be a wildcard.
@@ -136,6 +136,157 @@ class Expression
 };
 
 
+// Glob_index finds which of many glob patterns match a name, without
+// calling fnmatch for each pattern in turn.  Each pattern is added
+// with a number.  The index keeps the patterns in tries keyed by the
+// literal text at the start of the pattern, or, for patterns which
+// start with a wildcard, at the end.  Only the patterns whose literal
+// text matches the name are checked with fnmatch.
+
+class Glob_index
+{
+ public:
+  // FLAGS are the flags to pass to fnmatch.
+  Glob_index(int flags);
+
+  // Add PATTERN with number ID.
+  void
+  add(const std::string& pattern, unsigned int id);
+
+  // Add NAME with number ID, to be matched exactly, as though it were
+  // a pattern with no special characters.
+  void
+  add_literal(const std::string& name, unsigned int id);
+
+  // Return whether no patterns have been added.
+  bool
+  empty() const
+  { return this->patterns_.empty(); }
+
+  // Return the lowest number of the patterns which match NAME, or -1
+  // if none do.
+  int
+  first_match(const char* name) const
+  { return this->find_match(name, false); }
+
+  // Return the highest number of the patterns which match NAME, or -1
+  // if none do.
+  int
+  last_match(const char* name) const
+  { return this->find_match(name, true); }
+
+  // Return the lowest number of the patterns which match NAME and for
+  // which ACCEPT(number) returns true, or -1 if there are none.
+  template<typename Accept>
+  int
+  first_match(const char* name, Accept accept) const;
+
+ private:
+  // How a pattern is matched once its literal prefix has matched.
+  enum Pattern_kind
+  {
+    // The pattern has no wildcards.
+    PATTERN_EXACT,
+    // The pattern is a literal prefix followed by a single '*'.
+    PATTERN_PREFIX,
+    // Anything else, which needs fnmatch.
+    PATTERN_GLOB
+  };
+
+  struct Pattern
+  {
+    Pattern(const std::string& p, unsigned int i, Pattern_kind k,
+	    size_t plen, size_t slen)
+      : pattern(p), id(i), kind(k), prefix_len(plen), suffix_len(slen)
+    { }
+
+    std::string pattern;
+    unsigned int id;
+    Pattern_kind kind;
+    // The length of the literal text at the start of the pattern.
+    size_t prefix_len;
+    // The length of the literal text at the end of the pattern.
+    size_t suffix_len;
+  };
+
+  // A node in a trie.  The node for a string holds the indexes in
+  // patterns_ of the patterns whose key is that string.
+  struct Trie_node
+  {
+    Trie_node()
+      : children(), patterns()
+    { }
+
+    // The child nodes, sorted by character.
+    std::vector<std::pair<unsigned char, unsigned int> > children;
+    std::vector<unsigned int> patterns;
+  };
+
+  typedef std::vector<Trie_node> Trie;
+
+  // Add the pattern with index INDEX in patterns_ to TRIE, under the
+  // LEN characters at KEY, which are read backward if REVERSE.
+  static void
+  add_to_trie(Trie* trie, const char* key, size_t len, bool reverse,
+	      unsigned int index);
+
+  // Add to *CANDIDATES the patterns in TRIE whose keys are prefixes
+  // of the LEN characters at NAME, read backward if REVERSE.
+  static void
+  find_in_trie(const Trie& trie, const char* name, size_t len, bool reverse,
+	       std::vector<unsigned int>* candidates);
+
+  // Return whether the pattern at index INDEX in patterns_ matches
+  // NAME, of length LEN, given that its literal prefix or suffix
+  // does.
+  bool
+  pattern_matches(unsigned int index, const char* name, size_t len) const;
+
+  // Set *ORDER to the number and index of each pattern whose literal
+  // text matches NAME, of length LEN, sorted by number.
+  void
+  find_candidates(const char* name, size_t len,
+		  std::vector<std::pair<unsigned int, unsigned int> >* order)
+    const;
+
+  int
+  find_match(const char* name, bool last) const;
+
+  // Flags to pass to fnmatch.
+  int flags_;
+  // The patterns, in the order they were added.
+  std::vector<Pattern> patterns_;
+  // The patterns with a literal prefix, keyed by the prefix.
+  Trie prefixes_;
+  // The patterns with no literal prefix but a literal suffix, keyed
+  // by the reversed suffix.
+  Trie suffixes_;
+  // The patterns with neither.
+  std::vector<unsigned int> others_;
+};
+
+template<typename Accept>
+int
+Glob_index::first_match(const char* name, Accept accept) const
+{
+  if (this->patterns_.empty())
+    return -1;
+
+  size_t len = strlen(name);
+  std::vector<std::pair<unsigned int, unsigned int> > order;
+  this->find_candidates(name, len, &order);
+  for (std::vector<std::pair<unsigned int, unsigned int> >::const_iterator p =
+	 order.begin();
+       p != order.end();
+       ++p)
+    {
+      if (this->pattern_matches(p->second, name, len) && accept(p->first))
+	return p->first;
+    }
+  return -1;
+}
+
+
 // Version_script_info stores information parsed from the version
 // script, either provided by --version-script or as part of a linker
 // script.  A single Version_script_info object per target is owned by
@@ -175,12 +326,48 @@ class Version_script_info
   empty() const
   { return this->version_trees_.empty(); }
 
+  // The result of matching a symbol name against the version script,
+  // from match_symbol.
+  struct Symbol_match
+  {
+    Symbol_match()
+      : version(NULL), is_global(false), expression(NULL), ambiguous(NULL)
+    { }
+
+    // The Version_tree of the exact or glob pattern which matched, or
+    // NULL if none did.
+    const Version_tree* version;
+    // True if this is a global match.
+    bool is_global;
+    // For an exact match, the Version_expression which matched.
+    const Version_expression* expression;
+    // For an exact match, another Version_tree which names the symbol,
+    // or NULL.
+    const Version_tree* ambiguous;
+  };
+
+  // Match SYMBOL against the version script, setting *MATCH.  This
+  // has no side effects, so that it may be called by several threads
+  // at once, ahead of get_symbol_version.
+  void
+  match_symbol(const char* symbol, Symbol_match* match) const;
+
   // If there is a version associated with SYMBOL, return true, and
   // set *VERSION to the version, and *IS_GLOBAL to whether the symbol
   // should be global.  Otherwise, return false.
   bool
   get_symbol_version(const char* symbol, std::string* version,
-		     bool* is_global) const;
+		     bool* is_global) const
+  {
+    Symbol_match match;
+    this->match_symbol(symbol, &match);
+    return this->get_symbol_version(symbol, match, version, is_global);
+  }
+
+  // Likewise, using MATCH, which match_symbol set for SYMBOL.
+  bool
+  get_symbol_version(const char* symbol, const Symbol_match& match,
+		     std::string* version, bool* is_global) const;
 
   // Return whether this symbol matches the local: section of some
   // version.
@@ -312,6 +499,9 @@ class Version_script_info
   Exact* exact_[LANGUAGE_COUNT];
   // A vector of glob patterns mapping to Version_trees.
   Globs globs_;
+  // Indexes of the glob patterns, by language.  The pattern numbers
+  // are indexes in globs_.
+  Glob_index* glob_index_[LANGUAGE_COUNT];
   // The default version to use, if there is one.  This is from a
   // pattern of "*".
   const Version_tree* default_version_;
@@ -237,10 +237,11 @@ Stringpool_template<Stringpool_char>::new_key_offset(size_t length)
 
 template<typename Stringpool_char>
 const Stringpool_char*
-Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
-						      size_t length,
-						      bool copy,
-						      Key* pkey)
+Stringpool_template<Stringpool_char>::add_prehashed(const Stringpool_char* s,
+						    size_t length,
+						    size_t hash_code,
+						    bool copy,
+						    Key* pkey)
 {
   typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
 
@@ -252,7 +253,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
       // When we don't need to copy the string, we can call insert
       // directly.
 
-      std::pair<Hashkey, Hashval> element(Hashkey(s, length), k);
+      std::pair<Hashkey, Hashval> element(Hashkey(s, length, hash_code), k);
 
       Insert_type ins = this->string_set_.insert(element);
 
@@ -279,7 +280,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
+  Hashkey hk(s, length, hash_code);
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p != this->string_set_.end())
     {
@@ -304,6 +305,37 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   return hk.string;
 }
 
+// Merge the strings in POOL into this pool.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::merge(Stringpool_template* pool)
+{
+  gold_assert(pool != this && pool->strtab_size_ == 0);
+
+  // The keys of POOL record the order in which its strings were
+  // added.
+  std::vector<const Hashkey*> hashkeys(pool->key_to_offset_.size());
+  for (typename String_set_type::const_iterator p = pool->string_set_.begin();
+       p != pool->string_set_.end();
+       ++p)
+    hashkeys[p->second - 1] = &p->first;
+
+  // The strings need not be copied, since we take over POOL's
+  // copies below.
+  for (typename std::vector<const Hashkey*>::const_iterator p =
+	 hashkeys.begin();
+       p != hashkeys.end();
+       ++p)
+    this->add_prehashed((*p)->string, (*p)->length, (*p)->hash_code, false,
+			NULL);
+
+  // Keep the first buffer at the front, since add_string copies new
+  // strings into it.
+  this->strings_.splice(this->strings_.end(), pool->strings_);
+  pool->clear();
+}
+
 template<typename Stringpool_char>
 const Stringpool_char*
 Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
@@ -227,7 +227,32 @@ class Stringpool_template
   // Add string S of length LEN characters to the pool.  If COPY is
   // true, S need not be null terminated.
   const Stringpool_char*
-  add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
+  add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey)
+  {
+    return this->add_prehashed(s, len, string_hash(s, len), copy, pkey);
+  }
+
+  // Compute a hash code for a string.  LENGTH is the length of the
+  // string in characters.
+  static size_t
+  string_hash(const Stringpool_char*, size_t length);
+
+  // Add string S of length LEN characters to the pool, where
+  // HASH_CODE is the value that gold::string_hash returns for S.
+  // This permits the caller to compute the hash code ahead of time,
+  // possibly in a different thread.
+  const Stringpool_char*
+  add_prehashed(const Stringpool_char* s, size_t len, size_t hash_code,
+		bool copy, Key* pkey);
+
+  // Add all the strings in POOL to this pool, in the order in which
+  // they were added to POOL, and take over POOL's copies of the
+  // strings.  The string offsets are the same as if the strings had
+  // been added to this pool directly, so pools built independently,
+  // possibly in different threads, can be merged in a deterministic
+  // order.  POOL is left empty.
+  void
+  merge(Stringpool_template* pool);
 
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
@@ -297,11 +322,6 @@ class Stringpool_template
   static bool
   string_equal(const Stringpool_char*, const Stringpool_char*);
 
-  // Compute a hash code for a string.  LENGTH is the length of the
-  // string in characters.
-  static size_t
-  string_hash(const Stringpool_char*, size_t length);
-
   // We store the actual data in a list of these buffers.
   struct Stringdata
   {
@@ -353,6 +373,10 @@ class Stringpool_template
     Hashkey(const Stringpool_char* s, size_t len)
       : string(s), length(len), hash_code(string_hash(s, len))
     { }
+
+    Hashkey(const Stringpool_char* s, size_t len, size_t hash)
+      : string(s), length(len), hash_code(hash)
+    { }
   };
 
   // Hash function.  This is trivial, since we have already computed
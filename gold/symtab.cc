@@ -1157,6 +1157,8 @@ Symbol_table::add_from_relobj(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
+    const Version_script_info::Symbol_match* version_matches,
     typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
     size_t* defined)
 {
@@ -1218,7 +1220,13 @@ Symbol_table::add_from_relobj(
       // In an object file, an '@' in the name separates the symbol
       // name from the version name.  If there are two '@' characters,
       // this is the default version.
-      const char* ver = strchr(name, '@');
+      const char* ver;
+      if (name_hashes == NULL)
+	ver = strchr(name, '@');
+      else if (name[name_hashes[i].length] == '@')
+	ver = name + name_hashes[i].length;
+      else
+	ver = NULL;
       Stringpool::Key ver_key = 0;
       int namelen = 0;
       // IS_DEFAULT_VERSION: is the version default?
@@ -1251,7 +1259,7 @@ Symbol_table::add_from_relobj(
       // about a common symbol?
       else
 	{
-	  namelen = strlen(name);
+	  namelen = name_hashes != NULL ? name_hashes[i].length : strlen(name);
 	  if (!this->version_script_.empty()
 	      && st_shndx != elfcpp::SHN_UNDEF)
 	    {
@@ -1259,8 +1267,15 @@ Symbol_table::add_from_relobj(
 	      // version script may assign a version anyway.
 	      std::string version;
 	      bool is_global;
-	      if (this->version_script_.get_symbol_version(name, &version,
-							   &is_global))
+	      bool found;
+	      if (version_matches != NULL)
+		found = this->version_script_.get_symbol_version(
+		    name, version_matches[i], &version, &is_global);
+	      else
+		found = this->version_script_.get_symbol_version(name,
+								 &version,
+								 &is_global);
+	      if (found)
 		{
 		  if (!is_global)
 		    is_forced_local = true;
@@ -1323,8 +1338,13 @@ Symbol_table::add_from_relobj(
         }
 
       Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+      if (name_hashes != NULL)
+	name = this->namepool_.add_prehashed(name, namelen,
+					     name_hashes[i].hash_code,
+					     true, &name_key);
+      else
+	name = this->namepool_.add_with_length(name, namelen, true,
+					       &name_key);
 
       Sized_symbol<size>* res;
       res = this->add_from_object(relobj, name, name_key, ver, ver_key,
@@ -3703,6 +3723,8 @@ Symbol_table::add_from_relobj<32, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
+    const Version_script_info::Symbol_match* version_matches,
     Sized_relobj_file<32, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3717,6 +3739,8 @@ Symbol_table::add_from_relobj<32, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
+    const Version_script_info::Symbol_match* version_matches,
     Sized_relobj_file<32, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3731,6 +3755,8 @@ Symbol_table::add_from_relobj<64, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
+    const Version_script_info::Symbol_match* version_matches,
     Sized_relobj_file<64, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3745,6 +3771,8 @@ Symbol_table::add_from_relobj<64, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
+    const Version_script_info::Symbol_match* version_matches,
     Sized_relobj_file<64, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -21,10 +21,15 @@
 // MA 02110-1301, USA.
 
 #include "gold.h"
+
+#include <list>
+
 #include "elfcpp.h"
 #include "dynobj.h"
 #include "symtab.h"
 #include "output.h"
+#include "layout.h"
+#include "workqueue.h"
 #include "target.h"
 
 namespace gold
@@ -214,6 +219,208 @@ Target::do_plt_fde_location(const Output_data* plt, unsigned char*,
   *len = plt->data_size();
 }
 
+// The state shared by the threads scanning objects for relaxation.
+// The objects are put into groups, one for each input file, since
+// objects in the same archive may not be locked by two threads at
+// once.  The task which called Target::scan_relobjs_for_relax and the
+// Relax_scan_tasks each take the next group to scan until there are
+// none left.  The caller then waits for the groups which other tasks
+// are still scanning.  Since a Relax_scan_task may not start running
+// until the caller has returned, the last user frees this.
+
+class Relax_scan_state
+{
+ public:
+  Relax_scan_state(Relax_scan_runner* runner)
+    : runner_(runner), groups_(), next_(), active_(0), refcount_(1),
+      lock_(), condvar_(lock_)
+  { }
+
+  // Add a new group of objects, returning it.
+  std::vector<Relobj*>*
+  add_group()
+  {
+    this->groups_.push_back(std::vector<Relobj*>());
+    return &this->groups_.back();
+  }
+
+  // Start scanning, with HELPERS more tasks using this.
+  void
+  start(int helpers)
+  {
+    this->next_ = this->groups_.begin();
+    this->refcount_ += helpers;
+  }
+
+  // Scan groups of objects until there are none left.
+  void
+  scan(const Task* task);
+
+  // Wait until all the groups have been scanned.
+  void
+  wait();
+
+  // Drop a reference, freeing this if it was the last one.
+  void
+  release();
+
+ private:
+  Relax_scan_runner* runner_;
+  // The groups of objects.  This is a list so that add_group can
+  // return a stable pointer.
+  std::list<std::vector<Relobj*> > groups_;
+  // The next group to scan.
+  std::list<std::vector<Relobj*> >::iterator next_;
+  // The number of groups which are being scanned.
+  int active_;
+  // The number of tasks using this.
+  int refcount_;
+  // Protects the fields above, once scanning has started.
+  Lock lock_;
+  // Signalled when the last group has been scanned.
+  Condvar condvar_;
+};
+
+void
+Relax_scan_state::scan(const Task* task)
+{
+  while (true)
+    {
+      std::vector<Relobj*>* group;
+      {
+	Hold_lock hl(this->lock_);
+	if (this->next_ == this->groups_.end())
+	  return;
+	group = &*this->next_;
+	++this->next_;
+	++this->active_;
+      }
+
+      for (std::vector<Relobj*>::const_iterator p = group->begin();
+	   p != group->end();
+	   ++p)
+	{
+	  Task_lock_obj<Object> tl(task, *p);
+	  this->runner_->scan(*p, task);
+	}
+
+      {
+	Hold_lock hl(this->lock_);
+	--this->active_;
+	if (this->active_ == 0 && this->next_ == this->groups_.end())
+	  this->condvar_.broadcast();
+      }
+    }
+}
+
+void
+Relax_scan_state::wait()
+{
+  Hold_lock hl(this->lock_);
+  while (this->active_ > 0 || this->next_ != this->groups_.end())
+    this->condvar_.wait();
+}
+
+void
+Relax_scan_state::release()
+{
+  bool last;
+  {
+    Hold_lock hl(this->lock_);
+    --this->refcount_;
+    last = this->refcount_ == 0;
+  }
+  if (last)
+    delete this;
+}
+
+// A task which helps to scan objects for relaxation.
+
+class Relax_scan_task : public Task
+{
+ public:
+  Relax_scan_task(Relax_scan_state* state)
+    : state_(state)
+  { }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*)
+  {
+    this->state_->scan(this);
+    this->state_->release();
+  }
+
+  std::string
+  get_name() const
+  { return "Relax_scan_task"; }
+
+ private:
+  Relax_scan_state* state_;
+};
+
+// Scan the objects in INPUT_OBJECTS for relaxation.
+
+void
+Target::scan_relobjs_for_relax(const Input_objects* input_objects,
+			       Layout* layout, Relax_scan_runner* runner,
+			       Workqueue* workqueue, const Task* task)
+{
+  if (workqueue == NULL || input_objects->number_of_relobjs() < 2)
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	{
+	  // Lock the object so we can read from it.  This is only
+	  // called single-threaded from Layout::finalize, so it is OK
+	  // to lock.
+	  Task_lock_obj<Object> tl(task, *p);
+	  runner->scan(*p, task);
+	}
+      return;
+    }
+
+  // The maps used to find input sections are built on first use;
+  // build them now, before several threads use them.
+  for (Layout::Section_list::const_iterator p = layout->section_list().begin();
+       p != layout->section_list().end();
+       ++p)
+    (*p)->build_lookup_maps_if_needed();
+
+  Relax_scan_state* state = new Relax_scan_state(runner);
+  Unordered_map<const Task_token*, std::vector<Relobj*>*> groups;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      std::vector<Relobj*>*& group = groups[(*p)->token()];
+      if (group == NULL)
+	group = state->add_group();
+      group->push_back(*p);
+    }
+
+  // Use as many tasks as there are threads, if that was specified;
+  // otherwise one for each group, as for the other middle tasks.
+  int helpers = parameters->options().thread_count_middle() - 1;
+  if (helpers < 0 || static_cast<size_t>(helpers) >= groups.size())
+    helpers = groups.size() - 1;
+  state->start(helpers);
+  for (int i = 0; i < helpers; ++i)
+    workqueue->queue_soon(new Relax_scan_task(state));
+
+  state->scan(task);
+  state->wait();
+  state->release();
+}
+
 // Class Sized_target.
 
 // Set the EI_OSABI field of the ELF header if requested.
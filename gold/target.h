@@ -60,10 +60,27 @@ class Output_data;
 class Output_data_got_base;
 class Output_section;
 class Input_objects;
+class Layout;
 class Task;
+class Workqueue;
 struct Symbol_location;
 class Versions;
 
+// An interface used by Target::scan_relobjs_for_relax.
+
+class Relax_scan_runner
+{
+ public:
+  virtual
+  ~Relax_scan_runner()
+  { }
+
+  // Scan OBJECT.  The object has been locked by TASK.  This may be
+  // called by several threads at once, for different objects.
+  virtual void
+  scan(Relobj* object, const Task* task) = 0;
+};
+
 // The abstract class for target specific handling.
 
 class Target
@@ -310,6 +327,23 @@ class Target
   can_check_for_function_pointers() const
   { return this->do_can_check_for_function_pointers(); }
 
+  // Return whether the Gc_process_relocs tasks for different objects
+  // may run at the same time when only garbage collecting.  This is
+  // true unless processing the relocations of one object may change
+  // another object.
+  bool
+  may_gc_process_relocs_in_parallel() const
+  { return this->do_may_gc_process_relocs_in_parallel(); }
+
+  // Return whether the relocations for a single section may be split
+  // into ranges which are applied by different tasks.  This is only
+  // true if applying a relocation depends on no state left behind by
+  // earlier relocations, other than that left by a relocation against
+  // a TLS symbol for the relocation which immediately follows it.
+  bool
+  may_split_relocs() const
+  { return this->do_may_split_relocs(); }
+
   // Return whether a relocation to a merged section can be processed
   // to retrieve the contents.
   bool
@@ -384,15 +418,18 @@ class Target
   }
 
   // Perform a relaxation pass.  Return true if layout may be changed.
+  // WORKQUEUE may be used to scan objects in parallel; it is NULL if
+  // we are not using threads.
   bool
   relax(int pass, const Input_objects* input_objects, Symbol_table* symtab,
-	Layout* layout, const Task* task)
+	Layout* layout, Workqueue* workqueue, const Task* task)
   {
     // Run the dummy relaxation pass twice if relaxation debugging is enabled.
     if (is_debugging_enabled(DEBUG_RELAXATION))
       return pass < 2;
 
-    return this->do_relax(pass, input_objects, symtab, layout, task);
+    return this->do_relax(pass, input_objects, symtab, layout, workqueue,
+			  task);
   }
 
   // Return the target-specific name of attributes section.  This is
@@ -650,6 +687,16 @@ class Target
   do_can_check_for_function_pointers() const
   { return false; }
 
+  // Virtual function which may be overridden by the child class.
+  virtual bool
+  do_may_gc_process_relocs_in_parallel() const
+  { return true; }
+
+  // Virtual function which may be overridden by the child class.
+  virtual bool
+  do_may_split_relocs() const
+  { return false; }
+
   // Virtual function which may be overridden by the child class.  We
   // recognize some default sections for which we don't care whether
   // they have function pointers.
@@ -734,9 +781,20 @@ class Target
 
   // Virtual function which may be overridden by the child class.
   virtual bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*)
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*)
   { return false; }
 
+  // A function for targets to call while relaxing.  Call RUNNER->scan
+  // for each relocatable object in INPUT_OBJECTS.  If WORKQUEUE is
+  // not NULL, objects in different files are scanned in parallel, by
+  // TASK and by tasks queued on WORKQUEUE.  This returns when all the
+  // objects have been scanned.
+  void
+  scan_relobjs_for_relax(const Input_objects* input_objects, Layout* layout,
+			 Relax_scan_runner* runner, Workqueue* workqueue,
+			 const Task* task);
+
   // A function for targets to call.  Return whether BYTES/LEN matches
   // VIEW/VIEW_SIZE at OFFSET.
   bool
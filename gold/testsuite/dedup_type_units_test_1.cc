@@ -0,0 +1,32 @@
+// dedup_type_units_test_1.cc -- a test case for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// Both source files use the same types, so with -fdebug-types-section
+// each object has a type unit for each of them.  Check that
+// --dedup-type-units keeps only one copy of each.
+
+#include "dedup_type_units_test.h"
+
+int
+f(T* t)
+{
+  return t->k + t->s[0].a;
+}
@@ -0,0 +1,33 @@
+// eh_frame_hdr_sort_test.c -- a test case for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// This program has enough FDEs that gold sorts the .eh_frame_hdr
+// table in several chunks when using threads.  It uses a generated .h
+// file to define 70,000 functions, alternating between .text and
+// another section.
+
+#include "eh_frame_hdr_sort_define.h"
+
+int
+main (void)
+{
+  return 0;
+}
@@ -0,0 +1,67 @@
+/* gc_mark_test.c -- a test case for gold
+
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   The table refers to enough functions, each in its own section, that
+   with --gc-sections and threads gold follows the references from
+   them using several tasks.  Check that every referenced function is
+   kept and that the unreferenced ones are collected.  */
+
+#define K0(p) keep_##p,
+#define K1(p) K0(p##0) K0(p##1) K0(p##2) K0(p##3) K0(p##4) \
+  K0(p##5) K0(p##6) K0(p##7) K0(p##8) K0(p##9)
+#define K2(p) K1(p##0) K1(p##1) K1(p##2) K1(p##3) K1(p##4) \
+  K1(p##5) K1(p##6) K1(p##7) K1(p##8) K1(p##9)
+#define K3(p) K2(p##0) K2(p##1) K2(p##2) K2(p##3) K2(p##4) \
+  K2(p##5) K2(p##6) K2(p##7) K2(p##8) K2(p##9)
+#define K4(p) K3(p##0) K3(p##1) K3(p##2) K3(p##3) K3(p##4) \
+  K3(p##5) K3(p##6) K3(p##7) K3(p##8) K3(p##9)
+
+#define D0(p) int keep_##p (void); int keep_##p (void) { return 1; }
+#define D1(p) D0(p##0) D0(p##1) D0(p##2) D0(p##3) D0(p##4) \
+  D0(p##5) D0(p##6) D0(p##7) D0(p##8) D0(p##9)
+#define D2(p) D1(p##0) D1(p##1) D1(p##2) D1(p##3) D1(p##4) \
+  D1(p##5) D1(p##6) D1(p##7) D1(p##8) D1(p##9)
+#define D3(p) D2(p##0) D2(p##1) D2(p##2) D2(p##3) D2(p##4) \
+  D2(p##5) D2(p##6) D2(p##7) D2(p##8) D2(p##9)
+#define D4(p) D3(p##0) D3(p##1) D3(p##2) D3(p##3) D3(p##4) \
+  D3(p##5) D3(p##6) D3(p##7) D3(p##8) D3(p##9)
+
+D4(_)
+
+int drop_1 (void);
+int drop_2 (void);
+
+int drop_1 (void) { return 0; }
+int drop_2 (void) { return drop_1 (); }
+
+int (*table[]) (void);
+int (*table[]) (void) = { K4(_) };
+
+int
+main (void)
+{
+  int sum = 0;
+  unsigned int i;
+
+  for (i = 0; i < sizeof table / sizeof table[0]; ++i)
+    sum += table[i] ();
+  return sum == 10000 ? 0 : 1;
+}
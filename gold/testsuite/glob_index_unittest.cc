@@ -0,0 +1,157 @@
+// glob_index_unittest.cc -- test Glob_index
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <fnmatch.h>
+
+#include "script.h"
+
+#include "test.h"
+
+namespace gold_testsuite
+{
+
+using namespace gold;
+
+// Return the first or last of the NPATTERNS patterns which fnmatch
+// says match NAME, or -1.
+
+static int
+slow_match(const char* const* patterns, int npatterns, const char* name,
+	   int flags, bool last)
+{
+  int ret = -1;
+  for (int i = 0; i < npatterns; ++i)
+    {
+      if (fnmatch(patterns[i], name, flags) == 0)
+	{
+	  ret = i;
+	  if (!last)
+	    break;
+	}
+    }
+  return ret;
+}
+
+// Accept the pattern numbers which are at least MIN.
+
+class Accept_at_least
+{
+ public:
+  Accept_at_least(unsigned int min)
+    : min_(min)
+  { }
+
+  bool
+  operator()(unsigned int id) const
+  { return id >= this->min_; }
+
+ private:
+  unsigned int min_;
+};
+
+bool
+Glob_index_test(Test_report*)
+{
+  static const char* const patterns[] =
+  {
+    "foo",
+    "foo*",
+    "*bar",
+    "f?o*",
+    "*",
+    "[a-c]*x",
+    "_ZN3foo*",
+    "*foo*",
+    "foo\\*",
+    "",
+    "foobar",
+    "*[xyz]",
+    "b*r",
+    ".text.*",
+    ".text.hot.*",
+    "*.o",
+  };
+  static const char* const names[] =
+  {
+    "", "foo", "foobar", "fob", "f", "fo", "bar", "xbar", "abx", "cx",
+    "_ZN3foo3barEv", "afoob", "foo*", "foo\\*", "z", "br", "bxr",
+    ".text", ".text.hot", ".text.hot.f", ".text.unlikely.g", "a.o",
+  };
+  const int npatterns = sizeof(patterns) / sizeof(patterns[0]);
+  const int nnames = sizeof(names) / sizeof(names[0]);
+
+  static const int flags[] = { 0, FNM_NOESCAPE };
+  for (int f = 0; f < 2; ++f)
+    {
+      // Try every prefix of the pattern list, so that each pattern is
+      // the last one in some index.
+      for (int n = 0; n <= npatterns; ++n)
+	{
+	  Glob_index index(flags[f]);
+	  for (int i = 0; i < n; ++i)
+	    index.add(patterns[i], i);
+	  CHECK(index.empty() == (n == 0));
+	  for (int j = 0; j < nnames; ++j)
+	    {
+	      CHECK(index.first_match(names[j])
+		    == slow_match(patterns, n, names[j], flags[f], false));
+	      CHECK(index.last_match(names[j])
+		    == slow_match(patterns, n, names[j], flags[f], true));
+	    }
+	}
+    }
+
+  // The numbers need not be in the order the patterns are added.
+  Glob_index index(0);
+  index.add("a*", 7);
+  index.add("*b", 3);
+  index.add("ab", 5);
+  CHECK(index.first_match("ab") == 3);
+  CHECK(index.last_match("ab") == 7);
+  CHECK(index.first_match("ac") == 7);
+  CHECK(index.first_match("cb") == 3);
+  CHECK(index.first_match("c") == -1);
+
+  // A literal is compared with strcmp, so a backslash is not special.
+  Glob_index literals(0);
+  literals.add_literal("a\\b", 1);
+  literals.add("a*", 2);
+  literals.add_literal("", 3);
+  literals.add("*", 4);
+  CHECK(literals.first_match("a\\b") == 1);
+  CHECK(literals.first_match("ab") == 2);
+  CHECK(literals.first_match("") == 3);
+  CHECK(literals.first_match("b") == 4);
+
+  // The accept function may pass over a pattern which matches.
+  CHECK(literals.first_match("a\\b", Accept_at_least(0)) == 1);
+  CHECK(literals.first_match("a\\b", Accept_at_least(2)) == 2);
+  CHECK(literals.first_match("", Accept_at_least(4)) == 4);
+  CHECK(literals.first_match("ab", Accept_at_least(5)) == -1);
+
+  return true;
+}
+
+Register_test glob_index_register("Glob_index", Glob_index_test);
+
+} // End namespace gold_testsuite.
@@ -0,0 +1,236 @@
+#!/bin/sh
+
+# link_benchmark.sh -- measure how long gold takes to link
+# synthetic programs
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This script is run by "make check-perf".  It is not part of "make
+# check", since it only measures gold and checks nothing.
+
+# It generates a synthetic program, links it with gold using several
+# sets of options, and writes one JSON object per link to the output
+# file, as a JSON array.  Each object gives the size of the workload,
+# the options, the run times of gold's initial, middle and final task
+# phases and of the whole link as reported by --stats, the peak
+# resident set size, and the size of the output file.
+
+# The workload is controlled by these environment variables:
+#   BENCH_OBJECTS	number of object files (default 64)
+#   BENCH_SYMBOLS	global functions in each object (default 256)
+#   BENCH_SECTIONS	sections in each object; the functions are
+#			spread over them (default 64)
+#   BENCH_DEBUG		struct types in the debug info of each
+#			object (default 32)
+#   BENCH_ARCHIVES	archive depth: the objects after the first
+#			are put in this many archives, each of which
+#			is only needed by the one before it (default 2)
+#   BENCH_RUNS		times to run each link (default 3)
+#   BENCH_OPTIONS	the option sets to try, separated by ';'
+# and these give the tools to use:
+#   CC, AR		the compiler and archiver (default cc, ar)
+#   GOLD		the linker to measure (default ../ld-new)
+#   BENCH_DIR		the scratch directory (default link_benchmark.dir)
+#   BENCH_OUTPUT	the JSON file to write (default link_benchmark.json)
+
+objects=${BENCH_OBJECTS:-64}
+symbols=${BENCH_SYMBOLS:-256}
+sections=${BENCH_SECTIONS:-64}
+debug=${BENCH_DEBUG:-32}
+archives=${BENCH_ARCHIVES:-2}
+runs=${BENCH_RUNS:-3}
+options=${BENCH_OPTIONS:-"--no-threads;--threads;--threads --icf=all;--threads --gc-sections;--threads --gdb-index;--threads --compress-debug-sections=zlib"}
+cc=${CC:-cc}
+ar=${AR:-ar}
+gold=${GOLD:-../ld-new}
+dir=${BENCH_DIR:-link_benchmark.dir}
+output=${BENCH_OUTPUT:-link_benchmark.json}
+
+case "$gold" in
+/*) ;;
+*) gold=`pwd`/$gold ;;
+esac
+
+if test "$archives" -ge "$objects"; then
+  echo "BENCH_ARCHIVES must be less than BENCH_OBJECTS" 1>&2
+  exit 1
+fi
+
+rm -rf "$dir"
+mkdir "$dir" || exit 1
+cd "$dir" || exit 1
+
+# Write the source of object I.  Most functions are in the sections
+# .text.bench_S, where S is the function number modulo the section
+# count, and call the first function in the next object, so that
+# every object is needed.  Some functions are in sections of their
+# own: those in .text.bench_icf_* are the same in every object, for
+# --icf, and those in .text.bench_unused_* are never called, for
+# --gc-sections.
+
+gen_object()
+{
+  i=$1
+  next=`expr \( $i + 1 \) % $objects`
+  {
+    t=0
+    while test $t -lt $debug; do
+      echo "struct bench_type_$t { int a; long b[$t + 1]; struct bench_type_$t *next; };"
+      echo "struct bench_type_$t bench_var_${i}_$t;"
+      t=`expr $t + 1`
+    done
+    echo "int bench_${next}_0 (int);"
+    s=0
+    while test $s -lt $symbols; do
+      echo "int bench_${i}_$s (int);"
+      s=`expr $s + 1`
+    done
+    s=0
+    while test $s -lt $symbols; do
+      sec=`expr $s % $sections`
+      icf=`expr $s + 4`
+      case `expr $s % 8` in
+      3)
+	if test $icf -lt $symbols; then
+	  body="return bench_${i}_$icf (x) + $s;"
+	else
+	  body="return x;"
+	fi
+	;;
+      5)
+	sec=unused_$s
+	body="return x - $s;"
+	;;
+      7)
+	sec=icf_$s
+	body="return x + $s;"
+	;;
+      *)
+	body="return x > 0 ? bench_${next}_0 (x - 1) + $s : 0;"
+	;;
+      esac
+      echo "int __attribute__ ((section (\".text.bench_$sec\"), noinline))"
+      echo "bench_${i}_$s (int x) { $body }"
+      s=`expr $s + 1`
+    done
+    if test $i -eq 0; then
+      echo "int main (void) { return bench_0_1 (1) & 0; }"
+      echo "void _start (void) { main (); for (;;); }"
+    fi
+  } > bench_$i.c
+}
+
+i=0
+while test $i -lt $objects; do
+  gen_object $i
+  $cc -O0 -g -ffreestanding -fno-asynchronous-unwind-tables \
+    -c -o bench_$i.o bench_$i.c || exit 1
+  i=`expr $i + 1`
+done
+
+# Put the objects after the first into archives.  Archive K holds
+# the objects which only the objects in archive K - 1 refer to, so
+# the archives must be searched in order.
+
+inputs="bench_0.o"
+if test "$archives" -gt 0; then
+  per=`expr \( $objects - 1 + $archives - 1 \) / $archives`
+  k=0
+  i=1
+  while test $i -lt $objects; do
+    members=
+    n=0
+    while test $n -lt $per -a $i -lt $objects; do
+      members="$members bench_$i.o"
+      i=`expr $i + 1`
+      n=`expr $n + 1`
+    done
+    rm -f libbench_$k.a
+    $ar rc libbench_$k.a $members || exit 1
+    inputs="$inputs libbench_$k.a"
+    k=`expr $k + 1`
+  done
+else
+  i=1
+  while test $i -lt $objects; do
+    inputs="$inputs bench_$i.o"
+    i=`expr $i + 1`
+  done
+fi
+
+# Print the seconds of TYPE (user, sys or wall) from the --stats line
+# matching PHASE in the file STATS.
+
+stat_time()
+{
+  sed -n "s/.*: $2 run time: .*$3: \([0-9.]*\).*/\1/p" "$1"
+}
+
+stat_value()
+{
+  sed -n "s/.*: $2: \([0-9]*\).*/\1/p" "$1"
+}
+
+phase_json()
+{
+  echo "{\"user\": `stat_time $1 "$2" user`, \"sys\": `stat_time $1 "$2" sys`, \"wall\": `stat_time $1 "$2" wall`}"
+}
+
+first=yes
+echo "[" > ../$output
+IFS_save=$IFS
+IFS=";"
+for opts in $options; do
+  IFS=$IFS_save
+  run=0
+  while test $run -lt $runs; do
+    if ! $gold -o bench --stats $opts $inputs 2> bench.stats; then
+      cat bench.stats 1>&2
+      exit 1
+    fi
+    rss=`stat_value bench.stats "peak resident set size"`
+    if test -z "$rss"; then
+      rss=null
+    fi
+    if test $first = no; then
+      echo "," >> ../$output
+    fi
+    first=no
+    cat >> ../$output <<EOF
+  {"objects": $objects, "symbols": $symbols, "sections": $sections,
+   "debug": $debug, "archives": $archives, "options": "$opts", "run": $run,
+   "initial": `phase_json bench.stats "initial tasks"`,
+   "middle": `phase_json bench.stats "middle tasks"`,
+   "final": `phase_json bench.stats "final tasks"`,
+   "total": `phase_json bench.stats "total"`,
+   "peak_rss_kb": $rss,
+   "output_size": `stat_value bench.stats "output file size"`}
+EOF
+    run=`expr $run + 1`
+  done
+  IFS=";"
+done
+IFS=$IFS_save
+echo "]" >> ../$output
+
+cd ..
+rm -rf "$dir"
+cat $output
+exit 0
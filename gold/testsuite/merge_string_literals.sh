@@ -39,3 +39,6 @@ check()
 
 # If string literals were merged, then "abcd" appears two times
 check merge_string_literals.stdout "abcd" 2
+
+# The same should be true when merging with threads.
+check merge_string_literals_threads.stdout "abcd" 2
@@ -0,0 +1,51 @@
+// relocate_range_test.cc -- a test case for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// The data section of this object has enough relocations that gold
+// applies them in several ranges in parallel when using threads.
+// Check that every entry is relocated correctly.
+
+#include <cassert>
+
+static int a[4];
+
+#define E(i) &a[(i) & 3]
+#define R4(i) E(i), E((i) + 1), E((i) + 2), E((i) + 3)
+#define R16(i) R4(i), R4((i) + 4), R4((i) + 8), R4((i) + 12)
+#define R64(i) R16(i), R16((i) + 16), R16((i) + 32), R16((i) + 48)
+#define R256(i) R64(i), R64((i) + 64), R64((i) + 128), R64((i) + 192)
+#define R1024(i) R256(i), R256((i) + 256), R256((i) + 512), R256((i) + 768)
+#define R4096(i) \
+  R1024(i), R1024((i) + 1024), R1024((i) + 2048), R1024((i) + 3072)
+#define R16384(i) \
+  R4096(i), R4096((i) + 4096), R4096((i) + 8192), R4096((i) + 12288)
+#define R65536(i) \
+  R16384(i), R16384((i) + 16384), R16384((i) + 32768), R16384((i) + 49152)
+
+int* table[] = { R65536(0), R16384(65536) };
+
+int
+main()
+{
+  for (unsigned int i = 0; i < sizeof table / sizeof table[0]; ++i)
+    assert(table[i] == &a[i & 3]);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+
+# trace_file_test.sh -- test --trace-file
+
+# Copyright (C) 2026 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This file goes with the trace file written when linking
+# trace_file_test.  Check that it is a JSON array of Chrome trace
+# events which includes the tasks that we expect to have run.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check trace_file_test.json '^\[$'
+check trace_file_test.json '^\]$'
+check trace_file_test.json '"name":"Read_symbols .*basic_test.o"'
+check trace_file_test.json '"name":"Relocate_task .*basic_test.o"'
+check trace_file_test.json '"ph":"X","ts":[0-9]*,"dur":[0-9]*,"pid":[0-9]*,"tid":[0-9]*'
+check trace_file_test.json '"args":{"token":"[0-9a-fx]*","token_type":"blocker"}'
+
+exit 0
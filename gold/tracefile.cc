@@ -0,0 +1,155 @@
+// tracefile.cc -- task trace file generation for gold
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#include "gold.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "gold-threads.h"
+#include "tracefile.h"
+
+namespace gold
+{
+
+// Return the wall clock time in microseconds.
+
+static long long
+get_microseconds()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+// Tracefile constructor.
+
+Tracefile::Tracefile()
+  : trace_file_(NULL),
+    lock_(NULL),
+    start_time_(0),
+    pid_(0),
+    wrote_event_(false)
+{
+}
+
+// Tracefile destructor.
+
+Tracefile::~Tracefile()
+{
+  if (this->trace_file_ != NULL)
+    this->close();
+  delete this->lock_;
+}
+
+// Open the trace file.
+
+bool
+Tracefile::open(const char* trace_filename)
+{
+  this->trace_file_ = ::fopen(trace_filename, "w");
+  if (this->trace_file_ == NULL)
+    {
+      gold_error(_("cannot open trace file %s: %s"), trace_filename,
+		 strerror(errno));
+      return false;
+    }
+  this->lock_ = new Lock();
+  this->start_time_ = get_microseconds();
+  this->pid_ = static_cast<long>(getpid());
+  fputs("[\n", this->trace_file_);
+  return true;
+}
+
+// Close the trace file.
+
+void
+Tracefile::close()
+{
+  fputs("\n]\n", this->trace_file_);
+  if (fclose(this->trace_file_) != 0)
+    gold_error(_("cannot close trace file: %s"), strerror(errno));
+  this->trace_file_ = NULL;
+}
+
+// Return the time since the trace file was opened.
+
+long long
+Tracefile::now() const
+{
+  return get_microseconds() - this->start_time_;
+}
+
+// Record a task as a complete event.  The token is identified by its
+// address, so that tasks which waited for the same token can be
+// matched up.  The token may have been deleted by now, so we don't
+// look at it.
+
+void
+Tracefile::record_task(int thread_number, const std::string& name,
+		       const void* token, bool is_blocker, long long start,
+		       long long end)
+{
+  Hold_lock hl(*this->lock_);
+
+  FILE* f = this->trace_file_;
+  if (this->wrote_event_)
+    fputs(",\n", f);
+  this->wrote_event_ = true;
+
+  fputs("{\"name\":", f);
+  this->write_string(name.c_str());
+  fprintf(f, ",\"cat\":\"task\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+	  "\"pid\":%ld,\"tid\":%d",
+	  start, end - start, this->pid_, thread_number);
+  if (token != NULL)
+    fprintf(f, ",\"args\":{\"token\":\"%p\",\"token_type\":\"%s\"}",
+	    token, is_blocker ? "blocker" : "lock");
+  fputs("}", f);
+}
+
+// Write S as a JSON string, quoting any special characters.
+
+void
+Tracefile::write_string(const char* s)
+{
+  FILE* f = this->trace_file_;
+  putc('"', f);
+  for (; *s != '\0'; ++s)
+    {
+      unsigned char c = *s;
+      if (c == '"' || c == '\\')
+	{
+	  putc('\\', f);
+	  putc(c, f);
+	}
+      else if (c < 0x20)
+	fprintf(f, "\\u%04x", c);
+      else
+	putc(c, f);
+    }
+  putc('"', f);
+}
+
+} // End namespace gold.
@@ -0,0 +1,94 @@
+// tracefile.h -- task trace file generation for gold   -*- C++ -*-
+
+// Copyright (C) 2026 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+#ifndef GOLD_TRACEFILE_H
+#define GOLD_TRACEFILE_H
+
+#include <cstdio>
+#include <string>
+
+namespace gold
+{
+
+class Lock;
+
+// This class manages the --trace-file output.  The Workqueue records
+// each Task that it runs, and we write it out as an event in the
+// Chrome trace event format, which can be loaded into chrome://tracing
+// or Perfetto to show what each thread was doing over time.  Each
+// event is written as soon as it is recorded, and the trace viewers
+// accept a file which is missing the closing bracket, so the trace is
+// still useful if the link fails.
+
+class Tracefile
+{
+ public:
+  Tracefile();
+
+  ~Tracefile();
+
+  // Open the trace file.  Return whether the open succeed.
+  bool
+  open(const char* trace_filename);
+
+  // Close the trace file.
+  void
+  close();
+
+  // Return the current time in microseconds since the trace file was
+  // opened.
+  long long
+  now() const;
+
+  // Record that thread THREAD_NUMBER ran the task NAME from time
+  // START to time END, as returned by now().  If TOKEN is not NULL,
+  // the task had to wait for the Task_token TOKEN to be released
+  // before it could run, and IS_BLOCKER is whether that token is a
+  // blocker.  This may be called by several threads at once.
+  void
+  record_task(int thread_number, const std::string& name,
+	      const void* token, bool is_blocker, long long start,
+	      long long end);
+
+ private:
+  // This class can not be copied.
+  Tracefile(const Tracefile&);
+  Tracefile& operator=(const Tracefile&);
+
+  // Write S as a JSON string.
+  void
+  write_string(const char* s);
+
+  // The trace file.
+  FILE* trace_file_;
+  // Lock controlling writes to trace_file_.
+  Lock* lock_;
+  // The time the trace file was opened, in microseconds.
+  long long start_time_;
+  // The process ID to use in the events.
+  long pid_;
+  // Whether we have written an event yet.
+  bool wrote_event_;
+};
+
+} // End namespace gold.
+
+#endif // !defined(GOLD_TRACEFILE_H)
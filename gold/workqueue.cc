@@ -22,9 +22,12 @@
 
 #include "gold.h"
 
+#include <algorithm>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
+#include "tracefile.h"
 #include "workqueue.h"
 #include "workqueue-internal.h"
 
@@ -118,12 +121,14 @@ class Workqueue_threader_single : public Workqueue_threader
 
 Workqueue::Workqueue(const General_options& options)
   : lock_(),
-    first_tasks_(),
-    tasks_(),
+    run_queues_(),
+    run_queue_count_(1),
+    next_run_queue_(0),
     running_(0),
     waiting_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    threader_(NULL),
+    tracefile_(NULL)
 {
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
@@ -135,6 +140,20 @@ Workqueue::Workqueue(const General_options& options)
     {
 #ifdef ENABLE_THREADS
       this->threader_ = new Workqueue_threader_threadpool(this);
+
+      // Use one run queue per thread, up to max_run_queues.  A
+      // thread count of zero means one thread per input file.
+      int thread_count = options.thread_count_initial();
+      thread_count = std::max(thread_count,
+			      static_cast<int>(options.thread_count_middle()));
+      thread_count = std::max(thread_count,
+			      static_cast<int>(options.thread_count_final()));
+      if (options.thread_count_initial() == 0
+	  || options.thread_count_middle() == 0
+	  || options.thread_count_final() == 0
+	  || thread_count > max_run_queues)
+	thread_count = max_run_queues;
+      this->run_queue_count_ = thread_count;
 #else
       gold_unreachable();
 #endif
@@ -145,29 +164,25 @@ Workqueue::~Workqueue()
 {
 }
 
-// Add a task to the end of a specific queue, or put it on the list
-// waiting for a Token.
+// Add a task to the end of a run queue, or put it on the list waiting
+// for a Token.  Tasks queued from outside a running Task are spread
+// across the run queues.
 
 void
-Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
+Workqueue::add_to_queue(Task* t, bool soon, bool front)
 {
   Hold_lock hl(this->lock_);
 
   Task_token* token = t->is_runnable();
   if (token != NULL)
-    {
-      if (front)
-	token->add_waiting_front(t);
-      else
-	token->add_waiting(t);
-      ++this->waiting_;
-    }
+    this->add_waiting(token, t, front);
   else
     {
-      if (front)
-	queue->push_front(t);
-      else
-	queue->push_back(t);
+      Run_queue* queue = &this->run_queues_[this->next_run_queue_];
+      ++this->next_run_queue_;
+      if (this->next_run_queue_ >= this->run_queue_count_)
+	this->next_run_queue_ = 0;
+      this->push_task(queue, t, soon, front);
       // Tell any waiting thread that there is work to do.
       this->condvar_.signal();
     }
@@ -178,7 +193,7 @@ Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
 void
 Workqueue::queue(Task* t)
 {
-  this->add_to_queue(&this->tasks_, t, false);
+  this->add_to_queue(t, false, false);
 }
 
 // Queue a task which should run soon.
@@ -187,7 +202,7 @@ void
 Workqueue::queue_soon(Task* t)
 {
   t->set_should_run_soon();
-  this->add_to_queue(&this->first_tasks_, t, false);
+  this->add_to_queue(t, true, false);
 }
 
 // Queue a task which should run next.
@@ -196,7 +211,21 @@ void
 Workqueue::queue_next(Task* t)
 {
   t->set_should_run_soon();
-  this->add_to_queue(&this->first_tasks_, t, true);
+  this->add_to_queue(t, true, true);
+}
+
+// Put T on the list of tasks waiting for TOKEN, at the front if FRONT
+// is true.  The workqueue lock must be held when this is called.
+
+void
+Workqueue::add_waiting(Task_token* token, Task* t, bool front)
+{
+  if (front)
+    token->add_waiting_front(t);
+  else
+    token->add_waiting(t);
+  t->set_waited_for(token);
+  ++this->waiting_;
 }
 
 // Return whether to cancel the current thread.
@@ -207,41 +236,110 @@ Workqueue::should_cancel_thread(int thread_number)
   return this->threader_->should_cancel_thread(thread_number);
 }
 
-// Find a runnable task in TASKS.  Return NULL if none could be found.
-// If we find a Task waiting for a Token, add it to the list for that
-// Token.  The workqueue lock must be held when this is called.
+// Add the runnable task T to QUEUE.  The workqueue lock must be held
+// when this is called, so that a thread which finds every run queue
+// empty while holding the workqueue lock can safely wait on condvar_.
+
+void
+Workqueue::push_task(Run_queue* queue, Task* t, bool soon, bool front)
+{
+  Hold_lock hl(queue->lock);
+  Task_list* list = soon ? &queue->first_tasks : &queue->tasks;
+  if (front)
+    list->push_front(t);
+  else
+    list->push_back(t);
+}
+
+// Remove a task from the run queues.  Look first at the tasks to
+// execute soon, starting with the run queue of THREAD_NUMBER and then
+// stealing from the others, and then do the same for the remaining
+// tasks.  If CLAIM is true, count the task as being claimed, so that
+// other threads do not decide that all work is done before we have
+// dealt with it; the caller must then call end_claim.  Store the run
+// queue in *PQUEUE.  Return NULL if every run queue is empty.  This
+// may be called with or without the workqueue lock held.
+
+Task*
+Workqueue::pop_task(int thread_number, bool claim, Run_queue** pqueue)
+{
+  int count = this->run_queue_count_;
+  int first = thread_number % count;
+  for (int pass = 0; pass < 2; ++pass)
+    {
+      for (int i = 0; i < count; ++i)
+	{
+	  Run_queue* queue = &this->run_queues_[(first + i) % count];
+	  Hold_lock hl(queue->lock);
+	  Task_list* list = pass == 0 ? &queue->first_tasks : &queue->tasks;
+	  Task* t = list->pop_front();
+	  if (t != NULL)
+	    {
+	      if (claim)
+		++queue->claiming;
+	      *pqueue = queue;
+	      return t;
+	    }
+	}
+    }
+  return NULL;
+}
+
+// Note that a task which pop_task claimed from QUEUE is now running
+// or waiting for a Token.  The workqueue lock must be held when this
+// is called.
+
+void
+Workqueue::end_claim(Run_queue* queue)
+{
+  Hold_lock hl(queue->lock);
+  gold_assert(queue->claiming > 0);
+  --queue->claiming;
+}
+
+// Return whether there is a task on any run queue.  If
+// INCLUDE_CLAIMING is true, also count tasks which have been claimed
+// but are not yet running.  The workqueue lock must be held when this
+// is called.
+
+bool
+Workqueue::have_queued_tasks(bool include_claiming)
+{
+  for (int i = 0; i < this->run_queue_count_; ++i)
+    {
+      Run_queue* queue = &this->run_queues_[i];
+      Hold_lock hl(queue->lock);
+      if (!queue->first_tasks.empty()
+	  || !queue->tasks.empty()
+	  || (include_claiming && queue->claiming > 0))
+	return true;
+    }
+  return false;
+}
+
+// Find a runnable task.  Return NULL if none could be found.  If we
+// find a Task waiting for a Token, add it to the list for that Token.
+// The workqueue lock must be held when this is called.
 
 Task*
-Workqueue::find_runnable_in_list(Task_list* tasks)
+Workqueue::find_runnable(int thread_number)
 {
   Task* t;
-  while ((t = tasks->pop_front()) != NULL)
+  Run_queue* queue;
+  while ((t = this->pop_task(thread_number, false, &queue)) != NULL)
     {
       Task_token* token = t->is_runnable();
 
       if (token == NULL)
 	return t;
 
-      token->add_waiting(t);
-      ++this->waiting_;
+      this->add_waiting(token, t, false);
     }
 
   // We couldn't find any runnable task.
   return NULL;
 }
 
-// Find a runnable task.  Return NULL if none could be found.  The
-// workqueue lock must be held when this is called.
-
-Task*
-Workqueue::find_runnable()
-{
-  Task* t = this->find_runnable_in_list(&this->first_tasks_);
-  if (t == NULL)
-    t = this->find_runnable_in_list(&this->tasks_);
-  return t;
-}
-
 // Find a runnable a task, and wait until we find one.  Return NULL if
 // we should exit.  The workqueue lock must be held when this is
 // called.
@@ -249,13 +347,11 @@ Workqueue::find_runnable()
 Task*
 Workqueue::find_runnable_or_wait(int thread_number)
 {
-  Task* t = this->find_runnable();
+  Task* t = this->find_runnable(thread_number);
 
   while (t == NULL)
     {
-      if (this->running_ == 0
-	  && this->first_tasks_.empty()
-	  && this->tasks_.empty())
+      if (this->running_ == 0 && !this->have_queued_tasks(true))
 	{
 	  // Kick all the threads to make them exit.
 	  this->condvar_.broadcast();
@@ -273,7 +369,7 @@ Workqueue::find_runnable_or_wait(int thread_number)
 
       gold_debug(DEBUG_TASK, "%3d awake", thread_number);
 
-      t = this->find_runnable();
+      t = this->find_runnable(thread_number);
     }
 
   return t;
@@ -291,11 +387,29 @@ Workqueue::find_and_run_task(int thread_number)
   Task* t;
   Task_locker tl;
 
+  // Take a task from the run queues before getting the workqueue
+  // lock, so that threads only contend for it to check the task's
+  // Tokens.
+  Run_queue* queue;
+  t = this->pop_task(thread_number, true, &queue);
+
   {
     Hold_lock hl(this->lock_);
 
+    if (t != NULL)
+      {
+	this->end_claim(queue);
+	Task_token* token = t->is_runnable();
+	if (token != NULL)
+	  {
+	    this->add_waiting(token, t, false);
+	    t = NULL;
+	  }
+      }
+
     // Find a runnable task.
-    t = this->find_runnable_or_wait(thread_number);
+    if (t == NULL)
+      t = this->find_runnable_or_wait(thread_number);
 
     if (t == NULL)
       return false;
@@ -316,8 +430,23 @@ Workqueue::find_and_run_task(int thread_number)
       if (is_debugging_enabled(DEBUG_TASK))
         timer.start();
 
+      long long start_time = 0;
+      if (this->tracefile_ != NULL)
+	{
+	  // Get the name before running the task, since the task may
+	  // free the object which the name describes.
+	  t->name();
+	  start_time = this->tracefile_->now();
+	}
+
       t->run(this);
 
+      if (this->tracefile_ != NULL)
+	this->tracefile_->record_task(thread_number, t->name(),
+				      t->waited_for(),
+				      t->waited_for_blocker(),
+				      start_time, this->tracefile_->now());
+
       if (is_debugging_enabled(DEBUG_TASK))
         {
           Timer::TimeStats elapsed = timer.get_elapsed_time();
@@ -339,10 +468,10 @@ Workqueue::find_and_run_task(int thread_number)
 
 	// Release the locks for the task.  This must be done with the
 	// workqueue lock held.  Get the next Task to run if any.
-	next = this->release_locks(t, &tl);
+	next = this->release_locks(t, &tl, thread_number);
 
 	if (next == NULL)
-	  next = this->find_runnable();
+	  next = this->find_runnable(thread_number);
 
 	// If we have another Task to run, get the Locks.  This must
 	// be called while we are still holding the Workqueue lock.
@@ -370,8 +499,8 @@ Workqueue::find_and_run_task(int thread_number)
 // 1) If T is not runnable, queue it on the appropriate token.
 
 // 2) Otherwise, T is runnable.  If *PRET is not NULL, then we have
-// already decided which Task to run next.  Add T to the list of
-// runnable tasks, and signal another thread.
+// already decided which Task to run next.  Add T to the run queue of
+// THREAD_NUMBER, and signal another thread.
 
 // 3) Otherwise, *PRET is NULL.  If IS_BLOCKER is false, then T was
 // waiting on a write lock.  We can grab that lock now, so we run T
@@ -394,14 +523,14 @@ Workqueue::find_and_run_task(int thread_number)
 // Return true if we set *PRET to T, false otherwise.
 
 bool
-Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
+Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret,
+			   int thread_number)
 {
   Task_token* token = t->is_runnable();
 
   if (token != NULL)
     {
-      token->add_waiting(t);
-      ++this->waiting_;
+      this->add_waiting(token, t, false);
       return false;
     }
 
@@ -414,7 +543,7 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     should_return = true;
   else if (t->should_run_soon())
     should_return = true;
-  else if (!this->first_tasks_.empty() || !this->tasks_.empty())
+  else if (this->have_queued_tasks(false))
     should_queue = true;
   else
     should_return = true;
@@ -427,10 +556,8 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     }
   else if (should_queue)
     {
-      if (t->should_run_soon())
-	this->first_tasks_.push_back(t);
-      else
-	this->tasks_.push_back(t);
+      this->push_task(this->run_queue(thread_number), t,
+		      t->should_run_soon(), false);
       this->condvar_.signal();
       return false;
     }
@@ -440,11 +567,11 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
 
 // Release the locks associated with a Task.  Return the first
 // runnable Task that we find.  If we find more runnable tasks, add
-// them to the run queue and signal any other threads.  This must be
-// called with the Workqueue lock held.
+// them to the run queue of THREAD_NUMBER and signal any other
+// threads.  This must be called with the Workqueue lock held.
 
 Task*
-Workqueue::release_locks(Task* t, Task_locker* tl)
+Workqueue::release_locks(Task* t, Task_locker* tl, int thread_number)
 {
   Task* ret = NULL;
   for (Task_locker::iterator p = tl->begin(); p != tl->end(); ++p)
@@ -460,7 +587,7 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	      while ((t = token->remove_first_waiting()) != NULL)
 		{
 		  --this->waiting_;
-		  this->return_or_queue(t, true, &ret);
+		  this->return_or_queue(t, true, &ret, thread_number);
 		}
 	    }
 	}
@@ -477,7 +604,7 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 	  while ((t = token->remove_first_waiting()) != NULL)
 	    {
 	      --this->waiting_;
-	      if (this->return_or_queue(t, false, &ret))
+	      if (this->return_or_queue(t, false, &ret, thread_number))
 		break;
 	    }
 	}
@@ -36,6 +36,7 @@ namespace gold
 {
 
 class General_options;
+class Tracefile;
 class Workqueue;
 
 // The superclass for tasks to be placed on the workqueue.  Each
@@ -45,7 +46,8 @@ class Task
 {
  public:
   Task()
-    : list_next_(NULL), name_(), should_run_soon_(false)
+    : list_next_(NULL), name_(), should_run_soon_(false),
+      waited_for_(NULL), waited_for_blocker_(false)
   { }
   virtual ~Task()
   { }
@@ -78,6 +80,26 @@ class Task
   set_should_run_soon()
   { this->should_run_soon_ = true; }
 
+  // Return the last Task_token this task had to wait for, or NULL.
+  // This is only used for --trace-file.
+  const Task_token*
+  waited_for() const
+  { return this->waited_for_; }
+
+  // Return whether the token returned by waited_for is a blocker.
+  bool
+  waited_for_blocker() const
+  { return this->waited_for_blocker_; }
+
+  // Note that this task has to wait for TOKEN.  Called by the
+  // Workqueue with the workqueue lock held.
+  void
+  set_waited_for(const Task_token* token)
+  {
+    this->waited_for_ = token;
+    this->waited_for_blocker_ = token->is_blocker();
+  }
+
   // Get the next Task on the list of Tasks.  Called by Task_list.
   Task*
   list_next() const
@@ -127,6 +149,10 @@ class Task
   // Whether this Task should be executed soon.  This is used for
   // Tasks which can be run after some data is read.
   bool should_run_soon_;
+  // The last Task_token this Task had to wait for.
+  const Task_token* waited_for_;
+  // Whether waited_for_ is a blocker.
+  bool waited_for_blocker_;
 };
 
 // An interface for Task_function.  This is a convenience class to run
@@ -233,14 +259,73 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Record each task run in TRACEFILE.  This must be called before
+  // any tasks are run.
+  void
+  set_tracefile(Tracefile* tracefile)
+  { this->tracefile_ = tracefile; }
+
  private:
   // This class can not be copied.
   Workqueue(const Workqueue&);
   Workqueue& operator=(const Workqueue&);
 
+  // The maximum number of run queues.
+  static const int max_run_queues = 16;
+
+  // A queue of runnable tasks.  When using threads there is one run
+  // queue for each of the first max_run_queues threads, and higher
+  // numbered threads share them.  A thread takes tasks from its own
+  // queue without holding the master Workqueue lock, and steals from
+  // the other queues when its own is empty.  Tasks which are waiting
+  // for a Task_token are not put on a run queue; they wait on the
+  // token until it is released.
+  struct Run_queue
+  {
+    Run_queue()
+      : lock(), first_tasks(), tasks(), claiming(0)
+    { }
+
+    // Lock for the other members.
+    Lock lock;
+    // List of tasks to execute soon.
+    Task_list first_tasks;
+    // List of tasks to execute after the ones in first_tasks.
+    Task_list tasks;
+    // Number of tasks taken from this queue by pop_task which have
+    // not yet been run or put on a Task_token.
+    int claiming;
+  };
+
   // Add a task to a queue.
   void
-  add_to_queue(Task_list* queue, Task* t, bool front);
+  add_to_queue(Task* t, bool soon, bool front);
+
+  // Put a task on the list waiting for a Task_token.
+  void
+  add_waiting(Task_token* token, Task* t, bool front);
+
+  // Return the run queue used by THREAD_NUMBER.
+  Run_queue*
+  run_queue(int thread_number)
+  { return &this->run_queues_[thread_number % this->run_queue_count_]; }
+
+  // Add a runnable task to a run queue.
+  void
+  push_task(Run_queue*, Task* t, bool soon, bool front);
+
+  // Remove a task from a run queue.
+  Task*
+  pop_task(int thread_number, bool claim, Run_queue** pqueue);
+
+  // Note that a task returned by pop_task has been run or put on a
+  // Task_token.
+  void
+  end_claim(Run_queue*);
+
+  // Return whether any run queue has a task.
+  bool
+  have_queued_tasks(bool include_claiming);
 
   // Find a runnable task, or wait for one.
   Task*
@@ -248,11 +333,7 @@ class Workqueue
 
   // Find a runnable task.
   Task*
-  find_runnable();
-
-  // Find a runnable task in a list.
-  Task*
-  find_runnable_in_list(Task_list*);
+  find_runnable(int thread_number);
 
   // Find an run a task.
   bool
@@ -260,23 +341,28 @@ class Workqueue
 
   // Release the locks for a Task.  Return the next Task to run.
   Task*
-  release_locks(Task*, Task_locker*);
+  release_locks(Task*, Task_locker*, int thread_number);
 
   // Store T into *PRET, or queue it as appropriate.
   bool
-  return_or_queue(Task* t, bool is_blocker, Task** pret);
+  return_or_queue(Task* t, bool is_blocker, Task** pret, int thread_number);
 
   // Return whether to cancel this thread.
   bool
   should_cancel_thread(int thread_number);
 
-  // Master Workqueue lock.  This controls access to the following
-  // member variables.
+  // Master Workqueue lock.  This controls access to all Task_tokens,
+  // and to the following member variables.  It must be held when
+  // adding a task to a run queue, but not when removing one.
   Lock lock_;
-  // List of tasks to execute soon.
-  Task_list first_tasks_;
-  // List of tasks to execute after the ones in first_tasks_.
-  Task_list tasks_;
+  // The run queues.
+  Run_queue run_queues_[max_run_queues];
+  // The number of run queues in use.  This is set at construction
+  // time and not changed thereafter.
+  int run_queue_count_;
+  // The run queue to use for the next task queued by queue(),
+  // queue_soon() or queue_next().
+  int next_run_queue_;
   // Number of tasks currently running.
   int running_;
   // Number of tasks waiting for a lock to release.
@@ -288,6 +374,8 @@ class Workqueue
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // The --trace-file output, or NULL.
+  Tracefile* tracefile_;
 };
 
 } // End namespace gold.
@@ -737,6 +737,12 @@ class Target_x86_64 : public Sized_target<size, false>
   do_can_check_for_function_pointers() const
   { return true; }
 
+  // Relocations only carry state from a TLS relocation to the call to
+  // __tls_get_addr which follows it, so they may be split into ranges.
+  bool
+  do_may_split_relocs() const
+  { return true; }
+
   // Return the base for a DW_EH_PE_datarel encoding.
   uint64_t
   do_ehframe_datarel_base() const;
@@ -1403,6 +1409,16 @@ Target_x86_64<size>::rela_dyn_section(Layout* layout)
       layout->add_output_section_data(".rela.dyn", elfcpp::SHT_RELA,
 				      elfcpp::SHF_ALLOC, this->rela_dyn_,
 				      ORDER_DYNAMIC_RELOCS, false);
+      if (parameters->options().pack_relative_relocs()
+	  && parameters->options().output_is_position_independent())
+	{
+	  Output_data_relr<size, false>* relr =
+	    new Output_data_relr<size, false>(elfcpp::R_X86_64_RELATIVE);
+	  layout->add_output_section_data(".relr.dyn", elfcpp::SHT_RELR,
+					  elfcpp::SHF_ALLOC, relr,
+					  ORDER_DYNAMIC_RELOCS, false);
+	  this->rela_dyn_->set_relr_section(relr);
+	}
     }
   return this->rela_dyn_;
 }
@@ -2080,10 +2096,15 @@ Output_data_plt_x86_64<size>::do_write(Output_file* of)
   gold_assert(parameters->incremental_update()
 	      || (got_file_offset + this->got_plt_->data_size()
 		  == this->got_irelative_->offset()));
+  // The first three entries in the GOT are reserved, and are written
+  // by Output_data_got_plt_x86_64::do_write, so our view of the GOT
+  // starts after them.
+  const off_t got_view_offset = got_file_offset + 24;
   const section_size_type got_size =
     convert_to_section_size_type(this->got_plt_->data_size()
-				 + this->got_irelative_->data_size());
-  unsigned char* const got_view = of->get_output_view(got_file_offset,
+				 + this->got_irelative_->data_size()
+				 - 24);
+  unsigned char* const got_view = of->get_output_view(got_view_offset,
 						      got_size);
 
   unsigned char* pov = oview;
@@ -2101,9 +2122,7 @@ Output_data_plt_x86_64<size>::do_write(Output_file* of)
   this->fill_first_plt_entry(pov, got_address, plt_address);
   pov += this->get_plt_entry_size();
 
-  // The first three entries in the GOT are reserved, and are written
-  // by Output_data_got_plt_x86_64::do_write.
-  unsigned char* got_pov = got_view + 24;
+  unsigned char* got_pov = got_view;
 
   unsigned int plt_offset = this->get_plt_entry_size();
   unsigned int got_offset = 24;
@@ -2140,7 +2159,7 @@ Output_data_plt_x86_64<size>::do_write(Output_file* of)
   gold_assert(static_cast<section_size_type>(got_pov - got_view) == got_size);
 
   of->write_output_view(offset, oview_size, oview);
-  of->write_output_view(got_file_offset, got_size, got_view);
+  of->write_output_view(got_view_offset, got_size, got_view);
 }
 
 // Write out the BND PLT.
@@ -2161,10 +2180,15 @@ Output_data_plt_x86_64_bnd::do_write(Output_file* of)
   gold_assert(parameters->incremental_update()
 	      || (got_file_offset + got_plt->data_size()
 		  == got_irelative->offset()));
+  // The first three entries in the GOT are reserved, and are written
+  // by Output_data_got_plt_x86_64::do_write, so our view of the GOT
+  // starts after them.
+  const off_t got_view_offset = got_file_offset + 24;
   const section_size_type got_size =
     convert_to_section_size_type(got_plt->data_size()
-				 + got_irelative->data_size());
-  unsigned char* const got_view = of->get_output_view(got_file_offset,
+				 + got_irelative->data_size()
+				 - 24);
+  unsigned char* const got_view = of->get_output_view(got_view_offset,
 						      got_size);
 
   unsigned char* pov = oview;
@@ -2181,9 +2205,7 @@ Output_data_plt_x86_64_bnd::do_write(Output_file* of)
   this->fill_first_plt_entry(pov, got_address, plt_address);
   pov += plt_entry_size;
 
-  // The first three entries in the GOT are reserved, and are written
-  // by Output_data_got_plt_x86_64::do_write.
-  unsigned char* got_pov = got_view + 24;
+  unsigned char* got_pov = got_view;
 
   unsigned int plt_offset = plt_entry_size;
   unsigned int got_offset = 24;
@@ -2234,7 +2256,7 @@ Output_data_plt_x86_64_bnd::do_write(Output_file* of)
   gold_assert(static_cast<section_size_type>(got_pov - got_view) == got_size);
 
   of->write_output_view(offset, oview_size, oview);
-  of->write_output_view(got_file_offset, got_size, got_view);
+  of->write_output_view(got_view_offset, got_size, got_view);
 }
 
 // Create the PLT section.